@@ -0,0 +1,74 @@
+// Compares the B+-tree bmap with the AA-tree smap on random inserts, random lookups,
+// lower_bound range scans, full ordered iteration and erasing all keys, for uint64_t keys.
+// Usage: bmap_bench [num_keys] [num_lookups]
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "stc/random.h"
+
+#define i_type bumap, uint64_t, uint64_t
+#include "stc/bmap.h"
+
+#define i_type sumap, uint64_t, uint64_t
+#include "stc/smap.h"
+
+enum {SCAN = 100};
+static isize N, M;
+static uint64_t* keys;
+
+static double now(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec*1e-9;
+}
+
+#define BENCH(C, res) do { \
+    C map = {0}; \
+    uint64_t sum = 0; \
+    double t = now(); \
+    for (isize i = 0; i < N; ++i) \
+        C##_insert(&map, keys[i], (uint64_t)i); \
+    res[0] = now() - t; \
+    t = now(); \
+    for (isize i = 0; i < M; ++i) \
+        sum += C##_contains(&map, keys[i % N] + (i & 1)); \
+    res[1] = now() - t; \
+    t = now(); \
+    for (isize i = 0; i < M/SCAN; ++i) { \
+        C##_iter it = C##_lower_bound(&map, keys[i % N]); \
+        for (int j = 0; j < SCAN && it.ref; ++j, C##_next(&it)) \
+            sum += it.ref->second; \
+    } \
+    res[2] = now() - t; \
+    t = now(); \
+    for (c_each(it, C, map)) \
+        sum += it.ref->first; \
+    res[3] = now() - t; \
+    t = now(); \
+    for (isize i = 0; i < N; ++i) \
+        C##_erase(&map, keys[i]); \
+    res[4] = now() - t; \
+    res[5] = (double)(sum & 0xffff); \
+    C##_drop(&map); \
+} while (0)
+
+int main(int argc, char* argv[])
+{
+    N = argc > 1 ? atoll(argv[1]) : 2000000;
+    M = argc > 2 ? atoll(argv[2]) : 4000000;
+    crand64 rng = crand64_from(12345);
+    keys = c_new_n(uint64_t, N);
+    for (isize i = 0; i < N; ++i)
+        keys[i] = crand64_uint_r(&rng, 1) & ~(uint64_t)1; // even keys: odd lookups miss
+
+    double b[6], s[6];
+    BENCH(bumap, b);
+    BENCH(sumap, s);
+    printf("%" c_ZI " keys, %" c_ZI " lookups, %d-entry scans: seconds\n", N, M, SCAN);
+    printf("             bmap     smap\n");
+    const char* name[] = {"insert", "find", "scan", "iterate", "erase"};
+    for (int i = 0; i < 5; ++i)
+        printf("%-8s %8.3f %8.3f\n", name[i], b[i], s[i]);
+    printf("check    %s\n", b[5] == s[5] ? "ok" : "MISMATCH");
+    c_free(keys, N*c_sizeof *keys);
+}
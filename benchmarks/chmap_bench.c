@@ -0,0 +1,80 @@
+// Throughput of a sharded chmap compared with an hmap behind one global mutex, for
+// 1 to 32 threads doing 90% lookups and 10% inserts/updates of random uint64_t keys.
+// Requires POSIX threads.
+// Usage: chmap_bench [num_keys] [ops_per_thread]
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+#include "stc/random.h"
+
+#define i_type umap, uint64_t, uint64_t
+#include "stc/hmap.h"
+
+#define i_type cumap, uint64_t, uint64_t
+#include "stc/chmap.h"
+
+enum {MAX_THREADS = 32};
+static isize N, OPS;
+static umap gmap;
+static pthread_mutex_t gmutex = PTHREAD_MUTEX_INITIALIZER;
+static cumap cmap;
+
+static double now(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec*1e-9;
+}
+
+static void* run_mutex(void* arg) {
+    crand64 rng = crand64_from((uint64_t)(intptr_t)arg);
+    uint64_t found = 0;
+    for (isize i = 0; i < OPS; ++i) {
+        const uint64_t r = crand64_uint_r(&rng, 1), key = r % (uint64_t)N;
+        pthread_mutex_lock(&gmutex);
+        if (r >> 60 < 15) found += umap_contains(&gmap, key);
+        else umap_insert_or_assign(&gmap, key, r);
+        pthread_mutex_unlock(&gmutex);
+    }
+    return (void*)(intptr_t)found;
+}
+
+static void* run_chmap(void* arg) {
+    crand64 rng = crand64_from((uint64_t)(intptr_t)arg);
+    uint64_t found = 0;
+    for (isize i = 0; i < OPS; ++i) {
+        const uint64_t r = crand64_uint_r(&rng, 1), key = r % (uint64_t)N;
+        if (r >> 60 < 15) found += cumap_contains(&cmap, key);
+        else cumap_put(&cmap, key, r);
+    }
+    return (void*)(intptr_t)found;
+}
+
+static double bench(void* (*fn)(void*), int nthreads) {
+    pthread_t t[MAX_THREADS];
+    double start = now();
+    for (int i = 0; i < nthreads; ++i)
+        pthread_create(&t[i], NULL, fn, (void*)(intptr_t)(i + 1));
+    for (int i = 0; i < nthreads; ++i)
+        pthread_join(t[i], NULL);
+    return (double)(nthreads*OPS)/(now() - start)*1e-6;
+}
+
+int main(int argc, char* argv[])
+{
+    N = argc > 1 ? atoll(argv[1]) : 1000000;
+    OPS = argc > 2 ? atoll(argv[2]) : 1000000;
+    for (isize i = 0; i < N; i += 2) {
+        umap_insert(&gmap, (uint64_t)i, 0);
+        cumap_insert(&cmap, (uint64_t)i, 0);
+    }
+    printf("%" c_ZI " keys, %" c_ZI " ops per thread, 90%% lookups: Mops/s\n", N, OPS);
+    printf("threads  hmap+mutex    chmap\n");
+    for (int n = 1; n <= MAX_THREADS; n *= 2) {
+        double a = bench(run_mutex, n);
+        double b = bench(run_chmap, n);
+        printf("%7d %11.2f %8.2f\n", n, a, b);
+    }
+    umap_drop(&gmap);
+    cumap_drop(&cmap);
+}
@@ -0,0 +1,62 @@
+// The flat sorted-vector fmap against the smap tree: bulk put_n of random batches,
+// lookups and iteration. Usage: fmap_bench [num_keys] [batch_size]
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "stc/random.h"
+
+#define i_type fumap, uint64_t, uint64_t
+#include "stc/fmap.h"
+
+#define i_type sumap, uint64_t, uint64_t
+#include "stc/smap.h"
+
+static isize N, B;
+static fumap_raw* raws;
+
+static double now(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec*1e-9;
+}
+
+// res: put_n all in batches, lookups of all keys, iterate 10 times
+#define BENCH(C, res) do { \
+    C map = {0}; \
+    uint64_t sum = 0; \
+    double t = now(); \
+    for (isize i = 0; i < N; i += B) \
+        C##_put_n(&map, (const C##_raw*)raws + i, i + B < N ? B : N - i); \
+    res[0] = now() - t; \
+    t = now(); \
+    for (isize i = 0; i < N; ++i) \
+        sum += C##_get(&map, raws[i].first)->second; \
+    res[1] = now() - t; \
+    t = now(); \
+    for (int r = 0; r < 10; ++r) \
+        for (c_each(it, C, map)) sum += it.ref->first; \
+    res[2] = now() - t; \
+    res[3] = (double)(sum & 0xffff); \
+    C##_drop(&map); \
+} while (0)
+
+int main(int argc, char* argv[])
+{
+    N = argc > 1 ? atoll(argv[1]) : 1000000;
+    B = argc > 2 ? atoll(argv[2]) : 100000;
+    crand64 rng = crand64_from(12345);
+    raws = c_new_n(fumap_raw, N);
+    for (isize i = 0; i < N; ++i)
+        raws[i].first = crand64_uint_r(&rng, 1), raws[i].second = (uint64_t)i;
+
+    double f[4], s[4];
+    BENCH(fumap, f);
+    BENCH(sumap, s);
+    printf("%" c_ZI " keys, batches of %" c_ZI ": seconds\n", N, B);
+    printf("                  fmap        smap\n");
+    printf("put_n        %10.3f  %10.3f\n", f[0], s[0]);
+    printf("lookups      %10.3f  %10.3f\n", f[1], s[1]);
+    printf("iterate x10  %10.3f  %10.3f\n", f[2], s[2]);
+    printf("checksum     %10.0f  %10.0f\n", f[3], s[3]);
+    c_free(raws, N*c_sizeof *raws);
+}
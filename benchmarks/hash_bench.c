@@ -0,0 +1,122 @@
+// Compares the default hash functions with the multiply-only byte hash they replaced:
+// throughput by key size for c_hash_n() and c_hash_str(), and hmap inserts/lookups with
+// structured string and integer keys, where the weak low bits of the old hash cluster.
+// Usage: hash_bench [num_entries]
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "stc/cstr.h"
+#include "stc/random.h"
+
+static size_t old_hash_n(const void* key, isize len) {
+    size_t block = 0, hash = 0x811c9dc5;
+    const uint8_t* msg = (const uint8_t*)key;
+    while (len > c_sizeof(size_t)) {
+        memcpy(&block, msg, sizeof(size_t));
+        hash = (hash ^ block) * (size_t)0x89bb179901000193;
+        msg += c_sizeof(size_t);
+        len -= c_sizeof(size_t);
+    }
+    c_memcpy((char *)&block, msg, len);
+    hash = (hash ^ block) * (size_t)0xb0340f4501000193;
+    return hash ^ (hash >> 3);
+}
+
+static size_t old_hash_str(const char* str)
+    { return old_hash_n(str, c_strlen(str)); }
+
+static size_t old_hash_u64(const uint64_t* x)
+    { return (size_t)(*x * 0xc6a4a7935bd1e99d); }
+
+#define i_type smap_new
+#define i_keypro cstr
+#define i_val int
+#include "stc/hmap.h"
+
+#define i_type smap_old
+#define i_keypro cstr
+#define i_val int
+#define i_hash(p) old_hash_str(*(p))
+#include "stc/hmap.h"
+
+#define i_type umap_new, uint64_t, int
+#include "stc/hmap.h"
+
+#define i_type umap_old, uint64_t, int
+#define i_hash old_hash_u64
+#include "stc/hmap.h"
+
+enum {REPEAT = 3};
+#define min(a, b) ((a) < (b) ? (a) : (b))
+static double secs(clock_t t) { return (double)t/CLOCKS_PER_SEC; }
+static volatile size_t sink;
+
+static void bench_sizes(void)
+{
+    static const int sizes[] = {4, 8, 16, 24, 32, 64, 256, 4096};
+    static char buf[4096 + 2];
+    crand64 rng = crand64_from(1234);
+    for (int i = 0; i < c_arraylen(buf) - 1; ++i)
+        buf[i] = (char)('a' + crand64_uint_r(&rng, 1) % 26);
+
+    puts("bytes hashed per second (GB/s), best of 3:");
+    puts("  size    c_hash_n  old_hash_n  c_hash_str  old_hash_str");
+    for (int s = 0; s < c_arraylen(sizes); ++s) {
+        const int len = sizes[s];
+        const isize iters = ((isize)1 << 28) / (len + 16);
+        double best[4] = {1e9, 1e9, 1e9, 1e9};
+        size_t h = 0;
+        clock_t t;
+        buf[len + 1] = '\0';
+        for (int r = 0; r < REPEAT; ++r) {
+            t = clock(); // feed back the hash so that calls can not overlap unrealistically
+            for (isize i = 0; i < iters; ++i) h += c_hash_n(buf + (h & 1), len);
+            best[0] = min(best[0], secs(clock() - t));
+            t = clock();
+            for (isize i = 0; i < iters; ++i) h += old_hash_n(buf + (h & 1), len);
+            best[1] = min(best[1], secs(clock() - t));
+            t = clock();
+            for (isize i = 0; i < iters; ++i) h += c_hash_str(buf + (h & 1));
+            best[2] = min(best[2], secs(clock() - t));
+            t = clock();
+            for (isize i = 0; i < iters; ++i) h += old_hash_str(buf + (h & 1));
+            best[3] = min(best[3], secs(clock() - t));
+        }
+        buf[len + 1] = 'x';
+        sink = h;
+        const double gb = (double)iters*len/1e9;
+        printf("  %-6d  %8.2f  %10.2f  %10.2f  %12.2f\n", len,
+               gb/best[0], gb/best[1], gb/best[2], gb/best[3]);
+    }
+}
+
+#define BENCH_MAP(C, name, N, mkkey, put) do { \
+    C map = {0}; \
+    char key[32]; (void)key; \
+    isize found = 0; \
+    clock_t t = clock(); \
+    for (isize i = 0; i < N; ++i) \
+        C##_##put(&map, mkkey(i), 0); \
+    double ins = secs(clock() - t); \
+    t = clock(); \
+    for (isize i = 0; i < 2*N; ++i) \
+        found += C##_contains(&map, mkkey(i)); \
+    printf("  %-14s insert %.3f s, lookup %.3f s (%" c_ZI " found)\n", \
+           name, ins, secs(clock() - t), found); \
+    C##_drop(&map); \
+} while (0)
+
+#define KEY_STR(i) (snprintf(key, sizeof key, "key%" c_ZI, i), key)
+#define KEY_U64(i) ((uint64_t)(i) << 20)
+
+int main(int argc, char* argv[])
+{
+    const isize N = argc > 1 ? atoll(argv[1]) : 200000;
+    bench_sizes();
+    printf("hmap with %" c_ZI " \"key<i>\" strings:\n", N);
+    BENCH_MAP(smap_new, "c_hash_str", N, KEY_STR, emplace);
+    BENCH_MAP(smap_old, "old_hash_str", N, KEY_STR, emplace);
+    printf("hmap with %" c_ZI " keys i << 20:\n", N);
+    BENCH_MAP(umap_new, "c_hash_n", N, KEY_U64, insert);
+    BENCH_MAP(umap_old, "old multiply", N, KEY_U64, insert);
+}
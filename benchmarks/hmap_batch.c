@@ -0,0 +1,167 @@
+// Compares one-at-a-time hmap lookups/inserts with the batched, prefetching
+// put_n(), get_n() and contains_n(), for integer and short string keys.
+// The gain shows when the table is larger than the CPU cache. Also times
+// with_n() against build_n() on `threads` threads (default 4).
+// Usage: hmap_batch [num_entries] [num_lookups] [threads]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "stc/cstr.h"
+#include "stc/random.h"
+
+#define i_type umap, uint64_t, uint64_t
+#define i_parallel
+#include "stc/hmap.h"
+
+#define i_type smap_cstr
+#define i_keypro cstr
+#define i_val uint64_t
+#include "stc/hmap.h"
+
+enum {BATCH = 1024, REPEAT = 3};
+#define min(a, b) ((a) < (b) ? (a) : (b))
+
+static int threads = 4;
+
+static double secs(clock_t t) { return (double)t/CLOCKS_PER_SEC; }
+
+static double wall(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec*1e-9;
+}
+
+static void bench_int(const isize N, const isize M)
+{
+    crand64 rng = crand64_from(12345);
+    umap_raw* raw = c_new_n(umap_raw, N);
+    uint64_t* keys = c_new_n(uint64_t, M);
+    const umap_value* vals[BATCH];
+    bool found[BATCH];
+    umap map1 = {0}, map2 = {0};
+    double best[4] = {1e9, 1e9, 1e9, 1e9};
+    isize n[4];
+    clock_t t;
+
+    for (isize i = 0; i < N; ++i)
+        raw[i].first = crand64_uint_r(&rng, 1), raw[i].second = (uint64_t)i;
+    for (isize i = 0; i < M; ++i) // ~half of the keys are present
+        keys[i] = (i & 1) ? raw[crand64_uint_r(&rng, 1) % (uint64_t)N].first : crand64_uint_r(&rng, 1);
+
+    printf("uint64_t keys: %" c_ZI " entries, %" c_ZI " lookups, best of %d\n", N, M, REPEAT);
+    t = clock();
+    for (isize i = 0; i < N; ++i)
+        umap_insert_or_assign(&map1, raw[i].first, raw[i].second);
+    printf("  insert     : %.3f s\n", secs(clock() - t));
+    t = clock();
+    for (isize i = 0; i < N; i += BATCH)
+        umap_put_n(&map2, raw + i, min(BATCH, N - i));
+    printf("  put_n      : %.3f s\n", secs(clock() - t));
+    double w = wall();
+    umap map3 = umap_with_n(raw, N);
+    printf("  with_n     : %.3f s wall\n", wall() - w);
+    w = wall();
+    umap map4 = umap_build_n(raw, N, threads);
+    printf("  build_n    : %.3f s wall, %d threads, %s\n", wall() - w, threads,
+           umap_eq(&map3, &map4) && !memcmp(map3.meta, map4.meta, (size_t)map3.bucket_count*sizeof *map3.meta)
+           ? "same table" : "MISMATCH");
+    c_drop(umap, &map3, &map4);
+
+    for (int r = 0; r < REPEAT; ++r) {
+        n[0] = n[1] = n[2] = n[3] = 0;
+        t = clock();
+        for (isize i = 0; i < M; ++i)
+            n[0] += umap_get(&map1, keys[i]) != NULL;
+        best[0] = min(best[0], secs(clock() - t));
+
+        t = clock();
+        for (isize i = 0; i < M; i += BATCH)
+            n[1] += umap_get_n(&map1, keys + i, min(BATCH, M - i), vals);
+        best[1] = min(best[1], secs(clock() - t));
+
+        t = clock();
+        for (isize i = 0; i < M; ++i)
+            n[2] += umap_contains(&map1, keys[i]);
+        best[2] = min(best[2], secs(clock() - t));
+
+        t = clock();
+        for (isize i = 0; i < M; i += BATCH)
+            n[3] += umap_contains_n(&map1, keys + i, min(BATCH, M - i), found);
+        best[3] = min(best[3], secs(clock() - t));
+    }
+    printf("  get        : %.3f s\n", best[0]);
+    printf("  get_n      : %.3f s\n", best[1]);
+    printf("  contains   : %.3f s\n", best[2]);
+    printf("  contains_n : %.3f s\n", best[3]);
+    printf("  check      : %s\n", (n[0] == n[1] && n[1] == n[2] && n[2] == n[3] &&
+                                   umap_eq(&map1, &map2)) ? "ok" : "MISMATCH");
+    c_drop(umap, &map1, &map2);
+    c_free(raw, N*c_sizeof *raw);
+    c_free(keys, M*c_sizeof *keys);
+}
+
+static void bench_str(const isize N, const isize M)
+{
+    crand64 rng = crand64_from(12345);
+    smap_cstr_raw* raw = c_new_n(smap_cstr_raw, N);
+    const char** keys = c_new_n(const char*, M);
+    char* text = (char *)c_malloc((N + M)*20);
+    const smap_cstr_value* vals[BATCH];
+    smap_cstr map1 = {0}, map2 = {0};
+    double best[2] = {1e9, 1e9};
+    isize n[2], pos = 0;
+    clock_t t;
+
+    for (isize i = 0; i < N; ++i) {
+        raw[i].first = text + pos, raw[i].second = (uint64_t)i;
+        pos += sprintf(text + pos, "%016" PRIx64, crand64_uint_r(&rng, 1)) + 1;
+    }
+    for (isize i = 0; i < M; ++i) {
+        if (i & 1) {
+            keys[i] = raw[crand64_uint_r(&rng, 1) % (uint64_t)N].first;
+        } else {
+            keys[i] = text + pos;
+            pos += sprintf(text + pos, "%016" PRIx64, crand64_uint_r(&rng, 1)) + 1;
+        }
+    }
+
+    printf("short cstr keys: %" c_ZI " entries, %" c_ZI " lookups, best of %d\n", N, M, REPEAT);
+    t = clock();
+    for (isize i = 0; i < N; ++i)
+        smap_cstr_put(&map1, raw[i].first, raw[i].second);
+    printf("  put        : %.3f s\n", secs(clock() - t));
+    t = clock();
+    for (isize i = 0; i < N; i += BATCH)
+        smap_cstr_put_n(&map2, raw + i, min(BATCH, N - i));
+    printf("  put_n      : %.3f s\n", secs(clock() - t));
+
+    for (int r = 0; r < REPEAT; ++r) {
+        n[0] = n[1] = 0;
+        t = clock();
+        for (isize i = 0; i < M; ++i)
+            n[0] += smap_cstr_get(&map1, keys[i]) != NULL;
+        best[0] = min(best[0], secs(clock() - t));
+
+        t = clock();
+        for (isize i = 0; i < M; i += BATCH)
+            n[1] += smap_cstr_get_n(&map1, keys + i, min(BATCH, M - i), vals);
+        best[1] = min(best[1], secs(clock() - t));
+    }
+    printf("  get        : %.3f s\n", best[0]);
+    printf("  get_n      : %.3f s\n", best[1]);
+    printf("  check      : %s\n", (n[0] == n[1] && smap_cstr_eq(&map1, &map2)) ? "ok" : "MISMATCH");
+    c_drop(smap_cstr, &map1, &map2);
+    c_free(text, (N + M)*20);
+    c_free(keys, M*c_sizeof *keys);
+    c_free(raw, N*c_sizeof *raw);
+}
+
+int main(int argc, char* argv[])
+{
+    const isize N = argc > 1 ? atoll(argv[1]) : 8000000;
+    const isize M = argc > 2 ? atoll(argv[2]) : 4000000;
+    if (argc > 3) threads = atoi(argv[3]);
+    bench_int(N, M);
+    bench_str(N, M);
+}
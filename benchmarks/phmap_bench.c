@@ -0,0 +1,147 @@
+// Compares lookups in a static perfect hash map (phmap) with a robin-hood hmap,
+// for uint64_t and short string keys, half of them hits and half misses.
+// Usage: phmap_bench [num_entries] [num_lookups]
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "stc/cstr.h"
+#include "stc/random.h"
+
+#define i_type umap, uint64_t, uint64_t
+#include "stc/hmap.h"
+
+#define i_type upmap, uint64_t, uint64_t
+#include "stc/phmap.h"
+
+#define i_type smap_cstr
+#define i_keypro cstr
+#define i_val uint64_t
+#include "stc/hmap.h"
+
+#define i_type spmap_cstr
+#define i_keypro cstr
+#define i_val uint64_t
+#include "stc/phmap.h"
+
+enum {REPEAT = 3};
+#define min(a, b) ((a) < (b) ? (a) : (b))
+
+static double secs(clock_t t) { return (double)t/CLOCKS_PER_SEC; }
+
+static void bench_int(const isize N, const isize M)
+{
+    crand64 rng = crand64_from(12345);
+    umap_raw* raw = c_new_n(umap_raw, N);
+    uint64_t* keys = c_new_n(uint64_t, M);
+    umap map = {0};
+    upmap pmap = {0};
+    double best[2] = {1e9, 1e9};
+    uint64_t sum[2];
+    clock_t t;
+
+    for (isize i = 0; i < N; ++i)
+        raw[i].first = crand64_uint_r(&rng, 1), raw[i].second = (uint64_t)i;
+    for (isize i = 0; i < M; ++i) // ~half of the keys are present
+        keys[i] = (i & 1) ? raw[crand64_uint_r(&rng, 1) % (uint64_t)N].first : crand64_uint_r(&rng, 1);
+
+    printf("uint64_t keys: %" c_ZI " entries, %" c_ZI " lookups, best of %d\n", N, M, REPEAT);
+    t = clock();
+    umap_put_n(&map, raw, N);
+    printf("  hmap build  : %.3f s\n", secs(clock() - t));
+    t = clock();
+    upmap_build(&pmap, (const upmap_raw*)raw, N);
+    printf("  phmap build : %.3f s, %.2f bits/key\n", secs(clock() - t),
+           (double)(upmap_bucket_count(&pmap)*16 + (pmap.slot_count - pmap.size)*32)/(double)N);
+
+    for (int r = 0; r < REPEAT; ++r) {
+        sum[0] = sum[1] = 0;
+        t = clock();
+        for (isize i = 0; i < M; ++i) {
+            const umap_value* v = umap_get(&map, keys[i]);
+            sum[0] += v ? v->second : 1;
+        }
+        best[0] = min(best[0], secs(clock() - t));
+
+        t = clock();
+        for (isize i = 0; i < M; ++i) {
+            const upmap_value* v = upmap_get(&pmap, keys[i]);
+            sum[1] += v ? v->second : 1;
+        }
+        best[1] = min(best[1], secs(clock() - t));
+    }
+    printf("  hmap get    : %.3f s\n", best[0]);
+    printf("  phmap get   : %.3f s\n", best[1]);
+    printf("  check       : %s\n", sum[0] == sum[1] ? "ok" : "MISMATCH");
+    umap_drop(&map);
+    upmap_drop(&pmap);
+    c_free(raw, N*c_sizeof *raw);
+    c_free(keys, M*c_sizeof *keys);
+}
+
+static void bench_str(const isize N, const isize M)
+{
+    crand64 rng = crand64_from(12345);
+    smap_cstr_raw* raw = c_new_n(smap_cstr_raw, N);
+    const char** keys = c_new_n(const char*, M);
+    char* text = (char *)c_malloc((N + M)*20);
+    smap_cstr map = {0};
+    spmap_cstr pmap = {0};
+    double best[2] = {1e9, 1e9};
+    uint64_t sum[2];
+    isize pos = 0;
+    clock_t t;
+
+    for (isize i = 0; i < N; ++i) {
+        raw[i].first = text + pos, raw[i].second = (uint64_t)i;
+        pos += sprintf(text + pos, "%016" PRIx64, crand64_uint_r(&rng, 1)) + 1;
+    }
+    for (isize i = 0; i < M; ++i) {
+        if (i & 1) {
+            keys[i] = raw[crand64_uint_r(&rng, 1) % (uint64_t)N].first;
+        } else {
+            keys[i] = text + pos;
+            pos += sprintf(text + pos, "%016" PRIx64, crand64_uint_r(&rng, 1)) + 1;
+        }
+    }
+
+    printf("short cstr keys: %" c_ZI " entries, %" c_ZI " lookups, best of %d\n", N, M, REPEAT);
+    t = clock();
+    smap_cstr_put_n(&map, raw, N);
+    printf("  hmap build  : %.3f s\n", secs(clock() - t));
+    t = clock();
+    spmap_cstr_build(&pmap, (const spmap_cstr_raw*)raw, N);
+    printf("  phmap build : %.3f s\n", secs(clock() - t));
+
+    for (int r = 0; r < REPEAT; ++r) {
+        sum[0] = sum[1] = 0;
+        t = clock();
+        for (isize i = 0; i < M; ++i) {
+            const smap_cstr_value* v = smap_cstr_get(&map, keys[i]);
+            sum[0] += v ? v->second : 1;
+        }
+        best[0] = min(best[0], secs(clock() - t));
+
+        t = clock();
+        for (isize i = 0; i < M; ++i) {
+            const spmap_cstr_value* v = spmap_cstr_get(&pmap, keys[i]);
+            sum[1] += v ? v->second : 1;
+        }
+        best[1] = min(best[1], secs(clock() - t));
+    }
+    printf("  hmap get    : %.3f s\n", best[0]);
+    printf("  phmap get   : %.3f s\n", best[1]);
+    printf("  check       : %s\n", sum[0] == sum[1] ? "ok" : "MISMATCH");
+    smap_cstr_drop(&map);
+    spmap_cstr_drop(&pmap);
+    c_free(text, (N + M)*20);
+    c_free(keys, M*c_sizeof *keys);
+    c_free(raw, N*c_sizeof *raw);
+}
+
+int main(int argc, char* argv[])
+{
+    const isize N = argc > 1 ? atoll(argv[1]) : 4000000;
+    const isize M = argc > 2 ? atoll(argv[2]) : 4000000;
+    bench_int(N, M);
+    bench_str(N, M);
+}
@@ -0,0 +1,66 @@
+// Publishing snapshots of a sorted map after each update: the persistent psmap shares the
+// nodes with the snapshot and copies O(log n) nodes per update, while smap clones the map.
+// Also compares lookups. Usage: psmap_bench [num_keys] [num_updates]
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "stc/random.h"
+
+#define i_type pumap, uint64_t, uint64_t
+#include "stc/psmap.h"
+
+#define i_type sumap, uint64_t, uint64_t
+#include "stc/smap.h"
+
+static isize N, U;
+static uint64_t* keys;
+
+static double now(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec*1e-9;
+}
+
+// res: insert all, update + snapshot (per update), lookups of all keys
+#define BENCH(C, nupd, res) do { \
+    C map = {0}, snap = {0}; \
+    uint64_t sum = 0; \
+    double t = now(); \
+    for (isize i = 0; i < N; ++i) \
+        C##_insert(&map, keys[i], (uint64_t)i); \
+    res[0] = now() - t; \
+    t = now(); \
+    for (isize i = 0; i < (nupd); ++i) { \
+        C##_insert_or_assign(&map, keys[(i*7919) % N], (uint64_t)i); \
+        C##_drop(&snap); \
+        snap = C##_clone(map); \
+    } \
+    res[1] = (now() - t)/(double)(nupd); \
+    t = now(); \
+    for (isize i = 0; i < N; ++i) \
+        sum += C##_get(&snap, keys[i])->second; \
+    res[2] = now() - t; \
+    res[3] = (double)(sum & 0xffff); \
+    c_drop(C, &map, &snap); \
+} while (0)
+
+int main(int argc, char* argv[])
+{
+    N = argc > 1 ? atoll(argv[1]) : 1000000;
+    U = argc > 2 ? atoll(argv[2]) : 1000000;
+    crand64 rng = crand64_from(12345);
+    keys = c_new_n(uint64_t, N);
+    for (isize i = 0; i < N; ++i)
+        keys[i] = crand64_uint_r(&rng, 1);
+
+    double p[4], s[4];
+    BENCH(pumap, U, p);
+    BENCH(sumap, U/10000 + 1, s);
+    printf("%" c_ZI " keys, %" c_ZI " updates: seconds\n", N, U);
+    printf("                  psmap        smap\n");
+    printf("insert       %10.3f  %10.3f\n", p[0], s[0]);
+    printf("update+snap  %10.3g  %10.3g  (per update)\n", p[1], s[1]);
+    printf("lookups      %10.3f  %10.3f\n", p[2], s[2]);
+    printf("checksum     %10.0f  %10.0f\n", p[3], s[3]);
+    c_free(keys, N*c_sizeof *keys);
+}
@@ -0,0 +1,88 @@
+// Lookup throughput of the lock-free read path of rcmap compared with the reader-writer
+// locked shards of chmap, for 1 to 32 reader threads, with and without one writer thread
+// that keeps replacing entries. Requires POSIX threads.
+// Usage: rcmap_bench [num_keys] [lookups_per_thread]
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+#include "stc/random.h"
+
+#define i_type rumap, uint64_t, uint64_t
+#include "stc/rcmap.h"
+
+#define i_type cumap, uint64_t, uint64_t
+#include "stc/chmap.h"
+
+enum {MAX_THREADS = 32};
+static isize N, OPS;
+static rumap rmap;
+static cumap cmap;
+static _c_atomic(long) stop;
+
+static double now(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec*1e-9;
+}
+
+static void* read_rcmap(void* arg) {
+    crand64 rng = crand64_from((uint64_t)(intptr_t)arg);
+    uint64_t found = 0;
+    for (isize i = 0; i < OPS; ++i)
+        found += rumap_contains(&rmap, crand64_uint_r(&rng, 1) % (uint64_t)N);
+    return (void*)(intptr_t)found;
+}
+
+static void* read_chmap(void* arg) {
+    crand64 rng = crand64_from((uint64_t)(intptr_t)arg);
+    uint64_t found = 0;
+    for (isize i = 0; i < OPS; ++i)
+        found += cumap_contains(&cmap, crand64_uint_r(&rng, 1) % (uint64_t)N);
+    return (void*)(intptr_t)found;
+}
+
+static void* write_both(void* arg) {
+    crand64 rng = crand64_from((uint64_t)(intptr_t)arg);
+    while (!_c_atomic_load(&stop)) {
+        const uint64_t key = crand64_uint_r(&rng, 1) % (uint64_t)N;
+        rumap_put(&rmap, key, key);
+        cumap_put(&cmap, key, key);
+    }
+    return NULL;
+}
+
+static double bench(void* (*fn)(void*), int nthreads) {
+    pthread_t t[MAX_THREADS];
+    double start = now();
+    for (int i = 0; i < nthreads; ++i)
+        pthread_create(&t[i], NULL, fn, (void*)(intptr_t)(i + 1));
+    for (int i = 0; i < nthreads; ++i)
+        pthread_join(t[i], NULL);
+    return (double)(nthreads*OPS)/(now() - start)*1e-6;
+}
+
+int main(int argc, char* argv[])
+{
+    N = argc > 1 ? atoll(argv[1]) : 1000000;
+    OPS = argc > 2 ? atoll(argv[2]) : 2000000;
+    for (isize i = 0; i < N; i += 2) {
+        rumap_insert(&rmap, (uint64_t)i, 0);
+        cumap_insert(&cmap, (uint64_t)i, 0);
+    }
+    printf("%" c_ZI " keys, %" c_ZI " lookups per thread: Mlookups/s\n", N, OPS);
+    for (int w = 0; w < 2; ++w) {
+        pthread_t writer;
+        if (w) pthread_create(&writer, NULL, write_both, (void*)(intptr_t)99);
+        printf(w ? "with one writer thread:\n" : "read-only:\n");
+        printf("threads     rcmap    chmap\n");
+        for (int n = 1; n <= MAX_THREADS; n *= 2) {
+            double a = bench(read_rcmap, n);
+            double b = bench(read_chmap, n);
+            printf("%7d %9.2f %8.2f\n", n, a, b);
+        }
+        if (w) { _c_atomic_store(&stop, 1); pthread_join(writer, NULL); }
+    }
+    rumap_drop(&rmap);
+    cumap_drop(&cmap);
+}
@@ -0,0 +1,87 @@
+// Throughput of the lock-free skmap skip list compared with an smap behind one mutex, for
+// 1 to 32 threads, with a read-mostly mix (90% lookups, 5% inserts, 5% erases) and an update
+// heavy mix (50% lookups). Requires POSIX threads.
+// Usage: skmap_bench [num_keys] [ops_per_thread]
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+#include "stc/random.h"
+
+#define i_type skumap, uint64_t, uint64_t
+#include "stc/skmap.h"
+
+#define i_type sumap, uint64_t, uint64_t
+#include "stc/smap.h"
+
+enum {MAX_THREADS = 32};
+static isize N, OPS;
+static uint64_t lookup_pct;
+static skumap skm;
+static sumap sm;
+static pthread_mutex_t sm_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static double now(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec*1e-9;
+}
+
+static void* run_skmap(void* arg) {
+    crand64 rng = crand64_from((uint64_t)(intptr_t)arg);
+    uint64_t found = 0;
+    for (isize i = 0; i < OPS; ++i) {
+        const uint64_t r = crand64_uint_r(&rng, 1), key = (r >> 8) % (uint64_t)N, op = r % 100;
+        if (op < lookup_pct) found += skumap_contains(&skm, key);
+        else if (op & 1) skumap_insert(&skm, key, key);
+        else skumap_erase(&skm, key);
+    }
+    return (void*)(intptr_t)found;
+}
+
+static void* run_smap(void* arg) {
+    crand64 rng = crand64_from((uint64_t)(intptr_t)arg);
+    uint64_t found = 0;
+    for (isize i = 0; i < OPS; ++i) {
+        const uint64_t r = crand64_uint_r(&rng, 1), key = (r >> 8) % (uint64_t)N, op = r % 100;
+        pthread_mutex_lock(&sm_lock);
+        if (op < lookup_pct) found += sumap_contains(&sm, key);
+        else if (op & 1) sumap_insert(&sm, key, key);
+        else sumap_erase(&sm, key);
+        pthread_mutex_unlock(&sm_lock);
+    }
+    return (void*)(intptr_t)found;
+}
+
+static double bench(void* (*fn)(void*), int nthreads) {
+    pthread_t t[MAX_THREADS];
+    double start = now();
+    for (int i = 0; i < nthreads; ++i)
+        pthread_create(&t[i], NULL, fn, (void*)(intptr_t)(i + 1));
+    for (int i = 0; i < nthreads; ++i)
+        pthread_join(t[i], NULL);
+    return (double)(nthreads*OPS)/(now() - start)*1e-6;
+}
+
+int main(int argc, char* argv[])
+{
+    N = argc > 1 ? atoll(argv[1]) : 1000000;
+    OPS = argc > 2 ? atoll(argv[2]) : 1000000;
+    for (isize i = 0; i < N; i += 2) {
+        skumap_insert(&skm, (uint64_t)i, 0);
+        sumap_insert(&sm, (uint64_t)i, 0);
+    }
+    printf("%" c_ZI " keys, %" c_ZI " operations per thread: Mops/s\n", N, OPS);
+    for (int m = 0; m < 2; ++m) {
+        lookup_pct = m ? 50 : 90;
+        printf("%d%% lookups:\n", (int)lookup_pct);
+        printf("threads     skmap  smap+mutex\n");
+        for (int n = 1; n <= MAX_THREADS; n *= 2) {
+            double a = bench(run_skmap, n);
+            double b = bench(run_smap, n);
+            printf("%7d %9.2f %11.2f\n", n, a, b);
+        }
+    }
+    skumap_drop(&skm);
+    sumap_drop(&sm);
+}
@@ -0,0 +1,57 @@
+// The small vector svec against vec, for many short-lived vectors of 1 to 2*i_inline
+// elements, as when a parser collects the children of each node.
+// Usage: svec_bench [num_vectors]
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "stc/random.h"
+
+#define i_type ivec, int
+#include "stc/vec.h"
+
+#define i_type isvec, int
+#define i_inline 8
+#include "stc/svec.h"
+
+static isize N;
+static uint8_t* lens;
+
+static double now(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec*1e-9;
+}
+
+// Builds N vectors of the given lengths, and sums their elements
+#define BENCH(C, res) do { \
+    int64_t sum = 0; \
+    double t = now(); \
+    for (isize i = 0; i < N; ++i) { \
+        C v = {0}; \
+        for (int j = 0; j < lens[i]; ++j) \
+            C##_push(&v, j); \
+        for (c_each(it, C, v)) \
+            sum += *it.ref; \
+        C##_drop(&v); \
+    } \
+    res[0] = now() - t; \
+    res[1] = (double)sum; \
+} while (0)
+
+int main(int argc, char* argv[])
+{
+    N = argc > 1 ? atoll(argv[1]) : 20000000;
+    crand64 rng = crand64_from(12345);
+    lens = c_new_n(uint8_t, N);
+    for (isize i = 0; i < N; ++i) // 7 of 8 vectors fit inline
+        lens[i] = (uint8_t)(1 + crand64_uint_r(&rng, 1) % (i % 8 ? 8 : 16));
+
+    double v[2], s[2];
+    BENCH(ivec, v);
+    BENCH(isvec, s);
+    printf("%" c_ZI " vectors of 1 to 16 elements: seconds\n", N);
+    printf("                  vec        svec\n");
+    printf("build+sum   %10.3f  %10.3f\n", v[0], s[0]);
+    printf("checksum    %10.0f  %10.0f\n", v[1], s[1]);
+    c_free(lens, N*c_sizeof *lens);
+}
@@ -0,0 +1,106 @@
+// The tmap radix trie against the smap tree, both with cstr keys: inserts and lookups of
+// path-like keys, prefix scans and longest-prefix matches. Usage: tmap_bench [num_keys]
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "stc/cstr.h"
+#include "stc/random.h"
+
+#define i_type tsmap
+#define i_val int
+#include "stc/tmap.h"
+
+#define i_type ssmap
+#define i_keypro cstr
+#define i_val int
+#include "stc/smap.h"
+
+static isize N;
+static char (*keys)[32];
+
+static double now(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec*1e-9;
+}
+
+static isize tsmap_prefix_count(const tsmap* map, const char* prefix) {
+    isize n = 0;
+    for (tsmap_iter it = tsmap_prefix_begin(map, prefix); it.ref; tsmap_next(&it))
+        ++n;
+    return n;
+}
+
+static isize ssmap_prefix_count(const ssmap* map, const char* prefix) {
+    const size_t len = strlen(prefix);
+    isize n = 0;
+    for (ssmap_iter it = ssmap_lower_bound(map, prefix);
+         it.ref && !strncmp(cstr_str(&it.ref->first), prefix, len); ssmap_next(&it))
+        ++n;
+    return n;
+}
+
+// The smap version of longest_prefix_match: a lookup of each prefix of key, longest first.
+static const ssmap_value* ssmap_longest_prefix_match(const ssmap* map, const char* key) {
+    char buf[40];
+    for (isize n = c_strlen(key); n >= 0; --n) {
+        c_memcpy(buf, key, n);
+        buf[n] = '\0';
+        const ssmap_value* v = ssmap_get(map, buf);
+        if (v) return v;
+    }
+    return NULL;
+}
+
+// res: insert all, lookups of all keys, count the keys under N/100 prefixes, N longest-prefix matches
+#define BENCH(C, res) do { \
+    C map = {0}; \
+    uint64_t sum = 0; \
+    double t = now(); \
+    for (isize i = 0; i < N; ++i) \
+        C##_emplace(&map, keys[i], (int)i); \
+    res[0] = now() - t; \
+    t = now(); \
+    for (isize i = 0; i < N; ++i) \
+        sum += (uint64_t)C##_get(&map, keys[i])->second; \
+    res[1] = now() - t; \
+    t = now(); \
+    for (isize i = 0; i < N; i += 100) { \
+        char pre[32]; \
+        snprintf(pre, sizeof pre, "%.*s", (int)strlen(keys[i]) - 3, keys[i]); \
+        sum += (uint64_t)C##_prefix_count(&map, pre); \
+    } \
+    res[2] = now() - t; \
+    t = now(); \
+    for (isize i = 0; i < N; ++i) { \
+        char k[40]; \
+        snprintf(k, sizeof k, "%s/x", keys[i]); \
+        sum += (uint64_t)C##_longest_prefix_match(&map, k)->second; \
+    } \
+    res[3] = now() - t; \
+    res[4] = (double)(sum & 0xffff); \
+    C##_drop(&map); \
+} while (0)
+
+int main(int argc, char* argv[])
+{
+    N = argc > 1 ? atoll(argv[1]) : 1000000;
+    crand64 rng = crand64_from(12345);
+    keys = (char (*)[32])c_malloc(N*c_sizeof *keys);
+    for (isize i = 0; i < N; ++i) {
+        const uint64_t r = crand64_uint_r(&rng, 1);
+        snprintf(keys[i], sizeof *keys, "/user/%u/item/%u", (unsigned)(r % 10000), (unsigned)(r >> 40));
+    }
+
+    double a[5], b[5];
+    BENCH(tsmap, a);
+    BENCH(ssmap, b);
+    printf("%" c_ZI " keys: seconds\n", N);
+    printf("                  tmap        smap\n");
+    printf("insert       %10.3f  %10.3f\n", a[0], b[0]);
+    printf("lookups      %10.3f  %10.3f\n", a[1], b[1]);
+    printf("prefix scans %10.3f  %10.3f\n", a[2], b[2]);
+    printf("longest pfx  %10.3f  %10.3f\n", a[3], b[3]);
+    printf("checksum     %10.0f  %10.0f\n", a[4], b[4]);
+    c_free(keys, N*c_sizeof *keys);
+}
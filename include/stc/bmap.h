@@ -0,0 +1,772 @@
+/* MIT License
+ *
+ * Copyright (c) 2025 Tyge Løvset
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Sorted/Ordered set and map - implemented as a B+-tree.
+/*
+#include <stdio.h>
+#define i_implement
+#include "stc/cstr.h"
+
+#define i_type BMap  // Sorted map<cstr, double>
+#define i_keypro cstr
+#define i_val double
+#include "stc/bmap.h"
+
+int main(void) {
+    BMap m = {0};
+    BMap_emplace(&m, "Testing one", 1.234);
+    BMap_emplace(&m, "Testing two", 12.34);
+    BMap_emplace(&m, "Testing three", 123.4);
+
+    BMap_value *v = BMap_get(&m, "Testing five"); // NULL
+    double num = *BMap_at(&m, "Testing one");
+    BMap_emplace_or_assign(&m, "Testing three", 1000.0); // update
+    BMap_erase(&m, "Testing two");
+
+    for (c_each(i, BMap, m))
+        printf("map %s: %g\n", cstr_str(&i.ref->first), i.ref->second);
+
+    BMap_drop(&m);
+}
+*/
+#include "priv/linkage.h"
+#include "types.h"
+
+#ifndef STC_BMAP_H_INCLUDED
+#define STC_BMAP_H_INCLUDED
+#include "common.h"
+#include <stdlib.h>
+#define _bmap_node_bytes 256 // approx. size of the entry/key arrays of a node
+#define _bmap_max_height 48
+#endif // STC_BMAP_H_INCLUDED
+
+#ifndef _i_prefix
+  #define _i_prefix bmap_
+#endif
+#ifndef _i_is_set
+  #define _i_is_map
+  #define _i_MAP_ONLY c_true
+  #define _i_SET_ONLY c_false
+  #define _i_keyref(vp) (&(vp)->first)
+#else
+  #define _i_MAP_ONLY c_false
+  #define _i_SET_ONLY c_true
+  #define _i_keyref(vp) (vp)
+#endif
+#define _i_sorted
+#include "priv/template.h"
+#ifndef i_declared
+  _c_DEFTYPES(_c_btree_types, Self, i_key, i_val, _i_MAP_ONLY, _i_SET_ONLY);
+#endif
+
+_i_MAP_ONLY( struct _m_value {
+    _m_key first;
+    _m_mapped second;
+}; )
+
+// Leaves hold the entries in order and are linked. An inner node holds n keys and n + 1
+// children, where key[i] is a bitwise copy of the smallest key in the subtree of child[i + 1].
+#define _m_leaf _c_MEMB(_leaf)
+#define _m_inner _c_MEMB(_inner_)
+#define _i_leafcap (c_sizeof(_m_value) > _bmap_node_bytes/4 ? 4 \
+                    : (int)(_bmap_node_bytes/c_sizeof(_m_value)))
+#define _i_innercap (c_sizeof(_m_key) + c_sizeof(void*) > _bmap_node_bytes/4 ? 4 \
+                     : (int)(_bmap_node_bytes/(c_sizeof(_m_key) + c_sizeof(void*))))
+struct _m_leaf {
+    struct _m_leaf* next;
+    int n;
+    _m_value val[_i_leafcap];
+};
+typedef struct _m_inner {
+    int n;
+    _m_key key[_i_innercap];
+    void* child[_i_innercap + 1];
+} _m_inner;
+
+typedef i_keyraw _m_keyraw;
+typedef i_valraw _m_rmapped;
+typedef _i_SET_ONLY( _m_keyraw )
+        _i_MAP_ONLY( struct { _m_keyraw first; _m_rmapped second; } )
+        _m_raw;
+
+#if !defined i_no_emplace
+STC_API _m_result       _c_MEMB(_emplace)(Self* self, _m_keyraw rkey _i_MAP_ONLY(, _m_rmapped rmapped));
+#endif // !i_no_emplace
+#if !defined i_no_clone
+STC_API Self            _c_MEMB(_clone)(Self tree);
+#endif // !i_no_clone
+STC_API void            _c_MEMB(_drop)(const Self* cself);
+STC_API _m_iter         _c_MEMB(_find)(const Self* self, _m_keyraw rkey);
+STC_API _m_iter         _c_MEMB(_lower_bound)(const Self* self, _m_keyraw rkey);
+STC_API _m_value*       _c_MEMB(_back)(const Self* self);
+STC_API int             _c_MEMB(_erase)(Self* self, _m_keyraw rkey);
+STC_API _m_iter         _c_MEMB(_erase_at)(Self* self, _m_iter it);
+STC_API _m_iter         _c_MEMB(_erase_range)(Self* self, _m_iter it1, _m_iter it2);
+
+STC_INLINE Self         _c_MEMB(_init)(void) { Self tree = {0}; return tree; }
+STC_INLINE bool         _c_MEMB(_is_empty)(const Self* cx) { return cx->size == 0; }
+STC_INLINE isize        _c_MEMB(_size)(const Self* cx) { return cx->size; }
+STC_INLINE bool         _c_MEMB(_contains)(const Self* self, _m_keyraw rkey)
+                            { return _c_MEMB(_find)(self, rkey).ref != NULL; }
+STC_INLINE const _m_value* _c_MEMB(_get)(const Self* self, _m_keyraw rkey)
+                            { return _c_MEMB(_find)(self, rkey).ref; }
+STC_INLINE _m_value*    _c_MEMB(_get_mut)(Self* self, _m_keyraw rkey)
+                            { return _c_MEMB(_find)(self, rkey).ref; }
+STC_INLINE _m_value*    _c_MEMB(_front)(const Self* self)
+                            { return self->size ? &self->first->val[0] : NULL; }
+
+STC_INLINE void _c_MEMB(_clear)(Self* self)
+    { _c_MEMB(_drop)(self); *self = _c_MEMB(_init)(); }
+
+STC_INLINE _m_raw _c_MEMB(_value_toraw)(const _m_value* val) {
+    return _i_SET_ONLY( i_keytoraw(val) )
+           _i_MAP_ONLY( c_literal(_m_raw){i_keytoraw((&val->first)),
+                                          i_valtoraw((&val->second))} );
+}
+
+STC_INLINE void _c_MEMB(_value_drop)(_m_value* val) {
+    i_keydrop(_i_keyref(val));
+    _i_MAP_ONLY( i_valdrop((&val->second)); )
+}
+
+STC_INLINE Self _c_MEMB(_move)(Self *self) {
+    Self m = *self;
+    memset(self, 0, sizeof *self);
+    return m;
+}
+
+STC_INLINE void _c_MEMB(_take)(Self *self, Self unowned) {
+    _c_MEMB(_drop)(self);
+    *self = unowned;
+}
+
+#if !defined i_no_clone
+STC_INLINE _m_value _c_MEMB(_value_clone)(_m_value _val) {
+    *_i_keyref(&_val) = i_keyclone((*_i_keyref(&_val)));
+    _i_MAP_ONLY( _val.second = i_valclone(_val.second); )
+    return _val;
+}
+
+STC_INLINE void _c_MEMB(_copy)(Self *self, const Self other) {
+    if (self->root == other.root)
+        return;
+    _c_MEMB(_drop)(self);
+    *self = _c_MEMB(_clone)(other);
+}
+#endif // !i_no_clone
+
+STC_API _m_result _c_MEMB(_insert_entry_)(Self* self, _m_keyraw rkey);
+
+#ifdef _i_is_map
+    STC_API _m_result _c_MEMB(_insert_or_assign)(Self* self, _m_key key, _m_mapped mapped);
+    #ifndef i_no_emplace
+    STC_API _m_result _c_MEMB(_emplace_or_assign)(Self* self, _m_keyraw rkey, _m_rmapped rmapped);
+    #endif
+
+    STC_INLINE const _m_mapped* _c_MEMB(_at)(const Self* self, _m_keyraw rkey)
+        { return &_c_MEMB(_find)(self, rkey).ref->second; }
+
+    STC_INLINE _m_mapped* _c_MEMB(_at_mut)(Self* self, _m_keyraw rkey)
+        { return &_c_MEMB(_find)(self, rkey).ref->second; }
+#endif // _i_is_map
+
+STC_INLINE _m_iter _c_MEMB(_begin)(const Self* self) {
+    _m_iter it = {NULL, self->first, 0};
+    if (self->size) it.ref = &self->first->val[0];
+    return it;
+}
+
+STC_INLINE _m_iter _c_MEMB(_end)(const Self* self)
+    { (void)self; _m_iter it = {NULL, NULL, 0}; return it; }
+
+STC_INLINE void _c_MEMB(_next)(_m_iter* it) {
+    if (++it->_i < it->_leaf->n)
+        it->ref = &it->_leaf->val[it->_i];
+    else if ((it->_leaf = it->_leaf->next) != NULL)
+        it->_i = 0, it->ref = &it->_leaf->val[0];
+    else
+        it->ref = NULL;
+}
+
+STC_INLINE _m_iter _c_MEMB(_advance)(_m_iter it, size_t n) {
+    while (it.ref && n) { // skip whole leaves
+        const size_t rest = (size_t)(it._leaf->n - it._i);
+        if (n < rest) {
+            it._i += (int)n;
+            it.ref = &it._leaf->val[it._i];
+            break;
+        }
+        n -= rest;
+        it._i = it._leaf->n - 1;
+        _c_MEMB(_next)(&it);
+    }
+    return it;
+}
+
+#if defined _i_has_eq
+STC_INLINE bool
+_c_MEMB(_eq)(const Self* self, const Self* other) {
+    if (_c_MEMB(_size)(self) != _c_MEMB(_size)(other)) return false;
+    _m_iter i = _c_MEMB(_begin)(self), j = _c_MEMB(_begin)(other);
+    for (; i.ref; _c_MEMB(_next)(&i), _c_MEMB(_next)(&j)) {
+        const _m_keyraw _rx = i_keytoraw(_i_keyref(i.ref)), _ry = i_keytoraw(_i_keyref(j.ref));
+        if (!(i_eq((&_rx), (&_ry)))) return false;
+    }
+    return true;
+}
+#endif
+
+STC_INLINE _m_result
+_c_MEMB(_insert)(Self* self, _m_key _key _i_MAP_ONLY(, _m_mapped _mapped)) {
+    _m_result _res = _c_MEMB(_insert_entry_)(self, i_keytoraw((&_key)));
+    if (_res.inserted)
+        { *_i_keyref(_res.ref) = _key; _i_MAP_ONLY( _res.ref->second = _mapped; )}
+    else
+        { i_keydrop((&_key)); _i_MAP_ONLY( i_valdrop((&_mapped)); )}
+    return _res;
+}
+
+STC_INLINE _m_value* _c_MEMB(_push)(Self* self, _m_value _val) {
+    _m_result _res = _c_MEMB(_insert_entry_)(self, i_keytoraw(_i_keyref(&_val)));
+    if (_res.inserted)
+        *_res.ref = _val;
+    else
+        _c_MEMB(_value_drop)(&_val);
+    return _res.ref;
+}
+
+#ifdef _i_is_map
+STC_INLINE _m_result _c_MEMB(_put)(Self* self, _m_keyraw rkey, _m_rmapped rmapped) {
+    #ifdef i_no_emplace
+        return _c_MEMB(_insert_or_assign)(self, rkey, rmapped);
+    #else
+        return _c_MEMB(_emplace_or_assign)(self, rkey, rmapped);
+    #endif
+}
+#endif
+
+STC_INLINE void _c_MEMB(_put_n)(Self* self, const _m_raw* raw, isize n) {
+    while (n--)
+        #if defined _i_is_set && defined i_no_emplace
+            _c_MEMB(_insert)(self, *raw++);
+        #elif defined _i_is_set
+            _c_MEMB(_emplace)(self, *raw++);
+        #else
+            _c_MEMB(_put)(self, raw->first, raw->second), ++raw;
+        #endif
+}
+
+STC_INLINE Self _c_MEMB(_with_n)(const _m_raw* raw, isize n)
+    { Self cx = {0}; _c_MEMB(_put_n)(&cx, raw, n); return cx; }
+
+/* -------------------------- IMPLEMENTATION ------------------------- */
+#if defined i_implement
+
+// Index of the child of nd whose subtree may hold rkey: the number of keys <= rkey.
+static int
+_c_MEMB(_child_)(const _m_inner* nd, const _m_keyraw* rkey) {
+    int lo = 0, hi = nd->n;
+    while (lo < hi) {
+        const int mid = (lo + hi)/2;
+        const _m_keyraw _raw = i_keytoraw((&nd->key[mid]));
+        if (i_cmp((&_raw), rkey) <= 0) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+// Position of the first entry >= rkey in leaf; *found tells whether it equals rkey.
+static int
+_c_MEMB(_leaf_pos_)(const _m_leaf* leaf, const _m_keyraw* rkey, bool* found) {
+    int lo = 0, hi = leaf->n;
+    while (lo < hi) {
+        const int mid = (lo + hi)/2;
+        const _m_keyraw _raw = i_keytoraw(_i_keyref(&leaf->val[mid]));
+        if (i_cmp((&_raw), rkey) < 0) lo = mid + 1;
+        else hi = mid;
+    }
+    if (lo < leaf->n) {
+        const _m_keyraw _raw = i_keytoraw(_i_keyref(&leaf->val[lo]));
+        *found = i_eq((&_raw), rkey);
+    } else {
+        *found = false;
+    }
+    return lo;
+}
+
+static _m_leaf*
+_c_MEMB(_find_leaf_)(const Self* self, const _m_keyraw* rkey) {
+    void* nd = self->root;
+    for (int h = self->height; h > 0; --h)
+        nd = ((_m_inner*)nd)->child[_c_MEMB(_child_)((_m_inner*)nd, rkey)];
+    return (_m_leaf*)nd;
+}
+
+STC_DEF _m_iter
+_c_MEMB(_find)(const Self* self, _m_keyraw rkey) {
+    _m_iter it = {NULL};
+    if (self->size == 0)
+        return it;
+    bool found;
+    it._leaf = _c_MEMB(_find_leaf_)(self, &rkey);
+    it._i = _c_MEMB(_leaf_pos_)(it._leaf, &rkey, &found);
+    if (found)
+        it.ref = &it._leaf->val[it._i];
+    return it;
+}
+
+STC_DEF _m_iter
+_c_MEMB(_lower_bound)(const Self* self, _m_keyraw rkey) {
+    _m_iter it = {NULL};
+    if (self->size == 0)
+        return it;
+    bool found;
+    it._leaf = _c_MEMB(_find_leaf_)(self, &rkey);
+    it._i = _c_MEMB(_leaf_pos_)(it._leaf, &rkey, &found);
+    if (it._i < it._leaf->n)
+        it.ref = &it._leaf->val[it._i];
+    else if ((it._leaf = it._leaf->next) != NULL)
+        it._i = 0, it.ref = &it._leaf->val[0];
+    return it;
+}
+
+STC_DEF _m_value*
+_c_MEMB(_back)(const Self* self) {
+    if (self->size == 0)
+        return NULL;
+    void* nd = self->root;
+    for (int h = self->height; h > 0; --h)
+        nd = ((_m_inner*)nd)->child[((_m_inner*)nd)->n];
+    return &((_m_leaf*)nd)->val[((_m_leaf*)nd)->n - 1];
+}
+
+#ifdef _i_is_map
+    STC_DEF _m_result
+    _c_MEMB(_insert_or_assign)(Self* self, _m_key _key, _m_mapped _mapped) {
+        _m_result _res = _c_MEMB(_insert_entry_)(self, i_keytoraw((&_key)));
+        _m_mapped* _mp = _res.ref ? &_res.ref->second : &_mapped;
+        if (_res.inserted)
+            _res.ref->first = _key;
+        else
+            { i_keydrop((&_key)); i_valdrop(_mp); }
+        *_mp = _mapped;
+        return _res;
+    }
+
+    #if !defined i_no_emplace
+    STC_DEF _m_result
+    _c_MEMB(_emplace_or_assign)(Self* self, _m_keyraw rkey, _m_rmapped rmapped) {
+        _m_result _res = _c_MEMB(_insert_entry_)(self, rkey);
+        if (_res.inserted)
+            _res.ref->first = i_keyfrom(rkey);
+        else {
+            if (_res.ref == NULL) return _res;
+            i_valdrop((&_res.ref->second));
+        }
+        _res.ref->second = i_valfrom(rmapped);
+        return _res;
+    }
+    #endif // !i_no_emplace
+#endif // !_i_is_map
+
+// Make room for a new entry at pos in the full leaf by moving the upper entries to right.
+// The new entry is never first in right, so that its (still unassigned) key is not copied
+// to the parent. Returns the slot of the new entry.
+static _m_value*
+_c_MEMB(_split_leaf_)(_m_leaf* leaf, _m_leaf* right, int pos) {
+    int m = (_i_leafcap + 1)/2; // entries of the left leaf, counting the new one
+    if (pos == _i_leafcap && leaf->next == NULL)
+        m = _i_leafcap - 1; // appending to the last leaf: keep the left leaf nearly full
+    else if (pos == m)
+        ++m;
+    right->next = leaf->next;
+    leaf->next = right;
+    leaf->n = m;
+    if (pos < m) {
+        right->n = _i_leafcap + 1 - m;
+        c_memcpy(right->val, leaf->val + m - 1, right->n*c_sizeof(_m_value));
+        c_memmove(leaf->val + pos + 1, leaf->val + pos, (m - 1 - pos)*c_sizeof(_m_value));
+        return &leaf->val[pos];
+    }
+    right->n = _i_leafcap + 1 - m;
+    c_memcpy(right->val, leaf->val + m, (pos - m)*c_sizeof(_m_value));
+    c_memcpy(right->val + pos - m + 1, leaf->val + pos, (_i_leafcap - pos)*c_sizeof(_m_value));
+    return &right->val[pos - m];
+}
+
+// Insert sep and child after child ci of the full node p, moving the upper half to right.
+// Returns the key that goes up to the parent.
+static _m_key
+_c_MEMB(_split_inner_)(_m_inner* p, _m_inner* right, int ci, _m_key sep, void* child) {
+    _m_key key[_i_innercap + 1];
+    void* chld[_i_innercap + 2];
+    c_memcpy(key, p->key, ci*c_sizeof(_m_key));
+    key[ci] = sep;
+    c_memcpy(key + ci + 1, p->key + ci, (_i_innercap - ci)*c_sizeof(_m_key));
+    c_memcpy(chld, p->child, (ci + 1)*c_sizeof(void*));
+    chld[ci + 1] = child;
+    c_memcpy(chld + ci + 2, p->child + ci + 1, (_i_innercap - ci)*c_sizeof(void*));
+    const int m = (_i_innercap + 1)/2; // keys of the left node
+    p->n = m;
+    c_memcpy(p->key, key, m*c_sizeof(_m_key));
+    c_memcpy(p->child, chld, (m + 1)*c_sizeof(void*));
+    right->n = _i_innercap - m;
+    c_memcpy(right->key, key + m + 1, right->n*c_sizeof(_m_key));
+    c_memcpy(right->child, chld + m + 1, (right->n + 1)*c_sizeof(void*));
+    return key[m];
+}
+
+STC_DEF _m_result
+_c_MEMB(_insert_entry_)(Self* self, _m_keyraw rkey) {
+    _m_result res = {NULL};
+    struct { _m_inner* nd; int ci; } path[_bmap_max_height];
+    if (self->root == NULL) {
+        _m_leaf* leaf = _i_malloc(_m_leaf, 1);
+        if (leaf == NULL)
+            return res;
+        leaf->next = NULL, leaf->n = 0;
+        self->root = self->first = leaf, self->height = 0;
+    }
+    void* nd = self->root;
+    for (int h = 0; h < self->height; ++h) {
+        path[h].nd = (_m_inner*)nd;
+        path[h].ci = _c_MEMB(_child_)(path[h].nd, &rkey);
+        nd = path[h].nd->child[path[h].ci];
+    }
+    _m_leaf* leaf = (_m_leaf*)nd;
+    bool found;
+    const int pos = _c_MEMB(_leaf_pos_)(leaf, &rkey, &found);
+    if (found) {
+        res.ref = &leaf->val[pos];
+        return res;
+    }
+    if (leaf->n < _i_leafcap) {
+        c_memmove(leaf->val + pos + 1, leaf->val + pos, (leaf->n - pos)*c_sizeof(_m_value));
+        ++leaf->n;
+        res.ref = &leaf->val[pos];
+    } else {
+        // Allocate the new nodes first: one per full node on the path, and maybe a new root.
+        int top = self->height - 1, k = 0;
+        while (top >= 0 && path[top].nd->n == _i_innercap)
+            --top;
+        _m_inner* spare[_bmap_max_height + 1];
+        _m_leaf* right = _i_malloc(_m_leaf, 1);
+        bool ok = right != NULL;
+        for (const int n = self->height - 1 - top + (top < 0); ok && k < n; ++k)
+            ok = (spare[k] = _i_malloc(_m_inner, 1)) != NULL;
+        if (!ok) {
+            while (k--) i_free(spare[k], c_sizeof(_m_inner));
+            i_free(right, c_sizeof(_m_leaf));
+            return res;
+        }
+        res.ref = _c_MEMB(_split_leaf_)(leaf, right, pos);
+        _m_key sep = *_i_keyref(&right->val[0]);
+        void* child = right;
+        for (int h = self->height - 1; h > top; --h) { // split the full parents
+            _m_inner* r = spare[--k];
+            sep = _c_MEMB(_split_inner_)(path[h].nd, r, path[h].ci, sep, child);
+            child = r;
+        }
+        if (top >= 0) {
+            _m_inner* p = path[top].nd;
+            const int ci = path[top].ci;
+            c_memmove(p->key + ci + 1, p->key + ci, (p->n - ci)*c_sizeof(_m_key));
+            c_memmove(p->child + ci + 2, p->child + ci + 1, (p->n - ci)*c_sizeof(void*));
+            p->key[ci] = sep, p->child[ci + 1] = child;
+            ++p->n;
+        } else { // the root was split: grow a level
+            _m_inner* root = spare[--k];
+            root->n = 1;
+            root->key[0] = sep;
+            root->child[0] = self->root, root->child[1] = child;
+            self->root = root;
+            ++self->height;
+        }
+    }
+    res.inserted = true;
+    ++self->size;
+    return res;
+}
+
+// Rebalance the underfull node nd, child ci of p, with a sibling: borrow an entry or key
+// from it, or merge the two. Returns true if p lost a key.
+static bool
+_c_MEMB(_fix_leaf_)(_m_inner* p, int ci) {
+    _m_leaf* leaf = (_m_leaf*)p->child[ci];
+    _m_leaf* left = ci > 0 ? (_m_leaf*)p->child[ci - 1] : NULL;
+    _m_leaf* right = ci < p->n ? (_m_leaf*)p->child[ci + 1] : NULL;
+    if (left && left->n > _i_leafcap/2) {
+        c_memmove(leaf->val + 1, leaf->val, leaf->n*c_sizeof(_m_value));
+        leaf->val[0] = left->val[--left->n];
+        ++leaf->n;
+        p->key[ci - 1] = *_i_keyref(&leaf->val[0]);
+        return false;
+    }
+    if (right && right->n > _i_leafcap/2) {
+        leaf->val[leaf->n++] = right->val[0];
+        c_memmove(right->val, right->val + 1, --right->n*c_sizeof(_m_value));
+        p->key[ci] = *_i_keyref(&right->val[0]);
+        return false;
+    }
+    if (left) // merge leaf into left
+        right = leaf, leaf = left, --ci;
+    c_memcpy(leaf->val + leaf->n, right->val, right->n*c_sizeof(_m_value));
+    leaf->n += right->n;
+    leaf->next = right->next;
+    i_free(right, c_sizeof(_m_leaf));
+    c_memmove(p->key + ci, p->key + ci + 1, (p->n - ci - 1)*c_sizeof(_m_key));
+    c_memmove(p->child + ci + 1, p->child + ci + 2, (p->n - ci - 1)*c_sizeof(void*));
+    --p->n;
+    return true;
+}
+
+static bool
+_c_MEMB(_fix_inner_)(_m_inner* p, int ci) {
+    _m_inner* nd = (_m_inner*)p->child[ci];
+    _m_inner* left = ci > 0 ? (_m_inner*)p->child[ci - 1] : NULL;
+    _m_inner* right = ci < p->n ? (_m_inner*)p->child[ci + 1] : NULL;
+    if (left && left->n > _i_innercap/2) { // rotate right through p
+        c_memmove(nd->key + 1, nd->key, nd->n*c_sizeof(_m_key));
+        c_memmove(nd->child + 1, nd->child, (nd->n + 1)*c_sizeof(void*));
+        nd->key[0] = p->key[ci - 1];
+        nd->child[0] = left->child[left->n];
+        ++nd->n;
+        p->key[ci - 1] = left->key[--left->n];
+        return false;
+    }
+    if (right && right->n > _i_innercap/2) { // rotate left through p
+        nd->key[nd->n] = p->key[ci];
+        nd->child[++nd->n] = right->child[0];
+        p->key[ci] = right->key[0];
+        --right->n;
+        c_memmove(right->key, right->key + 1, right->n*c_sizeof(_m_key));
+        c_memmove(right->child, right->child + 1, (right->n + 1)*c_sizeof(void*));
+        return false;
+    }
+    if (left) // merge nd into left
+        right = nd, nd = left, --ci;
+    nd->key[nd->n] = p->key[ci];
+    c_memcpy(nd->key + nd->n + 1, right->key, right->n*c_sizeof(_m_key));
+    c_memcpy(nd->child + nd->n + 1, right->child, (right->n + 1)*c_sizeof(void*));
+    nd->n += right->n + 1;
+    i_free(right, c_sizeof(_m_inner));
+    c_memmove(p->key + ci, p->key + ci + 1, (p->n - ci - 1)*c_sizeof(_m_key));
+    c_memmove(p->child + ci + 1, p->child + ci + 2, (p->n - ci - 1)*c_sizeof(void*));
+    --p->n;
+    return true;
+}
+
+STC_DEF int
+_c_MEMB(_erase)(Self* self, _m_keyraw rkey) {
+    struct { _m_inner* nd; int ci; } path[_bmap_max_height];
+    _m_key* sep = NULL; // the copy of rkey in an inner node, if any
+    if (self->size == 0)
+        return 0;
+    void* nd = self->root;
+    for (int h = 0; h < self->height; ++h) {
+        _m_inner* in = (_m_inner*)nd;
+        const int ci = _c_MEMB(_child_)(in, &rkey);
+        if (ci > 0) {
+            const _m_keyraw _raw = i_keytoraw((&in->key[ci - 1]));
+            if (i_eq((&_raw), (&rkey))) sep = &in->key[ci - 1];
+        }
+        path[h].nd = in, path[h].ci = ci;
+        nd = in->child[ci];
+    }
+    _m_leaf* leaf = (_m_leaf*)nd;
+    bool found;
+    const int pos = _c_MEMB(_leaf_pos_)(leaf, &rkey, &found);
+    if (!found)
+        return 0;
+    _c_MEMB(_value_drop)(&leaf->val[pos]);
+    c_memmove(leaf->val + pos, leaf->val + pos + 1, (--leaf->n - pos)*c_sizeof(_m_value));
+    --self->size;
+    if (sep != NULL) { // rkey was the smallest key of a subtree: copy its successor
+        if (leaf->n > 0)
+            *sep = *_i_keyref(&leaf->val[0]);
+        else if (leaf->next != NULL)
+            *sep = *_i_keyref(&leaf->next->val[0]);
+    }
+    if (self->height == 0) {
+        if (leaf->n == 0) {
+            i_free(leaf, c_sizeof(_m_leaf));
+            self->root = self->first = NULL;
+        }
+        return 1;
+    }
+    int h = self->height - 1;
+    if (leaf->n >= _i_leafcap/2 || !_c_MEMB(_fix_leaf_)(path[h].nd, path[h].ci))
+        return 1;
+    for (; h > 0 && path[h].nd->n < _i_innercap/2; --h)
+        if (!_c_MEMB(_fix_inner_)(path[h - 1].nd, path[h - 1].ci))
+            return 1;
+    _m_inner* root = (_m_inner*)self->root;
+    if (root->n == 0) { // shrink a level
+        self->root = root->child[0];
+        --self->height;
+        i_free(root, c_sizeof(_m_inner));
+    }
+    return 1;
+}
+
+STC_DEF _m_iter
+_c_MEMB(_erase_at)(Self* self, _m_iter it) {
+    const _m_keyraw _raw = i_keytoraw(_i_keyref(it.ref));
+    _c_MEMB(_next)(&it);
+    if (it.ref == NULL) {
+        _c_MEMB(_erase)(self, _raw);
+        return it;
+    }
+    _m_key _nxt = *_i_keyref(it.ref); // bitwise copy: stays valid when the entry is moved
+    _c_MEMB(_erase)(self, _raw);
+    return _c_MEMB(_lower_bound)(self, i_keytoraw((&_nxt)));
+}
+
+STC_DEF _m_iter
+_c_MEMB(_erase_range)(Self* self, _m_iter it1, _m_iter it2) {
+    if (it2.ref == NULL) {
+        while (it1.ref != NULL)
+            it1 = _c_MEMB(_erase_at)(self, it1);
+        return it1;
+    }
+    _m_key _k2 = *_i_keyref(it2.ref);
+    const _m_keyraw _r2 = i_keytoraw((&_k2));
+    for (;;) {
+        const _m_keyraw _r1 = i_keytoraw(_i_keyref(it1.ref));
+        if (i_eq((&_r1), (&_r2)))
+            return it1;
+        it1 = _c_MEMB(_erase_at)(self, it1);
+    }
+}
+
+static void
+_c_MEMB(_drop_inner_)(void* nd, int height) {
+    if (height > 0) {
+        _m_inner* in = (_m_inner*)nd;
+        for (int c = 0; c <= in->n; ++c)
+            _c_MEMB(_drop_inner_)(in->child[c], height - 1);
+        i_free(in, c_sizeof(_m_inner));
+    }
+}
+
+// Build the inner levels over the leaves from self->first, which must hold the entries in order.
+static bool
+_c_MEMB(_build_inner_)(Self* self, isize nleaves) {
+    struct _c_MEMB(_lvl_) { void* nd; _m_key* min; };
+    struct _c_MEMB(_lvl_)* lvl = _i_malloc(struct _c_MEMB(_lvl_), nleaves);
+    if (lvl == NULL)
+        return false;
+    isize n = 0;
+    for (_m_leaf* leaf = self->first; leaf; leaf = leaf->next, ++n)
+        lvl[n].nd = leaf, lvl[n].min = _i_keyref(&leaf->val[0]);
+    self->height = 0;
+    bool ok = true;
+    while (ok && n > 1) { // group the nodes of a level evenly under new parents
+        const isize np = (n + _i_innercap)/(_i_innercap + 1);
+        isize j = 0;
+        for (isize p = 0; p < np; ++p) {
+            const isize end = n*(p + 1)/np;
+            _m_inner* in = _i_malloc(_m_inner, 1);
+            if (in == NULL) { // free the inner nodes made so far; the leaves are kept
+                for (isize q = 0; q < p; ++q) _c_MEMB(_drop_inner_)(lvl[q].nd, self->height + 1);
+                for (; j < n; ++j) _c_MEMB(_drop_inner_)(lvl[j].nd, self->height);
+                ok = false;
+                break;
+            }
+            in->n = (int)(end - j - 1);
+            _m_key* min = lvl[j].min;
+            for (int c = 0; j < end; ++j, ++c) {
+                in->child[c] = lvl[j].nd;
+                if (c) in->key[c - 1] = *lvl[j].min;
+            }
+            lvl[p].nd = in, lvl[p].min = min;
+        }
+        n = np;
+        ++self->height;
+    }
+    if (!ok)
+        self->height = 0;
+    self->root = ok ? lvl[0].nd : self->first;
+    i_free(lvl, nleaves*c_sizeof *lvl);
+    return ok;
+}
+
+#if !defined i_no_clone
+STC_DEF Self
+_c_MEMB(_clone)(Self tree) {
+    Self clone = {0};
+    _m_leaf **tail = &clone.first;
+    isize nleaves = 0;
+    for (const _m_leaf* src = tree.first; tree.size && src; src = src->next, ++nleaves) {
+        _m_leaf* leaf = _i_malloc(_m_leaf, 1);
+        if (leaf == NULL) break;
+        for (leaf->n = 0; leaf->n < src->n; ++leaf->n)
+            leaf->val[leaf->n] = _c_MEMB(_value_clone)(src->val[leaf->n]);
+        leaf->next = NULL;
+        *tail = leaf, tail = &leaf->next;
+        clone.size += leaf->n;
+    }
+    if (clone.size == tree.size && nleaves && _c_MEMB(_build_inner_)(&clone, nleaves))
+        return clone;
+    _c_MEMB(_drop)(&clone); // out of memory
+    return _c_MEMB(_init)();
+}
+#endif // !i_no_clone
+
+#if !defined i_no_emplace
+STC_DEF _m_result
+_c_MEMB(_emplace)(Self* self, _m_keyraw rkey _i_MAP_ONLY(, _m_rmapped rmapped)) {
+    _m_result res = _c_MEMB(_insert_entry_)(self, rkey);
+    if (res.inserted) {
+        *_i_keyref(res.ref) = i_keyfrom(rkey);
+        _i_MAP_ONLY(res.ref->second = i_valfrom(rmapped);)
+    }
+    return res;
+}
+#endif // i_no_emplace
+
+STC_DEF void
+_c_MEMB(_drop)(const Self* cself) {
+    Self* self = (Self*)cself;
+    _c_MEMB(_drop_inner_)(self->root, self->height);
+    for (_m_leaf* leaf = self->first, *next; leaf; leaf = next) {
+        for (int i = 0; i < leaf->n; ++i)
+            _c_MEMB(_value_drop)(&leaf->val[i]);
+        next = leaf->next;
+        i_free(leaf, c_sizeof(_m_leaf));
+    }
+}
+
+#endif // i_implement
+#undef _m_leaf
+#undef _m_inner
+#undef _i_leafcap
+#undef _i_innercap
+#undef _i_is_set
+#undef _i_is_map
+#undef _i_sorted
+#undef _i_keyref
+#undef _i_MAP_ONLY
+#undef _i_SET_ONLY
+#include "priv/linkage2.h"
+#include "priv/template2.h"
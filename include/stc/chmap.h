@@ -0,0 +1,64 @@
+/* MIT License
+ *
+ * Copyright (c) 2025 Tyge Løvset
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Concurrent hashmap - keys are partitioned by hash into i_shards hmaps, each guarded by a
+// reader-writer spin lock. Element references never escape a lock: values are copied out by
+// get(), or accessed in a callback by read(), update() and emplace_update().
+/*
+#include <stdio.h>
+#include "stc/cstr.h"
+
+#define i_type WordCount
+#define i_keypro cstr
+#define i_val int
+#include "stc/chmap.h"
+
+static void incr(WordCount_value* v, void* arg) { v->second += *(int *)arg; }
+
+int main(void) {
+    WordCount wc = {0}; // may be shared by many threads
+    int one = 1;
+    for (c_items(w, const char*, {"a", "b", "a", "c", "a"}))
+        WordCount_emplace_update(&wc, *w.ref, 0, incr, &one);
+
+    int n;
+    if (WordCount_get(&wc, "a", &n))
+        printf("a: %d\n", n);
+    WordCount_drop(&wc);
+}
+*/
+#include "priv/sync_prv.h"
+
+#if defined i_stats // lookups under the shared lock would all write the counters of the shard
+  #error "i_stats can not be used with chmap"
+#endif
+#ifndef i_shards
+  #define i_shards 64
+#endif
+#if defined i_type
+  #define _i_chmap c_GETARG(1, i_type)
+#else
+  #define _i_chmap c_JOIN(chmap_, i_tag)
+#endif
+#define Self c_JOIN(_i_chmap, _shard) // the hmap of each shard
+#include "hmap.h"
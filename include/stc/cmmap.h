@@ -0,0 +1,139 @@
+/* MIT License
+ *
+ * Copyright (c) 2025 Tyge Løvset
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// cmmap is a read-only memory mapping of a file, e.g. an image written by hmap_X_write_image().
+// cmmap_str is a string stored in such an image: it refers to its characters by an offset
+// relative to its own address, so it is valid wherever the image is mapped.
+/*
+#include "stc/cmmap.h"
+
+int main(void) {
+    cmmap file = cmmap_open("data.bin");
+    if (file.data == NULL) return 1;
+    printf("%.*s", (int)file.size, file.data);
+    cmmap_close(&file);
+}
+*/
+#ifndef STC_CMMAP_H_INCLUDED
+#define STC_CMMAP_H_INCLUDED
+
+#include "common.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#if defined _WIN32
+  #ifndef WIN32_LEAN_AND_MEAN
+    #define WIN32_LEAN_AND_MEAN
+  #endif
+  #include <windows.h>
+  #define STC_CMMAP_WIN32
+#elif defined __unix__ || defined __APPLE__
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+  #define STC_CMMAP_POSIX
+#endif
+
+typedef struct {
+    const char* data; // NULL if the file could not be opened/mapped
+    isize size;
+    void* _handle;    // file mapping handle (win32), or the malloc'ed copy of the file (no mmap)
+} cmmap;
+
+typedef struct { int64_t off, size; } cmmap_str;
+typedef const char* cmmap_str_raw;
+#define cmmap_str_raw_cmp(xp, yp) cstr_raw_cmp(xp, yp)
+#define cmmap_str_raw_eq(xp, yp) cstr_raw_eq(xp, yp)
+#define cmmap_str_raw_hash(p) cstr_raw_hash(p)
+#define cmmap_str_clone(s) c_default_clone(s)
+#define cmmap_str_drop(self) c_default_drop(self)
+
+STC_INLINE const char* cmmap_str_str(const cmmap_str* self)
+    { return (const char*)self + self->off; }
+STC_INLINE const char* cmmap_str_toraw(const cmmap_str* self)
+    { return (const char*)self + self->off; }
+STC_INLINE isize cmmap_str_size(const cmmap_str* self)
+    { return (isize)self->size; }
+STC_INLINE size_t cmmap_str_hash(const cmmap_str* self)
+    { return c_basehash_n(cmmap_str_str(self), (isize)self->size); }
+
+// An image string can not be created from outside the image: containers of cmmap_str are read-only.
+STC_INLINE cmmap_str cmmap_str_from(const char* str)
+    { (void)str; c_assert(!"cmmap_str is read-only"); return c_literal(cmmap_str){0}; }
+
+STC_INLINE cmmap cmmap_open(const char* path) {
+    cmmap self = {0};
+#if defined STC_CMMAP_WIN32
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, NULL);
+    LARGE_INTEGER size;
+    if (file == INVALID_HANDLE_VALUE) return self;
+    if (GetFileSizeEx(file, &size) && size.QuadPart > 0) {
+        HANDLE map = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (map != NULL) {
+            self.data = (const char*)MapViewOfFile(map, FILE_MAP_READ, 0, 0, 0);
+            if (self.data) self.size = (isize)size.QuadPart, self._handle = map;
+            else CloseHandle(map);
+        }
+    }
+    CloseHandle(file);
+#elif defined STC_CMMAP_POSIX
+    struct stat st;
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return self;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        void* p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (p != MAP_FAILED) self.data = (const char*)p, self.size = (isize)st.st_size;
+    }
+    close(fd);
+#else
+    FILE* fp = fopen(path, "rb");
+    if (fp == NULL) return self;
+    if (fseek(fp, 0, SEEK_END) == 0) {
+        long n = ftell(fp);
+        char* buf = n > 0 ? (char*)c_malloc(n) : NULL;
+        if (buf != NULL && fseek(fp, 0, SEEK_SET) == 0 && (long)fread(buf, 1, (size_t)n, fp) == n)
+            self.data = buf, self.size = n, self._handle = buf;
+        else if (buf != NULL)
+            c_free(buf, n);
+    }
+    fclose(fp);
+#endif
+    return self;
+}
+
+STC_INLINE void cmmap_close(cmmap* self) {
+    if (self->data == NULL) return;
+#if defined STC_CMMAP_WIN32
+    UnmapViewOfFile(self->data);
+    CloseHandle((HANDLE)self->_handle);
+#elif defined STC_CMMAP_POSIX
+    munmap((void*)self->data, (size_t)self->size);
+#else
+    c_free(self->_handle, self->size);
+#endif
+    self->data = NULL, self->size = 0, self->_handle = NULL;
+}
+
+#endif // STC_CMMAP_H_INCLUDED
@@ -52,6 +52,23 @@ typedef ptrdiff_t       isize;
 #else
     #define STC_INLINE static inline
 #endif
+#if defined __GNUC__ && !defined __clang__ && __GNUC__ >= 8
+    #define STC_NOINLINE static __attribute__((noipa, unused))
+#elif defined __GNUC__ || defined __clang__
+    #define STC_NOINLINE static __attribute__((noinline, unused))
+#elif defined _MSC_VER
+    #define STC_NOINLINE static __declspec(noinline)
+#else
+    #define STC_NOINLINE static
+#endif
+#if defined __GNUC__ || defined __clang__
+    #define c_prefetch(p) __builtin_prefetch(p)
+#elif defined _MSC_VER && (defined _M_X64 || defined _M_IX86)
+    #include <xmmintrin.h>
+    #define c_prefetch(p) _mm_prefetch((const char*)(p), _MM_HINT_T0)
+#else
+    #define c_prefetch(p) ((void)(p))
+#endif
 #define c_ZI PRIiPTR
 #define c_ZU PRIuPTR
 #define c_NPOS INTPTR_MAX
@@ -245,31 +262,133 @@ typedef const char* cstr_raw;
 
 // General functions
 
+// Hashing of byte sequences is based on wyhash (public domain, Wang Yi): 64x64=>128-bit
+// multiply-and-fold mixing of 16 bytes per step, with three independent lanes for long keys.
+#if defined __SIZEOF_INT128__
+    __extension__ typedef unsigned __int128 _c_uint128;
+    STC_INLINE void _c_mum(uint64_t* a, uint64_t* b) {
+        _c_uint128 r = (_c_uint128)*a * *b;
+        *a = (uint64_t)r; *b = (uint64_t)(r >> 64);
+    }
+#elif defined _MSC_VER && defined _M_X64
+    #include <intrin.h>
+    STC_INLINE void _c_mum(uint64_t* a, uint64_t* b)
+        { *a = _umul128(*a, *b, b); }
+#else
+    STC_INLINE void _c_mum(uint64_t* a, uint64_t* b) {
+        uint64_t ha = *a >> 32, hb = *b >> 32, la = (uint32_t)*a, lb = (uint32_t)*b;
+        uint64_t rh = ha*hb, rm0 = ha*lb, rm1 = hb*la, rl = la*lb, t = rl + (rm0 << 32);
+        uint64_t c = t < rl, lo = t + (rm1 << 32);
+        c += lo < t;
+        *a = lo; *b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+    }
+#endif
+#define _c_hs0 0x2d358dccaa6c78a5
+#define _c_hs1 0x8bb84b93962eacc9
+#define _c_hs2 0x4b33a62ed433d4a3
+#define _c_hs3 0x4d5a2da51de1aa47
+#define _c_hseed 0xca813bf4c7abf0a9 // _c_mix(_c_hs0, _c_hs1)
+
+STC_INLINE uint64_t _c_mix(uint64_t a, uint64_t b)
+    { _c_mum(&a, &b); return a ^ b; }
+STC_INLINE uint64_t _c_r8(const uint8_t* p)
+    { uint64_t v; memcpy(&v, p, 8); return v; }
+STC_INLINE uint64_t _c_r4(const uint8_t* p)
+    { uint32_t v; memcpy(&v, p, 4); return v; }
+
+STC_INLINE size_t _c_hash_end(uint64_t a, uint64_t b, uint64_t seed, size_t len) {
+    a ^= _c_hs1; b ^= seed;
+    _c_mum(&a, &b);
+    return (size_t)_c_mix(a ^ _c_hs0 ^ len, b ^ _c_hs1);
+}
+
+// one 48-byte block of a key with len > 48, while more than 48 bytes remain.
+STC_INLINE void _c_hash_block48(const uint8_t* p, uint64_t s[3]) {
+    s[0] = _c_mix(_c_r8(p) ^ _c_hs1, _c_r8(p + 8) ^ s[0]);
+    s[1] = _c_mix(_c_r8(p + 16) ^ _c_hs2, _c_r8(p + 24) ^ s[1]);
+    s[2] = _c_mix(_c_r8(p + 32) ^ _c_hs3, _c_r8(p + 40) ^ s[2]);
+}
+
+// the last 1..48 bytes p[0..n) of a key with len > 16 bytes.
+STC_INLINE size_t _c_hash_tail(const uint8_t* p, size_t n, uint64_t seed, size_t len) {
+    for (; n > 16; n -= 16, p += 16)
+        seed = _c_mix(_c_r8(p) ^ _c_hs1, _c_r8(p + 8) ^ seed);
+    return _c_hash_end(_c_r8(p + n - 16), _c_r8(p + n - 8), seed, len);
+}
+
+// a key of 0..16 bytes.
+STC_INLINE size_t _c_hash_16(const uint8_t* p, size_t n) {
+    uint64_t a = 0, b = 0;
+    if (n >= 4) {
+        const size_t k = (n >> 3) << 2;
+        a = (_c_r4(p) << 32) | _c_r4(p + k);
+        b = (_c_r4(p + n - 4) << 32) | _c_r4(p + n - 4 - k);
+    } else if (n > 0) {
+        a = ((uint64_t)p[0] << 16) | ((uint64_t)p[n >> 1] << 8) | p[n - 1];
+    }
+    return _c_hash_end(a, b, _c_hseed, n);
+}
+
 STC_INLINE size_t c_basehash_n(const void* key, isize len) {
-    size_t block = 0, hash = 0x811c9dc5;
-    const uint8_t* msg = (const uint8_t*)key;
-    while (len > c_sizeof(size_t)) {
-        memcpy(&block, msg, sizeof(size_t));
-        hash = (hash ^ block) * (size_t)0x89bb179901000193;
-        msg += c_sizeof(size_t);
-        len -= c_sizeof(size_t);
+    const uint8_t* p = (const uint8_t*)key;
+    size_t n = (size_t)len;
+    if (n <= 16)
+        return _c_hash_16(p, n);
+    uint64_t s[3] = {_c_hseed, _c_hseed, _c_hseed};
+    if (n > 48) {
+        do _c_hash_block48(p, s), p += 48, n -= 48;
+        while (n > 48);
+        s[0] ^= s[1] ^ s[2];
     }
-    c_memcpy(&block, msg, len);
-    hash = (hash ^ block) * (size_t)0xb0340f4501000193;
-    return hash ^ (hash >> 3);
+    return _c_hash_tail(p, n, s[0], (size_t)len);
 }
 
+// Fast paths for 4 and 8 byte keys: equals c_basehash_n() on little-endian targets.
 STC_INLINE size_t c_hash_n(const void* key, isize len) {
-    uint64_t b8; uint32_t b4;
+    uint64_t a;
     switch (len) {
-        case 8: memcpy(&b8, key, 8); return (size_t)(b8 * 0xc6a4a7935bd1e99d);
-        case 4: memcpy(&b4, key, 4); return b4 * (size_t)0xa2ffeb2f01000193;
+        case 8: a = _c_r8((const uint8_t*)key);
+                return _c_hash_end(a << 32 | a >> 32, a, _c_hseed, 8);
+        case 4: a = _c_r4((const uint8_t*)key);
+                a |= a << 32; return _c_hash_end(a, a, _c_hseed, 4);
         default: return c_basehash_n(key, len);
     }
 }
 
-STC_INLINE size_t c_hash_str(const char *str)
-    { return c_basehash_n(str, c_strlen(str)); }
+// c_hash_str() of a string longer than 16 bytes: finds the end of str in windows of 64 blocks,
+// and hashes each window while it is still in L1 cache: long strings are only loaded once.
+// memchr() stops at the first match, so it never reads past the zero.
+STC_NOINLINE size_t _c_hash_str_long(const char *str) {
+    enum {window = 48*64};
+    const uint8_t* p = (const uint8_t*)str;
+    const char* z;
+    uint64_t s[3] = {_c_hseed, _c_hseed, _c_hseed};
+    while ((z = (const char*)memchr(p, 0, window + 1)) == NULL)
+        for (int i = 0; i < window; i += 48)
+            _c_hash_block48(p, s), p += 48;
+    if (z - str <= 48)
+        return c_basehash_n(str, z - str);
+    size_t n = (size_t)(z - (const char*)p);
+    for (; n > 48; n -= 48, p += 48)
+        _c_hash_block48(p, s);
+    s[0] ^= s[1] ^ s[2];
+    return _c_hash_tail(p, n, s[0], (size_t)(z - str));
+}
+
+#if defined __GNUC__ && !defined __clang__
+  #pragma GCC diagnostic push // warns wrongfully on the dead paths when str is a short array
+  #pragma GCC diagnostic ignored "-Warray-bounds"
+#endif
+// Same as c_basehash_n(str, strlen(str)). Strings of up to 8 bytes are hashed inline.
+STC_INLINE size_t c_hash_str(const char *str) {
+    size_t n = 0;
+    while (str[n] != 0)
+        if (++n > 8) return _c_hash_str_long(str);
+    return _c_hash_16((const uint8_t*)str, n);
+}
+#if defined __GNUC__ && !defined __clang__
+  #pragma GCC diagnostic pop
+#endif
 
 #define c_hash_mix(...) /* non-commutative hash combine! */ \
     _chash_mix(c_make_array(size_t, {__VA_ARGS__}), c_NUMARGS(__VA_ARGS__))
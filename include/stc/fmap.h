@@ -0,0 +1,531 @@
+/* MIT License
+ *
+ * Copyright (c) 2025 Tyge Løvset
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Flat sorted set and map - the entries are stored in key order in a vector.
+/*
+#include <stdio.h>
+#define i_implement
+#include "stc/cstr.h"
+
+#define i_type FMap  // Flat sorted map<cstr, double>
+#define i_keypro cstr
+#define i_val double
+#include "stc/fmap.h"
+
+int main(void) {
+    FMap m = {0};
+    FMap_emplace(&m, "Testing one", 1.234);
+    FMap_emplace(&m, "Testing two", 12.34);
+    FMap_emplace(&m, "Testing three", 123.4);
+
+    const FMap_value *v = FMap_get(&m, "Testing five"); // NULL
+    double num = *FMap_at(&m, "Testing one");
+    FMap_emplace_or_assign(&m, "Testing three", 1000.0); // update
+    FMap_erase(&m, "Testing two");
+
+    for (c_each(i, FMap, m))
+        printf("map %s: %g\n", cstr_str(&i.ref->first), i.ref->second);
+
+    FMap_drop(&m);
+}
+*/
+#include "priv/linkage.h"
+#include "types.h"
+
+#ifndef STC_FMAP_H_INCLUDED
+#define STC_FMAP_H_INCLUDED
+#include "common.h"
+#include <stdlib.h>
+#endif // STC_FMAP_H_INCLUDED
+
+#ifndef _i_prefix
+  #define _i_prefix fmap_
+#endif
+#ifndef _i_is_set
+  #define _i_is_map
+  #define _i_MAP_ONLY c_true
+  #define _i_SET_ONLY c_false
+  #define _i_keyref(vp) (&(vp)->first)
+#else
+  #define _i_MAP_ONLY c_false
+  #define _i_SET_ONLY c_true
+  #define _i_keyref(vp) (vp)
+#endif
+#define _i_sorted
+#include "priv/template.h"
+#ifndef i_declared
+  _c_DEFTYPES(_c_flatmap_types, Self, i_key, i_val, _i_MAP_ONLY, _i_SET_ONLY);
+#endif
+
+_i_MAP_ONLY( struct _m_value {
+    _m_key first;
+    _m_mapped second;
+}; )
+
+typedef i_keyraw _m_keyraw;
+typedef i_valraw _m_rmapped;
+typedef _i_SET_ONLY( _m_keyraw )
+        _i_MAP_ONLY( struct { _m_keyraw first; _m_rmapped second; } )
+        _m_raw;
+
+#if !defined i_no_emplace
+STC_API _m_result       _c_MEMB(_emplace)(Self* self, _m_keyraw rkey _i_MAP_ONLY(, _m_rmapped rmapped));
+#endif // !i_no_emplace
+#if !defined i_no_clone
+STC_API Self            _c_MEMB(_clone)(Self map);
+#endif // !i_no_clone
+STC_API void            _c_MEMB(_drop)(const Self* cself);
+STC_API void            _c_MEMB(_clear)(Self* self);
+STC_API bool            _c_MEMB(_reserve)(Self* self, isize cap);
+STC_API isize           _c_MEMB(_lower_bound_i_)(const Self* self, const _m_keyraw* rkey);
+STC_API _m_result       _c_MEMB(_insert_entry_)(Self* self, _m_keyraw rkey);
+STC_API int             _c_MEMB(_erase)(Self* self, _m_keyraw rkey);
+STC_API _m_iter         _c_MEMB(_erase_range)(Self* self, _m_iter it1, _m_iter it2);
+STC_API void            _c_MEMB(_put_n)(Self* self, const _m_raw* raw, isize n);
+
+STC_INLINE Self         _c_MEMB(_init)(void) { Self map = {0}; return map; }
+STC_INLINE bool         _c_MEMB(_is_empty)(const Self* cx) { return cx->size == 0; }
+STC_INLINE isize        _c_MEMB(_size)(const Self* cx) { return cx->size; }
+STC_INLINE isize        _c_MEMB(_capacity)(const Self* cx) { return cx->capacity; }
+
+STC_INLINE Self _c_MEMB(_with_capacity)(const isize cap) {
+    Self map = {0};
+    _c_MEMB(_reserve)(&map, cap);
+    return map;
+}
+
+STC_INLINE void _c_MEMB(_shrink_to_fit)(Self* self)
+    { _c_MEMB(_reserve)(self, self->size); }
+
+STC_INLINE _m_iter _c_MEMB(_begin)(const Self* self) {
+    _m_iter it = {NULL, self->data + self->size};
+    if (self->size) it.ref = self->data;
+    return it;
+}
+
+STC_INLINE _m_iter _c_MEMB(_end)(const Self* self)
+    { (void)self; _m_iter it = {0}; return it; }
+
+STC_INLINE void _c_MEMB(_next)(_m_iter* it)
+    { if (++it->ref == it->end) it->ref = NULL; }
+
+STC_INLINE _m_iter _c_MEMB(_advance)(_m_iter it, size_t n) {
+    if ((it.ref += n) >= it.end) it.ref = NULL;
+    return it;
+}
+
+STC_INLINE _m_iter _c_MEMB(_lower_bound)(const Self* self, _m_keyraw rkey) {
+    _m_iter it = {self->data + _c_MEMB(_lower_bound_i_)(self, &rkey), self->data + self->size};
+    if (it.ref == it.end) it.ref = NULL;
+    return it;
+}
+
+STC_INLINE _m_iter _c_MEMB(_find)(const Self* self, _m_keyraw rkey) {
+    _m_iter it = _c_MEMB(_lower_bound)(self, rkey);
+    if (it.ref) {
+        const _m_keyraw _raw = i_keytoraw(_i_keyref(it.ref));
+        if (i_less((&rkey), (&_raw))) it.ref = NULL;
+    }
+    return it;
+}
+
+STC_INLINE bool _c_MEMB(_contains)(const Self* self, _m_keyraw rkey)
+    { return _c_MEMB(_find)(self, rkey).ref != NULL; }
+
+STC_INLINE const _m_value* _c_MEMB(_get)(const Self* self, _m_keyraw rkey)
+    { return _c_MEMB(_find)(self, rkey).ref; }
+
+STC_INLINE _m_value* _c_MEMB(_get_mut)(Self* self, _m_keyraw rkey)
+    { return _c_MEMB(_find)(self, rkey).ref; }
+
+STC_INLINE _m_value* _c_MEMB(_front)(const Self* self) { return self->data; }
+STC_INLINE _m_value* _c_MEMB(_back)(const Self* self) { return self->data + self->size - 1; }
+
+STC_INLINE _m_raw _c_MEMB(_value_toraw)(const _m_value* val) {
+    return _i_SET_ONLY( i_keytoraw(val) )
+           _i_MAP_ONLY( c_literal(_m_raw){i_keytoraw((&val->first)),
+                                          i_valtoraw((&val->second))} );
+}
+
+STC_INLINE void _c_MEMB(_value_drop)(_m_value* val) {
+    i_keydrop(_i_keyref(val));
+    _i_MAP_ONLY( i_valdrop((&val->second)); )
+}
+
+STC_INLINE Self _c_MEMB(_move)(Self *self) {
+    Self m = *self;
+    memset(self, 0, sizeof *self);
+    return m;
+}
+
+STC_INLINE void _c_MEMB(_take)(Self *self, Self unowned) {
+    _c_MEMB(_drop)(self);
+    *self = unowned;
+}
+
+#if !defined i_no_clone
+STC_INLINE _m_value _c_MEMB(_value_clone)(_m_value _val) {
+    *_i_keyref(&_val) = i_keyclone((*_i_keyref(&_val)));
+    _i_MAP_ONLY( _val.second = i_valclone(_val.second); )
+    return _val;
+}
+
+STC_INLINE void _c_MEMB(_copy)(Self *self, const Self other) {
+    if (self->data == other.data)
+        return;
+    _c_MEMB(_drop)(self);
+    *self = _c_MEMB(_clone)(other);
+}
+#endif // !i_no_clone
+
+#ifdef _i_is_map
+    STC_API _m_result _c_MEMB(_insert_or_assign)(Self* self, _m_key key, _m_mapped mapped);
+    #ifndef i_no_emplace
+    STC_API _m_result _c_MEMB(_emplace_or_assign)(Self* self, _m_keyraw rkey, _m_rmapped rmapped);
+    #endif
+
+    STC_INLINE const _m_mapped* _c_MEMB(_at)(const Self* self, _m_keyraw rkey)
+        { return &_c_MEMB(_find)(self, rkey).ref->second; }
+
+    STC_INLINE _m_mapped* _c_MEMB(_at_mut)(Self* self, _m_keyraw rkey)
+        { return &_c_MEMB(_find)(self, rkey).ref->second; }
+#endif // _i_is_map
+
+#if defined _i_has_eq
+STC_INLINE bool
+_c_MEMB(_eq)(const Self* self, const Self* other) {
+    if (self->size != other->size) return false;
+    for (isize i = 0; i < self->size; ++i) {
+        const _m_keyraw _rx = i_keytoraw(_i_keyref(self->data + i)), _ry = i_keytoraw(_i_keyref(other->data + i));
+        if (!(i_eq((&_rx), (&_ry)))) return false;
+    }
+    return true;
+}
+#endif
+
+STC_INLINE _m_result
+_c_MEMB(_insert)(Self* self, _m_key _key _i_MAP_ONLY(, _m_mapped _mapped)) {
+    _m_result _res = _c_MEMB(_insert_entry_)(self, i_keytoraw((&_key)));
+    if (_res.inserted)
+        { *_i_keyref(_res.ref) = _key; _i_MAP_ONLY( _res.ref->second = _mapped; )}
+    else
+        { i_keydrop((&_key)); _i_MAP_ONLY( i_valdrop((&_mapped)); )}
+    return _res;
+}
+
+STC_INLINE _m_value* _c_MEMB(_push)(Self* self, _m_value _val) {
+    _m_result _res = _c_MEMB(_insert_entry_)(self, i_keytoraw(_i_keyref(&_val)));
+    if (_res.inserted)
+        *_res.ref = _val;
+    else
+        _c_MEMB(_value_drop)(&_val);
+    return _res.ref;
+}
+
+#ifdef _i_is_map
+STC_INLINE _m_result _c_MEMB(_put)(Self* self, _m_keyraw rkey, _m_rmapped rmapped) {
+    #ifdef i_no_emplace
+        return _c_MEMB(_insert_or_assign)(self, rkey, rmapped);
+    #else
+        return _c_MEMB(_emplace_or_assign)(self, rkey, rmapped);
+    #endif
+}
+#endif
+
+STC_INLINE Self _c_MEMB(_with_n)(const _m_raw* raw, isize n)
+    { Self cx = {0}; _c_MEMB(_put_n)(&cx, raw, n); return cx; }
+
+STC_INLINE _m_iter _c_MEMB(_erase_at)(Self* self, _m_iter it) {
+    _m_iter it2 = it;
+    _c_MEMB(_next)(&it2);
+    return _c_MEMB(_erase_range)(self, it, it2);
+}
+
+/* -------------------------- IMPLEMENTATION ------------------------- */
+#if defined i_implement
+
+STC_DEF void
+_c_MEMB(_clear)(Self* self) {
+    for (isize i = 0; i < self->size; ++i)
+        _c_MEMB(_value_drop)(self->data + i);
+    self->size = 0;
+}
+
+STC_DEF void
+_c_MEMB(_drop)(const Self* cself) {
+    Self* self = (Self*)cself;
+    if (self->capacity == 0)
+        return;
+    _c_MEMB(_clear)(self);
+    i_free(self->data, self->capacity*c_sizeof(*self->data));
+}
+
+STC_DEF bool
+_c_MEMB(_reserve)(Self* self, const isize cap) {
+    if (cap > self->capacity || (cap && cap == self->size)) {
+        _m_value* d = (_m_value*)i_realloc(self->data, self->capacity*c_sizeof *d,
+                                           cap*c_sizeof *d);
+        if (d == NULL)
+            return false;
+        self->data = d;
+        self->capacity = cap;
+    }
+    return true;
+}
+
+// The branch-reducing lower bound search of priv/sort_prv.h, on the keys.
+// Returns the index of the first entry >= rkey, or size if none.
+STC_DEF isize
+_c_MEMB(_lower_bound_i_)(const Self* self, const _m_keyraw* rkey) {
+    isize start = 0, count = self->size, step = count/2;
+    while (count > 0) {
+        const _m_keyraw rx = i_keytoraw(_i_keyref(self->data + start + step));
+        if (i_less((&rx), rkey)) {
+            start += step + 1;
+            count -= step + 1;
+            step = count*7/8;
+        } else {
+            count = step;
+            step = count/8;
+        }
+    }
+    return start;
+}
+
+STC_DEF _m_result
+_c_MEMB(_insert_entry_)(Self* self, _m_keyraw rkey) {
+    _m_result res = {NULL};
+    const isize idx = _c_MEMB(_lower_bound_i_)(self, &rkey);
+    if (idx < self->size) {
+        const _m_keyraw _raw = i_keytoraw(_i_keyref(self->data + idx));
+        if (!(i_less((&rkey), (&_raw))))
+            { res.ref = self->data + idx; return res; }
+    }
+    if (self->size == self->capacity)
+        if (!_c_MEMB(_reserve)(self, self->size*3/2 + 4))
+            return res;
+    _m_value* pos = self->data + idx;
+    c_memmove(pos + 1, pos, (self->size - idx)*c_sizeof *pos);
+    ++self->size;
+    res.ref = pos;
+    res.inserted = true;
+    return res;
+}
+
+#ifdef _i_is_map
+    STC_DEF _m_result
+    _c_MEMB(_insert_or_assign)(Self* self, _m_key _key, _m_mapped _mapped) {
+        _m_result _res = _c_MEMB(_insert_entry_)(self, i_keytoraw((&_key)));
+        _m_mapped* _mp = _res.ref ? &_res.ref->second : &_mapped;
+        if (_res.inserted)
+            _res.ref->first = _key;
+        else
+            { i_keydrop((&_key)); i_valdrop(_mp); }
+        *_mp = _mapped;
+        return _res;
+    }
+
+    #if !defined i_no_emplace
+    STC_DEF _m_result
+    _c_MEMB(_emplace_or_assign)(Self* self, _m_keyraw rkey, _m_rmapped rmapped) {
+        _m_result _res = _c_MEMB(_insert_entry_)(self, rkey);
+        if (_res.inserted)
+            _res.ref->first = i_keyfrom(rkey);
+        else {
+            if (_res.ref == NULL) return _res;
+            i_valdrop((&_res.ref->second));
+        }
+        _res.ref->second = i_valfrom(rmapped);
+        return _res;
+    }
+    #endif // !i_no_emplace
+#endif // _i_is_map
+
+#if !defined i_no_emplace
+STC_DEF _m_result
+_c_MEMB(_emplace)(Self* self, _m_keyraw rkey _i_MAP_ONLY(, _m_rmapped rmapped)) {
+    _m_result res = _c_MEMB(_insert_entry_)(self, rkey);
+    if (res.inserted) {
+        *_i_keyref(res.ref) = i_keyfrom(rkey);
+        _i_MAP_ONLY(res.ref->second = i_valfrom(rmapped);)
+    }
+    return res;
+}
+#endif // i_no_emplace
+
+STC_DEF int
+_c_MEMB(_erase)(Self* self, _m_keyraw rkey) {
+    _m_iter it = _c_MEMB(_find)(self, rkey);
+    if (it.ref == NULL)
+        return 0;
+    _c_MEMB(_erase_at)(self, it);
+    return 1;
+}
+
+STC_DEF _m_iter
+_c_MEMB(_erase_range)(Self* self, _m_iter it1, _m_iter it2) {
+    if (it1.ref == NULL)
+        return it1;
+    _m_value* p = it1.ref, *q = it2.ref ? it2.ref : it1.end, *end = self->data + self->size;
+    for (_m_value* v = p; v != q; ++v)
+        _c_MEMB(_value_drop)(v);
+    c_memmove(p, q, (end - q)*c_sizeof *p);
+    self->size -= q - p;
+    it1.end = self->data + self->size;
+    if (it1.ref == it1.end) it1.ref = NULL;
+    return it1;
+}
+
+#if !defined i_no_clone
+STC_DEF Self
+_c_MEMB(_clone)(Self map) {
+    Self out = _c_MEMB(_with_capacity)(map.size);
+    if (out.capacity < map.size)
+        return out;
+    for (isize i = 0; i < map.size; ++i)
+        out.data[i] = _c_MEMB(_value_clone)(map.data[i]);
+    out.size = map.size;
+    return out;
+}
+#endif // !i_no_clone
+
+#define _i_rawkey(rp) _i_SET_ONLY( (rp) )_i_MAP_ONLY( (&(rp)->first) )
+
+// A new entry from raw, with the semantics of put_n().
+static _m_value
+_c_MEMB(_from_raw_)(const _m_raw* raw) {
+    _m_value v;
+  #if defined i_no_emplace
+    *_i_keyref(&v) = *_i_rawkey(raw);
+    _i_MAP_ONLY( v.second = raw->second; )
+  #else
+    *_i_keyref(&v) = i_keyfrom((*_i_rawkey(raw)));
+    _i_MAP_ONLY( v.second = i_valfrom(raw->second); )
+  #endif
+    return v;
+}
+
+// Update the entry v with the same key as raw, or drop raw if v is NULL.
+static void
+_c_MEMB(_put_raw_)(_m_value* v, _m_raw* raw) {
+    (void)v; (void)raw;
+  #if defined i_no_emplace
+    i_keydrop(((_m_key*)_i_rawkey(raw)));
+    _i_MAP_ONLY( if (v) { i_valdrop((&v->second)); v->second = raw->second; }
+                 else i_valdrop((&raw->second)); )
+  #else
+    _i_MAP_ONLY( if (v) { i_valdrop((&v->second)); v->second = i_valfrom(raw->second); } )
+  #endif
+}
+
+// Stable merge sort of raw[0..n) by key, using tmp[0..n).
+static void
+_c_MEMB(_sort_raw_)(_m_raw* raw, _m_raw* tmp, const isize n) {
+    enum {RUN = 8};
+    for (isize lo = 0; lo < n; lo += RUN) // insertion sort short runs
+        for (isize i = lo + 1; i < n && i < lo + RUN; ++i) {
+            _m_raw x = raw[i];
+            isize j = i;
+            for (; j > lo && i_less(_i_rawkey(&x), _i_rawkey(&raw[j - 1])); --j)
+                raw[j] = raw[j - 1];
+            raw[j] = x;
+        }
+    _m_raw *src = raw, *dst = tmp;
+    for (isize w = RUN; w < n; w *= 2) {
+        for (isize lo = 0; lo < n; lo += 2*w) {
+            isize i = lo, mid = lo + w < n ? lo + w : n, j = mid, hi = lo + 2*w < n ? lo + 2*w : n, k = lo;
+            while (i < mid && j < hi)
+                dst[k++] = i_less(_i_rawkey(&src[j]), _i_rawkey(&src[i])) ? src[j++] : src[i++];
+            while (i < mid) dst[k++] = src[i++];
+            while (j < hi) dst[k++] = src[j++];
+        }
+        c_swap(&src, &dst);
+    }
+    if (src != raw)
+        c_memcpy(raw, src, n*c_sizeof *raw);
+}
+
+// Sort the batch, and merge it with the entries in O(n + m log m) time, where
+// n is the size of the map and m the size of the batch.
+STC_DEF void
+_c_MEMB(_put_n)(Self* self, const _m_raw* raw, isize n) {
+    if (n <= 0)
+        return;
+    _m_raw* buf = _i_malloc(_m_raw, n*2);
+    if (buf == NULL) {
+        for (; n--; ++raw) _c_MEMB(_put_raw_)(NULL, (_m_raw*)raw);
+        return;
+    }
+    c_memcpy(buf, raw, n*c_sizeof *raw);
+    isize i = 1;
+    while (i < n && !(i_less(_i_rawkey(&buf[i]), _i_rawkey(&buf[i - 1]))))
+        ++i;
+    if (i < n)
+        _c_MEMB(_sort_raw_)(buf, buf + n, n);
+
+    // Keep the last of equal keys in the batch. Update the entries with the remaining
+    // keys which are in the map, and keep the m keys which are not in buf[0..m).
+    isize m = 0, e = 0;
+    for (i = 0; i < n; ++i) {
+        if (i + 1 < n && !(i_less(_i_rawkey(&buf[i]), _i_rawkey(&buf[i + 1])))) {
+            _c_MEMB(_put_raw_)(NULL, &buf[i]);
+            continue;
+        }
+        _m_keyraw rx;
+        while (e < self->size && (rx = i_keytoraw(_i_keyref(self->data + e)),
+                                  i_less((&rx), _i_rawkey(&buf[i]))))
+            ++e;
+        if (e < self->size && !(i_less(_i_rawkey(&buf[i]), (&rx))))
+            _c_MEMB(_put_raw_)(self->data + e, &buf[i]);
+        else
+            buf[m++] = buf[i];
+    }
+    // Merge the new keys in from the back.
+    if (m > 0 && (self->size + m <= self->capacity || _c_MEMB(_reserve)(self, self->size + m))) {
+        isize k = self->size + m;
+        e = self->size;
+        self->size = k;
+        while (m > 0) {
+            _m_keyraw rx;
+            if (e > 0 && (rx = i_keytoraw(_i_keyref(self->data + e - 1)),
+                          i_less(_i_rawkey(&buf[m - 1]), (&rx))))
+                self->data[--k] = self->data[--e];
+            else
+                self->data[--k] = _c_MEMB(_from_raw_)(&buf[--m]);
+        }
+    } else
+        while (m > 0)
+            _c_MEMB(_put_raw_)(NULL, &buf[--m]);
+    i_free(buf, n*2*c_sizeof *buf);
+}
+
+#undef _i_rawkey
+#endif // i_implement
+#undef _i_is_set
+#undef _i_is_map
+#undef _i_sorted
+#undef _i_keyref
+#undef _i_MAP_ONLY
+#undef _i_SET_ONLY
+#include "priv/linkage2.h"
+#include "priv/template2.h"
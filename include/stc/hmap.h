@@ -54,9 +54,97 @@ int main(void) {
 #include <stdlib.h>
 #define _hashmask 0x3fU
 #define _distmask 0x3ffU
+#define _hmap_ahead 16 // lookahead of batched operations, power of 2
 struct hmap_meta { uint16_t hashx:6, dist:10; }; // dist: 0=empty, 1=PSL 0, 2=PSL 1, ...
+#define hmap_stats_bins 16
+
+// Snapshot of the table layout, see _stats(). PSL is the probe sequence length of an entry,
+// i.e. its distance from its home bucket. The fingerprint collision rate is the fraction of
+// the buckets probed past during successful lookups whose 6-bit fingerprint (and stored hash
+// with i_store_hash) equals the key's own, each costing a key compare.
+struct hmap_stats {
+    isize size, bucket_count;
+    double load_factor, mean_psl;
+    int max_psl;
+    isize psl_hist[hmap_stats_bins]; // number of entries with PSL 0, 1, ..., last bin: 15 or more
+    double fingerprint_collision_rate;
+    isize bytes; // memory held by the tables, excluding memory owned by the elements
+    struct hmap_counters counters; // probe/compare/rehash counters, all zero without i_stats
+};
 #endif // STC_HMAP_H_INCLUDED
 
+#if defined i_simd_probe && !defined STC_HMAP_SIMD_INCLUDED
+#define STC_HMAP_SIMD_INCLUDED
+// Group probing: one 16-byte load holds the hmap_meta words of 8 consecutive buckets (hashx in
+// bits 0-5, dist in bits 6-15 on the supported little-endian targets), and the fingerprints and
+// probe lengths of the whole group are compared at once. Groups start at multiples of 8 buckets,
+// so they never straddle a cache line of meta[], and the table wraps around on group boundaries.
+// Other targets use the scalar probing loop.
+#if defined __SSE2__ || defined _M_X64 || (defined _M_IX86_FP && _M_IX86_FP >= 2)
+  #include <emmintrin.h>
+  #define STC_HMAP_SIMD 1 // SSE2
+#elif (defined __aarch64__ || defined _M_ARM64) && !defined __ARM_BIG_ENDIAN
+  #include <arm_neon.h>
+  #define STC_HMAP_SIMD 2 // NEON
+#endif
+
+#ifdef STC_HMAP_SIMD
+#define _hmap_group 8
+#if defined _MSC_VER && !defined __clang__
+  #include <intrin.h>
+  STC_INLINE int _hmap_ctz(uint32_t x) { unsigned long i; _BitScanForward(&i, x); return (int)i; }
+#else
+  #define _hmap_ctz(x) __builtin_ctz(x)
+#endif
+
+// Returns a bit per bucket in m[0..7] whose fingerprint equals hashx. *stop gets a bit per bucket
+// where a robin-hood probe terminates, i.e. its dist is less than the probe length of that bucket,
+// which is dist0 for m[0], dist0 + 1 for m[1], etc.
+STC_INLINE uint32_t _hmap_group_match(const struct hmap_meta* m, unsigned hashx, int dist0, uint32_t* stop) {
+  #if STC_HMAP_SIMD == 1
+    const __m128i v = _mm_loadu_si128((const __m128i*)m);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i want = _mm_add_epi16(_mm_set1_epi16((short)dist0), _mm_setr_epi16(0,1,2,3,4,5,6,7));
+    const __m128i term = _mm_cmplt_epi16(_mm_srli_epi16(v, 6), want);
+    const __m128i hits = _mm_cmpeq_epi16(_mm_and_si128(v, _mm_set1_epi16(_hashmask)),
+                                         _mm_set1_epi16((short)hashx));
+    *stop = (uint32_t)_mm_movemask_epi8(_mm_packs_epi16(term, zero));
+    return (uint32_t)_mm_movemask_epi8(_mm_packs_epi16(hits, zero));
+  #else
+    static const int16_t iota[8] = {0,1,2,3,4,5,6,7};
+    static const uint8_t bits[8] = {1,2,4,8,16,32,64,128};
+    const uint16x8_t v = vld1q_u16((const uint16_t*)m);
+    const int16x8_t want = vaddq_s16(vdupq_n_s16((int16_t)dist0), vld1q_s16(iota));
+    const uint16x8_t term = vcltq_s16(vreinterpretq_s16_u16(vshrq_n_u16(v, 6)), want);
+    const uint16x8_t hits = vceqq_u16(vandq_u16(v, vdupq_n_u16(_hashmask)), vdupq_n_u16((uint16_t)hashx));
+    *stop = vaddv_u8(vand_u8(vmovn_u16(term), vld1_u8(bits)));
+    return vaddv_u8(vand_u8(vmovn_u16(hits), vld1_u8(bits)));
+  #endif
+}
+#endif // STC_HMAP_SIMD
+#endif // i_simd_probe
+
+#if defined i_image && !defined STC_HMAP_IMAGE_INCLUDED
+#define STC_HMAP_IMAGE_INCLUDED
+#include "cmmap.h"
+// Flat image of a table: this header, then the meta[], hashes[] and table[] arrays as laid out
+// in memory, and the string pool of cstr keys, which are stored as cmmap_str in the image.
+struct hmap_image {
+    char magic[8];
+    uint32_t value_size, flags;
+    int64_t size, bucket_count;
+    int64_t meta_pos, hashes_pos, table_pos, pool_pos, end_pos;
+};
+#define _hmap_image_cstr 1      // i_keypro cstr: keys are written to the string pool
+#define _hmap_image_cmmap_str 2 // i_keypro cmmap_str: view of an image with pooled keys
+#define _hmap_image_align(pos) (((pos) + 63) & ~(int64_t)63)
+
+STC_INLINE bool _hmap_image_pad(FILE* fp, int64_t n) {
+    static const char zeros[64] = {0};
+    return n == 0 || fwrite(zeros, 1, (size_t)n, fp) == (size_t)n;
+}
+#endif // i_image
+
 #ifndef _i_prefix
   #define _i_prefix hmap_
 #endif
@@ -71,15 +159,76 @@ struct hmap_meta { uint16_t hashx:6, dist:10; }; // dist: 0=empty, 1=PSL 0, 2=PS
   #define _i_keyref(vp) (vp)
 #endif
 #define _i_is_hash
+#if defined i_simd_probe && defined STC_HMAP_SIMD
+  #define _i_simd_probe
+#endif
+#if defined i_store_hash
+  #define _i_store_hash
+  #define _i_if_store_hash c_true
+  #define _i_elem_hash(t, i, rkeyptr) ((size_t)(t)->hashes[i])
+#else
+  #define _i_if_store_hash c_false
+  #define _i_elem_hash(t, i, rkeyptr) i_hash(rkeyptr)
+#endif
+#if defined i_image
+  #define _i_image
+#endif
+#if defined i_slab
+  #define _i_slab
+  #define _i_if_slab c_true
+  #define _i_slotref(p) (*(p)) // bucket => entry
+  #if defined i_incremental || defined i_image
+    #error "i_slab can not be combined with i_incremental or i_image"
+  #endif
+#else
+  #define _i_if_slab c_false
+  #define _i_slotref(p) (p)
+#endif
+#if defined i_capacity
+  #define _i_fixed
+  #if defined i_incremental || defined i_image || defined i_slab
+    #error "i_capacity can not be combined with i_incremental, i_image or i_slab"
+  #endif
+#endif
+#if defined i_stats
+  #define _i_stats
+  #define _i_if_stats c_true
+#else
+  #define _i_if_stats c_false
+#endif
+// lookups through a const map are counted too, so the counters are mutable: with i_stats,
+// concurrent lookups in a shared map race on them (chmap rejects i_stats).
+#define _i_count(self, field, n) _i_if_stats( ((Self*)(self))->_stats.field += (uint64_t)(n); )
+#if defined i_parallel
+  #define _i_parallel
+#endif
+#if defined i_incremental
+  #define _i_incremental
+  #ifndef i_rehash_step
+    #define i_rehash_step 64
+  #endif
+#endif
 #include "priv/template.h"
 #ifndef i_declared
+  #ifdef _i_fixed // the inline table needs the complete entry type
+    _i_MAP_ONLY( struct _m_value { i_key first; i_val second; }; )
+  #endif
   _c_DEFTYPES(_c_htable_types, Self, i_key, i_val, _i_MAP_ONLY, _i_SET_ONLY);
 #endif
+#if defined _i_image && defined i_keypro && c_JOIN(_hmap_image_, i_keypro) == _hmap_image_cstr
+  #define _i_image_str _hmap_image_cstr
+#elif defined _i_image && defined i_keypro && c_JOIN(_hmap_image_, i_keypro) == _hmap_image_cmmap_str
+  #define _i_image_str _hmap_image_cmmap_str
+#else
+  #define _i_image_str 0 // keys are stored as is
+#endif
 
+#ifndef _i_fixed
 _i_MAP_ONLY( struct _m_value {
     _m_key first;
     _m_mapped second;
 }; )
+#endif
 
 typedef i_keyraw _m_keyraw;
 typedef i_valraw _m_rmapped;
@@ -88,6 +237,43 @@ typedef _i_SET_ONLY( i_keyraw )
                               _m_rmapped second; } )
 _m_raw;
 
+#define _m_slot _c_MEMB(_slot_) // bucket type
+#ifdef _i_slab
+typedef _m_value* _m_slot;
+
+// Entries are allocated from chunks that are never moved or freed before the map is cleared
+// or dropped, so the buckets only hold pointers and entry references stay valid until erased.
+union _c_MEMB(_node_) { _m_value value; union _c_MEMB(_node_)* next; };
+struct _c_MEMB(_chunk_) { struct _c_MEMB(_chunk_)* prev; isize n; union _c_MEMB(_node_) node[]; };
+static bool _c_MEMB(_slab_grow_)(Self* self, isize n);
+static void _c_MEMB(_slab_drop_)(Self* self);
+
+// Makes sure that _node_new_() has a node to return. The next chunk is as large as the map.
+STC_INLINE bool _c_MEMB(_slab_ready_)(Self* self) {
+    return self->_slab.free != NULL || self->_slab.next != self->_slab.end ||
+           _c_MEMB(_slab_grow_)(self, self->size < 16 ? 16 : (isize)self->size);
+}
+
+STC_INLINE _m_value* _c_MEMB(_node_new_)(Self* self) {
+    union _c_MEMB(_node_)* n = (union _c_MEMB(_node_)*)self->_slab.free;
+    if (n != NULL) {
+        self->_slab.free = n->next;
+    } else {
+        n = (union _c_MEMB(_node_)*)self->_slab.next;
+        self->_slab.next = n + 1;
+    }
+    return &n->value;
+}
+
+STC_INLINE void _c_MEMB(_node_free_)(Self* self, _m_value* val) {
+    union _c_MEMB(_node_)* n = (union _c_MEMB(_node_)*)(void*)val;
+    n->next = (union _c_MEMB(_node_)*)self->_slab.free;
+    self->_slab.free = n;
+}
+#else
+typedef _m_value _m_slot;
+#endif
+
 STC_API Self            _c_MEMB(_with_capacity)(isize cap);
 #if !defined i_no_clone
 STC_API Self            _c_MEMB(_clone)(Self map);
@@ -96,10 +282,46 @@ STC_API void            _c_MEMB(_drop)(const Self* cself);
 STC_API void            _c_MEMB(_clear)(Self* self);
 STC_API bool            _c_MEMB(_reserve)(Self* self, isize capacity);
 STC_API void            _c_MEMB(_erase_entry)(Self* self, _m_value* val);
+static void             _c_MEMB(_erase_slot_)(Self* self, Self* t, size_t i);
 STC_API float           _c_MEMB(_max_load_factor)(const Self* self);
 STC_API isize           _c_MEMB(_capacity)(const Self* map);
-static _m_result        _c_MEMB(_bucket_lookup_)(const Self* self, const _m_keyraw* rkeyptr);
-static _m_result        _c_MEMB(_bucket_insert_)(const Self* self, const _m_keyraw* rkeyptr);
+static _m_result        _c_MEMB(_bucket_lookup_)(const Self* self, const _m_keyraw* rkeyptr, size_t hash);
+static _m_result        _c_MEMB(_bucket_insert_)(Self* self, const _m_keyraw* rkeyptr, size_t hash);
+#ifdef _i_incremental
+static bool             _c_MEMB(_grow_)(Self* self);
+static void             _c_MEMB(_rehash_step_)(Self* self, isize n);
+
+// View of the table being migrated from during an incremental resize.
+STC_INLINE Self _c_MEMB(_old_)(const Self* self) {
+    Self o = {.table=self->_old.table, .meta=self->_old.meta,
+              .size=self->_old.size, .bucket_count=self->_old.bucket_count};
+  #ifdef _i_store_hash
+    o.hashes = self->_old.hashes;
+  #endif
+    return o;
+}
+
+STC_INLINE bool _c_MEMB(_in_old_)(const Self* self, const _m_value* ref) {
+    return (uintptr_t)ref - (uintptr_t)self->_old.table <
+           (uintptr_t)self->_old.bucket_count*sizeof *ref;
+}
+#endif
+
+// Requires a non-empty map.
+STC_INLINE _m_value* _c_MEMB(_lookup_hash_)(const Self* self, const _m_keyraw* rkeyptr, size_t hash) {
+    _m_value* ref = _c_MEMB(_bucket_lookup_)(self, rkeyptr, hash).ref;
+  #ifdef _i_incremental
+    if (ref == NULL && self->_old.size != 0) {
+        const Self _o = _c_MEMB(_old_)(self);
+        ref = _c_MEMB(_bucket_lookup_)(&_o, rkeyptr, hash).ref;
+    }
+  #endif
+    return ref;
+}
+
+STC_INLINE _m_value* _c_MEMB(_lookup_)(const Self* self, const _m_keyraw* rkeyptr) {
+    return self->size ? _c_MEMB(_lookup_hash_)(self, rkeyptr, i_hash(rkeyptr)) : NULL;
+}
 
 STC_INLINE Self         _c_MEMB(_init)(void) { Self map = {0}; return map; }
 STC_INLINE void         _c_MEMB(_shrink_to_fit)(Self* self) { _c_MEMB(_reserve)(self, (isize)self->size); }
@@ -107,23 +329,52 @@ STC_INLINE bool         _c_MEMB(_is_empty)(const Self* map) { return !map->size;
 STC_INLINE isize        _c_MEMB(_size)(const Self* map) { return (isize)map->size; }
 STC_INLINE isize        _c_MEMB(_bucket_count)(Self* map) { return map->bucket_count; }
 STC_INLINE bool         _c_MEMB(_contains)(const Self* self, _m_keyraw rkey)
-                            { return self->size && _c_MEMB(_bucket_lookup_)(self, &rkey).ref; }
+                            { return _c_MEMB(_lookup_)(self, &rkey) != NULL; }
 
 #ifndef i_max_load_factor
   #define i_max_load_factor 0.80f
 #endif
 
 STC_INLINE _m_result
-_c_MEMB(_insert_entry_)(Self* self, _m_keyraw rkey) {
+_c_MEMB(_insert_entry_hash_)(Self* self, const _m_keyraw* rkeyptr, size_t hash) {
+  #ifdef _i_incremental
+    if (self->_old.table != NULL)
+        _c_MEMB(_rehash_step_)(self, i_rehash_step);
+    if (self->size - self->_old.size >= (isize)((float)self->bucket_count * (i_max_load_factor)))
+        if (!_c_MEMB(_grow_)(self))
+            return c_literal(_m_result){0};
+    if (self->_old.size != 0) { // after _grow_(), which may have made the current table the old one
+        const Self _o = _c_MEMB(_old_)(self);
+        _m_result res = _c_MEMB(_bucket_lookup_)(&_o, rkeyptr, hash);
+        if (res.ref) return res;
+    }
+  #elif defined _i_fixed
+    if (self->bucket_count == 0)
+        _c_MEMB(_reserve)(self, 1);
+    else if (self->size == (i_capacity)) // full: only finds an existing key
+        return _c_MEMB(_bucket_lookup_)(self, rkeyptr, hash);
+  #else
     if (self->size >= (isize)((float)self->bucket_count * (i_max_load_factor)))
         if (!_c_MEMB(_reserve)(self, (isize)(self->size*3/2 + 2)))
             return c_literal(_m_result){0};
+  #endif
 
-    _m_result res = _c_MEMB(_bucket_insert_)(self, &rkey);
+  #ifdef _i_slab
+    if (!_c_MEMB(_slab_ready_)(self))
+        return c_literal(_m_result){0};
+  #endif
+    _m_result res = _c_MEMB(_bucket_insert_)(self, rkeyptr, hash);
+  #ifdef _i_slab
+    if (res.inserted)
+        res.ref = self->table[res.idx] = _c_MEMB(_node_new_)(self);
+  #endif
     self->size += res.inserted;
     return res;
 }
 
+STC_INLINE _m_result _c_MEMB(_insert_entry_)(Self* self, _m_keyraw rkey)
+    { return _c_MEMB(_insert_entry_hash_)(self, &rkey, i_hash((&rkey))); }
+
 #ifdef _i_is_map
     STC_API _m_result _c_MEMB(_insert_or_assign)(Self* self, _m_key key, _m_mapped mapped);
     #if !defined i_no_emplace
@@ -131,9 +382,9 @@ _c_MEMB(_insert_entry_)(Self* self, _m_keyraw rkey) {
     #endif
 
     STC_INLINE const _m_mapped* _c_MEMB(_at)(const Self* self, _m_keyraw rkey) {
-        _m_result res = _c_MEMB(_bucket_lookup_)(self, &rkey);
-        c_assert(res.ref);
-        return &res.ref->second;
+        _m_value* ref = _c_MEMB(_lookup_)(self, &rkey);
+        c_assert(ref);
+        return &ref->second;
     }
 
     STC_INLINE _m_mapped* _c_MEMB(_at_mut)(Self* self, _m_keyraw rkey)
@@ -142,10 +393,16 @@ _c_MEMB(_insert_entry_)(Self* self, _m_keyraw rkey) {
 
 #if !defined i_no_clone
     STC_INLINE void _c_MEMB(_copy)(Self *self, const Self other) {
+      #ifdef _i_fixed // other holds a copy of the inline tables, which may be those of *self
+        Self _tmp = _c_MEMB(_clone)(other);
+        _c_MEMB(_drop)(self);
+        *self = _tmp;
+      #else
         if (self->table == other.table)
             return;
         _c_MEMB(_drop)(self);
         *self = _c_MEMB(_clone)(other);
+      #endif
     }
 
     STC_INLINE _m_value _c_MEMB(_value_clone)(_m_value _val) {
@@ -217,28 +474,83 @@ STC_INLINE _m_result _c_MEMB(_put)(Self* self, _m_keyraw rkey, _m_rmapped rmappe
 }
 #endif
 
-STC_INLINE void _c_MEMB(_put_n)(Self* self, const _m_raw* raw, isize n) {
-    while (n--)
-        #if defined _i_is_set && defined i_no_emplace
-            _c_MEMB(_insert)(self, *raw++);
-        #elif defined _i_is_set
-            _c_MEMB(_emplace)(self, *raw++);
-        #else
-            _c_MEMB(_put)(self, raw->first, raw->second), ++raw;
-        #endif
-}
+STC_API void _c_MEMB(_put_n)(Self* self, const _m_raw* raw, isize n);
+STC_API isize _c_MEMB(_get_n)(const Self* self, const _m_keyraw rkeys[], isize n, const _m_value* out[]);
+STC_API isize _c_MEMB(_contains_n)(const Self* self, const _m_keyraw rkeys[], isize n, bool out[]);
 
 STC_INLINE Self _c_MEMB(_with_n)(const _m_raw* raw, isize n)
     { Self cx = {0}; _c_MEMB(_put_n)(&cx, raw, n); return cx; }
 
+#ifdef _i_parallel
+// Same as with_n(), but hashes, sorts and places the entries on up to `threads` threads.
+STC_API Self _c_MEMB(_build_n)(const _m_raw* raw, isize n, int threads);
+#endif
+
+// Erase the entries for which pred(entry, arg) returns true (false for retain()) in one sweep
+// over the table, moving the remaining entries back towards their home buckets as it goes.
+// Returns the number of erased entries. The table is not shrunk, see shrink_to_fit().
+STC_API isize _c_MEMB(_erase_if_)(Self* self, bool (*pred)(const _m_value* entry, void* arg),
+                                  void* arg, bool erase);
+STC_INLINE isize _c_MEMB(_erase_if)(Self* self, bool (*pred)(const _m_value* entry, void* arg), void* arg)
+    { return _c_MEMB(_erase_if_)(self, pred, arg, true); }
+STC_INLINE isize _c_MEMB(_retain)(Self* self, bool (*pred)(const _m_value* entry, void* arg), void* arg)
+    { return _c_MEMB(_erase_if_)(self, pred, arg, false); }
+
+#ifdef _i_image
+// Write a flat image of the table, which can be memory mapped and used by _view_image().
+// Keys and values must be trivially copyable, except for cstr keys (i_keypro cstr), which are
+// stored in a string pool and are viewed with i_keypro cmmap_str. Returns false on write error.
+STC_API bool _c_MEMB(_write_image)(const Self* self, FILE* fp);
+  #if _i_image_str != _hmap_image_cstr
+// Make view a read-only map of an image, e.g. mapped with cmmap_open(). No data is copied:
+// view must not be modified or dropped, and is valid as long as the image is. Key and value
+// types, i_hash and i_simd_probe/i_store_hash must match the map that wrote it.
+STC_API bool _c_MEMB(_view_image)(Self* view, const void* image, isize size);
+  #endif
+#endif
+
+// PSL histogram, fingerprint collision rate and memory use of the map, computed by scanning
+// the table. With i_stats, the run-time counters are included.
+STC_API struct hmap_stats _c_MEMB(_stats)(const Self* self);
+#ifdef _i_stats
+STC_INLINE void _c_MEMB(_reset_stats)(Self* self)
+    { memset(&self->_stats, 0, sizeof self->_stats); }
+#endif
+
 STC_API _m_iter _c_MEMB(_begin)(const Self* self);
 
 STC_INLINE _m_iter _c_MEMB(_end)(const Self* self)
     { (void)self; return c_literal(_m_iter){0}; }
 
+#ifndef _i_slab
+// Iterator to the first entry of table t, which is a map or a view of the old table of a map.
+STC_INLINE _m_iter _c_MEMB(_begin_table_)(const Self* t) {
+    _m_iter it = {(_m_value*)t->table, (_m_value*)t->table, (struct hmap_meta*)t->meta};
+    if (t->bucket_count == 0) return c_literal(_m_iter){0};
+    it._end += t->bucket_count;
+    while (it._mref->dist == 0)
+        ++it.ref, ++it._mref;
+    if (it.ref == it._end) it.ref = NULL;
+    return it;
+}
+#endif
+
 STC_INLINE void _c_MEMB(_next)(_m_iter* it) {
+  #ifdef _i_slab
+    while ((++it->_sref, (++it->_mref)->dist == 0)) ;
+    it->ref = it->_sref == it->_end ? NULL : *it->_sref;
+  #else
     while ((++it->ref, (++it->_mref)->dist == 0)) ;
-    if (it->ref == it->_end) it->ref = NULL;
+    if (it->ref == it->_end) {
+      #ifdef _i_incremental
+        if (it->_map != NULL) { // end of the old table: continue with the current one
+            *it = _c_MEMB(_begin_table_)(it->_map);
+            return;
+        }
+      #endif
+        it->ref = NULL;
+    }
+  #endif
 }
 
 STC_INLINE _m_iter _c_MEMB(_advance)(_m_iter it, size_t n) {
@@ -248,17 +560,33 @@ STC_INLINE _m_iter _c_MEMB(_advance)(_m_iter it, size_t n) {
 
 STC_INLINE _m_iter
 _c_MEMB(_find)(const Self* self, _m_keyraw rkey) {
-    _m_value* ref;
-    if (self->size != 0 && (ref = _c_MEMB(_bucket_lookup_)(self, &rkey).ref) != NULL)
+  #ifdef _i_slab
+    _m_result res = {0};
+    if (self->size != 0)
+        res = _c_MEMB(_bucket_lookup_)(self, &rkey, i_hash((&rkey)));
+    if (res.ref == NULL)
+        return _c_MEMB(_end)(self);
+    return c_literal(_m_iter){res.ref, &self->table[self->bucket_count],
+                                       &self->meta[res.idx], &self->table[res.idx]};
+  #else
+    _m_value* ref = _c_MEMB(_lookup_)(self, &rkey);
+    if (ref == NULL)
+        return _c_MEMB(_end)(self);
+  #ifdef _i_incremental
+    if (_c_MEMB(_in_old_)(self, ref))
         return c_literal(_m_iter){ref,
-                                  &self->table[self->bucket_count],
-                                  &self->meta[ref - self->table]};
-    return _c_MEMB(_end)(self);
+                                  &self->_old.table[self->_old.bucket_count],
+                                  &self->_old.meta[ref - self->_old.table], self};
+  #endif
+    return c_literal(_m_iter){ref, // casts are for i_capacity, where the tables are inline
+                                  (_m_value*)&self->table[self->bucket_count],
+                                  (struct hmap_meta*)&self->meta[ref - self->table]};
+  #endif
 }
 
 STC_INLINE const _m_value*
 _c_MEMB(_get)(const Self* self, _m_keyraw rkey) {
-    return self->size ? _c_MEMB(_bucket_lookup_)(self, &rkey).ref : NULL;
+    return _c_MEMB(_lookup_)(self, &rkey);
 }
 
 STC_INLINE _m_value*
@@ -267,17 +595,38 @@ _c_MEMB(_get_mut)(Self* self, _m_keyraw rkey)
 
 STC_INLINE int
 _c_MEMB(_erase)(Self* self, _m_keyraw rkey) {
+  #ifdef _i_slab
+    if (self->size != 0) {
+        _m_result res = _c_MEMB(_bucket_lookup_)(self, &rkey, i_hash((&rkey)));
+        if (res.ref != NULL)
+            { _c_MEMB(_erase_slot_)(self, self, res.idx); return 1; }
+    }
+    return 0;
+  #else
     _m_value* ref;
-    if (self->size != 0 && (ref = _c_MEMB(_bucket_lookup_)(self, &rkey).ref) != NULL)
+  #ifdef _i_incremental
+    if (self->_old.table != NULL)
+        _c_MEMB(_rehash_step_)(self, i_rehash_step);
+  #endif
+    if ((ref = _c_MEMB(_lookup_)(self, &rkey)) != NULL)
         { _c_MEMB(_erase_entry)(self, ref); return 1; }
     return 0;
+  #endif
 }
 
 STC_INLINE _m_iter
 _c_MEMB(_erase_at)(Self* self, _m_iter it) {
+  #ifdef _i_slab
+    _c_MEMB(_erase_slot_)(self, self, (size_t)(it._mref - self->meta));
+    if (it._mref->dist == 0)
+        _c_MEMB(_next)(&it);
+    else
+        it.ref = *it._sref; // the next entry was shifted into this bucket
+  #else
     _c_MEMB(_erase_entry)(self, it.ref);
     if (it._mref->dist == 0)
         _c_MEMB(_next)(&it);
+  #endif
     return it;
 }
 
@@ -295,13 +644,25 @@ _c_MEMB(_eq)(const Self* self, const Self* other) {
 #if defined i_implement
 
 STC_DEF _m_iter _c_MEMB(_begin)(const Self* self) {
-    _m_iter it = {self->table, self->table, self->meta};
-    if (it.ref == NULL) return it;
+  #ifdef _i_slab
+    _m_iter it = {NULL, self->table, self->meta, self->table};
+    if (it._sref == NULL) return it;
     it._end += self->bucket_count;
     while (it._mref->dist == 0)
-        ++it.ref, ++it._mref;
-    if (it.ref == it._end) it.ref = NULL;
+        ++it._sref, ++it._mref;
+    it.ref = it._sref == it._end ? NULL : *it._sref;
     return it;
+  #else
+  #ifdef _i_incremental
+    if (self->_old.size != 0) { // the entries not yet moved first, then the current table
+        const Self _o = _c_MEMB(_old_)(self);
+        _m_iter it = _c_MEMB(_begin_table_)(&_o);
+        it._map = self;
+        return it;
+    }
+  #endif
+    return _c_MEMB(_begin_table_)(self);
+  #endif
 }
 
 STC_DEF float _c_MEMB(_max_load_factor)(const Self* self) {
@@ -309,7 +670,11 @@ STC_DEF float _c_MEMB(_max_load_factor)(const Self* self) {
 }
 
 STC_DEF isize _c_MEMB(_capacity)(const Self* map) {
+  #ifdef _i_fixed
+    (void)map; return (i_capacity);
+  #else
     return (isize)((float)map->bucket_count * (i_max_load_factor));
+  #endif
 }
 
 STC_DEF Self _c_MEMB(_with_capacity)(const isize cap) {
@@ -321,24 +686,46 @@ STC_DEF Self _c_MEMB(_with_capacity)(const isize cap) {
 static void _c_MEMB(_wipe_)(Self* self) {
     if (self->size == 0)
         return;
-    _m_value* d = self->table, *_end = &d[self->bucket_count];
+    _m_slot* d = self->table, *_end = &d[self->bucket_count];
     struct hmap_meta* m = self->meta;
     for (; d != _end; ++d)
         if ((m++)->dist)
-            _c_MEMB(_value_drop)(d);
+            _c_MEMB(_value_drop)(_i_slotref(d));
 }
 
 STC_DEF void _c_MEMB(_drop)(const Self* cself) {
     Self* self = (Self*)cself;
+  #ifdef _i_fixed
+    _c_MEMB(_wipe_)(self);
+  #else
     if (self->bucket_count > 0) {
         _c_MEMB(_wipe_)(self);
         i_free(self->meta, (self->bucket_count + 1)*c_sizeof *self->meta);
         i_free(self->table, self->bucket_count*c_sizeof *self->table);
+        _i_if_store_hash( i_free(self->hashes, self->bucket_count*c_sizeof *self->hashes); )
+    }
+  #endif
+    _i_if_slab( _c_MEMB(_slab_drop_)(self); )
+  #ifdef _i_incremental
+    if (self->_old.table != NULL) {
+        Self _o = _c_MEMB(_old_)(self);
+        memset(&self->_old, 0, sizeof self->_old);
+        _c_MEMB(_drop)(&_o);
     }
+  #endif
 }
 
 STC_DEF void _c_MEMB(_clear)(Self* self) {
+  #ifdef _i_incremental
+    if (self->_old.table != NULL) {
+        Self _o = _c_MEMB(_old_)(self);
+        self->size -= _o.size;
+        memset(&self->_old, 0, sizeof self->_old);
+        _c_MEMB(_drop)(&_o);
+    }
+  #endif
     _c_MEMB(_wipe_)(self);
+    _i_if_slab( _c_MEMB(_slab_drop_)(self); )
     self->size = 0;
     c_memset(self->meta, 0, c_sizeof(struct hmap_meta)*self->bucket_count);
 }
@@ -373,53 +760,110 @@ STC_DEF void _c_MEMB(_clear)(Self* self) {
 #endif // _i_is_map
 
 static _m_result
-_c_MEMB(_bucket_lookup_)(const Self* self, const _m_keyraw* rkeyptr) {
-    const size_t _hash = i_hash(rkeyptr);
+_c_MEMB(_bucket_lookup_)(const Self* self, const _m_keyraw* rkeyptr, const size_t _hash) {
     const size_t _idxmask = (size_t)self->bucket_count - 1;
     _m_result _res = {.idx=_hash & _idxmask, .hashx=(uint8_t)((_hash >> 24) & _hashmask), .dist=1};
+    _i_count(self, lookups, 1);
 
+#ifdef _i_simd_probe
+    if (self->bucket_count >= _hmap_group) {
+        // Home bucket first: keeps the common hit/empty cases branch-predictable.
+        const struct hmap_meta _m = self->meta[_res.idx];
+        _i_count(self, probes, 1);
+        if (_m.dist == 0)
+            return _res;
+        if (_m.hashx == _res.hashx _i_if_store_hash(&& self->hashes[_res.idx] == (uint32_t)_hash)) {
+            const _m_keyraw _raw = i_keytoraw(_i_keyref(_i_slotref(&self->table[_res.idx])));
+            _i_count(self, compares, 1);
+            if (i_eq((&_raw), rkeyptr)) {
+                _res.ref = (_m_value*)_i_slotref(&self->table[_res.idx]);
+                return _res;
+            }
+        }
+        size_t _g = (_res.idx + 1) & _idxmask;
+        const int _off = (int)(_g & (_hmap_group - 1));
+        int _d0 = 2 - _off; // probe length of first bucket in group (negative for lanes before home)
+        uint32_t _lanes = ~0U << _off;
+        for (_g -= (size_t)_off;; _g = (_g + _hmap_group) & _idxmask, _d0 += _hmap_group, _lanes = ~0U) {
+            uint32_t _stop, _hits = _hmap_group_match(self->meta + _g, _res.hashx, _d0, &_stop);
+            _stop &= _lanes;
+            _hits &= _lanes & (_stop ? (_stop & (0U - _stop)) - 1U : ~0U);
+            for (; _hits; _hits &= _hits - 1) {
+                const int _k = _hmap_ctz(_hits);
+              #ifdef _i_store_hash
+                if (self->hashes[_g + (size_t)_k] != (uint32_t)_hash) continue;
+              #endif
+                const _m_keyraw _raw = i_keytoraw(_i_keyref(_i_slotref(&self->table[_g + (size_t)_k])));
+                _i_count(self, compares, 1);
+                if (i_eq((&_raw), rkeyptr)) {
+                    _res.ref = (_m_value*)_i_slotref(&self->table[_g + (size_t)_k]);
+                    _stop = 1U << _k;
+                    break;
+                }
+            }
+            if (_stop) {
+                const int _k = _hmap_ctz(_stop);
+                _res.idx = _g + (size_t)_k;
+                _res.dist = (uint16_t)(_d0 + _k);
+                _i_count(self, probes, _res.dist - 1);
+                return _res;
+            }
+        }
+    }
+#endif
     while (_res.dist <= self->meta[_res.idx].dist) {
-        if (self->meta[_res.idx].hashx == _res.hashx) {
-            const _m_keyraw _raw = i_keytoraw(_i_keyref(&self->table[_res.idx]));
+        if (self->meta[_res.idx].hashx == _res.hashx
+            _i_if_store_hash(&& self->hashes[_res.idx] == (uint32_t)_hash)) {
+            const _m_keyraw _raw = i_keytoraw(_i_keyref(_i_slotref(&self->table[_res.idx])));
+            _i_count(self, compares, 1);
             if (i_eq((&_raw), rkeyptr)) {
-                _res.ref = &self->table[_res.idx];
+                _res.ref = (_m_value*)_i_slotref(&self->table[_res.idx]);
                 break;
             }
         }
         _res.idx = (_res.idx + 1) & _idxmask;
         ++_res.dist;
     }
+    _i_count(self, probes, _res.dist);
     return _res;
 }
 
 static _m_result
-_c_MEMB(_bucket_insert_)(const Self* self, const _m_keyraw* rkeyptr) {
-    _m_result res = _c_MEMB(_bucket_lookup_)(self, rkeyptr);
+_c_MEMB(_bucket_insert_)(Self* self, const _m_keyraw* rkeyptr, const size_t hash) {
+    _m_result res = _c_MEMB(_bucket_lookup_)(self, rkeyptr, hash);
     if (res.ref) // bucket exists
         return res;
+  #ifndef _i_slab // else the caller stores the entry pointer in table[res.idx]
     res.ref = &self->table[res.idx];
+  #endif
     res.inserted = true;
     struct hmap_meta snew = {.hashx=(uint16_t)(res.hashx & _hashmask),
                              .dist=(uint16_t)(res.dist & _distmask)};
     struct hmap_meta scur = self->meta[res.idx];
     self->meta[res.idx] = snew;
+  #ifdef _i_store_hash
+    uint32_t hcur = self->hashes[res.idx];
+    self->hashes[res.idx] = (uint32_t)hash;
+  #endif
 
     if (scur.dist != 0) { // collision, reorder buckets
         struct hmap_meta *meta = self->meta;
-        size_t mask = (size_t)self->bucket_count - 1;
-        _m_value dcur = *res.ref;
+        size_t mask = (size_t)self->bucket_count - 1, i = res.idx;
+        _m_slot dcur = self->table[i];
         for (;;) {
-            res.idx = (res.idx + 1) & mask;
+            i = (i + 1) & mask;
             ++scur.dist;
-            if (meta[res.idx].dist == 0)
+            if (meta[i].dist == 0)
                 break;
-            if (meta[res.idx].dist < scur.dist) {
-                c_swap(&scur, &meta[res.idx]);
-                c_swap(&dcur, &self->table[res.idx]);
+            if (meta[i].dist <= scur.dist) { // <=: keeps entries of a home bucket in insertion order
+                c_swap(&scur, &meta[i]);
+                c_swap(&dcur, &self->table[i]);
+                _i_if_store_hash( c_swap(&hcur, &self->hashes[i]); )
             }
         }
-        meta[res.idx] = scur;
-        self->table[res.idx] = dcur;
+        meta[i] = scur;
+        self->table[i] = dcur;
+        _i_if_store_hash( self->hashes[i] = hcur; )
     }
     return res;
 }
@@ -428,16 +872,53 @@ _c_MEMB(_bucket_insert_)(const Self* self, const _m_keyraw* rkeyptr) {
 #if !defined i_no_clone
     STC_DEF Self
     _c_MEMB(_clone)(Self map) {
+      #ifdef _i_fixed // map is a copy of the tables
+        for (isize i = 0; i < map.bucket_count; ++i)
+            if (map.meta[i].dist)
+                map.table[i] = _c_MEMB(_value_clone)(map.table[i]);
+        return map;
+      #else
+      #ifdef _i_incremental
+        const Self _o = _c_MEMB(_old_)(&map);
+        memset(&map._old, 0, sizeof map._old);
+      #endif
+      #ifdef _i_slab
+        memset(&map._slab, 0, sizeof map._slab);
+      #endif
         if (map.bucket_count != 0) {
-            _m_value *d = _i_malloc(_m_value, map.bucket_count);
+            _m_slot *d = _i_malloc(_m_slot, map.bucket_count);
             const isize _mbytes = (map.bucket_count + 1)*c_sizeof *map.meta;
             struct hmap_meta *m = (struct hmap_meta *)i_malloc(_mbytes);
+          #ifdef _i_store_hash
+            uint32_t *h = _i_malloc(uint32_t, map.bucket_count);
+            if (h == NULL) {
+                if (m != NULL) i_free(m, _mbytes);
+                m = NULL;
+            } else if (d == NULL || m == NULL) {
+                i_free(h, map.bucket_count*c_sizeof *h);
+                h = NULL;
+            } else {
+                c_memcpy(h, map.hashes, map.bucket_count*c_sizeof *h);
+            }
+            map.hashes = h;
+          #endif
+          #ifdef _i_slab
+            if (d != NULL && map.size != 0 && !_c_MEMB(_slab_grow_)(&map, (isize)map.size)) {
+                i_free(d, map.bucket_count*c_sizeof *d);
+                d = NULL;
+            }
+          #endif
             if (d != NULL && m != NULL) {
                 c_memcpy(m, map.meta, _mbytes);
-                _m_value *_dst = d, *_end = map.table + map.bucket_count;
+                _m_slot *_dst = d, *_end = map.table + map.bucket_count;
                 for (; map.table != _end; ++map.table, ++map.meta, ++_dst)
-                    if (map.meta->dist)
+                    if (map.meta->dist) {
+                      #ifdef _i_slab
+                        *(*_dst = _c_MEMB(_node_new_)(&map)) = _c_MEMB(_value_clone)(**map.table);
+                      #else
                         *_dst = _c_MEMB(_value_clone)(*map.table);
+                      #endif
+                    }
             } else {
                 if (d != NULL) i_free(d, map.bucket_count*c_sizeof *d);
                 if (m != NULL) i_free(m, _mbytes);
@@ -445,12 +926,37 @@ _c_MEMB(_bucket_insert_)(const Self* self, const _m_keyraw* rkeyptr) {
             }
             map.table = d, map.meta = m;
         }
+      #ifdef _i_incremental
+        // the new table is sized for all entries, so the clone gets the old entries moved in.
+        if (map.table != NULL && _o.size != 0) {
+            const _m_value* d = _o.table;
+            const struct hmap_meta* m = _o.meta;
+            for (isize i = 0; i < _o.bucket_count; ++i, ++d) if ((m++)->dist != 0) {
+                _m_keyraw r = i_keytoraw(_i_keyref(d));
+                *_c_MEMB(_bucket_insert_)(&map, &r, _i_elem_hash(&_o, i, &r)).ref = _c_MEMB(_value_clone)(*d);
+            }
+        }
+      #endif
         return map;
+      #endif
     }
 #endif
 
 STC_DEF bool
 _c_MEMB(_reserve)(Self* self, const isize _newcap) {
+  #ifdef _i_fixed // nothing to allocate: the first call enables the inline table
+    if (_newcap > (i_capacity))
+        return false;
+    if (self->bucket_count == 0) {
+        self->bucket_count = c_arraylen(self->table);
+        self->meta[self->bucket_count].dist = _distmask; // end-mark for iter
+    }
+    return true;
+  #else
+  #ifdef _i_incremental
+    if (self->_old.table != NULL)
+        _c_MEMB(_rehash_step_)(self, -1);
+  #endif
     const isize _oldbucks = self->bucket_count;
     isize _newbucks = (isize)((float)_newcap / (i_max_load_factor)) + 4;
     _newbucks = c_next_pow2(_newbucks);
@@ -458,43 +964,75 @@ _c_MEMB(_reserve)(Self* self, const isize _newcap) {
     if (_newcap < self->size || _newbucks == _oldbucks)
         return true;
     Self map = {
-        _i_malloc(_m_value, _newbucks),
-        _i_calloc(struct hmap_meta, _newbucks + 1),
-        self->size, _newbucks
+        .table=_i_malloc(_m_slot, _newbucks),
+        .meta=_i_calloc(struct hmap_meta, _newbucks + 1),
+        .size=self->size, .bucket_count=_newbucks
     };
-
+  #ifdef _i_store_hash
+    map.hashes = _i_malloc(uint32_t, _newbucks);
+    bool ok = map.table && map.meta && map.hashes;
+  #else
     bool ok = map.table && map.meta;
+  #endif
     if (ok) {  // Rehash:
         map.meta[_newbucks].dist = _distmask; // end-mark for iter
-        const _m_value* d = self->table;
+        const _m_slot* d = self->table;
         const struct hmap_meta* m = self->meta;
 
         for (isize i = 0; i < _oldbucks; ++i, ++d) if ((m++)->dist != 0) {
-            _m_keyraw r = i_keytoraw(_i_keyref(d));
-            _m_result _res = _c_MEMB(_bucket_insert_)(&map, &r);
-            *_res.ref = *d; // move
+            _m_keyraw r = i_keytoraw(_i_keyref(_i_slotref(d)));
+            _m_result _res = _c_MEMB(_bucket_insert_)(&map, &r, _i_elem_hash(self, i, &r));
+            map.table[_res.idx] = *d; // move
         }
         c_swap(self, &map);
+        _i_if_slab( self->_slab = map._slab; )
+        _i_if_stats( self->_stats = map._stats; ++self->_stats.rehashes; ) // rehash probes not counted
     }
     i_free(map.meta, (map.bucket_count + (int)(map.meta != NULL))*c_sizeof *map.meta);
     i_free(map.table, map.bucket_count*c_sizeof *map.table);
+    _i_if_store_hash( i_free(map.hashes, map.bucket_count*c_sizeof *map.hashes); )
     return ok;
+  #endif
 }
 
 STC_DEF void
 _c_MEMB(_erase_entry)(Self* self, _m_value* _val) {
-    _m_value* d = self->table;
-    struct hmap_meta *m = self->meta;
-    size_t i = (size_t)(_val - d), j = i;
-    size_t mask = (size_t)self->bucket_count - 1;
+    Self* t = self;
+  #ifdef _i_incremental
+    Self _o;
+    if (_c_MEMB(_in_old_)(self, _val)) {
+        _o = _c_MEMB(_old_)(self), t = &_o;
+        --self->_old.size; // old arrays are released by the next resize step, not here
+    }
+  #endif
+  #ifdef _i_slab // find the bucket that points to the entry
+    const _m_keyraw _raw = i_keytoraw(_i_keyref(_val));
+    const size_t mask = (size_t)t->bucket_count - 1;
+    size_t i = i_hash((&_raw)) & mask;
+    while (t->table[i] != _val)
+        i = (i + 1) & mask;
+  #else
+    size_t i = (size_t)(_val - t->table);
+  #endif
+    _c_MEMB(_erase_slot_)(self, t, i);
+}
 
-    _c_MEMB(_value_drop)(_val);
+// Removes the entry in bucket i of t, which is self or a view of the old table of self.
+static void
+_c_MEMB(_erase_slot_)(Self* self, Self* t, size_t i) {
+    _m_slot* d = t->table;
+    struct hmap_meta *m = t->meta;
+    size_t j = i, mask = (size_t)t->bucket_count - 1;
+
+    _c_MEMB(_value_drop)(_i_slotref(&d[i]));
+    _i_if_slab( _c_MEMB(_node_free_)(self, d[i]); )
     for (;;) {
         j = (j + 1) & mask;
         if (m[j].dist < 2) // 0 => empty, 1 => PSL 0
             break;
         d[i] = d[j];
         m[i] = m[j];
+        _i_if_store_hash( t->hashes[i] = t->hashes[j]; )
         --m[i].dist;
         i = j;
     }
@@ -502,8 +1040,436 @@ _c_MEMB(_erase_entry)(Self* self, _m_value* _val) {
     --self->size;
 }
 
+// Starts after an empty bucket, so that every cluster is swept from its head. gap counts the
+// empty buckets right before bucket i that its entry may move back to: it can move at most its
+// PSL, and the buckets it leaves behind become the gap of the next entry.
+STC_DEF isize
+_c_MEMB(_erase_if_)(Self* self, bool (*pred)(const _m_value* entry, void* arg),
+                    void* arg, const bool erase) {
+  #ifdef _i_incremental
+    if (self->_old.table != NULL)
+        _c_MEMB(_rehash_step_)(self, -1);
+  #endif
+    if (self->size == 0)
+        return 0;
+    _m_slot* d = self->table;
+    struct hmap_meta* m = self->meta;
+    const size_t mask = (size_t)self->bucket_count - 1;
+    size_t i = 0, gap = 0;
+    isize n = 0;
+    while (m[i].dist != 0) // the load factor guarantees an empty bucket
+        ++i;
+    for (size_t k = 0; k < (size_t)self->bucket_count; ++k) {
+        i = (i + 1) & mask;
+        if (m[i].dist == 0) {
+            gap = 0;
+        } else if (pred(_i_slotref(&d[i]), arg) == erase) {
+            _c_MEMB(_value_drop)(_i_slotref(&d[i]));
+            _i_if_slab( _c_MEMB(_node_free_)(self, d[i]); )
+            m[i].dist = 0;
+            ++gap, ++n;
+        } else if (gap != 0 && m[i].dist > 1) {
+            const size_t shift = gap < m[i].dist - 1U ? gap : m[i].dist - 1U;
+            const size_t j = (i - shift) & mask;
+            d[j] = d[i];
+            m[j].hashx = m[i].hashx;
+            m[j].dist = (uint16_t)((m[i].dist - shift) & _distmask);
+            _i_if_store_hash( self->hashes[j] = self->hashes[i]; )
+            m[i].dist = 0;
+            gap = shift;
+        } else {
+            gap = 0;
+        }
+    }
+    self->size -= n;
+    return n;
+}
+
+// Batched operations hash key i + _hmap_ahead and prefetch its home bucket before key i is
+// probed, so the cache misses of many keys are in flight at the same time.
+static isize
+_c_MEMB(_lookup_n_)(const Self* self, const _m_keyraw rkeys[], const isize n,
+                    const _m_value* vals[], bool found[]) {
+    size_t hv[_hmap_ahead];
+    const size_t mask = (size_t)self->bucket_count - 1;
+    isize count = 0;
+    for (isize i = 0; i < n + _hmap_ahead; ++i) {
+        const isize j = i - _hmap_ahead;
+        if (j >= 0) {
+            const _m_value* ref = self->size ? _c_MEMB(_lookup_hash_)(self, &rkeys[j], hv[j & (_hmap_ahead - 1)])
+                                             : NULL;
+            count += ref != NULL;
+            if (vals) vals[j] = ref;
+            if (found) found[j] = ref != NULL;
+        }
+        if (i < n && self->size) {
+            const size_t h = i_hash((&rkeys[i]));
+            hv[i & (_hmap_ahead - 1)] = h;
+            c_prefetch(&self->meta[h & mask]);
+            c_prefetch(&self->table[h & mask]);
+            _i_if_store_hash( c_prefetch(&self->hashes[h & mask]); )
+        }
+    }
+    return count;
+}
+
+STC_DEF isize _c_MEMB(_get_n)(const Self* self, const _m_keyraw rkeys[], isize n, const _m_value* out[])
+    { return _c_MEMB(_lookup_n_)(self, rkeys, n, out, NULL); }
+
+STC_DEF isize _c_MEMB(_contains_n)(const Self* self, const _m_keyraw rkeys[], isize n, bool out[])
+    { return _c_MEMB(_lookup_n_)(self, rkeys, n, NULL, out); }
+
+STC_DEF void
+_c_MEMB(_put_n)(Self* self, const _m_raw* raw, const isize n) {
+    size_t hv[_hmap_ahead];
+  #ifndef _i_incremental
+    _c_MEMB(_reserve)(self, (isize)self->size + n);
+  #endif
+    for (isize i = 0; i < n + _hmap_ahead; ++i) {
+        const isize j = i - _hmap_ahead;
+        if (j >= 0) {
+            const _m_keyraw* rk = &_i_SET_ONLY(raw[j]) _i_MAP_ONLY(raw[j].first);
+            _m_result res = _c_MEMB(_insert_entry_hash_)(self, rk, hv[j & (_hmap_ahead - 1)]);
+            if (res.ref == NULL)
+                continue;
+          #if defined i_no_emplace // as insert(): the raw values are moved into the map
+            _m_key _key = *rk;
+            if (res.inserted)
+                *_i_keyref(res.ref) = _key;
+            else
+                i_keydrop((&_key));
+            #ifdef _i_is_map
+            if (!res.inserted)
+                i_valdrop((&res.ref->second));
+            res.ref->second = raw[j].second;
+            #endif
+          #else // as emplace(), and assign for maps
+            if (res.inserted)
+                *_i_keyref(res.ref) = i_keyfrom((*rk));
+            #ifdef _i_is_map
+            else
+                i_valdrop((&res.ref->second));
+            res.ref->second = i_valfrom(raw[j].second);
+            #endif
+          #endif
+        }
+        if (i < n) {
+            const size_t h = i_hash((&_i_SET_ONLY(raw[i]) _i_MAP_ONLY(raw[i].first)));
+            hv[i & (_hmap_ahead - 1)] = h;
+            if (self->bucket_count) {
+                const size_t idx = h & ((size_t)self->bucket_count - 1);
+                c_prefetch(&self->meta[idx]);
+                c_prefetch(&self->table[idx]);
+            }
+        }
+    }
+}
+
+#ifdef _i_incremental
+// Starts an incremental resize: a new table is allocated and subsequent inserts and erases
+// each move a few clusters of the old table into it, instead of rehashing all at once.
+static bool
+_c_MEMB(_grow_)(Self* self) {
+    if (self->_old.table != NULL)
+        _c_MEMB(_rehash_step_)(self, -1);
+    if (self->bucket_count == 0)
+        return _c_MEMB(_reserve)(self, (isize)(self->size*3/2 + 2));
+
+    isize _newbucks = (isize)((float)(self->size*3/2 + 2) / (i_max_load_factor)) + 4;
+    _newbucks = c_next_pow2(_newbucks);
+    _m_value* d = _i_malloc(_m_value, _newbucks);
+    struct hmap_meta* m = _i_calloc(struct hmap_meta, _newbucks + 1);
+  #ifdef _i_store_hash
+    uint32_t* h = _i_malloc(uint32_t, _newbucks);
+    if (d == NULL || m == NULL || h == NULL) {
+        i_free(h, _newbucks*c_sizeof *h);
+  #else
+    if (d == NULL || m == NULL) {
+  #endif
+        i_free(m, (_newbucks + (int)(m != NULL))*c_sizeof *m);
+        i_free(d, _newbucks*c_sizeof *d);
+        return false;
+    }
+    m[_newbucks].dist = _distmask; // end-mark for iter
+    _i_count(self, rehashes, 1);
+
+    self->_old.table = self->table;
+    self->_old.meta = self->meta;
+    self->_old.size = self->size;
+    self->_old.bucket_count = self->bucket_count;
+    self->_old.pos = 0; // migration must start at the head of a cluster
+    while (self->meta[self->_old.pos].dist != 0)
+        ++self->_old.pos;
+    self->table = d;
+    self->meta = m;
+    self->bucket_count = _newbucks;
+  #ifdef _i_store_hash
+    self->_old.hashes = self->hashes;
+    self->hashes = h;
+  #endif
+    return true;
+}
+
+// Moves whole clusters from the old table to the new, scanning at least n old buckets (all if
+// n < 0). _old.pos is always an empty bucket or the head of a cluster: erasing from the old table
+// only shifts entries backward within their cluster, so they stay reachable by robin-hood probing.
+static void
+_c_MEMB(_rehash_step_)(Self* self, isize n) {
+    _m_value* d = self->_old.table;
+    struct hmap_meta* m = self->_old.meta;
+    const size_t mask = (size_t)self->_old.bucket_count - 1;
+    size_t i = (size_t)self->_old.pos;
+    _i_if_stats( const struct hmap_counters _st = self->_stats; ) // migration probes not counted
+
+    if (n < 0) n = c_NPOS;
+    for (; self->_old.size != 0 && n > 0; --n, i = (i + 1) & mask) {
+        for (; m[i].dist != 0; i = (i + 1) & mask, --n) {
+            _m_keyraw r = i_keytoraw(_i_keyref(&d[i]));
+            *_c_MEMB(_bucket_insert_)(self, &r, _i_elem_hash(&self->_old, i, &r)).ref = d[i]; // move
+            m[i].dist = 0;
+            --self->_old.size;
+        }
+    }
+    self->_old.pos = (isize)i;
+    _i_if_stats( self->_stats = _st; )
+    if (self->_old.size == 0) {
+        i_free(m, (self->_old.bucket_count + 1)*c_sizeof *m);
+        i_free(d, self->_old.bucket_count*c_sizeof *d);
+        _i_if_store_hash( i_free(self->_old.hashes, self->_old.bucket_count*c_sizeof *self->_old.hashes); )
+        memset(&self->_old, 0, sizeof self->_old);
+    }
+}
+#endif // _i_incremental
+
+#ifdef _i_image
+#if _i_image_str
+  #define _i_image_key cmmap_str
+#else
+  #define _i_image_key _m_key
+#endif
+#ifdef _i_simd_probe
+  #define _i_image_flags ((_i_image_str ? 1U : 0U) | _i_if_store_hash(2U |) 4U)
+#else
+  #define _i_image_flags ((_i_image_str ? 1U : 0U) | _i_if_store_hash(2U |) 0U)
+#endif
+typedef _i_SET_ONLY( _i_image_key )
+        _i_MAP_ONLY( struct { _i_image_key first;
+                              _m_mapped second; } )
+_c_MEMB(_image_value_);
+
+STC_DEF bool _c_MEMB(_write_image)(const Self* self, FILE* fp) {
+  #ifdef _i_incremental
+    if (self->_old.size != 0) { // write a merged copy of the two tables; the entries are not cloned
+        const Self _o = _c_MEMB(_old_)(self);
+        Self map = *self;
+        memset(&map._old, 0, sizeof map._old);
+        map.table = _i_malloc(_m_value, map.bucket_count);
+        map.meta = _i_malloc(struct hmap_meta, map.bucket_count + 1);
+        _i_if_store_hash( map.hashes = _i_malloc(uint32_t, map.bucket_count); )
+        bool ok = map.table != NULL && map.meta != NULL _i_if_store_hash(&& map.hashes != NULL);
+        if (ok) {
+            c_memcpy(map.table, self->table, map.bucket_count*c_sizeof *map.table);
+            c_memcpy(map.meta, self->meta, (map.bucket_count + 1)*c_sizeof *map.meta);
+            _i_if_store_hash( c_memcpy(map.hashes, self->hashes, map.bucket_count*c_sizeof *map.hashes); )
+            for (isize i = 0; i < _o.bucket_count; ++i) if (_o.meta[i].dist != 0) {
+                _m_keyraw r = i_keytoraw(_i_keyref(&_o.table[i]));
+                *_c_MEMB(_bucket_insert_)(&map, &r, _i_elem_hash(&_o, i, &r)).ref = _o.table[i];
+            }
+            ok = _c_MEMB(_write_image)(&map, fp);
+        }
+        i_free(map.meta, (map.bucket_count + 1)*c_sizeof *map.meta);
+        i_free(map.table, map.bucket_count*c_sizeof *map.table);
+        _i_if_store_hash( i_free(map.hashes, map.bucket_count*c_sizeof *map.hashes); )
+        return ok;
+    }
+  #endif
+    typedef _c_MEMB(_image_value_) _value_t;
+    const isize n = self->bucket_count;
+    const struct hmap_meta* m = self->meta;
+    struct hmap_image h = {"STCHMAP", (uint32_t)sizeof(_value_t), _i_image_flags,
+                           (int64_t)self->size, (int64_t)n};
+    h.meta_pos = _hmap_image_align((int64_t)sizeof h);
+    h.hashes_pos = _hmap_image_align(h.meta_pos + (n + (n > 0))*c_sizeof *m);
+    h.table_pos = h.hashes_pos;
+    _i_if_store_hash( h.table_pos = _hmap_image_align(h.hashes_pos + n*c_sizeof(uint32_t)); )
+    h.pool_pos = h.table_pos + n*c_sizeof(_value_t);
+    h.end_pos = h.pool_pos;
+  #if _i_image_str
+    for (isize i = 0; i < n; ++i)
+        if (m[i].dist) {
+            _m_keyraw r = i_keytoraw(_i_keyref(&self->table[i]));
+            h.end_pos += (int64_t)strlen(r) + 1;
+        }
+  #endif
+    bool ok = fwrite(&h, sizeof h, 1, fp) == 1 &&
+              _hmap_image_pad(fp, h.meta_pos - c_sizeof h) &&
+              (n == 0 || fwrite(m, sizeof *m, (size_t)n + 1, fp) == (size_t)n + 1) &&
+              _hmap_image_pad(fp, h.hashes_pos - h.meta_pos - (n + (n > 0))*c_sizeof *m);
+  #ifdef _i_store_hash
+    for (isize i = 0; ok && i < n; ++i) {
+        const uint32_t hash = m[i].dist ? self->hashes[i] : 0;
+        ok = fwrite(&hash, sizeof hash, 1, fp) == 1;
+    }
+    ok = ok && _hmap_image_pad(fp, h.table_pos - h.hashes_pos - n*c_sizeof(uint32_t));
+  #endif
+  #if _i_image_str
+    int64_t pool = h.pool_pos;
+  #endif
+    for (isize i = 0; ok && i < n; ++i) {
+        _value_t e;
+        memset(&e, 0, sizeof e);
+        if (m[i].dist) {
+          #if _i_image_str
+            cmmap_str* k = _i_SET_ONLY( &e ) _i_MAP_ONLY( &e.first );
+            _m_keyraw r = i_keytoraw(_i_keyref(&self->table[i]));
+            k->off = pool - (h.table_pos + i*c_sizeof e + (int64_t)((char*)k - (char*)&e));
+            k->size = (int64_t)strlen(r);
+            pool += k->size + 1;
+            _i_MAP_ONLY( e.second = self->table[i].second; )
+          #else
+            memcpy(&e, &self->table[i], sizeof e);
+          #endif
+        }
+        ok = fwrite(&e, sizeof e, 1, fp) == 1;
+    }
+  #if _i_image_str
+    for (isize i = 0; ok && i < n; ++i)
+        if (m[i].dist) {
+            _m_keyraw r = i_keytoraw(_i_keyref(&self->table[i]));
+            const size_t len = strlen(r) + 1;
+            ok = fwrite(r, 1, len, fp) == len;
+        }
+  #endif
+    return ok;
+}
+
+  #if _i_image_str != _hmap_image_cstr
+STC_DEF bool _c_MEMB(_view_image)(Self* view, const void* image, isize size) {
+    const struct hmap_image* h = (const struct hmap_image*)image;
+    const char* base = (const char*)image;
+    memset(view, 0, sizeof *view);
+    if (size < c_sizeof *h || memcmp(h->magic, "STCHMAP", 8) != 0 ||
+        h->value_size != sizeof(_m_value) || h->flags != (_i_image_flags) || h->end_pos > size)
+        return false;
+    if (h->bucket_count > 0) {
+        view->table = (_m_value*)(base + h->table_pos);
+        view->meta = (struct hmap_meta*)(base + h->meta_pos);
+        _i_if_store_hash( view->hashes = (uint32_t*)(base + h->hashes_pos); )
+        view->size = (isize)h->size;
+        view->bucket_count = (isize)h->bucket_count;
+    }
+    return true;
+}
+  #endif
+#undef _i_image_key
+#undef _i_image_flags
+#endif // _i_image
+
+#ifdef _i_slab
+static bool
+_c_MEMB(_slab_grow_)(Self* self, const isize n) {
+    struct _c_MEMB(_chunk_)* c = (struct _c_MEMB(_chunk_)*)i_malloc(c_sizeof *c + n*c_sizeof c->node[0]);
+    if (c == NULL)
+        return false;
+    c->prev = (struct _c_MEMB(_chunk_)*)self->_slab.chunks;
+    c->n = n;
+    self->_slab.chunks = c;
+    self->_slab.next = c->node;
+    self->_slab.end = c->node + n;
+    return true;
+}
+
+static void
+_c_MEMB(_slab_drop_)(Self* self) {
+    struct _c_MEMB(_chunk_)* c = (struct _c_MEMB(_chunk_)*)self->_slab.chunks;
+    while (c != NULL) {
+        struct _c_MEMB(_chunk_)* prev = c->prev;
+        i_free(c, c_sizeof *c + c->n*c_sizeof c->node[0]);
+        c = prev;
+    }
+    memset(&self->_slab, 0, sizeof self->_slab);
+}
+#endif // _i_slab
+
+STC_DEF struct hmap_stats
+_c_MEMB(_stats)(const Self* self) {
+    struct hmap_stats st = {.size=(isize)self->size, .bucket_count=(isize)self->bucket_count};
+    const isize _bucksize = c_sizeof(_m_slot) + c_sizeof(struct hmap_meta)
+                            _i_if_store_hash(+ c_sizeof(uint32_t));
+    isize _pslsum = 0, _probed = 0, _matched = 0;
+    Self _t = *self;
+  #ifdef _i_incremental
+    const Self _o = _c_MEMB(_old_)(self);
+    st.size += (isize)_o.size;
+    st.bytes += _o.bucket_count ? _o.bucket_count*_bucksize + c_sizeof(struct hmap_meta) : 0;
+    for (int _pass = 0; _pass < 2; ++_pass, _t = _o)
+  #endif
+    {
+        const size_t _mask = (size_t)_t.bucket_count - 1;
+        for (size_t i = 0; i < (size_t)_t.bucket_count; ++i) {
+            const struct hmap_meta _m = _t.meta[i];
+            if (_m.dist == 0) continue;
+            const int _psl = _m.dist - 1;
+            _pslsum += _psl;
+            if (_psl > st.max_psl) st.max_psl = _psl;
+            ++st.psl_hist[_psl < hmap_stats_bins ? _psl : hmap_stats_bins - 1];
+            // buckets passed on the way from the home bucket, and fingerprint matches among them:
+            for (size_t j = (i - (size_t)_psl) & _mask; j != i; j = (j + 1) & _mask) {
+                ++_probed;
+                _matched += _t.meta[j].hashx == _m.hashx
+                            _i_if_store_hash(&& _t.hashes[j] == _t.hashes[i]);
+            }
+        }
+    }
+  #ifndef _i_fixed // else the tables are part of Self
+    st.bytes += self->bucket_count ? self->bucket_count*_bucksize + c_sizeof(struct hmap_meta) : 0;
+  #else
+    (void)_bucksize;
+  #endif
+    st.bytes += c_sizeof(Self);
+  #ifdef _i_slab
+    for (const struct _c_MEMB(_chunk_)* c = (const struct _c_MEMB(_chunk_)*)self->_slab.chunks; c; c = c->prev)
+        st.bytes += c_sizeof *c + c->n*c_sizeof c->node[0];
+  #endif
+    if (st.bucket_count) st.load_factor = (double)st.size/(double)st.bucket_count;
+    if (st.size) st.mean_psl = (double)_pslsum/(double)st.size;
+    if (_probed) st.fingerprint_collision_rate = (double)_matched/(double)_probed;
+    _i_if_stats( st.counters = self->_stats; )
+    return st;
+}
+
+#ifdef _i_parallel
+  #include "priv/hmap_build_prv.h"
+#endif
 #endif // i_implement
+#ifdef _i_chmap
+  #include "priv/chmap_prv.h"
+#endif
 #undef i_max_load_factor
+#undef i_simd_probe
+#undef _i_simd_probe
+#undef i_incremental
+#undef i_rehash_step
+#undef _i_incremental
+#undef i_store_hash
+#undef _i_store_hash
+#undef i_image
+#undef _i_image
+#undef _i_image_str
+#undef _i_if_store_hash
+#undef _m_slot
+#undef _i_fixed
+#undef i_slab
+#undef _i_slab
+#undef _i_if_slab
+#undef _i_slotref
+#undef i_parallel
+#undef _i_parallel
+#undef i_stats
+#undef _i_stats
+#undef _i_if_stats
+#undef _i_count
+#undef _i_elem_hash
 #undef _i_is_set
 #undef _i_is_map
 #undef _i_is_hash
@@ -0,0 +1,425 @@
+/* MIT License
+ *
+ * Copyright (c) 2025 Tyge Løvset
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Static map - minimal perfect hashing (PTHash-style hash and displace) of an immutable key set.
+/*
+#include <stdio.h>
+#include "stc/cstr.h"
+
+#define i_type Weekdays
+#define i_keypro cstr
+#define i_val int
+#include "stc/phmap.h"
+
+int main(void) {
+    Weekdays days = c_make(Weekdays, {{"Mon", 1}, {"Tue", 2}, {"Wed", 3}, {"Thu", 4},
+                                      {"Fri", 5}, {"Sat", 6}, {"Sun", 7}});
+    printf("Fri: %d\n", *Weekdays_at(&days, "Fri"));
+    printf("Xyz: %d\n", Weekdays_contains(&days, "Xyz"));
+
+    for (c_each_kv(k, v, Weekdays, days))
+        printf("%s: %d\n", cstr_str(k), *v);
+    Weekdays_drop(&days);
+}
+*/
+#include "priv/linkage.h"
+#include "types.h"
+
+#ifndef STC_PHMAP_H_INCLUDED
+#define STC_PHMAP_H_INCLUDED
+#include "common.h"
+#include <stdlib.h>
+// Keys are split into bucket_count ~ size/_phmap_lambda buckets. Each bucket stores a 16-bit
+// pilot which displaces all its keys to free slots of a table with slot_count ~ size/0.99 slots.
+// The few keys placed in the slots >= size are remapped to the free slots below size.
+#define _phmap_lambda 4
+#define _phmap_alpha 0.99
+#define _phmap_max_pilot 0xffff
+#define _phmap_max_seeds 64
+
+STC_INLINE uint64_t _phmap_key_hash(size_t hash, uint64_t seed)
+    { return _c_mix((uint64_t)hash ^ seed, _c_hs2); }
+
+// Skewed bucket assignment: 60% of the keys go to the first 30% of the buckets. The large buckets
+// are placed first while the table is still empty, which makes the pilot search much shorter.
+STC_INLINE size_t _phmap_bucket(uint64_t keyhash, isize bucket_count) {
+    uint64_t u = keyhash & 0xffffffff;
+    u = u < 0x9999999a ? u >> 1 : 0x4ccccccd + (((u - 0x9999999a)*7) >> 2);
+    return (size_t)((u * (uint64_t)bucket_count) >> 32);
+}
+
+STC_INLINE uint64_t _phmap_pilot_hash(unsigned pilot)
+    { return _c_mix(pilot, _c_hs3); }
+
+STC_INLINE size_t _phmap_slot(uint64_t keyhash, uint64_t pilothash, isize slot_count) {
+    uint64_t a = keyhash ^ pilothash, b = (uint64_t)slot_count;
+    _c_mum(&a, &b);
+    return (size_t)b; // high 64 bits of the product: in [0, slot_count)
+}
+#endif // STC_PHMAP_H_INCLUDED
+
+#ifndef _i_prefix
+  #define _i_prefix phmap_
+#endif
+#ifndef _i_is_set
+  #define _i_is_map
+  #define _i_MAP_ONLY c_true
+  #define _i_SET_ONLY c_false
+  #define _i_keyref(vp) (&(vp)->first)
+  #define _i_rawkey(rp) ((rp)->first)
+#else
+  #define _i_MAP_ONLY c_false
+  #define _i_SET_ONLY c_true
+  #define _i_keyref(vp) (vp)
+  #define _i_rawkey(rp) (*(rp))
+#endif
+#define _i_is_hash
+#include "priv/template.h"
+#ifndef i_declared
+  _c_DEFTYPES(_c_phtable_types, Self, i_key, i_val, _i_MAP_ONLY, _i_SET_ONLY);
+#endif
+
+_i_MAP_ONLY( struct _m_value {
+    _m_key first;
+    _m_mapped second;
+}; )
+
+typedef i_keyraw _m_keyraw;
+typedef i_valraw _m_rmapped;
+typedef _i_SET_ONLY( i_keyraw )
+        _i_MAP_ONLY( struct { _m_keyraw first;
+                              _m_rmapped second; } )
+_m_raw;
+
+// Replace the content of self with the n entries of raw. Entries with a key equal to an earlier
+// one are skipped. Returns false if memory ran out, or if distinct keys have equal i_hash values.
+STC_API bool            _c_MEMB(_build)(Self* self, const _m_raw raw[], isize n);
+#if !defined i_no_clone
+STC_API Self            _c_MEMB(_clone)(Self map);
+#endif
+STC_API void            _c_MEMB(_drop)(const Self* cself);
+
+STC_INLINE Self         _c_MEMB(_init)(void) { Self map = {0}; return map; }
+STC_INLINE Self         _c_MEMB(_with_n)(const _m_raw raw[], isize n)
+                            { Self map = {0}; _c_MEMB(_build)(&map, raw, n); return map; }
+STC_INLINE void         _c_MEMB(_clear)(Self* self) {
+                            _c_MEMB(_drop)(self);
+                            self->table = NULL, self->pilots = NULL, self->remap = NULL;
+                            self->seed = 0, self->size = self->slot_count = self->bucket_count = 0;
+                        }
+STC_INLINE bool         _c_MEMB(_is_empty)(const Self* map) { return !map->size; }
+STC_INLINE isize        _c_MEMB(_size)(const Self* map) { return map->size; }
+STC_INLINE isize        _c_MEMB(_bucket_count)(const Self* map) { return map->bucket_count; }
+
+// One slot probe and one key compare.
+STC_INLINE const _m_value* _c_MEMB(_get)(const Self* self, _m_keyraw rkey) {
+    if (self->size == 0) return NULL;
+    const uint64_t kh = _phmap_key_hash(i_hash((&rkey)), self->seed);
+    const unsigned pilot = self->pilots[_phmap_bucket(kh, self->bucket_count)];
+    size_t slot = _phmap_slot(kh, _phmap_pilot_hash(pilot), self->slot_count);
+    if (slot >= (size_t)self->size)
+        slot = self->remap[slot - (size_t)self->size];
+    const _m_value* ref = &self->table[slot];
+    const _m_keyraw r = i_keytoraw(_i_keyref(ref));
+    return i_eq((&r), (&rkey)) ? ref : NULL;
+}
+
+STC_INLINE _m_value* _c_MEMB(_get_mut)(Self* self, _m_keyraw rkey)
+    { return (_m_value*)_c_MEMB(_get)(self, rkey); }
+
+STC_INLINE bool _c_MEMB(_contains)(const Self* self, _m_keyraw rkey)
+    { return _c_MEMB(_get)(self, rkey) != NULL; }
+
+#ifdef _i_is_map
+    STC_INLINE const _m_mapped* _c_MEMB(_at)(const Self* self, _m_keyraw rkey) {
+        const _m_value* ref = _c_MEMB(_get)(self, rkey);
+        c_assert(ref);
+        return &ref->second;
+    }
+
+    STC_INLINE _m_mapped* _c_MEMB(_at_mut)(Self* self, _m_keyraw rkey)
+        { return (_m_mapped*)_c_MEMB(_at)(self, rkey); }
+#endif // _i_is_map
+
+#if !defined i_no_clone
+    STC_INLINE void _c_MEMB(_copy)(Self *self, const Self other) {
+        if (self->table == other.table)
+            return;
+        _c_MEMB(_drop)(self);
+        *self = _c_MEMB(_clone)(other);
+    }
+
+    STC_INLINE _m_value _c_MEMB(_value_clone)(_m_value _val) {
+        *_i_keyref(&_val) = i_keyclone((*_i_keyref(&_val)));
+        _i_MAP_ONLY( _val.second = i_valclone(_val.second); )
+        return _val;
+    }
+#endif // !i_no_clone
+
+STC_INLINE _m_raw _c_MEMB(_value_toraw)(const _m_value* val) {
+    return _i_SET_ONLY( i_keytoraw(val) )
+           _i_MAP_ONLY( c_literal(_m_raw){i_keytoraw((&val->first)), i_valtoraw((&val->second))} );
+}
+
+STC_INLINE void _c_MEMB(_value_drop)(_m_value* _val) {
+    i_keydrop(_i_keyref(_val));
+    _i_MAP_ONLY( i_valdrop((&_val->second)); )
+}
+
+STC_INLINE Self _c_MEMB(_move)(Self *self) {
+    Self m = *self;
+    memset(self, 0, sizeof *self);
+    return m;
+}
+
+STC_INLINE void _c_MEMB(_take)(Self *self, Self unowned) {
+    _c_MEMB(_drop)(self);
+    *self = unowned;
+}
+
+STC_INLINE _m_iter _c_MEMB(_begin)(const Self* self) {
+    _m_iter it = {self->table, self->table + self->size};
+    if (self->size == 0) it.ref = NULL;
+    return it;
+}
+
+STC_INLINE _m_iter _c_MEMB(_end)(const Self* self)
+    { (void)self; return c_literal(_m_iter){0}; }
+
+STC_INLINE void _c_MEMB(_next)(_m_iter* it)
+    { if (++it->ref == it->end) it->ref = NULL; }
+
+STC_INLINE _m_iter _c_MEMB(_advance)(_m_iter it, size_t n) {
+    if ((size_t)(it.end - it.ref) <= n) it.ref = NULL;
+    else it.ref += n;
+    return it;
+}
+
+STC_INLINE _m_iter _c_MEMB(_find)(const Self* self, _m_keyraw rkey) {
+    _m_iter it = {(_m_value*)_c_MEMB(_get)(self, rkey), self->table + self->size};
+    return it;
+}
+
+STC_INLINE bool _c_MEMB(_eq)(const Self* self, const Self* other) {
+    if (self->size != other->size) return false;
+    for (isize i = 0; i < self->size; ++i) {
+        const _m_keyraw _raw = i_keytoraw(_i_keyref(&self->table[i]));
+        if (!_c_MEMB(_contains)(other, _raw)) return false;
+    }
+    return true;
+}
+
+/* -------------------------- IMPLEMENTATION ------------------------- */
+#if defined i_implement
+
+STC_DEF void _c_MEMB(_drop)(const Self* cself) {
+    Self* self = (Self*)cself;
+    if (self->size == 0) return;
+    for (isize i = 0; i < self->size; ++i)
+        _c_MEMB(_value_drop)(&self->table[i]);
+    i_free(self->table, self->size*c_sizeof *self->table);
+    i_free(self->pilots, self->bucket_count*c_sizeof *self->pilots);
+    i_free(self->remap, (self->slot_count - self->size)*c_sizeof *self->remap);
+}
+
+#if !defined i_no_clone
+STC_DEF Self _c_MEMB(_clone)(Self map) {
+    Self out = map;
+    if (map.size == 0) return out;
+    out.table = _i_malloc(_m_value, map.size);
+    out.pilots = _i_malloc(uint16_t, map.bucket_count);
+    out.remap = _i_malloc(uint32_t, map.slot_count - map.size);
+    if (!(out.table && out.pilots && out.remap)) {
+        i_free(out.table, map.size*c_sizeof *out.table);
+        i_free(out.pilots, map.bucket_count*c_sizeof *out.pilots);
+        i_free(out.remap, (map.slot_count - map.size)*c_sizeof *out.remap);
+        return c_literal(Self){0};
+    }
+    for (isize i = 0; i < map.size; ++i)
+        out.table[i] = _c_MEMB(_value_clone)(map.table[i]);
+    c_memcpy(out.pilots, map.pilots, map.bucket_count*c_sizeof *out.pilots);
+    c_memcpy(out.remap, map.remap, (map.slot_count - map.size)*c_sizeof *out.remap);
+    return out;
+}
+#endif
+
+// Place the keys of each bucket, largest buckets first, with the first pilot that moves all
+// of them to free slots. Returns false if some bucket found no pilot: then try another seed.
+static bool _c_MEMB(_place_)(Self* self, const uint64_t kh[], const uint32_t order[],
+                             const uint32_t start[], uint64_t taken[], uint32_t slot[]) {
+    const isize nb = self->bucket_count, ns = self->slot_count;
+    uint32_t* bysize = (uint32_t*)c_malloc(nb*c_sizeof(uint32_t));
+    isize maxsize = 0, *cnt;
+    if (bysize == NULL) return false;
+    for (isize b = 0; b < nb; ++b)
+        if (start[b + 1] - start[b] > maxsize) maxsize = start[b + 1] - start[b];
+    cnt = (isize*)c_calloc(maxsize + 2, c_sizeof(isize));
+    if (cnt == NULL) { c_free(bysize, nb*c_sizeof(uint32_t)); return false; }
+    for (isize b = 0; b < nb; ++b) // counting sort of buckets by decreasing size
+        ++cnt[maxsize - (start[b + 1] - start[b]) + 1];
+    for (isize k = 1; k <= maxsize + 1; ++k)
+        cnt[k] += cnt[k - 1];
+    for (isize b = 0; b < nb; ++b)
+        bysize[cnt[maxsize - (start[b + 1] - start[b])]++] = (uint32_t)b;
+    c_free(cnt, (maxsize + 2)*c_sizeof(isize));
+
+    bool ok = true;
+    for (isize k = 0; ok && k < nb; ++k) {
+        const uint32_t b = bysize[k], first = start[b], last = start[b + 1];
+        unsigned pilot = 0;
+        self->pilots[b] = 0;
+        if (first == last) continue;
+        for (; pilot <= _phmap_max_pilot; ++pilot) {
+            const uint64_t ph = _phmap_pilot_hash(pilot);
+            uint32_t j = first;
+            for (; j < last; ++j) {
+                const size_t s = _phmap_slot(kh[order[j]], ph, ns);
+                if (taken[s >> 6] >> (s & 63) & 1) break;
+                taken[s >> 6] |= (uint64_t)1 << (s & 63);
+                slot[order[j]] = (uint32_t)s;
+            }
+            if (j == last) break;
+            while (j-- > first) // undo
+                taken[slot[order[j]] >> 6] &= ~((uint64_t)1 << (slot[order[j]] & 63));
+        }
+        if (pilot > _phmap_max_pilot) ok = false;
+        else self->pilots[b] = (uint16_t)pilot;
+    }
+    c_free(bysize, nb*c_sizeof(uint32_t));
+    return ok;
+}
+
+// Counting sort of the unskipped keys by bucket: bucket b has keys order[start[b] .. start[b+1]).
+static void _c_MEMB(_bucket_sort_)(const Self* self, const uint64_t kh[], const uint8_t skip[],
+                                   isize n, uint32_t order[], uint32_t start[]) {
+    const isize nb = self->bucket_count;
+    memset(start, 0, (size_t)(nb + 1)*sizeof *start);
+    for (isize i = 0; i < n; ++i)
+        if (!skip[i]) ++start[_phmap_bucket(kh[i], nb) + 1];
+    for (isize b = 0; b < nb; ++b)
+        start[b + 1] += start[b];
+    for (isize i = 0; i < n; ++i)
+        if (!skip[i]) order[start[_phmap_bucket(kh[i], nb)]++] = (uint32_t)i;
+    for (isize b = nb; b > 0; --b)
+        start[b] = start[b - 1];
+    start[0] = 0;
+}
+
+STC_DEF bool _c_MEMB(_build)(Self* self, const _m_raw raw[], const isize n) {
+    _c_MEMB(_clear)(self);
+    if (n == 0) return true;
+    if ((uint64_t)n > UINT32_MAX/2) return false;
+    const isize nb = n/_phmap_lambda + 1;
+    uint64_t* kh = (uint64_t*)c_malloc(n*c_sizeof(uint64_t));
+    size_t* hash = (size_t*)c_malloc(n*c_sizeof(size_t));
+    uint32_t* order = (uint32_t*)c_malloc(n*c_sizeof(uint32_t));
+    uint32_t* slot = (uint32_t*)c_malloc(n*c_sizeof(uint32_t));
+    uint8_t* skip = (uint8_t*)c_calloc(n, 1);
+    uint32_t* start = (uint32_t*)c_malloc((nb + 1)*c_sizeof(uint32_t));
+    uint64_t* taken = NULL;
+    isize ns = 0, m = n; // m: number of unique keys
+    bool ok = kh && hash && order && slot && skip && start;
+
+    if (ok) { // skip duplicate keys; they have equal hashes, so are in the same bucket
+        self->bucket_count = nb;
+        for (isize i = 0; i < n; ++i) {
+            hash[i] = i_hash((&_i_rawkey(&raw[i])));
+            kh[i] = _phmap_key_hash(hash[i], 0);
+        }
+        _c_MEMB(_bucket_sort_)(self, kh, skip, n, order, start);
+        for (isize b = 0; ok && b < nb; ++b)
+            for (uint32_t j = start[b]; j < start[b + 1]; ++j)
+                for (uint32_t k = start[b]; k < j; ++k) {
+                    const uint32_t x = order[j], y = order[k]; // y < x
+                    if (skip[y] || hash[x] != hash[y]) continue;
+                    if (!(i_eq((&_i_rawkey(&raw[x])), (&_i_rawkey(&raw[y]))))) ok = false;
+                    skip[x] = 1, --m;
+                    break;
+                }
+        ns = (isize)((double)m/_phmap_alpha) + 1;
+        taken = (uint64_t*)c_malloc((ns + 63)/64*c_sizeof(uint64_t));
+        self->pilots = _i_malloc(uint16_t, nb);
+        self->slot_count = ns;
+        ok = ok && taken && self->pilots;
+    }
+    for (int attempt = 0; ok; ++attempt) {
+        if (attempt == _phmap_max_seeds) { ok = false; break; }
+        if (attempt > 0) {
+            self->seed = _c_mix((uint64_t)attempt, _c_hs0);
+            for (isize i = 0; i < n; ++i)
+                kh[i] = _phmap_key_hash(hash[i], self->seed);
+        }
+        if (attempt > 0 || m != n)
+            _c_MEMB(_bucket_sort_)(self, kh, skip, n, order, start);
+        memset(taken, 0, (size_t)(ns + 63)/64*sizeof *taken);
+        if (_c_MEMB(_place_)(self, kh, order, start, taken, slot))
+            break;
+    }
+    if (ok) {
+        self->table = _i_malloc(_m_value, m);
+        self->remap = _i_malloc(uint32_t, ns - m);
+        ok = self->table && self->remap;
+    }
+    if (ok) {
+        isize freeslot = 0;
+        for (isize s = m; s < ns; ++s) { // map the used slots >= m to the free slots < m
+            self->remap[s - m] = 0;
+            if (taken[s >> 6] >> (s & 63) & 1) {
+                while (taken[freeslot >> 6] >> (freeslot & 63) & 1) ++freeslot;
+                self->remap[s - m] = (uint32_t)freeslot++;
+            }
+        }
+        for (isize i = 0; i < n; ++i) {
+            if (skip[i]) continue;
+            const uint32_t s = slot[i] < m ? slot[i] : self->remap[slot[i] - m];
+            _m_value* ref = &self->table[s];
+            *_i_keyref(ref) = i_keyfrom(_i_rawkey(&raw[i]));
+            _i_MAP_ONLY( ref->second = i_valfrom(raw[i].second); )
+        }
+        self->size = m;
+    } else {
+        if (self->table) i_free(self->table, m*c_sizeof *self->table);
+        if (self->remap) i_free(self->remap, (ns - m)*c_sizeof *self->remap);
+        if (self->pilots) i_free(self->pilots, nb*c_sizeof *self->pilots);
+        self->table = NULL, self->pilots = NULL, self->remap = NULL;
+        self->bucket_count = self->slot_count = 0;
+    }
+    if (taken) c_free(taken, (ns + 63)/64*c_sizeof(uint64_t));
+    if (start) c_free(start, (nb + 1)*c_sizeof(uint32_t));
+    if (skip) c_free(skip, n);
+    if (slot) c_free(slot, n*c_sizeof(uint32_t));
+    if (order) c_free(order, n*c_sizeof(uint32_t));
+    if (hash) c_free(hash, n*c_sizeof(size_t));
+    if (kh) c_free(kh, n*c_sizeof(uint64_t));
+    return ok;
+}
+#endif // i_implement
+#undef _i_is_set
+#undef _i_is_map
+#undef _i_is_hash
+#undef _i_keyref
+#undef _i_rawkey
+#undef _i_MAP_ONLY
+#undef _i_SET_ONLY
+#include "priv/linkage2.h"
+#include "priv/template2.h"
@@ -0,0 +1,244 @@
+/* MIT License
+ *
+ * Copyright (c) 2025 Tyge Løvset
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// IWYU pragma: private, include "stc/chmap.h"
+// Included at the end of hmap.h by chmap.h: Self is the hmap type of each shard.
+#define _i_shard c_JOIN(_i_chmap, _shard)
+#define _c_SMEMB(name) c_JOIN(_i_shard, name)
+#undef Self
+#define Self _i_chmap
+
+typedef _c_SMEMB(_key) _m_key;
+typedef _c_SMEMB(_mapped) _m_mapped;
+typedef _c_SMEMB(_value) _m_value;
+typedef _c_SMEMB(_keyraw) _m_keyraw;
+typedef _c_SMEMB(_rmapped) _m_rmapped;
+typedef _c_SMEMB(_raw) _m_raw;
+
+struct _c_MEMB(_cell_) { chmap_rwlock lock; _i_shard map; };
+
+typedef struct Self {
+    union { struct _c_MEMB(_cell_) cell;
+            char _pad[(sizeof(struct _c_MEMB(_cell_)) + 63) & ~(size_t)63]; } shard[i_shards];
+} Self;
+
+// The shard is selected by the high 32 bits of the hash; hmap uses the low bits.
+STC_INLINE struct _c_MEMB(_cell_)* _c_MEMB(_cell_)(const Self* self, size_t hash) {
+  #if SIZE_MAX > 0xffffffff
+    const uint64_t hi = (uint64_t)hash >> 32;
+  #else
+    const uint64_t hi = (uint32_t)(hash*0x9e3779b9); // spread the low bits upwards
+  #endif
+    return (struct _c_MEMB(_cell_)*)&self->shard[(hi*(i_shards)) >> 32].cell;
+}
+
+STC_INLINE Self _c_MEMB(_init)(void) { Self map = {0}; return map; }
+
+// Not thread-safe: no other thread may access the map.
+STC_INLINE void _c_MEMB(_drop)(const Self* self) {
+    for (int i = 0; i < (i_shards); ++i)
+        _c_SMEMB(_drop)(&self->shard[i].cell.map);
+}
+
+STC_INLINE void _c_MEMB(_clear)(Self* self) {
+    for (int i = 0; i < (i_shards); ++i) {
+        chmap_rwlock_wrlock(&self->shard[i].cell.lock);
+        _c_SMEMB(_clear)(&self->shard[i].cell.map);
+        chmap_rwlock_wrunlock(&self->shard[i].cell.lock);
+    }
+}
+
+STC_INLINE bool _c_MEMB(_reserve)(Self* self, isize capacity) {
+    bool ok = true;
+    for (int i = 0; i < (i_shards); ++i) {
+        chmap_rwlock_wrlock(&self->shard[i].cell.lock);
+        ok &= _c_SMEMB(_reserve)(&self->shard[i].cell.map, capacity/(i_shards) + 1);
+        chmap_rwlock_wrunlock(&self->shard[i].cell.lock);
+    }
+    return ok;
+}
+
+// Sum of the shard sizes, each read at a different time while other threads may modify the map.
+STC_INLINE isize _c_MEMB(_size)(const Self* self) {
+    isize n = 0;
+    for (int i = 0; i < (i_shards); ++i) {
+        struct _c_MEMB(_cell_)* c = (struct _c_MEMB(_cell_)*)&self->shard[i].cell;
+        chmap_rwlock_rdlock(&c->lock);
+        n += _c_SMEMB(_size)(&c->map);
+        chmap_rwlock_rdunlock(&c->lock);
+    }
+    return n;
+}
+
+STC_INLINE bool _c_MEMB(_is_empty)(const Self* self)
+    { return _c_MEMB(_size)(self) == 0; }
+
+// Calls fn(val, arg) for the entry with key rkey under the shared lock. Returns false if not found.
+STC_INLINE bool _c_MEMB(_read)(const Self* self, _m_keyraw rkey,
+                               void (*fn)(const _m_value* val, void* arg), void* arg) {
+    const size_t hash = i_hash((&rkey));
+    struct _c_MEMB(_cell_)* c = _c_MEMB(_cell_)(self, hash);
+    chmap_rwlock_rdlock(&c->lock);
+    const _m_value* ref = c->map.size ? _c_SMEMB(_lookup_hash_)(&c->map, &rkey, hash) : NULL;
+    if (ref != NULL && fn != NULL) fn(ref, arg);
+    chmap_rwlock_rdunlock(&c->lock);
+    return ref != NULL;
+}
+
+STC_INLINE bool _c_MEMB(_contains)(const Self* self, _m_keyraw rkey)
+    { return _c_MEMB(_read)(self, rkey, NULL, NULL); }
+
+// Calls fn(val, arg) for the entry with key rkey under the exclusive lock. fn may modify the
+// mapped value, but not the key. Returns false if not found.
+STC_INLINE bool _c_MEMB(_update)(Self* self, _m_keyraw rkey,
+                                 void (*fn)(_m_value* val, void* arg), void* arg) {
+    const size_t hash = i_hash((&rkey));
+    struct _c_MEMB(_cell_)* c = _c_MEMB(_cell_)(self, hash);
+    chmap_rwlock_wrlock(&c->lock);
+    _m_value* ref = c->map.size ? _c_SMEMB(_lookup_hash_)(&c->map, &rkey, hash) : NULL;
+    if (ref != NULL) fn(ref, arg);
+    chmap_rwlock_wrunlock(&c->lock);
+    return ref != NULL;
+}
+
+#if !defined i_no_clone
+// Copies the mapped value of rkey to *out (with i_valclone). Returns false if not found.
+STC_INLINE bool _c_MEMB(_get)(const Self* self, _m_keyraw rkey, _m_mapped* out) {
+    const size_t hash = i_hash((&rkey));
+    struct _c_MEMB(_cell_)* c = _c_MEMB(_cell_)(self, hash);
+    chmap_rwlock_rdlock(&c->lock);
+    const _m_value* ref = c->map.size ? _c_SMEMB(_lookup_hash_)(&c->map, &rkey, hash) : NULL;
+    if (ref != NULL) *out = i_valclone(ref->second);
+    chmap_rwlock_rdunlock(&c->lock);
+    return ref != NULL;
+}
+#endif
+
+// Returns true if inserted. Otherwise key and mapped are dropped.
+STC_INLINE bool _c_MEMB(_insert)(Self* self, _m_key key, _m_mapped mapped) {
+    const _m_keyraw rkey = i_keytoraw((&key));
+    const size_t hash = i_hash((&rkey));
+    struct _c_MEMB(_cell_)* c = _c_MEMB(_cell_)(self, hash);
+    chmap_rwlock_wrlock(&c->lock);
+    _c_SMEMB(_result) res = _c_SMEMB(_insert_entry_hash_)(&c->map, &rkey, hash);
+    if (res.inserted)
+        res.ref->first = key, res.ref->second = mapped;
+    chmap_rwlock_wrunlock(&c->lock);
+    if (!res.inserted)
+        { i_keydrop((&key)); i_valdrop((&mapped)); }
+    return res.inserted;
+}
+
+// Returns true if inserted, false if the mapped value of an existing entry was replaced.
+STC_INLINE bool _c_MEMB(_insert_or_assign)(Self* self, _m_key key, _m_mapped mapped) {
+    const _m_keyraw rkey = i_keytoraw((&key));
+    const size_t hash = i_hash((&rkey));
+    struct _c_MEMB(_cell_)* c = _c_MEMB(_cell_)(self, hash);
+    chmap_rwlock_wrlock(&c->lock);
+    _c_SMEMB(_result) res = _c_SMEMB(_insert_entry_hash_)(&c->map, &rkey, hash);
+    _m_mapped old = mapped;
+    if (res.inserted)
+        res.ref->first = key;
+    if (res.ref != NULL)
+        old = res.ref->second, res.ref->second = mapped;
+    chmap_rwlock_wrunlock(&c->lock);
+    if (!res.inserted) { // drop outside of the lock
+        i_keydrop((&key));
+        i_valdrop((&old));
+    }
+    return res.inserted;
+}
+
+// Returns true if erased.
+STC_INLINE bool _c_MEMB(_erase)(Self* self, _m_keyraw rkey) {
+    const size_t hash = i_hash((&rkey));
+    struct _c_MEMB(_cell_)* c = _c_MEMB(_cell_)(self, hash);
+    chmap_rwlock_wrlock(&c->lock);
+    _m_value* ref = c->map.size ? _c_SMEMB(_lookup_hash_)(&c->map, &rkey, hash) : NULL;
+    if (ref != NULL) _c_SMEMB(_erase_entry)(&c->map, ref);
+    chmap_rwlock_wrunlock(&c->lock);
+    return ref != NULL;
+}
+
+#if !defined i_no_emplace
+// Inserts (rkey, rmapped) if rkey is not in the map. Then calls fn(val, arg) on the entry under
+// the exclusive lock, unless fn is NULL. Returns true if inserted.
+STC_INLINE bool _c_MEMB(_emplace_update)(Self* self, _m_keyraw rkey, _m_rmapped rmapped,
+                                         void (*fn)(_m_value* val, void* arg), void* arg) {
+    const size_t hash = i_hash((&rkey));
+    struct _c_MEMB(_cell_)* c = _c_MEMB(_cell_)(self, hash);
+    chmap_rwlock_wrlock(&c->lock);
+    _c_SMEMB(_result) res = _c_SMEMB(_insert_entry_hash_)(&c->map, &rkey, hash);
+    if (res.inserted)
+        res.ref->first = i_keyfrom(rkey), res.ref->second = i_valfrom(rmapped);
+    if (res.ref != NULL && fn != NULL)
+        fn(res.ref, arg);
+    chmap_rwlock_wrunlock(&c->lock);
+    return res.inserted;
+}
+
+// Returns true if inserted.
+STC_INLINE bool _c_MEMB(_emplace)(Self* self, _m_keyraw rkey, _m_rmapped rmapped)
+    { return _c_MEMB(_emplace_update)(self, rkey, rmapped, NULL, NULL); }
+
+// Returns true if inserted, false if the mapped value of an existing entry was replaced.
+STC_INLINE bool _c_MEMB(_emplace_or_assign)(Self* self, _m_keyraw rkey, _m_rmapped rmapped) {
+    const size_t hash = i_hash((&rkey));
+    struct _c_MEMB(_cell_)* c = _c_MEMB(_cell_)(self, hash);
+    chmap_rwlock_wrlock(&c->lock);
+    _c_SMEMB(_result) res = _c_SMEMB(_insert_entry_hash_)(&c->map, &rkey, hash);
+    if (res.inserted)
+        res.ref->first = i_keyfrom(rkey);
+    else if (res.ref != NULL)
+        i_valdrop((&res.ref->second));
+    if (res.ref != NULL)
+        res.ref->second = i_valfrom(rmapped);
+    chmap_rwlock_wrunlock(&c->lock);
+    return res.inserted;
+}
+#endif // !i_no_emplace
+
+STC_INLINE bool _c_MEMB(_put)(Self* self, _m_keyraw rkey, _m_rmapped rmapped) {
+  #ifdef i_no_emplace
+    return _c_MEMB(_insert_or_assign)(self, rkey, rmapped);
+  #else
+    return _c_MEMB(_emplace_or_assign)(self, rkey, rmapped);
+  #endif
+}
+
+// Calls fn(val, arg) for all entries, one shard at a time under its lock. Entries inserted or
+// erased by other threads during the visit may or may not be seen.
+STC_INLINE void _c_MEMB(_visit)(const Self* self, void (*fn)(const _m_value* val, void* arg), void* arg) {
+    for (int i = 0; i < (i_shards); ++i) {
+        struct _c_MEMB(_cell_)* c = (struct _c_MEMB(_cell_)*)&self->shard[i].cell;
+        chmap_rwlock_rdlock(&c->lock);
+        for (_c_SMEMB(_iter) it = _c_SMEMB(_begin)(&c->map); it.ref; _c_SMEMB(_next)(&it))
+            fn(it.ref, arg);
+        chmap_rwlock_rdunlock(&c->lock);
+    }
+}
+
+#undef _c_SMEMB
+#undef _i_shard
+#undef _i_chmap
+#undef i_shards
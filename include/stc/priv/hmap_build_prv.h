@@ -0,0 +1,251 @@
+/* MIT License
+ *
+ * Copyright (c) 2025 Tyge Løvset
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+// IWYU pragma: private, include "stc/hmap.h"
+
+// build_n() of hmap/hset, included by hmap.h with i_parallel. The buckets are split into one
+// region per thread, and the keys are partitioned by the region of their home bucket:
+// 1. each thread hashes a slice of the input, and counts its keys per region,
+// 2. each thread copies the hashes and indices of its keys to the regions, in input order,
+// 3. each thread inserts the keys of a region into its buckets as put_n() would. Entries pushed
+//    past the region's end are kept in an overflow list that continues the region's buckets,
+// 4. the overflow entries are inserted in turn. A robin-hood table is ordered by home bucket,
+//    and by insertion order within a home bucket, so the table equals the one of put_n().
+#include "sync_prv.h"
+
+#if defined _i_slab || defined _i_fixed // the entries are not in a heap table: build in turn
+STC_DEF Self _c_MEMB(_build_n)(const _m_raw* raw, isize n, int threads)
+    { (void)threads; return _c_MEMB(_with_n)(raw, n); }
+#else
+
+struct _c_MEMB(_build_key_) { size_t hash; isize idx; };
+struct _c_MEMB(_build_ext_) { _m_value val; size_t hash; struct hmap_meta meta; };
+
+struct _c_MEMB(_build_) {
+    Self* map;
+    const _m_raw* raw;
+    isize n;
+    int nt;                              // threads = slices of the input = regions of the table
+    size_t* hv;                          // hash of each input key
+    struct _c_MEMB(_build_key_)* keys;   // keys by region, in input order
+    isize* cnt;                          // keys of slice t in region r at [t*nt + r], then offsets
+    isize beg[_c_parallel_max + 1];      // keys of region r start at beg[r]
+    struct {
+        struct _c_MEMB(_build_ext_)* ext;  // buckets after the region's end, all in use
+        isize len, cap, size;
+        bool failed;
+    } reg[_c_parallel_max];
+};
+
+#define _i_build_lo(b, r) (((b)->map->bucket_count*(r) + (b)->nt - 1)/(b)->nt) // first bucket of r
+#define _i_build_region(b, home) ((int)((uint64_t)(home)*(uint64_t)(b)->nt/(uint64_t)(b)->map->bucket_count))
+#define _i_build_key(b, i) (&_i_SET_ONLY((b)->raw[i]) _i_MAP_ONLY((b)->raw[i].first))
+
+static void _c_MEMB(_build_hash_)(void* arg, int t) {
+    struct _c_MEMB(_build_)* b = (struct _c_MEMB(_build_)*)arg;
+    const size_t mask = (size_t)b->map->bucket_count - 1;
+    isize* cnt = b->cnt + t*b->nt;
+    for (isize i = b->n*t/b->nt, e = b->n*(t + 1)/b->nt; i < e; ++i) {
+        const size_t h = i_hash(_i_build_key(b, i));
+        b->hv[i] = h;
+        ++cnt[_i_build_region(b, h & mask)];
+    }
+}
+
+static void _c_MEMB(_build_scatter_)(void* arg, int t) {
+    struct _c_MEMB(_build_)* b = (struct _c_MEMB(_build_)*)arg;
+    const size_t mask = (size_t)b->map->bucket_count - 1;
+    isize* cnt = b->cnt + t*b->nt;
+    for (isize i = b->n*t/b->nt, e = b->n*(t + 1)/b->nt; i < e; ++i) {
+        struct _c_MEMB(_build_key_)* k = &b->keys[cnt[_i_build_region(b, b->hv[i] & mask)]++];
+        k->hash = b->hv[i], k->idx = i;
+    }
+}
+
+// Insert x at overflow bucket e of region r, moving the entries from e on one bucket up.
+static void _c_MEMB(_build_ext_insert_)(struct _c_MEMB(_build_)* b, int r, isize e,
+                                        struct _c_MEMB(_build_ext_)* x) {
+    if (b->reg[r].len == b->reg[r].cap) {
+        const isize cap = b->reg[r].cap*2 + 64;
+        struct _c_MEMB(_build_ext_)* ext = (struct _c_MEMB(_build_ext_)*)
+            i_realloc(b->reg[r].ext, b->reg[r].cap*c_sizeof *ext, cap*c_sizeof *ext);
+        if (ext == NULL) {
+            b->reg[r].failed = true;
+            _c_MEMB(_value_drop)(&x->val);
+            return;
+        }
+        b->reg[r].ext = ext, b->reg[r].cap = cap;
+    }
+  #ifndef _i_store_hash // the entry may come from the table, which holds no hash
+    const _m_keyraw _raw = i_keytoraw(_i_keyref(&x->val));
+    x->hash = i_hash((&_raw));
+  #endif
+    struct _c_MEMB(_build_ext_)* ext = b->reg[r].ext;
+    c_memmove(ext + e + 1, ext + e, (b->reg[r].len - e)*c_sizeof *ext);
+    for (isize j = e + 1; j <= b->reg[r].len; ++j)
+        ext[j].meta.dist = (uint16_t)((ext[j].meta.dist + 1) & _distmask);
+    ext[e] = *x;
+    ++b->reg[r].len;
+}
+
+static void _c_MEMB(_build_insert_)(void* arg, int r) {
+    struct _c_MEMB(_build_)* b = (struct _c_MEMB(_build_)*)arg;
+    Self* map = b->map;
+    const size_t mask = (size_t)map->bucket_count - 1;
+    const isize hi = _i_build_lo(b, r + 1);
+    for (isize k = b->beg[r], end = b->beg[r + 1]; k < end && !b->reg[r].failed; ++k) {
+        if (k + _hmap_ahead < end) {
+            const size_t idx = b->keys[k + _hmap_ahead].hash & mask;
+            c_prefetch(&map->meta[idx]);
+            c_prefetch(&map->table[idx]);
+        }
+        const isize i = b->keys[k].idx;
+        const _m_keyraw* rk = _i_build_key(b, i);
+        struct _c_MEMB(_build_ext_) x = {.hash=b->keys[k].hash};
+        x.meta.hashx = (uint16_t)((x.hash >> 24) & _hashmask);
+        x.meta.dist = 1;
+        isize p = (isize)(x.hash & mask);
+        _m_value* v = NULL;
+
+        for (;; ++p, x.meta.dist = (uint16_t)((x.meta.dist + 1) & _distmask)) { // lookup
+            struct hmap_meta m;
+            _m_value* d;
+            if (p < hi) {
+                m = map->meta[p], d = &map->table[p];
+            } else if (p - hi < b->reg[r].len) {
+                m = b->reg[r].ext[p - hi].meta, d = &b->reg[r].ext[p - hi].val;
+            } else break;
+            if (m.dist < x.meta.dist)
+                break;
+          #ifdef _i_store_hash
+            const uint32_t h = p < hi ? map->hashes[p] : (uint32_t)b->reg[r].ext[p - hi].hash;
+            if (m.hashx == x.meta.hashx && h == (uint32_t)x.hash) {
+          #else
+            if (m.hashx == x.meta.hashx) {
+          #endif
+                const _m_keyraw _raw = i_keytoraw(_i_keyref(d));
+                if (i_eq((&_raw), rk)) { v = d; break; }
+            }
+        }
+        if (v != NULL) { // as put_n() of a key in the map
+          #if defined i_no_emplace
+            _m_key _key = *rk;
+            i_keydrop((&_key));
+            _i_MAP_ONLY( i_valdrop((&v->second)); v->second = b->raw[i].second; )
+          #else
+            _i_MAP_ONLY( i_valdrop((&v->second)); v->second = i_valfrom(b->raw[i].second); )
+          #endif
+            continue;
+        }
+      #if defined i_no_emplace
+        *_i_keyref(&x.val) = *rk;
+        _i_MAP_ONLY( x.val.second = b->raw[i].second; )
+      #else
+        *_i_keyref(&x.val) = i_keyfrom((*rk));
+        _i_MAP_ONLY( x.val.second = i_valfrom(b->raw[i].second); )
+      #endif
+        ++b->reg[r].size;
+        for (; p < hi; ++p) { // put x at p, and move the rest of the cluster one bucket up
+            const struct hmap_meta m = map->meta[p];
+            _m_value d = map->table[p];
+            map->meta[p] = x.meta;
+            map->table[p] = x.val;
+          #ifdef _i_store_hash
+            const uint32_t h = map->hashes[p];
+            map->hashes[p] = (uint32_t)x.hash;
+            x.hash = h;
+          #endif
+            if (m.dist == 0)
+                break;
+            x.val = d, x.meta = m;
+            x.meta.dist = (uint16_t)((x.meta.dist + 1) & _distmask);
+        }
+        if (p >= hi)
+            _c_MEMB(_build_ext_insert_)(b, r, p - hi, &x);
+    }
+}
+
+STC_DEF Self
+_c_MEMB(_build_n)(const _m_raw* raw, const isize n, int threads) {
+    Self map = {0};
+    struct _c_MEMB(_build_) b = {.map=&map, .raw=raw, .n=n};
+    if (n == 0 || !_c_MEMB(_reserve)(&map, n))
+        return map;
+    b.nt = threads < 1 ? 1 : threads > _c_parallel_max ? _c_parallel_max : threads;
+    while (b.nt > 1 && n/b.nt < 4096) // not worth a thread
+        --b.nt;
+    if (b.nt == 1) {
+        _c_MEMB(_put_n)(&map, raw, n);
+        return map;
+    }
+    b.hv = _i_malloc(size_t, n);
+    b.keys = _i_malloc(struct _c_MEMB(_build_key_), n);
+    b.cnt = _i_calloc(isize, b.nt*b.nt);
+    bool ok = b.hv && b.keys && b.cnt;
+
+    if (ok) {
+        _c_parallel(_c_MEMB(_build_hash_), &b, b.nt);
+        isize sum = 0;
+        for (int r = 0; r < b.nt; ++r) {
+            b.beg[r] = sum;
+            for (int t = 0; t < b.nt; ++t) {
+                const isize c = b.cnt[t*b.nt + r];
+                b.cnt[t*b.nt + r] = sum;
+                sum += c;
+            }
+        }
+        b.beg[b.nt] = sum;
+        _c_parallel(_c_MEMB(_build_scatter_), &b, b.nt);
+        _c_parallel(_c_MEMB(_build_insert_), &b, b.nt);
+
+        for (int r = 0; r < b.nt; ++r)
+            ok &= !b.reg[r].failed;
+        _i_if_stats( const struct hmap_counters _st = map._stats; )
+        for (int r = 0; r < b.nt; ++r) {
+            for (isize e = 0; e < b.reg[r].len; ++e) { // as many as the clusters spilled
+                struct _c_MEMB(_build_ext_)* x = &b.reg[r].ext[e];
+                if (ok) {
+                    const _m_keyraw _raw = i_keytoraw(_i_keyref(&x->val));
+                    map.table[_c_MEMB(_bucket_insert_)(&map, &_raw, x->hash).idx] = x->val; // move
+                } else {
+                    _c_MEMB(_value_drop)(&x->val);
+                }
+            }
+            map.size += b.reg[r].size;
+            i_free(b.reg[r].ext, b.reg[r].cap*c_sizeof *b.reg[r].ext);
+        }
+        _i_if_stats( map._stats = _st; )
+    }
+    if (!ok) { // out of memory: build in turn
+        _c_MEMB(_clear)(&map);
+        _c_MEMB(_put_n)(&map, raw, n);
+    }
+    i_free(b.hv, n*c_sizeof *b.hv);
+    i_free(b.keys, n*c_sizeof *b.keys);
+    i_free(b.cnt, b.nt*b.nt*c_sizeof *b.cnt);
+    return map;
+}
+
+#undef _i_build_lo
+#undef _i_build_region
+#undef _i_build_key
+#endif // !_i_slab && !_i_fixed
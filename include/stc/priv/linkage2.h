@@ -28,6 +28,15 @@
 #undef i_free
 #undef i_aux
 #undef _i_aux_struct
+#undef _i_rehash_struct
+#undef _i_rehash_iter
+#undef _i_hashes_struct
+#undef _i_hashes_fixed
+#undef _i_table_struct
+#undef _i_stats_struct
+#undef _i_slot
+#undef _i_slab_struct
+#undef _i_slab_iter
 
 #undef i_static
 #undef i_header
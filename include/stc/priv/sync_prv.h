@@ -0,0 +1,229 @@
+/* MIT License
+ *
+ * Copyright (c) 2025 Tyge Løvset
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// IWYU pragma: private
+// Atomics, spin-wait, the reader-writer spin lock and the reader epoch used by chmap, rcmap and skmap.
+#ifndef STC_SYNC_PRV_H_INCLUDED
+#define STC_SYNC_PRV_H_INCLUDED
+#include "../common.h"
+
+#if defined _MSC_VER
+  #include <intrin.h>
+  typedef volatile long chmap_atomic;
+  #define _chmap_load(p) _InterlockedOr(p, 0)
+  #define _chmap_cas(p, expect, desired) (_InterlockedCompareExchange(p, desired, expect) == (expect))
+  #define _chmap_add(p, v) (void)_InterlockedExchangeAdd(p, v)
+  #define _chmap_or(p, v) (void)_InterlockedOr(p, v)
+  #define _chmap_clear(p) (void)_InterlockedExchange(p, 0)
+#elif defined __GNUC__ || defined __clang__
+  typedef long chmap_atomic;
+  #define _chmap_load(p) __atomic_load_n(p, __ATOMIC_ACQUIRE)
+  #define _chmap_cas(p, expect, desired) _chmap_cas_(p, expect, desired)
+  STC_INLINE bool _chmap_cas_(chmap_atomic* p, long expect, long desired)
+    { return __atomic_compare_exchange_n(p, &expect, desired, true, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED); }
+  #define _chmap_add(p, v) (void)__atomic_fetch_add(p, v, __ATOMIC_RELEASE)
+  #define _chmap_or(p, v) (void)__atomic_fetch_or(p, v, __ATOMIC_RELAXED)
+  #define _chmap_clear(p) __atomic_store_n(p, 0, __ATOMIC_RELEASE)
+#else
+  #include <stdatomic.h>
+  typedef _Atomic(long) chmap_atomic;
+  #define _chmap_load(p) atomic_load_explicit(p, memory_order_acquire)
+  #define _chmap_cas(p, expect, desired) _chmap_cas_(p, expect, desired)
+  STC_INLINE bool _chmap_cas_(chmap_atomic* p, long expect, long desired) {
+    return atomic_compare_exchange_weak_explicit(p, &expect, desired,
+                                                 memory_order_acquire, memory_order_relaxed);
+  }
+  #define _chmap_add(p, v) (void)atomic_fetch_add_explicit(p, v, memory_order_release)
+  #define _chmap_or(p, v) (void)atomic_fetch_or_explicit(p, v, memory_order_relaxed)
+  #define _chmap_clear(p) atomic_store_explicit(p, 0, memory_order_release)
+#endif
+
+#if defined _MSC_VER && (defined _M_X64 || defined _M_IX86)
+  #define _chmap_pause() _mm_pause()
+#elif (defined __GNUC__ || defined __clang__) && (defined __x86_64__ || defined __i386__)
+  #define _chmap_pause() __builtin_ia32_pause()
+#elif (defined __GNUC__ || defined __clang__) && (defined __aarch64__ || defined __arm__)
+  #define _chmap_pause() __asm__ __volatile__("yield")
+#else
+  #define _chmap_pause() ((void)0)
+#endif
+#if defined _WIN32
+  #ifndef WIN32_LEAN_AND_MEAN
+    #define WIN32_LEAN_AND_MEAN
+  #endif
+  #include <windows.h>
+  #define _chmap_yield() (void)SwitchToThread()
+#elif defined __unix__ || defined __APPLE__
+  #include <sched.h>
+  #define _chmap_yield() (void)sched_yield()
+#else
+  #define _chmap_yield() ((void)0)
+#endif
+
+// Reader-writer spin lock: word holds the number of readers, or the writer bit. A waiting writer
+// sets the waiting bit, which keeps new readers out so that writers are not starved.
+typedef struct { chmap_atomic word; } chmap_rwlock;
+#define _chmap_writer (1L << 30)
+#define _chmap_waiting (1L << 29)
+
+STC_INLINE void _chmap_backoff(int* spins) {
+    if (++*spins < 64) _chmap_pause();
+    else _chmap_yield(); // likely more threads than cores: let the lock holder run
+}
+
+STC_INLINE void chmap_rwlock_rdlock(chmap_rwlock* lk) {
+    for (int spins = 0; ; _chmap_backoff(&spins)) {
+        const long w = _chmap_load(&lk->word);
+        if (!(w & (_chmap_writer | _chmap_waiting)) && _chmap_cas(&lk->word, w, w + 1))
+            return;
+    }
+}
+
+STC_INLINE void chmap_rwlock_rdunlock(chmap_rwlock* lk)
+    { _chmap_add(&lk->word, -1); }
+
+STC_INLINE void chmap_rwlock_wrlock(chmap_rwlock* lk) {
+    for (int spins = 0; ; _chmap_backoff(&spins)) {
+        const long w = _chmap_load(&lk->word);
+        if ((w & ~_chmap_waiting) == 0) {
+            if (_chmap_cas(&lk->word, w, _chmap_writer))
+                return;
+        } else if (!(w & _chmap_waiting)) {
+            _chmap_or(&lk->word, _chmap_waiting);
+        }
+    }
+}
+
+STC_INLINE void chmap_rwlock_wrunlock(chmap_rwlock* lk)
+    { _chmap_clear(&lk->word); }
+
+// Generic atomics for any integer or pointer type T, declared as _c_atomic(T).
+#if defined __GNUC__ || defined __clang__
+  #define _c_atomic(T) T
+  #define _c_atomic_load(p) __atomic_load_n(p, __ATOMIC_ACQUIRE)
+  #define _c_atomic_load_sc(p) __atomic_load_n(p, __ATOMIC_SEQ_CST)
+  #define _c_atomic_store(p, v) __atomic_store_n(p, v, __ATOMIC_RELEASE)
+  #define _c_atomic_store_sc(p, v) __atomic_store_n(p, v, __ATOMIC_SEQ_CST)
+  #define _c_atomic_cas(p, expect, desired) \
+    __atomic_compare_exchange_n(p, expect, desired, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
+  #define _c_atomic_cas_sc(p, expect, desired) \
+    __atomic_compare_exchange_n(p, expect, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)
+  #define _c_atomic_add(p, v) __atomic_fetch_add(p, v, __ATOMIC_SEQ_CST)
+  #define _c_atomic_sub(p, v) __atomic_fetch_sub(p, v, __ATOMIC_RELEASE)
+#else // MSVC: requires /experimental:c11atomics
+  #include <stdatomic.h>
+  #define _c_atomic(T) _Atomic(T)
+  #define _c_atomic_load(p) atomic_load_explicit(p, memory_order_acquire)
+  #define _c_atomic_load_sc(p) atomic_load(p)
+  #define _c_atomic_store(p, v) atomic_store_explicit(p, v, memory_order_release)
+  #define _c_atomic_store_sc(p, v) atomic_store(p, v)
+  #define _c_atomic_cas(p, expect, desired) \
+    atomic_compare_exchange_strong_explicit(p, expect, desired, memory_order_acq_rel, memory_order_acquire)
+  #define _c_atomic_cas_sc(p, expect, desired) atomic_compare_exchange_strong(p, expect, desired)
+  #define _c_atomic_add(p, v) atomic_fetch_add(p, v)
+  #define _c_atomic_sub(p, v) atomic_fetch_sub_explicit(p, v, memory_order_release)
+#endif
+
+// Calls fn(arg, i) for i in [0, n) on n threads, of which the calling thread runs i = 0, and
+// returns when all calls are done. Without pthreads (or when a thread can not be created), the
+// remaining calls run in turn on the calling thread. n is at most _c_parallel_max.
+#define _c_parallel_max 64
+#if defined __unix__ || defined __APPLE__
+  #include <pthread.h>
+  struct _c_parallel_job { void (*fn)(void* arg, int i); void* arg; int i; };
+  STC_INLINE void* _c_parallel_run_(void* job) {
+      struct _c_parallel_job* j = (struct _c_parallel_job*)job;
+      j->fn(j->arg, j->i);
+      return NULL;
+  }
+  STC_INLINE void _c_parallel(void (*fn)(void* arg, int i), void* arg, int n) {
+      struct _c_parallel_job job[_c_parallel_max];
+      pthread_t thr[_c_parallel_max];
+      bool started[_c_parallel_max] = {0};
+      for (int i = 1; i < n; ++i) {
+          job[i].fn = fn, job[i].arg = arg, job[i].i = i;
+          started[i] = pthread_create(&thr[i], NULL, _c_parallel_run_, &job[i]) == 0;
+      }
+      fn(arg, 0);
+      for (int i = 1; i < n; ++i) {
+          if (started[i]) pthread_join(thr[i], NULL);
+          else fn(arg, i);
+      }
+  }
+#else
+  STC_INLINE void _c_parallel(void (*fn)(void* arg, int i), void* arg, int n)
+      { for (int i = 0; i < n; ++i) fn(arg, i); }
+#endif
+
+#if defined __GNUC__ || defined __clang__
+  #define _c_thread_local __thread
+#elif defined _MSC_VER
+  #define _c_thread_local __declspec(thread)
+#else
+  #define _c_thread_local _Thread_local
+#endif
+
+// Two-phase reader epoch, to free memory that lock-free readers may still be using. A reader
+// counts itself in one of the _c_epoch_slots counters of the current epoch while it runs.
+#define _c_epoch_slots 32
+typedef struct {
+    union { _c_atomic(long) n; char _pad[64]; } readers[2][_c_epoch_slots];
+    _c_atomic(long) epoch;
+} _c_epoch;
+
+#ifndef STC_EPOCH_STALL // test hook: runs between reading the epoch and counting the reader in it
+  #define STC_EPOCH_STALL() ((void)0)
+#endif
+
+// A reader preempted after reading the epoch may count itself after a synchronize() has flipped
+// the epoch and found the counter zero. The next synchronize() waits only on the other counters,
+// so the reader re-reads the epoch after counting itself, and counts again if it has changed.
+STC_INLINE int _c_epoch_enter(_c_epoch* e) {
+    static _c_thread_local int slot;
+    static _c_atomic(long) threads;
+    if (slot == 0)
+        slot = 1 + (int)(_c_atomic_add(&threads, 1) % _c_epoch_slots);
+    for (;;) {
+        const int idx = (int)(_c_atomic_load(&e->epoch) & 1);
+        STC_EPOCH_STALL();
+        _c_atomic_add(&e->readers[idx][slot - 1].n, 1);
+        if ((int)(_c_atomic_load_sc(&e->epoch) & 1) == idx)
+            return idx*_c_epoch_slots + slot - 1;
+        _c_atomic_sub(&e->readers[idx][slot - 1].n, 1);
+    }
+}
+
+STC_INLINE void _c_epoch_leave(_c_epoch* e, int token)
+    { _c_atomic_sub(&e->readers[token/_c_epoch_slots][token % _c_epoch_slots].n, 1); }
+
+// Waits until no readers that entered before the call are running. Everything that was unpublished
+// before the call can then be freed. Must not be called by a reader, and only by one thread at a
+// time. The unpublishing stores and the readers' loads of the published pointers must be sequentially
+// consistent: a reader whose counter increment is not seen here is ordered after them.
+STC_INLINE void _c_epoch_synchronize(_c_epoch* e) {
+    const int idx = (int)(_c_atomic_add(&e->epoch, 1) & 1); // new readers use the other counters
+    for (int i = 0; i < _c_epoch_slots; ++i)
+        for (int spins = 0; _c_atomic_load_sc(&e->readers[idx][i].n) != 0; )
+            _chmap_backoff(&spins);
+}
+#endif // STC_SYNC_PRV_H_INCLUDED
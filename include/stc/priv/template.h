@@ -69,7 +69,9 @@
 
 #if defined i_type && !(defined i_key || defined i_keyclass || \
                         defined i_keypro || defined i_rawclass)
-  #define Self c_GETARG(1, i_type)
+  #ifndef Self
+    #define Self c_GETARG(1, i_type)
+  #endif
   #define i_key c_GETARG(2, i_type)
   #if c_NUMARGS(i_type) == 3
     #if defined _i_is_map
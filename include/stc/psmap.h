@@ -0,0 +1,517 @@
+/* MIT License
+ *
+ * Copyright (c) 2025 Tyge Løvset
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Persistent sorted set and map - an AA-tree of reference counted nodes. clone() makes a
+// snapshot in O(1) time, which shares all nodes with the original. Inserts and erases copy
+// only the shared nodes on the path from the root (path copying), so an update costs O(log n)
+// time and memory, and is never seen by the other snapshots.
+/*
+#include <stdio.h>
+#define i_implement
+#include "stc/cstr.h"
+
+#define i_type Routes  // Persistent sorted map<cstr, int>
+#define i_keypro cstr
+#define i_val int
+#include "stc/psmap.h"
+
+int main(void) {
+    Routes r = {0};
+    Routes_emplace(&r, "10.0.0.0/8", 1);
+    Routes_emplace(&r, "192.168.0.0/16", 2);
+
+    Routes snap = Routes_clone(r); // O(1) snapshot: may be read by another thread
+    Routes_emplace_or_assign(&r, "10.0.0.0/8", 3);
+    Routes_erase(&r, "192.168.0.0/16");
+
+    for (c_each(i, Routes, snap)) // unchanged
+        printf("snap %s: %d\n", cstr_str(&i.ref->first), i.ref->second);
+    c_drop(Routes, &r, &snap);
+}
+*/
+#include "priv/linkage.h"
+#include "types.h"
+#include "priv/sync_prv.h"
+
+#ifndef STC_PSMAP_H_INCLUDED
+#define STC_PSMAP_H_INCLUDED
+#include <stdlib.h>
+#endif // STC_PSMAP_H_INCLUDED
+
+#ifndef _i_prefix
+  #define _i_prefix psmap_
+#endif
+#ifndef _i_is_set
+  #define _i_is_map
+  #define _i_MAP_ONLY c_true
+  #define _i_SET_ONLY c_false
+  #define _i_keyref(vp) (&(vp)->first)
+#else
+  #define _i_MAP_ONLY c_false
+  #define _i_SET_ONLY c_true
+  #define _i_keyref(vp) (vp)
+#endif
+#define _i_sorted
+#include "priv/template.h"
+#if defined i_no_clone
+  #error "psmap/psset require cloneable keys and values: shared nodes are copied on update."
+#endif
+#ifndef i_declared
+  _c_DEFTYPES(_c_pstree_types, Self, i_key, i_val, _i_MAP_ONLY, _i_SET_ONLY);
+#endif
+
+_i_MAP_ONLY( struct _m_value {
+    _m_key first;
+    _m_mapped second;
+}; )
+struct _m_node {
+    _c_atomic(long) rc; // number of links and snapshots sharing the node
+    _m_node* link[2];
+    int8_t level;
+    _m_value value;
+};
+
+typedef i_keyraw _m_keyraw;
+typedef i_valraw _m_rmapped;
+typedef _i_SET_ONLY( _m_keyraw )
+        _i_MAP_ONLY( struct { _m_keyraw first; _m_rmapped second; } )
+        _m_raw;
+
+#if !defined i_no_emplace
+STC_API _m_result       _c_MEMB(_emplace)(Self* self, _m_keyraw rkey _i_MAP_ONLY(, _m_rmapped rmapped));
+#endif // !i_no_emplace
+STC_API void            _c_MEMB(_drop)(const Self* cself);
+STC_API _m_value*       _c_MEMB(_find_it)(const Self* self, _m_keyraw rkey, _m_iter* out);
+STC_API _m_iter         _c_MEMB(_lower_bound)(const Self* self, _m_keyraw rkey);
+STC_API _m_value*       _c_MEMB(_front)(const Self* self);
+STC_API _m_value*       _c_MEMB(_back)(const Self* self);
+STC_API int             _c_MEMB(_erase)(Self* self, _m_keyraw rkey);
+STC_API _m_iter         _c_MEMB(_begin)(const Self* self);
+STC_API void            _c_MEMB(_next)(_m_iter* it);
+
+STC_INLINE Self         _c_MEMB(_init)(void) { Self tree = {0}; return tree; }
+STC_INLINE bool         _c_MEMB(_is_empty)(const Self* cx) { return cx->size == 0; }
+STC_INLINE isize        _c_MEMB(_size)(const Self* cx) { return cx->size; }
+STC_INLINE _m_iter      _c_MEMB(_find)(const Self* self, _m_keyraw rkey)
+                            { _m_iter it; _c_MEMB(_find_it)(self, rkey, &it); return it; }
+STC_INLINE bool         _c_MEMB(_contains)(const Self* self, _m_keyraw rkey)
+                            { _m_iter it; return _c_MEMB(_find_it)(self, rkey, &it) != NULL; }
+STC_INLINE const _m_value* _c_MEMB(_get)(const Self* self, _m_keyraw rkey)
+                            { _m_iter it; return _c_MEMB(_find_it)(self, rkey, &it); }
+
+// A snapshot: shares all nodes with tree until one of them is updated.
+STC_INLINE Self _c_MEMB(_clone)(Self tree) {
+    if (tree.root)
+        _c_atomic_add(&tree.root->rc, 1);
+    return tree;
+}
+
+STC_INLINE void _c_MEMB(_copy)(Self *self, const Self other) {
+    if (self->root == other.root)
+        return;
+    _c_MEMB(_drop)(self);
+    *self = _c_MEMB(_clone)(other);
+}
+
+STC_INLINE void _c_MEMB(_clear)(Self* self)
+    { _c_MEMB(_drop)(self); *self = _c_MEMB(_init)(); }
+
+STC_INLINE _m_raw _c_MEMB(_value_toraw)(const _m_value* val) {
+    return _i_SET_ONLY( i_keytoraw(val) )
+           _i_MAP_ONLY( c_literal(_m_raw){i_keytoraw((&val->first)),
+                                          i_valtoraw((&val->second))} );
+}
+
+STC_INLINE void _c_MEMB(_value_drop)(_m_value* val) {
+    i_keydrop(_i_keyref(val));
+    _i_MAP_ONLY( i_valdrop((&val->second)); )
+}
+
+STC_INLINE _m_value _c_MEMB(_value_clone)(_m_value _val) {
+    *_i_keyref(&_val) = i_keyclone((*_i_keyref(&_val)));
+    _i_MAP_ONLY( _val.second = i_valclone(_val.second); )
+    return _val;
+}
+
+STC_INLINE Self _c_MEMB(_move)(Self *self) {
+    Self m = *self;
+    memset(self, 0, sizeof *self);
+    return m;
+}
+
+STC_INLINE void _c_MEMB(_take)(Self *self, Self unowned) {
+    _c_MEMB(_drop)(self);
+    *self = unowned;
+}
+
+// With assign, the entry found is made private to self, so that it may be updated.
+STC_API _m_result _c_MEMB(_insert_entry_)(Self* self, _m_keyraw rkey, bool assign);
+
+#ifdef _i_is_map
+    STC_API _m_result _c_MEMB(_insert_or_assign)(Self* self, _m_key key, _m_mapped mapped);
+    #ifndef i_no_emplace
+    STC_API _m_result _c_MEMB(_emplace_or_assign)(Self* self, _m_keyraw rkey, _m_rmapped rmapped);
+    #endif
+
+    STC_INLINE const _m_mapped* _c_MEMB(_at)(const Self* self, _m_keyraw rkey)
+        { _m_iter it; return &_c_MEMB(_find_it)(self, rkey, &it)->second; }
+#endif // _i_is_map
+
+STC_INLINE _m_iter _c_MEMB(_end)(const Self* self) {
+    _m_iter it; (void)self;
+    it.ref = NULL, it._top = 0, it._tn = NULL;
+    return it;
+}
+
+STC_INLINE _m_iter _c_MEMB(_advance)(_m_iter it, size_t n) {
+    while (n-- && it.ref)
+        _c_MEMB(_next)(&it);
+    return it;
+}
+
+#if defined _i_has_eq
+STC_INLINE bool
+_c_MEMB(_eq)(const Self* self, const Self* other) {
+    if (_c_MEMB(_size)(self) != _c_MEMB(_size)(other)) return false;
+    _m_iter i = _c_MEMB(_begin)(self), j = _c_MEMB(_begin)(other);
+    for (; i.ref; _c_MEMB(_next)(&i), _c_MEMB(_next)(&j)) {
+        const _m_keyraw _rx = i_keytoraw(_i_keyref(i.ref)), _ry = i_keytoraw(_i_keyref(j.ref));
+        if (!(i_eq((&_rx), (&_ry)))) return false;
+    }
+    return true;
+}
+#endif
+
+STC_INLINE _m_result
+_c_MEMB(_insert)(Self* self, _m_key _key _i_MAP_ONLY(, _m_mapped _mapped)) {
+    _m_result _res = _c_MEMB(_insert_entry_)(self, i_keytoraw((&_key)), false);
+    if (_res.inserted)
+        { *_i_keyref(_res.ref) = _key; _i_MAP_ONLY( _res.ref->second = _mapped; )}
+    else
+        { i_keydrop((&_key)); _i_MAP_ONLY( i_valdrop((&_mapped)); )}
+    return _res;
+}
+
+STC_INLINE _m_value* _c_MEMB(_push)(Self* self, _m_value _val) {
+    _m_result _res = _c_MEMB(_insert_entry_)(self, i_keytoraw(_i_keyref(&_val)), false);
+    if (_res.inserted)
+        *_res.ref = _val;
+    else
+        _c_MEMB(_value_drop)(&_val);
+    return _res.ref;
+}
+
+#ifdef _i_is_map
+STC_INLINE _m_result _c_MEMB(_put)(Self* self, _m_keyraw rkey, _m_rmapped rmapped) {
+    #ifdef i_no_emplace
+        return _c_MEMB(_insert_or_assign)(self, rkey, rmapped);
+    #else
+        return _c_MEMB(_emplace_or_assign)(self, rkey, rmapped);
+    #endif
+}
+#endif
+
+STC_INLINE void _c_MEMB(_put_n)(Self* self, const _m_raw* raw, isize n) {
+    while (n--)
+        #if defined _i_is_set && defined i_no_emplace
+            _c_MEMB(_insert)(self, *raw++);
+        #elif defined _i_is_set
+            _c_MEMB(_emplace)(self, *raw++);
+        #else
+            _c_MEMB(_put)(self, raw->first, raw->second), ++raw;
+        #endif
+}
+
+STC_INLINE Self _c_MEMB(_with_n)(const _m_raw* raw, isize n)
+    { Self cx = {0}; _c_MEMB(_put_n)(&cx, raw, n); return cx; }
+
+/* -------------------------- IMPLEMENTATION ------------------------- */
+#if defined i_implement
+
+STC_DEF _m_value*
+_c_MEMB(_front)(const Self* self) {
+    _m_node* tn = self->root;
+    while (tn->link[0])
+        tn = tn->link[0];
+    return &tn->value;
+}
+
+STC_DEF _m_value*
+_c_MEMB(_back)(const Self* self) {
+    _m_node* tn = self->root;
+    while (tn->link[1])
+        tn = tn->link[1];
+    return &tn->value;
+}
+
+STC_DEF _m_value*
+_c_MEMB(_find_it)(const Self* self, _m_keyraw rkey, _m_iter* out) {
+    _m_node* tn = self->root;
+    out->_top = 0;
+    while (tn) {
+        int c; const _m_keyraw _raw = i_keytoraw(_i_keyref(&tn->value));
+        if ((c = i_cmp((&_raw), (&rkey))) < 0)
+            tn = tn->link[1];
+        else if (c > 0)
+            { out->_st[out->_top++] = tn; tn = tn->link[0]; }
+        else
+            { out->_tn = tn->link[1]; return (out->ref = &tn->value); }
+    }
+    return (out->ref = NULL);
+}
+
+STC_DEF _m_iter
+_c_MEMB(_lower_bound)(const Self* self, _m_keyraw rkey) {
+    _m_iter it;
+    _c_MEMB(_find_it)(self, rkey, &it);
+    if (it.ref == NULL && it._top != 0) {
+        _m_node* tn = it._st[--it._top];
+        it._tn = tn->link[1];
+        it.ref = &tn->value;
+    }
+    return it;
+}
+
+STC_DEF void
+_c_MEMB(_next)(_m_iter *it) {
+    _m_node* tn = it->_tn;
+    if (it->_top || tn) {
+        while (tn) {
+            it->_st[it->_top++] = tn;
+            tn = tn->link[0];
+        }
+        tn = it->_st[--it->_top];
+        it->_tn = tn->link[1];
+        it->ref = &tn->value;
+    } else
+        it->ref = NULL;
+}
+
+STC_DEF _m_iter
+_c_MEMB(_begin)(const Self* self) {
+    _m_iter it;
+    it.ref = NULL;
+    it._top = 0;
+    it._tn = self->root;
+    if (it._tn)
+        _c_MEMB(_next)(&it);
+    return it;
+}
+
+// Drop one reference to tn, and free it and its unshared subtrees when it was the last.
+static void
+_c_MEMB(_release_)(_m_node* tn) {
+    while (tn && _c_atomic_sub(&tn->rc, 1) == 1) {
+        (void)_c_atomic_load(&tn->rc); // acquire: synchronize with the other releases
+        _c_MEMB(_release_)(tn->link[0]);
+        _m_node* tx = tn->link[1];
+        _c_MEMB(_value_drop)(&tn->value);
+        i_free(tn, c_sizeof(_m_node));
+        tn = tx;
+    }
+}
+
+// Return tn if it is not shared, else a private copy of it, which takes over the reference
+// to tn. A node reached from the root through unshared nodes is only reachable from self.
+static _m_node*
+_c_MEMB(_unshare_)(_m_node* tn) {
+    if (_c_atomic_load(&tn->rc) == 1)
+        return tn;
+    _m_node* cn = _i_malloc(_m_node, 1);
+    cn->rc = 1;
+    cn->level = tn->level;
+    for (int i = 0; i < 2; ++i)
+        if ((cn->link[i] = tn->link[i]) != NULL)
+            _c_atomic_add(&cn->link[i]->rc, 1);
+    cn->value = _c_MEMB(_value_clone)(tn->value);
+    _c_MEMB(_release_)(tn);
+    return cn;
+}
+
+#define _i_level(tn) ((tn) ? (tn)->level : 0)
+
+// Rotations unshare the nodes they change. The parent link to tn must be unshared.
+static _m_node*
+_c_MEMB(_skew_)(_m_node* tn) {
+    if (tn && tn->link[0] && tn->link[0]->level == tn->level) {
+        tn = _c_MEMB(_unshare_)(tn);
+        _m_node* tx = _c_MEMB(_unshare_)(tn->link[0]);
+        tn->link[0] = tx->link[1];
+        tx->link[1] = tn;
+        tn = tx;
+    }
+    return tn;
+}
+
+static _m_node*
+_c_MEMB(_split_)(_m_node* tn) {
+    if (tn && tn->link[1] && _i_level(tn->link[1]->link[1]) == tn->level) {
+        tn = _c_MEMB(_unshare_)(tn);
+        _m_node* tx = _c_MEMB(_unshare_)(tn->link[1]);
+        tn->link[1] = tx->link[0];
+        tx->link[0] = tn;
+        tn = tx;
+        ++tn->level;
+    }
+    return tn;
+}
+
+static _m_node*
+_c_MEMB(_insert_r_)(_m_node* tn, const _m_keyraw* rkey, _m_result* _res) {
+    if (tn == NULL) {
+        tn = _i_malloc(_m_node, 1);
+        tn->rc = 1;
+        tn->link[0] = tn->link[1] = NULL;
+        tn->level = 1;
+        _res->ref = &tn->value;
+        _res->inserted = true;
+        return tn;
+    }
+    tn = _c_MEMB(_unshare_)(tn);
+    const _m_keyraw _raw = i_keytoraw(_i_keyref(&tn->value));
+    const int c = i_cmp((&_raw), rkey);
+    if (c == 0) {
+        _res->ref = &tn->value;
+        return tn;
+    }
+    tn->link[c < 0] = _c_MEMB(_insert_r_)(tn->link[c < 0], rkey, _res);
+    return _c_MEMB(_split_)(_c_MEMB(_skew_)(tn));
+}
+
+STC_DEF _m_result
+_c_MEMB(_insert_entry_)(Self* self, _m_keyraw rkey, bool assign) {
+    _m_result res = {NULL};
+    if (!assign) { // leave the tree untouched if the key is there
+        _m_iter it;
+        if ((res.ref = _c_MEMB(_find_it)(self, rkey, &it)) != NULL)
+            return res;
+    }
+    self->root = _c_MEMB(_insert_r_)(self->root, &rkey, &res);
+    self->size += res.inserted;
+    return res;
+}
+
+#ifdef _i_is_map
+    STC_DEF _m_result
+    _c_MEMB(_insert_or_assign)(Self* self, _m_key _key, _m_mapped _mapped) {
+        _m_result _res = _c_MEMB(_insert_entry_)(self, i_keytoraw((&_key)), true);
+        _m_mapped* _mp = _res.ref ? &_res.ref->second : &_mapped;
+        if (_res.inserted)
+            _res.ref->first = _key;
+        else
+            { i_keydrop((&_key)); i_valdrop(_mp); }
+        *_mp = _mapped;
+        return _res;
+    }
+
+    #if !defined i_no_emplace
+    STC_DEF _m_result
+    _c_MEMB(_emplace_or_assign)(Self* self, _m_keyraw rkey, _m_rmapped rmapped) {
+        _m_result _res = _c_MEMB(_insert_entry_)(self, rkey, true);
+        if (_res.inserted)
+            _res.ref->first = i_keyfrom(rkey);
+        else {
+            if (_res.ref == NULL) return _res;
+            i_valdrop((&_res.ref->second));
+        }
+        _res.ref->second = i_valfrom(rmapped);
+        return _res;
+    }
+    #endif // !i_no_emplace
+#endif // _i_is_map
+
+#if !defined i_no_emplace
+STC_DEF _m_result
+_c_MEMB(_emplace)(Self* self, _m_keyraw rkey _i_MAP_ONLY(, _m_rmapped rmapped)) {
+    _m_result res = _c_MEMB(_insert_entry_)(self, rkey, false);
+    if (res.inserted) {
+        *_i_keyref(res.ref) = i_keyfrom(rkey);
+        _i_MAP_ONLY(res.ref->second = i_valfrom(rmapped);)
+    }
+    return res;
+}
+#endif // i_no_emplace
+
+// Erase rkey, which is in the subtree tn.
+static _m_node*
+_c_MEMB(_erase_r_)(_m_node* tn, const _m_keyraw* rkey) {
+    _m_keyraw raw = i_keytoraw(_i_keyref(&tn->value));
+    const int c = i_cmp((&raw), rkey);
+    _m_node* tx;
+    if (c == 0 && (tn->link[0] == NULL || tn->link[1] == NULL)) { // unlink node
+        if ((tx = tn->link[tn->link[0] == NULL]) != NULL)
+            _c_atomic_add(&tx->rc, 1);
+        _c_MEMB(_release_)(tn);
+        return tx;
+    }
+    tn = _c_MEMB(_unshare_)(tn);
+    if (c != 0)
+        tn->link[c < 0] = _c_MEMB(_erase_r_)(tn->link[c < 0], rkey);
+    else { // replace by the predecessor, and erase that
+        tx = tn->link[0];
+        while (tx->link[1])
+            tx = tx->link[1];
+        _c_MEMB(_value_drop)(&tn->value);
+        tn->value = _c_MEMB(_value_clone)(tx->value);
+        raw = i_keytoraw(_i_keyref(&tn->value));
+        tn->link[0] = _c_MEMB(_erase_r_)(tn->link[0], &raw);
+    }
+    tx = tn->link[1];
+    if (_i_level(tn->link[0]) < tn->level - 1 || _i_level(tx) < tn->level - 1) {
+        if (_i_level(tx) > --tn->level)
+            { tx = tn->link[1] = _c_MEMB(_unshare_)(tx); tx->level = tn->level; }
+        tn = _c_MEMB(_skew_)(tn);
+        tx = tn->link[1] = _c_MEMB(_skew_)(tn->link[1]);
+        if (tx && tx->link[1] && tx->link[1]->link[0] && tx->link[1]->link[0]->level == tx->link[1]->level)
+            { tx = tn->link[1] = _c_MEMB(_unshare_)(tx); tx->link[1] = _c_MEMB(_skew_)(tx->link[1]); }
+        tn = _c_MEMB(_split_)(tn);
+        tn->link[1] = _c_MEMB(_split_)(tn->link[1]);
+    }
+    return tn;
+}
+
+STC_DEF int
+_c_MEMB(_erase)(Self* self, _m_keyraw rkey) {
+    _m_iter it;
+    if (_c_MEMB(_find_it)(self, rkey, &it) == NULL)
+        return 0;
+    self->root = _c_MEMB(_erase_r_)(self->root, &rkey);
+    --self->size;
+    return 1;
+}
+
+STC_DEF void
+_c_MEMB(_drop)(const Self* cself) {
+    _c_MEMB(_release_)(cself->root);
+}
+
+#undef _i_level
+#endif // i_implement
+#undef _i_is_set
+#undef _i_is_map
+#undef _i_sorted
+#undef _i_keyref
+#undef _i_MAP_ONLY
+#undef _i_SET_ONLY
+#include "priv/linkage2.h"
+#include "priv/template2.h"
@@ -0,0 +1,45 @@
+/* MIT License
+ *
+ * Copyright (c) 2025 Tyge Løvset
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Persistent sorted set - an AA-tree of reference counted nodes. See psmap.h.
+/*
+#include <stdio.h>
+
+#define i_type Intset,int
+#include "stc/psset.h"
+
+int main(void) {
+    Intset s = c_make(Intset, {5, 8, 3});
+    Intset snap = Intset_clone(s); // O(1)
+    Intset_insert(&s, 4);
+    Intset_erase(&s, 8);
+
+    for (c_each(k, Intset, snap)) // 3 5 8
+        printf("snap %d\n", *k.ref);
+    c_drop(Intset, &s, &snap);
+}
+*/
+
+#define _i_prefix psset_
+#define _i_is_set
+#include "psmap.h"
@@ -0,0 +1,439 @@
+/* MIT License
+ *
+ * Copyright (c) 2025 Tyge Løvset
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Read-concurrent hashmap - lookups take no locks and never wait, while writers are serialized
+// per stripe of keys. Open addressing with linear probing over atomic pointers to immutable
+// nodes. Erased and replaced nodes, and the old tables after a resize, are freed once all
+// lookups that may still see them have finished (reclamation by a two-phase reader epoch).
+/*
+#include <stdio.h>
+#include "stc/cstr.h"
+
+#define i_type Cache
+#define i_keypro cstr
+#define i_valpro cstr
+#include "stc/rcmap.h"
+
+int main(void) {
+    Cache cache = {0}; // may be shared by many threads
+    Cache_put(&cache, "color", "red");
+    Cache_put(&cache, "shape", "circle");
+    Cache_put(&cache, "color", "blue"); // replace
+
+    cstr val;
+    if (Cache_get(&cache, "color", &val)) {
+        printf("color: %s\n", cstr_str(&val));
+        cstr_drop(&val);
+    }
+    Cache_drop(&cache);
+}
+*/
+#include "priv/linkage.h"
+#include "types.h"
+#include "priv/sync_prv.h"
+
+#ifndef STC_RCMAP_H_INCLUDED
+#define STC_RCMAP_H_INCLUDED
+#include <stdlib.h>
+#define _rcmap_stripes 16        // writer locks
+#define _rcmap_min_buckets 128   // > 4/3*_rcmap_stripes, see _insert_node_()
+#define _rcmap_retire_batch 64   // erased/replaced nodes before memory is reclaimed
+#define _rcmap_tomb ((void*)1)   // erased slot
+
+struct rcmap_sync {
+    union { chmap_rwlock lock; char _pad[64]; } stripe[_rcmap_stripes];
+    _c_epoch lookups; // see _c_epoch_synchronize() in priv/sync_prv.h
+    chmap_rwlock retire_lock, reclaim_lock;
+};
+#endif // STC_RCMAP_H_INCLUDED
+
+#ifndef _i_prefix
+  #define _i_prefix rcmap_
+#endif
+#ifndef _i_is_set
+  #define _i_is_map
+  #define _i_MAP_ONLY c_true
+  #define _i_SET_ONLY c_false
+  #define _i_keyref(vp) (&(vp)->first)
+#else
+  #define _i_MAP_ONLY c_false
+  #define _i_SET_ONLY c_true
+  #define _i_keyref(vp) (vp)
+#endif
+#define _i_is_hash
+#include "priv/template.h"
+
+typedef i_key _m_key;
+typedef i_val _m_mapped;
+_i_MAP_ONLY( struct _m_value {
+    _m_key first;
+    _m_mapped second;
+}; )
+typedef _i_SET_ONLY( _m_key )
+        _i_MAP_ONLY( struct _m_value )
+_m_value;
+
+typedef i_keyraw _m_keyraw;
+typedef i_valraw _m_rmapped;
+typedef _i_SET_ONLY( i_keyraw )
+        _i_MAP_ONLY( struct { _m_keyraw first;
+                              _m_rmapped second; } )
+_m_raw;
+
+typedef struct _m_node {
+    struct _m_node* retired;
+    size_t hash;
+    _m_value value;
+} _m_node;
+
+typedef struct _c_MEMB(_table) {
+    struct _c_MEMB(_table)* retired;
+    size_t mask;
+    _c_atomic(long) used; // nodes and tombstones
+    struct { _c_atomic(size_t) hash; _c_atomic(_m_node*) node; } slot[]; // hash: 0 until set
+} _c_MEMB(_table);
+
+typedef struct Self {
+    _c_atomic(_c_MEMB(_table)*) table;
+    _c_atomic(long) size;
+    _m_node* retired_nodes;
+    _c_MEMB(_table)* retired_tables;
+    long retired_count;
+    struct rcmap_sync sync;
+} Self;
+
+STC_API void            _c_MEMB(_drop)(const Self* cself);
+static int              _c_MEMB(_insert_node_)(Self* self, _m_node* node, bool replace);
+STC_API bool            _c_MEMB(_erase)(Self* self, _m_keyraw rkey);
+static void             _c_MEMB(_reclaim_)(Self* self);
+
+STC_INLINE Self         _c_MEMB(_init)(void) { Self map = {0}; return map; }
+STC_INLINE isize        _c_MEMB(_size)(const Self* self) { return _c_atomic_load(&((Self*)self)->size); }
+STC_INLINE bool         _c_MEMB(_is_empty)(const Self* self) { return _c_MEMB(_size)(self) == 0; }
+
+// Must be called between _c_epoch_enter() and _c_epoch_leave() of sync.lookups.
+STC_INLINE const _m_node* _c_MEMB(_find_node_)(const Self* self, const _m_keyraw* rkeyptr, size_t hash) {
+    _c_MEMB(_table)* t = _c_atomic_load_sc(&((Self*)self)->table);
+    if (t == NULL) return NULL;
+    for (size_t i = hash & t->mask, n = 0; n <= t->mask; i = (i + 1) & t->mask, ++n) {
+        const _m_node* node = _c_atomic_load_sc(&t->slot[i].node); // sc: see _c_epoch_synchronize()
+        if (node == NULL)
+            return NULL;
+        if (node != _rcmap_tomb && _c_atomic_load(&t->slot[i].hash) == hash) {
+            const _m_keyraw _raw = i_keytoraw(_i_keyref(&node->value));
+            if (i_eq((&_raw), rkeyptr))
+                return node;
+        }
+    }
+    return NULL;
+}
+
+// Calls fn(val, arg) for the entry with key rkey, unless fn is NULL. Takes no locks.
+// Returns false if not found.
+STC_INLINE bool _c_MEMB(_read)(const Self* self, _m_keyraw rkey,
+                               void (*fn)(const _m_value* val, void* arg), void* arg) {
+    struct rcmap_sync* s = (struct rcmap_sync*)&self->sync;
+    const size_t hash = i_hash((&rkey));
+    const int token = _c_epoch_enter(&s->lookups);
+    const _m_node* node = _c_MEMB(_find_node_)(self, &rkey, hash);
+    if (node != NULL && fn != NULL) fn(&node->value, arg);
+    _c_epoch_leave(&s->lookups, token);
+    return node != NULL;
+}
+
+STC_INLINE bool _c_MEMB(_contains)(const Self* self, _m_keyraw rkey)
+    { return _c_MEMB(_read)(self, rkey, NULL, NULL); }
+
+#if defined _i_is_map && !defined i_no_clone
+// Copies the mapped value of rkey to *out (with i_valclone). Returns false if not found.
+STC_INLINE bool _c_MEMB(_get)(const Self* self, _m_keyraw rkey, _m_mapped* out) {
+    struct rcmap_sync* s = (struct rcmap_sync*)&self->sync;
+    const size_t hash = i_hash((&rkey));
+    const int token = _c_epoch_enter(&s->lookups);
+    const _m_node* node = _c_MEMB(_find_node_)(self, &rkey, hash);
+    if (node != NULL) *out = i_valclone(node->value.second);
+    _c_epoch_leave(&s->lookups, token);
+    return node != NULL;
+}
+#endif
+
+// Calls fn(val, arg) for all entries. Entries inserted or erased during the visit may or may
+// not be seen. Takes no locks.
+STC_INLINE void _c_MEMB(_visit)(const Self* self, void (*fn)(const _m_value* val, void* arg), void* arg) {
+    struct rcmap_sync* s = (struct rcmap_sync*)&self->sync;
+    const int token = _c_epoch_enter(&s->lookups);
+    _c_MEMB(_table)* t = _c_atomic_load_sc(&((Self*)self)->table);
+    for (size_t i = 0; t != NULL && i <= t->mask; ++i) {
+        const _m_node* node = _c_atomic_load_sc(&t->slot[i].node);
+        if (node != NULL && node != _rcmap_tomb)
+            fn(&node->value, arg);
+    }
+    _c_epoch_leave(&s->lookups, token);
+}
+
+STC_INLINE _m_node* _c_MEMB(_new_node_)(size_t hash) {
+    _m_node* node = _i_malloc(_m_node, 1);
+    if (node != NULL) node->retired = NULL, node->hash = hash;
+    return node;
+}
+
+STC_INLINE void _c_MEMB(_free_node_)(_m_node* node) {
+    i_keydrop(_i_keyref(&node->value));
+    _i_MAP_ONLY( i_valdrop((&node->value.second)); )
+    i_free(node, c_sizeof *node);
+}
+
+STC_INLINE void _c_MEMB(_free_table_)(_c_MEMB(_table)* t)
+    { i_free(t, c_sizeof *t + (isize)(t->mask + 1)*c_sizeof t->slot[0]); }
+
+// Returns true if inserted. Otherwise the arguments are dropped.
+STC_INLINE bool _c_MEMB(_insert)(Self* self, _m_key key _i_MAP_ONLY(, _m_mapped mapped)) {
+    const _m_keyraw rkey = i_keytoraw((&key));
+    _m_node* node = _c_MEMB(_new_node_)(i_hash((&rkey)));
+    if (node == NULL) {
+        i_keydrop((&key)); _i_MAP_ONLY( i_valdrop((&mapped)); )
+        return false;
+    }
+    *_i_keyref(&node->value) = key;
+    _i_MAP_ONLY( node->value.second = mapped; )
+    return _c_MEMB(_insert_node_)(self, node, false) == 1;
+}
+
+#if !defined i_no_emplace
+// Returns true if inserted.
+STC_INLINE bool _c_MEMB(_emplace)(Self* self, _m_keyraw rkey _i_MAP_ONLY(, _m_rmapped rmapped)) {
+    _m_node* node = _c_MEMB(_new_node_)(i_hash((&rkey)));
+    if (node == NULL) return false;
+    *_i_keyref(&node->value) = i_keyfrom(rkey);
+    _i_MAP_ONLY( node->value.second = i_valfrom(rmapped); )
+    return _c_MEMB(_insert_node_)(self, node, false) == 1;
+}
+#endif
+
+#ifdef _i_is_map
+// Inserts the entry, or replaces an existing entry with the same key. Returns true if inserted.
+STC_INLINE bool _c_MEMB(_insert_or_assign)(Self* self, _m_key key, _m_mapped mapped) {
+    const _m_keyraw rkey = i_keytoraw((&key));
+    _m_node* node = _c_MEMB(_new_node_)(i_hash((&rkey)));
+    if (node == NULL) {
+        i_keydrop((&key)); i_valdrop((&mapped));
+        return false;
+    }
+    node->value.first = key, node->value.second = mapped;
+    return _c_MEMB(_insert_node_)(self, node, true) == 1;
+}
+
+  #if !defined i_no_emplace
+    STC_INLINE bool _c_MEMB(_emplace_or_assign)(Self* self, _m_keyraw rkey, _m_rmapped rmapped) {
+        _m_node* node = _c_MEMB(_new_node_)(i_hash((&rkey)));
+        if (node == NULL) return false;
+        node->value.first = i_keyfrom(rkey), node->value.second = i_valfrom(rmapped);
+        return _c_MEMB(_insert_node_)(self, node, true) == 1;
+    }
+  #endif
+
+STC_INLINE bool _c_MEMB(_put)(Self* self, _m_keyraw rkey, _m_rmapped rmapped) {
+  #ifdef i_no_emplace
+    return _c_MEMB(_insert_or_assign)(self, rkey, rmapped);
+  #else
+    return _c_MEMB(_emplace_or_assign)(self, rkey, rmapped);
+  #endif
+}
+#endif // _i_is_map
+
+/* -------------------------- IMPLEMENTATION ------------------------- */
+#if defined i_implement
+
+STC_DEF void _c_MEMB(_drop)(const Self* cself) {
+    Self* self = (Self*)cself;
+    _c_MEMB(_table)* t = self->table;
+    for (size_t i = 0; t != NULL && i <= t->mask; ++i)
+        if (t->slot[i].node != NULL && t->slot[i].node != _rcmap_tomb)
+            _c_MEMB(_free_node_)(t->slot[i].node);
+    if (t != NULL) {
+        t->retired = self->retired_tables;
+        self->retired_tables = t;
+    }
+    for (_m_node* n = self->retired_nodes, *next; n != NULL; n = next) {
+        next = n->retired;
+        _c_MEMB(_free_node_)(n);
+    }
+    for (_c_MEMB(_table)* r = self->retired_tables, *next; r != NULL; r = next) {
+        next = r->retired;
+        _c_MEMB(_free_table_)(r);
+    }
+}
+
+static long _c_MEMB(_retire_)(Self* self, _m_node* node, _c_MEMB(_table)* table) {
+    chmap_rwlock_wrlock(&self->sync.retire_lock);
+    if (node != NULL)
+        node->retired = self->retired_nodes, self->retired_nodes = node;
+    if (table != NULL)
+        table->retired = self->retired_tables, self->retired_tables = table;
+    const long n = ++self->retired_count;
+    chmap_rwlock_wrunlock(&self->sync.retire_lock);
+    return n;
+}
+
+static void _c_MEMB(_reclaim_)(Self* self) {
+    chmap_rwlock_wrlock(&self->sync.reclaim_lock);
+    chmap_rwlock_wrlock(&self->sync.retire_lock);
+    _m_node* nodes = self->retired_nodes;
+    _c_MEMB(_table)* tables = self->retired_tables;
+    self->retired_nodes = NULL, self->retired_tables = NULL, self->retired_count = 0;
+    chmap_rwlock_wrunlock(&self->sync.retire_lock);
+
+    _c_epoch_synchronize(&self->sync.lookups); // all retired entries were unpublished before this
+    for (_m_node* next; nodes != NULL; nodes = next) {
+        next = nodes->retired;
+        _c_MEMB(_free_node_)(nodes);
+    }
+    for (_c_MEMB(_table)* next; tables != NULL; tables = next) {
+        next = tables->retired;
+        _c_MEMB(_free_table_)(tables);
+    }
+    chmap_rwlock_wrunlock(&self->sync.reclaim_lock);
+}
+
+// Rebuilds the table with all writers locked out. Lookups continue in the old table until the
+// new one is published. Returns false if out of memory.
+static bool _c_MEMB(_grow_)(Self* self) {
+    bool ok = true, grown = false;
+    for (int i = 0; i < _rcmap_stripes; ++i)
+        chmap_rwlock_wrlock(&self->sync.stripe[i].lock);
+    _c_MEMB(_table)* t = self->table;
+    const long size = _c_atomic_load(&self->size);
+    if (t == NULL || (_c_atomic_load(&t->used) + 1)*4 > (long)(t->mask + 1)*3) { // still needed
+        size_t buckets = _rcmap_min_buckets;
+        while ((long)buckets < (size + 1)*2) // at most 1/2 full after the resize
+            buckets *= 2;
+        _c_MEMB(_table)* nt = (_c_MEMB(_table)*)i_calloc(1, c_sizeof *nt + (isize)buckets*c_sizeof nt->slot[0]);
+        if ((ok = nt != NULL)) {
+            nt->mask = buckets - 1;
+            nt->used = size;
+            for (size_t i = 0; t != NULL && i <= t->mask; ++i) {
+                _m_node* node = t->slot[i].node;
+                if (node == NULL || node == _rcmap_tomb) continue;
+                size_t j = node->hash & nt->mask;
+                while (nt->slot[j].node != NULL) j = (j + 1) & nt->mask;
+                nt->slot[j].hash = node->hash;
+                nt->slot[j].node = node;
+            }
+            _c_atomic_store_sc(&self->table, nt);
+            grown = t != NULL;
+        }
+    }
+    for (int i = _rcmap_stripes - 1; i >= 0; --i)
+        chmap_rwlock_wrunlock(&self->sync.stripe[i].lock);
+    if (grown) {
+        _c_MEMB(_retire_)(self, NULL, t);
+        _c_MEMB(_reclaim_)(self);
+    }
+    return ok;
+}
+
+// Returns 1 if node was inserted, 0 if the key exists (then node is freed, or replaces the
+// existing entry if replace is true), or -1 if out of memory.
+static int _c_MEMB(_insert_node_)(Self* self, _m_node* node, bool replace) {
+    chmap_rwlock* lock = &self->sync.stripe[node->hash % _rcmap_stripes].lock;
+    const _m_keyraw rkey = i_keytoraw(_i_keyref(&node->value));
+    _m_node* old = NULL;
+    int res = -1;
+    for (;;) {
+        chmap_rwlock_wrlock(lock);
+        _c_MEMB(_table)* t = self->table;
+        // Writers in other stripes may each add one more entry: at most 3/4 + 16/128 full.
+        if (t == NULL || (_c_atomic_load(&t->used) + 1)*4 > (long)(t->mask + 1)*3) {
+            chmap_rwlock_wrunlock(lock);
+            if (!_c_MEMB(_grow_)(self)) break;
+            continue;
+        }
+        for (size_t i = node->hash & t->mask; ; i = (i + 1) & t->mask) {
+            _m_node* cur = _c_atomic_load(&t->slot[i].node);
+            if (cur == NULL) { // the key is not in the table: claim the slot
+                if (!_c_atomic_cas(&t->slot[i].node, &cur, node)) {
+                    i = (i - 1) & t->mask; // taken by a writer of another stripe: recheck
+                    continue;
+                }
+                _c_atomic_store(&t->slot[i].hash, node->hash); // lookups can now find it
+                _c_atomic_add(&t->used, 1);
+                _c_atomic_add(&self->size, 1);
+                res = 1;
+                break;
+            }
+            if (cur != _rcmap_tomb && cur->hash == node->hash) {
+                const _m_keyraw _raw = i_keytoraw(_i_keyref(&cur->value));
+                if (i_eq((&_raw), (&rkey))) {
+                    if (replace)
+                        _c_atomic_store_sc(&t->slot[i].node, node), old = cur;
+                    res = 0;
+                    break;
+                }
+            }
+        }
+        chmap_rwlock_wrunlock(lock);
+        break;
+    }
+    if (res == 0 && !replace)
+        _c_MEMB(_free_node_)(node); // was never published
+    else if (res == -1)
+        _c_MEMB(_free_node_)(node);
+    if (old != NULL && _c_MEMB(_retire_)(self, old, NULL) >= _rcmap_retire_batch)
+        _c_MEMB(_reclaim_)(self);
+    return res;
+}
+
+STC_DEF bool _c_MEMB(_erase)(Self* self, _m_keyraw rkey) {
+    const size_t hash = i_hash((&rkey));
+    chmap_rwlock* lock = &self->sync.stripe[hash % _rcmap_stripes].lock;
+    _m_node* old = NULL;
+    chmap_rwlock_wrlock(lock);
+    _c_MEMB(_table)* t = self->table;
+    for (size_t i = hash & (t ? t->mask : 0), n = 0; t != NULL && n <= t->mask; i = (i + 1) & t->mask, ++n) {
+        _m_node* cur = _c_atomic_load(&t->slot[i].node);
+        if (cur == NULL)
+            break;
+        if (cur != _rcmap_tomb && cur->hash == hash) {
+            const _m_keyraw _raw = i_keytoraw(_i_keyref(&cur->value));
+            if (i_eq((&_raw), (&rkey))) {
+                _c_atomic_store_sc(&t->slot[i].node, (_m_node*)_rcmap_tomb);
+                _c_atomic_sub(&self->size, 1);
+                old = cur;
+                break;
+            }
+        }
+    }
+    chmap_rwlock_wrunlock(lock);
+    if (old != NULL && _c_MEMB(_retire_)(self, old, NULL) >= _rcmap_retire_batch)
+        _c_MEMB(_reclaim_)(self);
+    return old != NULL;
+}
+#endif // i_implement
+#undef _i_is_set
+#undef _i_is_map
+#undef _i_is_hash
+#undef _i_keyref
+#undef _i_MAP_ONLY
+#undef _i_SET_ONLY
+#include "priv/linkage2.h"
+#include "priv/template2.h"
@@ -0,0 +1,421 @@
+/* MIT License
+ *
+ * Copyright (c) 2025 Tyge Løvset
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Concurrent sorted map - a lock-free skip list. Lookups, inserts and erases take no locks.
+// An erase first marks the next pointers of the node, which makes it logically erased, and
+// any thread that passes a marked node unlinks it. Unlinked nodes are freed once all threads
+// that may still see them have finished (reclamation by a two-phase reader epoch).
+/*
+#include <stdio.h>
+#include "stc/cstr.h"
+
+#define i_type Index
+#define i_keypro cstr
+#define i_val int
+#include "stc/skmap.h"
+
+static void print(const Index_value* v, void* arg)
+    { (void)arg; printf("%s: %d\n", cstr_str(&v->first), v->second); }
+
+int main(void) {
+    Index ix = {0}; // may be shared by many threads
+    Index_emplace(&ix, "pear", 3);
+    Index_emplace(&ix, "apple", 1);
+    Index_emplace(&ix, "fig", 2);
+    Index_erase(&ix, "pear");
+
+    Index_visit(&ix, print, NULL); // apple: 1, fig: 2
+    Index_drop(&ix);
+}
+*/
+#include "priv/linkage.h"
+#include "types.h"
+#include "priv/sync_prv.h"
+
+#ifndef STC_SKMAP_H_INCLUDED
+#define STC_SKMAP_H_INCLUDED
+#include <stdlib.h>
+#define _skmap_levels 20         // max node height: 4^20 entries
+#define _skmap_retire_batch 64   // erased nodes before memory is reclaimed
+#define _skmap_mark ((uintptr_t)1) // in next[i] of an erased node
+#define _skmap_node(p) ((_m_node*)((p) & ~_skmap_mark))
+
+struct skmap_sync {
+    _c_epoch threads; // see _c_epoch_synchronize() in priv/sync_prv.h
+    chmap_rwlock retire_lock, reclaim_lock;
+};
+
+// Random node height in [1, _skmap_levels], where each level is used by 1/4 of the nodes below.
+STC_INLINE int _skmap_height(void) {
+    static _c_thread_local uint64_t state;
+    static _c_atomic(uint64_t) seed;
+    if (state == 0)
+        state = (_c_atomic_add(&seed, 1) + 1)*0x9e3779b97f4a7c15;
+    state ^= state << 13, state ^= state >> 7, state ^= state << 17;
+    int h = 1;
+    for (uint64_t r = state >> 24; (r & 3) == 0 && h < _skmap_levels; r >>= 2)
+        ++h;
+    return h;
+}
+#endif // STC_SKMAP_H_INCLUDED
+
+#ifndef _i_prefix
+  #define _i_prefix skmap_
+#endif
+#ifndef _i_is_set
+  #define _i_is_map
+  #define _i_MAP_ONLY c_true
+  #define _i_SET_ONLY c_false
+  #define _i_keyref(vp) (&(vp)->first)
+#else
+  #define _i_MAP_ONLY c_false
+  #define _i_SET_ONLY c_true
+  #define _i_keyref(vp) (vp)
+#endif
+#define _i_sorted
+#include "priv/template.h"
+
+typedef i_key _m_key;
+typedef i_val _m_mapped;
+_i_MAP_ONLY( struct _m_value {
+    _m_key first;
+    _m_mapped second;
+}; )
+typedef _i_SET_ONLY( _m_key )
+        _i_MAP_ONLY( struct _m_value )
+_m_value;
+
+typedef i_keyraw _m_keyraw;
+typedef i_valraw _m_rmapped;
+typedef _i_SET_ONLY( i_keyraw )
+        _i_MAP_ONLY( struct { _m_keyraw first;
+                              _m_rmapped second; } )
+_m_raw;
+
+typedef struct _m_node {
+    struct _m_node* retired;
+    _c_atomic(int) refs; // the inserting and the erasing thread: the last one retires the node
+    int height;
+    _m_value value;
+    _c_atomic(uintptr_t) next[];
+} _m_node;
+
+typedef struct Self {
+    _c_atomic(uintptr_t) head[_skmap_levels];
+    _c_atomic(long) size;
+    _m_node* retired_nodes;
+    long retired_count;
+    struct skmap_sync sync;
+} Self;
+
+typedef void (*_c_MEMB(_visitor))(const _m_value* val, void* arg);
+
+STC_API void            _c_MEMB(_drop)(const Self* cself);
+static bool             _c_MEMB(_insert_node_)(Self* self, _m_node* node);
+STC_API bool            _c_MEMB(_erase)(Self* self, _m_keyraw rkey);
+STC_API void            _c_MEMB(_visit_range)(const Self* self, const _m_keyraw* lo, const _m_keyraw* hi,
+                                              _c_MEMB(_visitor) fn, void* arg);
+
+STC_INLINE Self         _c_MEMB(_init)(void) { Self map = {0}; return map; }
+STC_INLINE isize        _c_MEMB(_size)(const Self* self) { return _c_atomic_load(&((Self*)self)->size); }
+STC_INLINE bool         _c_MEMB(_is_empty)(const Self* self) { return _c_MEMB(_size)(self) == 0; }
+
+// The first entry >= rkey which is not erased, or NULL. Marked nodes are skipped, not unlinked.
+// Must be called between _c_epoch_enter() and _c_epoch_leave() of sync.threads.
+STC_INLINE const _m_node* _c_MEMB(_seek_)(const Self* self, const _m_keyraw* rkey) {
+    _c_atomic(uintptr_t)* pred = ((Self*)self)->head;
+    _m_node* curr = NULL;
+    for (int lv = _skmap_levels - 1; lv >= 0; --lv) {
+        curr = _skmap_node(_c_atomic_load_sc(&pred[lv])); // sc: see _c_epoch_synchronize()
+        while (curr != NULL) {
+            const uintptr_t succ = _c_atomic_load_sc(&curr->next[lv]);
+            if (succ & _skmap_mark)
+                { curr = _skmap_node(succ); continue; }
+            const _m_keyraw _raw = i_keytoraw(_i_keyref(&curr->value));
+            if (!(i_less((&_raw), rkey)))
+                break;
+            pred = curr->next;
+            curr = (_m_node*)succ;
+        }
+    }
+    return curr;
+}
+
+// Calls fn(val, arg) for the first entry >= rkey, unless fn is NULL. Takes no locks.
+// Returns false if there is none.
+STC_INLINE bool _c_MEMB(_lower_bound)(const Self* self, _m_keyraw rkey, _c_MEMB(_visitor) fn, void* arg) {
+    struct skmap_sync* s = (struct skmap_sync*)&self->sync;
+    const int token = _c_epoch_enter(&s->threads);
+    const _m_node* node = _c_MEMB(_seek_)(self, &rkey);
+    if (node != NULL && fn != NULL) fn(&node->value, arg);
+    _c_epoch_leave(&s->threads, token);
+    return node != NULL;
+}
+
+// Calls fn(val, arg) for the entry with key rkey, unless fn is NULL. Takes no locks.
+// Returns false if not found.
+STC_INLINE bool _c_MEMB(_read)(const Self* self, _m_keyraw rkey, _c_MEMB(_visitor) fn, void* arg) {
+    struct skmap_sync* s = (struct skmap_sync*)&self->sync;
+    const int token = _c_epoch_enter(&s->threads);
+    const _m_node* node = _c_MEMB(_seek_)(self, &rkey);
+    if (node != NULL) {
+        const _m_keyraw _raw = i_keytoraw(_i_keyref(&node->value));
+        if (i_less((&rkey), (&_raw))) node = NULL;
+        else if (fn != NULL) fn(&node->value, arg);
+    }
+    _c_epoch_leave(&s->threads, token);
+    return node != NULL;
+}
+
+STC_INLINE bool _c_MEMB(_contains)(const Self* self, _m_keyraw rkey)
+    { return _c_MEMB(_read)(self, rkey, NULL, NULL); }
+
+#if defined _i_is_map && !defined i_no_clone
+STC_INLINE void _c_MEMB(_get_)(const _m_value* val, void* out)
+    { *(_m_mapped*)out = i_valclone(val->second); }
+
+// Copies the mapped value of rkey to *out (with i_valclone). Returns false if not found.
+STC_INLINE bool _c_MEMB(_get)(const Self* self, _m_keyraw rkey, _m_mapped* out)
+    { return _c_MEMB(_read)(self, rkey, _c_MEMB(_get_), out); }
+#endif
+
+// Calls fn(val, arg) for all entries in key order. Entries inserted or erased during the
+// visit may or may not be seen. Takes no locks.
+STC_INLINE void _c_MEMB(_visit)(const Self* self, _c_MEMB(_visitor) fn, void* arg)
+    { _c_MEMB(_visit_range)(self, NULL, NULL, fn, arg); }
+
+STC_INLINE _m_node* _c_MEMB(_new_node_)(void) {
+    const int height = _skmap_height();
+    _m_node* node = (_m_node*)i_malloc(c_sizeof(_m_node) + height*c_sizeof(uintptr_t));
+    if (node != NULL) node->retired = NULL, node->refs = 2, node->height = height;
+    return node;
+}
+
+STC_INLINE void _c_MEMB(_free_node_)(_m_node* node) {
+    i_keydrop(_i_keyref(&node->value));
+    _i_MAP_ONLY( i_valdrop((&node->value.second)); )
+    i_free(node, c_sizeof(_m_node) + node->height*c_sizeof(uintptr_t));
+}
+
+// Returns true if inserted. Otherwise the arguments are dropped.
+STC_INLINE bool _c_MEMB(_insert)(Self* self, _m_key key _i_MAP_ONLY(, _m_mapped mapped)) {
+    _m_node* node = _c_MEMB(_new_node_)();
+    if (node == NULL) {
+        i_keydrop((&key)); _i_MAP_ONLY( i_valdrop((&mapped)); )
+        return false;
+    }
+    *_i_keyref(&node->value) = key;
+    _i_MAP_ONLY( node->value.second = mapped; )
+    return _c_MEMB(_insert_node_)(self, node);
+}
+
+#if !defined i_no_emplace
+// Returns true if inserted.
+STC_INLINE bool _c_MEMB(_emplace)(Self* self, _m_keyraw rkey _i_MAP_ONLY(, _m_rmapped rmapped)) {
+    _m_node* node = _c_MEMB(_new_node_)();
+    if (node == NULL) return false;
+    *_i_keyref(&node->value) = i_keyfrom(rkey);
+    _i_MAP_ONLY( node->value.second = i_valfrom(rmapped); )
+    return _c_MEMB(_insert_node_)(self, node);
+}
+#endif
+
+/* -------------------------- IMPLEMENTATION ------------------------- */
+#if defined i_implement
+
+STC_DEF void _c_MEMB(_drop)(const Self* cself) {
+    Self* self = (Self*)cself;
+    for (_m_node* n = _skmap_node(self->head[0]), *next; n != NULL; n = next) {
+        next = _skmap_node(n->next[0]);
+        _c_MEMB(_free_node_)(n);
+    }
+    for (_m_node* n = self->retired_nodes, *next; n != NULL; n = next) {
+        next = n->retired;
+        _c_MEMB(_free_node_)(n);
+    }
+}
+
+STC_DEF void _c_MEMB(_visit_range)(const Self* self, const _m_keyraw* lo, const _m_keyraw* hi,
+                                   _c_MEMB(_visitor) fn, void* arg) {
+    struct skmap_sync* s = (struct skmap_sync*)&self->sync;
+    const int token = _c_epoch_enter(&s->threads);
+    const _m_node* node = lo ? _c_MEMB(_seek_)(self, lo)
+                             : _skmap_node(_c_atomic_load_sc(&((Self*)self)->head[0]));
+    while (node != NULL) {
+        const uintptr_t succ = _c_atomic_load_sc(&((_m_node*)node)->next[0]);
+        if (!(succ & _skmap_mark)) {
+            if (hi != NULL) {
+                const _m_keyraw _raw = i_keytoraw(_i_keyref(&node->value));
+                if (!(i_less((&_raw), hi))) break;
+            }
+            fn(&node->value, arg);
+        }
+        node = _skmap_node(succ);
+    }
+    _c_epoch_leave(&s->threads, token);
+}
+
+// Sets preds[i] to the next array of the last node on level i < rkey (or head), and succs[i] to
+// the node after it. Unlinks the marked nodes on the way. Returns true if succs[0] has key rkey.
+// Must be called between _c_epoch_enter() and _c_epoch_leave() of sync.threads.
+static bool _c_MEMB(_find_)(Self* self, const _m_keyraw* rkey,
+                            _c_atomic(uintptr_t)** preds, _m_node** succs) {
+    retry:;
+    _c_atomic(uintptr_t)* pred = self->head;
+    _m_node* curr = NULL;
+    for (int lv = _skmap_levels - 1; lv >= 0; --lv) {
+        curr = _skmap_node(_c_atomic_load_sc(&pred[lv]));
+        while (curr != NULL) {
+            uintptr_t succ = _c_atomic_load_sc(&curr->next[lv]);
+            if (succ & _skmap_mark) { // curr is erased: unlink it on this level
+                uintptr_t expect = (uintptr_t)curr;
+                if (!_c_atomic_cas_sc(&pred[lv], &expect, succ & ~_skmap_mark))
+                    goto retry; // pred was changed or erased
+                curr = _skmap_node(succ);
+                continue;
+            }
+            const _m_keyraw _raw = i_keytoraw(_i_keyref(&curr->value));
+            if (!(i_less((&_raw), rkey)))
+                break;
+            pred = curr->next;
+            curr = (_m_node*)succ;
+        }
+        preds[lv] = pred;
+        succs[lv] = curr;
+    }
+    if (curr == NULL)
+        return false;
+    const _m_keyraw _raw = i_keytoraw(_i_keyref(&curr->value));
+    return !(i_less(rkey, (&_raw)));
+}
+
+// Called by the last of the inserting and the erasing thread of node, when both are done
+// linking and marking it. Returns the number of retired nodes.
+static long _c_MEMB(_retire_)(Self* self, _m_node* node) {
+    _c_atomic(uintptr_t)* preds[_skmap_levels];
+    _m_node* succs[_skmap_levels];
+    const _m_keyraw rkey = i_keytoraw(_i_keyref(&node->value));
+    _c_MEMB(_find_)(self, &rkey, preds, succs); // unlinks node on all levels
+    chmap_rwlock_wrlock(&self->sync.retire_lock);
+    node->retired = self->retired_nodes, self->retired_nodes = node;
+    const long n = ++self->retired_count;
+    chmap_rwlock_wrunlock(&self->sync.retire_lock);
+    return n;
+}
+
+static void _c_MEMB(_reclaim_)(Self* self) {
+    chmap_rwlock_wrlock(&self->sync.reclaim_lock);
+    chmap_rwlock_wrlock(&self->sync.retire_lock);
+    _m_node* nodes = self->retired_nodes;
+    self->retired_nodes = NULL, self->retired_count = 0;
+    chmap_rwlock_wrunlock(&self->sync.retire_lock);
+
+    _c_epoch_synchronize(&self->sync.threads); // all retired nodes were unlinked before this
+    for (_m_node* next; nodes != NULL; nodes = next) {
+        next = nodes->retired;
+        _c_MEMB(_free_node_)(nodes);
+    }
+    chmap_rwlock_wrunlock(&self->sync.reclaim_lock);
+}
+
+// Links node on level 0, which inserts it, and then on the levels above from the bottom up.
+// Stops linking if node gets erased meanwhile. Returns false if the key exists (node is freed).
+static bool _c_MEMB(_insert_node_)(Self* self, _m_node* node) {
+    _c_atomic(uintptr_t)* preds[_skmap_levels];
+    _m_node* succs[_skmap_levels];
+    const _m_keyraw rkey = i_keytoraw(_i_keyref(&node->value));
+    const int token = _c_epoch_enter(&self->sync.threads);
+    long retired = 0;
+    for (;;) {
+        if (_c_MEMB(_find_)(self, &rkey, preds, succs)) {
+            _c_epoch_leave(&self->sync.threads, token);
+            _c_MEMB(_free_node_)(node); // was never published
+            return false;
+        }
+        for (int lv = 0; lv < node->height; ++lv)
+            _c_atomic_store(&node->next[lv], (uintptr_t)succs[lv]);
+        uintptr_t expect = (uintptr_t)succs[0];
+        if (_c_atomic_cas_sc(&preds[0][0], &expect, (uintptr_t)node))
+            break;
+    }
+    _c_atomic_add(&self->size, 1);
+
+    for (int lv = 1; lv < node->height; ++lv) {
+        for (;;) {
+            uintptr_t next = _c_atomic_load(&node->next[lv]);
+            if (next & _skmap_mark) // erased: the next pointer must not change
+                goto done;
+            if (next != (uintptr_t)succs[lv] &&
+                !_c_atomic_cas_sc(&node->next[lv], &next, (uintptr_t)succs[lv]))
+                goto done;
+            uintptr_t expect = (uintptr_t)succs[lv];
+            if (_c_atomic_cas_sc(&preds[lv][lv], &expect, (uintptr_t)node))
+                break;
+            if (!_c_MEMB(_find_)(self, &rkey, preds, succs) || succs[0] != node)
+                goto done; // erased
+        }
+    }
+    done:
+    if (_c_atomic_sub(&node->refs, 1) == 1)
+        retired = _c_MEMB(_retire_)(self, node);
+    _c_epoch_leave(&self->sync.threads, token);
+    if (retired >= _skmap_retire_batch)
+        _c_MEMB(_reclaim_)(self);
+    return true;
+}
+
+STC_DEF bool _c_MEMB(_erase)(Self* self, _m_keyraw rkey) {
+    _c_atomic(uintptr_t)* preds[_skmap_levels];
+    _m_node* succs[_skmap_levels];
+    const int token = _c_epoch_enter(&self->sync.threads);
+    bool erased = false;
+    long retired = 0;
+    if (_c_MEMB(_find_)(self, &rkey, preds, succs)) {
+        _m_node* node = succs[0];
+        for (int lv = node->height - 1; lv >= 0; --lv) { // mark the levels top down
+            uintptr_t next = _c_atomic_load(&node->next[lv]);
+            while (!(next & _skmap_mark)) {
+                if (_c_atomic_cas_sc(&node->next[lv], &next, next | _skmap_mark))
+                    erased = lv == 0; // the thread which marks level 0 erases the node
+            }
+        }
+        if (erased) {
+            _c_atomic_sub(&self->size, 1);
+            if (_c_atomic_sub(&node->refs, 1) == 1)
+                retired = _c_MEMB(_retire_)(self, node);
+        }
+    }
+    _c_epoch_leave(&self->sync.threads, token);
+    if (retired >= _skmap_retire_batch)
+        _c_MEMB(_reclaim_)(self);
+    return erased;
+}
+#endif // i_implement
+#undef _i_is_set
+#undef _i_is_map
+#undef _i_sorted
+#undef _i_keyref
+#undef _i_MAP_ONLY
+#undef _i_SET_ONLY
+#include "priv/linkage2.h"
+#include "priv/template2.h"
@@ -56,6 +56,7 @@ int main(void) {
 #define STC_SMAP_H_INCLUDED
 #include "common.h"
 #include <stdlib.h>
+#define _smap_chunk_bits 16 // 64K nodes per chunk with i_chunked
 #endif // STC_SMAP_H_INCLUDED
 
 #ifndef _i_prefix
@@ -72,9 +73,28 @@ int main(void) {
   #define _i_keyref(vp) (vp)
 #endif
 #define _i_sorted
+#if defined i_order_stats
+  #define _i_order_stats
+  #define _i_if_order_stats c_true
+#else
+  #define _i_if_order_stats c_false
+#endif
+#if defined i_index64
+  #define _i_index int64_t
+#else
+  #define _i_index int32_t
+#endif
+#if defined i_chunked // nodes in fixed-size chunks: growing copies only the chunk table
+  #define _i_chunked
+  #define _i_nodes _m_node**
+  #define _i_nd(d, tn) (d)[(tn) >> _smap_chunk_bits][(tn) & (((_i_index)1 << _smap_chunk_bits) - 1)]
+#else
+  #define _i_nodes _m_node*
+  #define _i_nd(d, tn) (d)[tn]
+#endif
 #include "priv/template.h"
 #ifndef i_declared
-  _c_DEFTYPES(_c_aatree_types, Self, i_key, i_val, _i_MAP_ONLY, _i_SET_ONLY);
+  _c_DEFTYPES(_c_aatree_types_ex, Self, i_key, i_val, _i_MAP_ONLY, _i_SET_ONLY, _i_index, _i_nodes);
 #endif
 
 _i_MAP_ONLY( struct _m_value {
@@ -82,8 +102,9 @@ _i_MAP_ONLY( struct _m_value {
     _m_mapped second;
 }; )
 struct _m_node {
-    int32_t link[2];
+    _i_index link[2];
     int8_t level;
+    _i_if_order_stats( _i_index count; ) // number of nodes in this subtree
     _m_value value;
 };
 
@@ -111,6 +132,13 @@ STC_API _m_iter         _c_MEMB(_erase_range)(Self* self, _m_iter it1, _m_iter i
 STC_API _m_iter         _c_MEMB(_begin)(const Self* self);
 STC_API void            _c_MEMB(_next)(_m_iter* it);
 
+#if defined _i_order_stats
+STC_API isize           _c_MEMB(_rank)(const Self* self, _m_keyraw rkey);
+STC_API _m_iter         _c_MEMB(_select)(const Self* self, isize k);
+STC_INLINE isize        _c_MEMB(_count_range)(const Self* self, _m_keyraw lo, _m_keyraw hi)
+                            { isize n = _c_MEMB(_rank)(self, hi) - _c_MEMB(_rank)(self, lo); return n > 0 ? n : 0; }
+#endif
+
 STC_INLINE Self         _c_MEMB(_init)(void) { Self tree = {0}; return tree; }
 STC_INLINE bool         _c_MEMB(_is_empty)(const Self* cx) { return cx->size == 0; }
 STC_INLINE isize        _c_MEMB(_size)(const Self* cx) { return cx->size; }
@@ -258,20 +286,37 @@ STC_INLINE void _c_MEMB(_put_n)(Self* self, const _m_raw* raw, isize n) {
 STC_INLINE Self _c_MEMB(_with_n)(const _m_raw* raw, isize n)
     { Self cx = {0}; _c_MEMB(_put_n)(&cx, raw, n); return cx; }
 
+STC_API void _c_MEMB(_put_sorted_n)(Self* self, const _m_raw* raw, isize n);
+STC_API bool _c_MEMB(_compact)(Self* self);
+STC_API bool _c_MEMB(_merge)(Self* self, Self* other);
+STC_API bool _c_MEMB(_split)(Self* self, _m_keyraw rkey, Self* out);
+#if !defined i_no_clone
+STC_API Self _c_MEMB(_union)(const Self* a, const Self* b);
+STC_API Self _c_MEMB(_intersection)(const Self* a, const Self* b);
+STC_API Self _c_MEMB(_difference)(const Self* a, const Self* b);
+#endif
+
+// Append other to self, when all keys in other are greater than those in self, e.g. after split().
+STC_INLINE bool _c_MEMB(_join)(Self* self, Self* other)
+    { return _c_MEMB(_merge)(self, other); }
+
+STC_INLINE Self _c_MEMB(_with_sorted_n)(const _m_raw* raw, isize n)
+    { Self cx = {0}; _c_MEMB(_put_sorted_n)(&cx, raw, n); return cx; }
+
 /* -------------------------- IMPLEMENTATION ------------------------- */
 #if defined i_implement
 
 STC_DEF void
 _c_MEMB(_next)(_m_iter *it) {
-    int32_t tn = it->_tn;
+    _i_index tn = it->_tn;
     if (it->_top || tn) {
         while (tn) {
             it->_st[it->_top++] = tn;
-            tn = it->_d[tn].link[0];
+            tn = _i_nd(it->_d, tn).link[0];
         }
         tn = it->_st[--it->_top];
-        it->_tn = it->_d[tn].link[1];
-        it->ref = &it->_d[tn].value;
+        it->_tn = _i_nd(it->_d, tn).link[1];
+        it->ref = &_i_nd(it->_d, tn).value;
     } else
         it->ref = NULL;
 }
@@ -287,6 +332,51 @@ _c_MEMB(_begin)(const Self* self) {
     return it;
 }
 
+#if defined _i_chunked
+// The first chunk grows by realloc until it is full. Beyond that, whole chunks are added,
+// and only the chunk table is reallocated, so existing nodes are never copied.
+STC_DEF bool
+_c_MEMB(_reserve)(Self* self, const isize cap) {
+    const isize csize = (isize)1 << _smap_chunk_bits;
+    if (cap <= self->capacity)
+        return false;
+    if (cap < csize) {
+        _m_node** table = self->nodes;
+        if (table == NULL && (table = _i_malloc(_m_node*, 1)) == NULL)
+            return false;
+        _m_node* chunk = (_m_node*)i_realloc(self->nodes ? table[0] : NULL,
+                                             (self->capacity + 1)*c_sizeof(_m_node),
+                                             (cap + 1)*c_sizeof(_m_node));
+        if (chunk == NULL) {
+            if (self->nodes == NULL)
+                i_free(table, c_sizeof(_m_node*));
+            return false;
+        }
+        chunk[0] = c_literal(_m_node){0};
+        table[0] = chunk;
+        self->nodes = table;
+        self->capacity = (_i_index)cap;
+        return true;
+    }
+    if (self->capacity < csize - 1 && !_c_MEMB(_reserve)(self, csize - 1))
+        return false;
+    const isize nch = (self->capacity + 1)/csize, n = (cap + csize)/csize;
+    _m_node** table = (_m_node**)i_realloc(self->nodes, nch*c_sizeof(_m_node*), n*c_sizeof(_m_node*));
+    if (table == NULL)
+        return false;
+    self->nodes = table;
+    for (isize i = nch; i < n; ++i) {
+        if ((table[i] = _i_malloc(_m_node, csize)) == NULL) {
+            while (i > nch)
+                i_free(table[--i], csize*c_sizeof(_m_node));
+            self->nodes = (_m_node**)i_realloc(table, n*c_sizeof(_m_node*), nch*c_sizeof(_m_node*));
+            return false;
+        }
+    }
+    self->capacity = (_i_index)(n*csize - 1);
+    return true;
+}
+#else
 STC_DEF bool
 _c_MEMB(_reserve)(Self* self, const isize cap) {
     if (cap <= self->capacity)
@@ -297,42 +387,61 @@ _c_MEMB(_reserve)(Self* self, const isize cap) {
         return false;
     nodes[0] = c_literal(_m_node){0};
     self->nodes = nodes;
-    self->capacity = (int32_t)cap;
+    self->capacity = (_i_index)cap;
     return true;
 }
+#endif // _i_chunked
+
+// Free a node store with room for cap entries.
+static void
+_c_MEMB(_free_store_)(_i_nodes d, const isize cap) {
+    if (cap == 0)
+        return;
+  #if defined _i_chunked
+    const isize csize = (isize)1 << _smap_chunk_bits, nch = (cap + csize)/csize;
+    if (nch == 1)
+        i_free(d[0], (cap + 1)*c_sizeof(_m_node));
+    else for (isize i = 0; i < nch; ++i)
+        i_free(d[i], csize*c_sizeof(_m_node));
+    i_free(d, nch*c_sizeof(_m_node*));
+  #else
+    i_free(d, (cap + 1)*c_sizeof(_m_node));
+  #endif
+}
 
 STC_DEF _m_value*
 _c_MEMB(_front)(const Self* self) {
-    _m_node *d = self->nodes;
-    int32_t tn = self->root;
-    while (d[tn].link[0])
-        tn = d[tn].link[0];
-    return &d[tn].value;
+    _i_nodes d = self->nodes;
+    _i_index tn = self->root;
+    while (_i_nd(d, tn).link[0])
+        tn = _i_nd(d, tn).link[0];
+    return &_i_nd(d, tn).value;
 }
 
 STC_DEF _m_value*
 _c_MEMB(_back)(const Self* self) {
-    _m_node *d = self->nodes;
-    int32_t tn = self->root;
-    while (d[tn].link[1])
-        tn = d[tn].link[1];
-    return &d[tn].value;
+    _i_nodes d = self->nodes;
+    _i_index tn = self->root;
+    while (_i_nd(d, tn).link[1])
+        tn = _i_nd(d, tn).link[1];
+    return &_i_nd(d, tn).value;
 }
 
-static int32_t
+static _i_index
 _c_MEMB(_new_node_)(Self* self, int level) {
-    int32_t tn;
+    _i_index tn;
     if (self->disp != 0) {
         tn = self->disp;
-        self->disp = self->nodes[tn].link[1];
+        self->disp = _i_nd(self->nodes, tn).link[1];
     } else {
         if (self->head == self->capacity)
             if (!_c_MEMB(_reserve)(self, self->head*3/2 + 4))
                 return 0;
         tn = ++self->head; /* start with 1, 0 is nullnode. */
     }
-    _m_node* dn = &self->nodes[tn];
+    _m_node* dn = &_i_nd(self->nodes, tn);
     dn->link[0] = dn->link[1] = 0; dn->level = (int8_t)level;
+    _i_if_order_stats( dn->count = 1; )
     return tn;
 }
 
@@ -367,17 +476,17 @@ _c_MEMB(_new_node_)(Self* self, int level) {
 
 STC_DEF _m_value*
 _c_MEMB(_find_it)(const Self* self, _m_keyraw rkey, _m_iter* out) {
-    int32_t tn = self->root;
-    _m_node *d = out->_d = self->nodes;
+    _i_index tn = self->root;
+    _i_nodes d = out->_d = self->nodes;
     out->_top = 0;
     while (tn) {
-        int c; const _m_keyraw _raw = i_keytoraw(_i_keyref(&d[tn].value));
+        int c; const _m_keyraw _raw = i_keytoraw(_i_keyref(&_i_nd(d, tn).value));
         if ((c = i_cmp((&_raw), (&rkey))) < 0)
-            tn = d[tn].link[1];
+            tn = _i_nd(d, tn).link[1];
         else if (c > 0)
-            { out->_st[out->_top++] = tn; tn = d[tn].link[0]; }
+            { out->_st[out->_top++] = tn; tn = _i_nd(d, tn).link[0]; }
         else
-            { out->_tn = d[tn].link[1]; return (out->ref = &d[tn].value); }
+            { out->_tn = _i_nd(d, tn).link[1]; return (out->ref = &_i_nd(d, tn).value); }
     }
     return (out->ref = NULL);
 }
@@ -387,64 +496,110 @@ _c_MEMB(_lower_bound)(const Self* self, _m_keyraw rkey) {
     _m_iter it;
     _c_MEMB(_find_it)(self, rkey, &it);
     if (it.ref == NULL && it._top != 0) {
-        int32_t tn = it._st[--it._top];
-        it._tn = it._d[tn].link[1];
-        it.ref = &it._d[tn].value;
+        _i_index tn = it._st[--it._top];
+        it._tn = _i_nd(it._d, tn).link[1];
+        it.ref = &_i_nd(it._d, tn).value;
     }
     return it;
 }
 
-STC_DEF int32_t
-_c_MEMB(_skew_)(_m_node *d, int32_t tn) {
-    if (tn != 0 && d[d[tn].link[0]].level == d[tn].level) {
-        int32_t tmp = d[tn].link[0];
-        d[tn].link[0] = d[tmp].link[1];
-        d[tmp].link[1] = tn;
+#if defined _i_order_stats
+STC_DEF isize
+_c_MEMB(_rank)(const Self* self, _m_keyraw rkey) {
+    _i_nodes d = self->nodes;
+    _i_index tn = self->root;
+    isize rank = 0;
+    while (tn) {
+        int c; const _m_keyraw _raw = i_keytoraw(_i_keyref(&_i_nd(d, tn).value));
+        if ((c = i_cmp((&_raw), (&rkey))) < 0)
+            { rank += _i_nd(d, _i_nd(d, tn).link[0]).count + 1; tn = _i_nd(d, tn).link[1]; }
+        else if (c > 0)
+            tn = _i_nd(d, tn).link[0];
+        else
+            return rank + _i_nd(d, _i_nd(d, tn).link[0]).count;
+    }
+    return rank;
+}
+
+STC_DEF _m_iter
+_c_MEMB(_select)(const Self* self, isize k) {
+    _m_iter it = _c_MEMB(_end)(self);
+    _i_nodes d = it._d = self->nodes;
+    _i_index tn = self->root;
+    while (tn) {
+        const isize lc = _i_nd(d, _i_nd(d, tn).link[0]).count;
+        if (k < lc)
+            { it._st[it._top++] = tn; tn = _i_nd(d, tn).link[0]; }
+        else if (k > lc)
+            { k -= lc + 1; tn = _i_nd(d, tn).link[1]; }
+        else
+            { it._tn = _i_nd(d, tn).link[1]; it.ref = &_i_nd(d, tn).value; return it; }
+    }
+    it._top = 0;
+    return it;
+}
+#endif // _i_order_stats
+
+// Recount the subtree size of node tn after its children changed.
+#define _i_recount(d, tn) _i_if_order_stats( \
+    if (tn) _i_nd(d, tn).count = _i_nd(d, _i_nd(d, tn).link[0]).count + _i_nd(d, _i_nd(d, tn).link[1]).count + 1; )
+
+STC_DEF _i_index
+_c_MEMB(_skew_)(_i_nodes d, _i_index tn) {
+    if (tn != 0 && _i_nd(d, _i_nd(d, tn).link[0]).level == _i_nd(d, tn).level) {
+        _i_index tmp = _i_nd(d, tn).link[0];
+        _i_nd(d, tn).link[0] = _i_nd(d, tmp).link[1];
+        _i_nd(d, tmp).link[1] = tn;
+        _i_recount(d, tn);
+        _i_recount(d, tmp);
         tn = tmp;
     }
     return tn;
 }
 
-STC_DEF int32_t
-_c_MEMB(_split_)(_m_node *d, int32_t tn) {
-    if (d[d[d[tn].link[1]].link[1]].level == d[tn].level) {
-        int32_t tmp = d[tn].link[1];
-        d[tn].link[1] = d[tmp].link[0];
-        d[tmp].link[0] = tn;
+STC_DEF _i_index
+_c_MEMB(_split_)(_i_nodes d, _i_index tn) {
+    if (_i_nd(d, _i_nd(d, _i_nd(d, tn).link[1]).link[1]).level == _i_nd(d, tn).level) {
+        _i_index tmp = _i_nd(d, tn).link[1];
+        _i_nd(d, tn).link[1] = _i_nd(d, tmp).link[0];
+        _i_nd(d, tmp).link[0] = tn;
+        _i_recount(d, tn);
+        _i_recount(d, tmp);
         tn = tmp;
-        ++d[tn].level;
+        ++_i_nd(d, tn).level;
     }
     return tn;
 }
 
-STC_DEF int32_t
-_c_MEMB(_insert_entry_i_)(Self* self, int32_t tn, const _m_keyraw* rkey, _m_result* _res) {
-    int32_t up[64], tx = tn;
-    _m_node* d = self->nodes;
+STC_DEF _i_index
+_c_MEMB(_insert_entry_i_)(Self* self, _i_index tn, const _m_keyraw* rkey, _m_result* _res) {
+    _i_index up[c_sizeof(_i_index)*16], tx = tn;
+    _i_nodes d = self->nodes;
     int c, top = 0, dir = 0;
     while (tx) {
         up[top++] = tx;
-        const _m_keyraw _raw = i_keytoraw(_i_keyref(&d[tx].value));
+        const _m_keyraw _raw = i_keytoraw(_i_keyref(&_i_nd(d, tx).value));
         if ((c = i_cmp((&_raw), rkey)) == 0)
-            { _res->ref = &d[tx].value; return tn; }
+            { _res->ref = &_i_nd(d, tx).value; return tn; }
         dir = (c < 0);
-        tx = d[tx].link[dir];
+        tx = _i_nd(d, tx).link[dir];
     }
     if ((tx = _c_MEMB(_new_node_)(self, 1)) == 0)
         return 0;
     d = self->nodes;
-    _res->ref = &d[tx].value;
+    _res->ref = &_i_nd(d, tx).value;
     _res->inserted = true;
     if (top == 0)
         return tx;
-    d[up[top - 1]].link[dir] = tx;
+    _i_nd(d, up[top - 1]).link[dir] = tx;
     while (top--) {
         if (top != 0)
-            dir = (d[up[top - 1]].link[1] == up[top]);
+            dir = (_i_nd(d, up[top - 1]).link[1] == up[top]);
+        _i_recount(d, up[top]);
         up[top] = _c_MEMB(_skew_)(d, up[top]);
         up[top] = _c_MEMB(_split_)(d, up[top]);
         if (top)
-            d[up[top - 1]].link[dir] = up[top];
+            _i_nd(d, up[top - 1]).link[dir] = up[top];
     }
     return up[0];
 }
@@ -452,48 +607,49 @@ _c_MEMB(_insert_entry_i_)(Self* self, int32_t tn, const _m_keyraw* rkey, _m_resu
 STC_DEF _m_result
 _c_MEMB(_insert_entry_)(Self* self, _m_keyraw rkey) {
     _m_result res = {NULL};
-    int32_t tn = _c_MEMB(_insert_entry_i_)(self, self->root, &rkey, &res);
+    _i_index tn = _c_MEMB(_insert_entry_i_)(self, self->root, &rkey, &res);
     self->root = tn;
     self->size += res.inserted;
     return res;
 }
 
-STC_DEF int32_t
-_c_MEMB(_erase_r_)(Self *self, int32_t tn, const _m_keyraw* rkey, int *erased) {
-    _m_node *d = self->nodes;
+STC_DEF _i_index
+_c_MEMB(_erase_r_)(Self *self, _i_index tn, const _m_keyraw* rkey, int *erased) {
+    _i_nodes d = self->nodes;
     if (tn == 0)
         return 0;
-    _m_keyraw raw = i_keytoraw(_i_keyref(&d[tn].value));
-    int32_t tx; int c = i_cmp((&raw), rkey);
+    _m_keyraw raw = i_keytoraw(_i_keyref(&_i_nd(d, tn).value));
+    _i_index tx; int c = i_cmp((&raw), rkey);
     if (c != 0)
-        d[tn].link[c < 0] = _c_MEMB(_erase_r_)(self, d[tn].link[c < 0], rkey, erased);
+        _i_nd(d, tn).link[c < 0] = _c_MEMB(_erase_r_)(self, _i_nd(d, tn).link[c < 0], rkey, erased);
     else {
         if ((*erased)++ == 0)
-            _c_MEMB(_value_drop)(&d[tn].value); // drop first time, not second.
-        if (d[tn].link[0] && d[tn].link[1]) {
-            tx = d[tn].link[0];
-            while (d[tx].link[1])
-                tx = d[tx].link[1];
-            d[tn].value = d[tx].value; /* move */
-            raw = i_keytoraw(_i_keyref(&d[tn].value));
-            d[tn].link[0] = _c_MEMB(_erase_r_)(self, d[tn].link[0], &raw, erased);
+            _c_MEMB(_value_drop)(&_i_nd(d, tn).value); // drop first time, not second.
+        if (_i_nd(d, tn).link[0] && _i_nd(d, tn).link[1]) {
+            tx = _i_nd(d, tn).link[0];
+            while (_i_nd(d, tx).link[1])
+                tx = _i_nd(d, tx).link[1];
+            _i_nd(d, tn).value = _i_nd(d, tx).value; /* move */
+            raw = i_keytoraw(_i_keyref(&_i_nd(d, tn).value));
+            _i_nd(d, tn).link[0] = _c_MEMB(_erase_r_)(self, _i_nd(d, tn).link[0], &raw, erased);
         } else { /* unlink node */
             tx = tn;
-            tn = d[tn].link[ d[tn].link[0] == 0 ];
+            tn = _i_nd(d, tn).link[ _i_nd(d, tn).link[0] == 0 ];
             /* move it to disposed nodes list */
-            d[tx].link[1] = self->disp;
+            _i_nd(d, tx).link[1] = self->disp;
             self->disp = tx;
         }
     }
-    tx = d[tn].link[1];
-    if (d[d[tn].link[0]].level < d[tn].level - 1 || d[tx].level < d[tn].level - 1) {
-        if (d[tx].level > --d[tn].level)
-            d[tx].level = d[tn].level;
+    _i_recount(d, tn);
+    tx = _i_nd(d, tn).link[1];
+    if (_i_nd(d, _i_nd(d, tn).link[0]).level < _i_nd(d, tn).level - 1 || _i_nd(d, tx).level < _i_nd(d, tn).level - 1) {
+        if (_i_nd(d, tx).level > --_i_nd(d, tn).level)
+            _i_nd(d, tx).level = _i_nd(d, tn).level;
                        tn = _c_MEMB(_skew_)(d, tn);
-       tx = d[tn].link[1] = _c_MEMB(_skew_)(d, d[tn].link[1]);
-            d[tx].link[1] = _c_MEMB(_skew_)(d, d[tx].link[1]);
+       tx = _i_nd(d, tn).link[1] = _c_MEMB(_skew_)(d, _i_nd(d, tn).link[1]);
+            _i_nd(d, tx).link[1] = _c_MEMB(_skew_)(d, _i_nd(d, tx).link[1]);
                        tn = _c_MEMB(_split_)(d, tn);
-            d[tn].link[1] = _c_MEMB(_split_)(d, d[tn].link[1]);
+            _i_nd(d, tn).link[1] = _c_MEMB(_split_)(d, _i_nd(d, tn).link[1]);
     }
     return tn;
 }
@@ -501,7 +657,7 @@ _c_MEMB(_erase_r_)(Self *self, int32_t tn, const _m_keyraw* rkey, int *erased) {
 STC_DEF int
 _c_MEMB(_erase)(Self* self, _m_keyraw rkey) {
     int erased = 0;
-    int32_t root = _c_MEMB(_erase_r_)(self, self->root, &rkey, &erased);
+    _i_index root = _c_MEMB(_erase_r_)(self, self->root, &rkey, &erased);
     if (erased == 0)
         return 0;
     self->root = root;
@@ -543,14 +699,15 @@ _c_MEMB(_erase_range)(Self* self, _m_iter it1, _m_iter it2) {
 }
 
 #if !defined i_no_clone
-STC_DEF int32_t
-_c_MEMB(_clone_r_)(Self* self, _m_node* src, int32_t sn) {
+STC_DEF _i_index
+_c_MEMB(_clone_r_)(Self* self, _i_nodes src, _i_index sn) {
     if (sn == 0)
         return 0;
-    int32_t tx, tn = _c_MEMB(_new_node_)(self, src[sn].level);
-    self->nodes[tn].value = _c_MEMB(_value_clone)(src[sn].value);
-    tx = _c_MEMB(_clone_r_)(self, src, src[sn].link[0]); self->nodes[tn].link[0] = tx;
-    tx = _c_MEMB(_clone_r_)(self, src, src[sn].link[1]); self->nodes[tn].link[1] = tx;
+    _i_index tx, tn = _c_MEMB(_new_node_)(self, _i_nd(src, sn).level);
+    _i_nd(self->nodes, tn).value = _c_MEMB(_value_clone)(_i_nd(src, sn).value);
+    tx = _c_MEMB(_clone_r_)(self, src, _i_nd(src, sn).link[0]); _i_nd(self->nodes, tn).link[0] = tx;
+    tx = _c_MEMB(_clone_r_)(self, src, _i_nd(src, sn).link[1]); _i_nd(self->nodes, tn).link[1] = tx;
+    _i_recount(self->nodes, tn);
     return tn;
 }
 
@@ -560,11 +717,247 @@ _c_MEMB(_clone)(Self tree) {
     tree.root = _c_MEMB(_clone_r_)(&clone, tree.nodes, tree.root);
     tree.nodes = clone.nodes;
     tree.disp = clone.disp;
+    tree.head = clone.head;
     tree.capacity = clone.capacity;
     return tree;
 }
 #endif // !i_no_clone
 
+// Link the in-order nodes d[lo + 1 .. lo + n] into a perfectly balanced AA-tree.
+// The larger half goes right, so a left child is always one level below its parent.
+static _i_index
+_c_MEMB(_build_r_)(_i_nodes d, _i_index lo, _i_index n) {
+    if (n == 0)
+        return 0;
+    const _i_index left = (n - 1)/2, tn = lo + left + 1;
+    _i_nd(d, tn).link[0] = _c_MEMB(_build_r_)(d, lo, left);
+    _i_nd(d, tn).link[1] = _c_MEMB(_build_r_)(d, tn, n - 1 - left);
+    _i_nd(d, tn).level = (int8_t)(_i_nd(d, _i_nd(d, tn).link[0]).level + 1);
+    _i_recount(d, tn);
+    return tn;
+}
+
+#define _i_rawkey(rp) _i_SET_ONLY( (rp) )_i_MAP_ONLY( (&(rp)->first) )
+
+// Append raw after the n merged entries in d[1..n], or update d[n] if it has the same key,
+// with the semantics of put_n(). Returns the new number of entries.
+static _i_index
+_c_MEMB(_put_last_)(_i_nodes d, _i_index n, const _m_raw* raw) {
+    if (n > 0) {
+        const _m_keyraw _raw = i_keytoraw(_i_keyref(&_i_nd(d, n).value));
+        if (i_eq((&_raw), _i_rawkey(raw))) {
+          #if defined i_no_emplace
+            i_keydrop(((_m_key*)_i_rawkey(raw)));
+            _i_MAP_ONLY( i_valdrop((&_i_nd(d, n).value.second));
+                         _i_nd(d, n).value.second = raw->second; )
+          #else
+            _i_MAP_ONLY( i_valdrop((&_i_nd(d, n).value.second));
+                         _i_nd(d, n).value.second = i_valfrom(raw->second); )
+          #endif
+            return n;
+        }
+    }
+    _m_value* v = &_i_nd(d, n + 1).value;
+    ++n;
+  #if defined i_no_emplace
+    *_i_keyref(v) = *_i_rawkey(raw);
+    _i_MAP_ONLY( v->second = raw->second; )
+  #else
+    *_i_keyref(v) = i_keyfrom((*_i_rawkey(raw)));
+    _i_MAP_ONLY( v->second = i_valfrom(raw->second); )
+  #endif
+    return n;
+}
+
+// Make store an empty tree with room for cap entries. Returns false if out of memory.
+static bool
+_c_MEMB(_new_store_)(Self* store, const isize cap) {
+    *store = _c_MEMB(_with_capacity)(cap);
+    return store->capacity >= cap;
+}
+
+// Give self the m entries stored in key order in store.nodes[1..m], linked up as a balanced
+// tree. The old node array of self must hold no entries.
+static void
+_c_MEMB(_set_nodes_)(Self* self, Self store, const _i_index m) {
+    if (store.nodes != self->nodes) {
+        _c_MEMB(_free_store_)(self->nodes, self->capacity);
+        if (m == 0) {
+            _c_MEMB(_free_store_)(store.nodes, store.capacity);
+            store.nodes = NULL, store.capacity = 0;
+        }
+        self->nodes = store.nodes;
+        self->capacity = store.capacity;
+    }
+    self->root = _c_MEMB(_build_r_)(self->nodes, 0, m);
+    self->size = self->head = m;
+    self->disp = 0;
+}
+
+// Merge the current entries in order with the sorted raw into a new node array, and
+// link them up as a balanced tree. Returns false if out of memory.
+static bool
+_c_MEMB(_merge_sorted_)(Self* self, const _m_raw* raw, isize n) {
+    const isize cap = self->size + n;
+    Self store = *self;
+    if ((self->size || cap > self->capacity) && !_c_MEMB(_new_store_)(&store, cap))
+        return false;
+    _i_nodes d = store.nodes;
+    _m_iter it = _c_MEMB(_begin)(self);
+    _i_index m = 0;
+    for (isize i = 0; it.ref || i < n; ) {
+        bool take = (i == n);
+        if (!take && it.ref) {
+            const _m_keyraw _raw = i_keytoraw(_i_keyref(it.ref));
+            take = i_cmp((&_raw), _i_rawkey(&raw[i])) <= 0;
+        }
+        if (take)
+            { ++m; _i_nd(d, m).value = *it.ref; _c_MEMB(_next)(&it); }
+        else
+            m = _c_MEMB(_put_last_)(d, m, &raw[i++]);
+    }
+    _c_MEMB(_set_nodes_)(self, store, m);
+    return true;
+}
+
+STC_DEF void
+_c_MEMB(_put_sorted_n)(Self* self, const _m_raw* raw, isize n) {
+    isize i = 1;
+    while (i < n && i_cmp(_i_rawkey(&raw[i - 1]), _i_rawkey(&raw[i])) <= 0)
+        ++i;
+    if (i < n || !_c_MEMB(_merge_sorted_)(self, raw, n)) // not sorted, or out of memory
+        _c_MEMB(_put_n)(self, raw, n);
+}
+
+STC_DEF bool
+_c_MEMB(_compact)(Self* self) {
+    if (self->size == 0) {
+        _c_MEMB(_clear)(self);
+        return true;
+    }
+    return _c_MEMB(_merge_sorted_)(self, NULL, 0);
+}
+
+// Compare the keys of two iterators; an end iterator compares greater than any key.
+static int
+_c_MEMB(_cmp_it_)(const _m_iter* i, const _m_iter* j) {
+    if (i->ref == NULL || j->ref == NULL)
+        return (i->ref == NULL) - (j->ref == NULL);
+    const _m_keyraw _rx = i_keytoraw(_i_keyref(i->ref)), _ry = i_keytoraw(_i_keyref(j->ref));
+    return i_cmp((&_rx), (&_ry));
+}
+
+STC_DEF bool
+_c_MEMB(_merge)(Self* self, Self* other) {
+    const isize cap = self->size + other->size, ocap = other->size;
+    if (ocap == 0)
+        return true;
+    Self s1, s2;
+    if (!_c_MEMB(_new_store_)(&s1, cap) | !_c_MEMB(_new_store_)(&s2, ocap)) {
+        _c_MEMB(_free_store_)(s1.nodes, s1.capacity);
+        _c_MEMB(_free_store_)(s2.nodes, s2.capacity);
+        return false;
+    }
+    _i_nodes d = s1.nodes;
+    _i_nodes e = s2.nodes;
+    _m_iter i = _c_MEMB(_begin)(self), j = _c_MEMB(_begin)(other);
+    _i_index m = 0, k = 0;
+    while (i.ref || j.ref) {
+        const int c = _c_MEMB(_cmp_it_)(&i, &j);
+        if (c > 0)
+            { ++m; _i_nd(d, m).value = *j.ref; _c_MEMB(_next)(&j); continue; }
+        if (c == 0) // the key is in both: it stays in other
+            { ++k; _i_nd(e, k).value = *j.ref; _c_MEMB(_next)(&j); }
+        ++m; _i_nd(d, m).value = *i.ref; _c_MEMB(_next)(&i);
+    }
+    _c_MEMB(_set_nodes_)(self, s1, m);
+    _c_MEMB(_set_nodes_)(other, s2, k);
+    return true;
+}
+
+STC_DEF bool
+_c_MEMB(_split)(Self* self, _m_keyraw rkey, Self* out) {
+    Self hi = *self;
+    hi.nodes = NULL, hi.root = hi.disp = hi.head = hi.size = hi.capacity = 0;
+    _m_iter it = _c_MEMB(_begin)(self);
+    _i_index n = 0; // entries less than rkey
+    for (; it.ref; _c_MEMB(_next)(&it), ++n) {
+        const _m_keyraw _raw = i_keytoraw(_i_keyref(it.ref));
+        if (i_cmp((&_raw), (&rkey)) >= 0) break;
+    }
+    const _i_index m = self->size - n;
+    if (n == 0) { // move it all
+        hi = *self;
+        self->nodes = NULL, self->root = self->disp = self->head = self->size = self->capacity = 0;
+    } else if (m != 0) {
+        Self s1, s2;
+        if (!_c_MEMB(_new_store_)(&s1, n) | !_c_MEMB(_new_store_)(&s2, m)) {
+            _c_MEMB(_free_store_)(s1.nodes, s1.capacity);
+            _c_MEMB(_free_store_)(s2.nodes, s2.capacity);
+            return false;
+        }
+        _i_nodes d = s1.nodes;
+        _i_nodes e = s2.nodes;
+        it = _c_MEMB(_begin)(self);
+        for (_i_index i = 1; i <= n; ++i, _c_MEMB(_next)(&it))
+            _i_nd(d, i).value = *it.ref;
+        for (_i_index i = 1; i <= m; ++i, _c_MEMB(_next)(&it))
+            _i_nd(e, i).value = *it.ref;
+        _c_MEMB(_set_nodes_)(self, s1, n);
+        _c_MEMB(_set_nodes_)(&hi, s2, m);
+    }
+    _c_MEMB(_drop)(out);
+    *out = hi;
+    return true;
+}
+
+#if !defined i_no_clone
+// Clone the entries of a and b into a new tree: those only in a if keep & 1, only in b
+// if keep & 2, and (from a) those in both if keep & 4.
+static Self
+_c_MEMB(_combine_)(const Self* a, const Self* b, int keep, isize cap) {
+    Self out = *a;
+    out.nodes = NULL, out.root = out.disp = out.head = out.size = out.capacity = 0;
+    Self store;
+    if (!_c_MEMB(_new_store_)(&store, cap)) {
+        _c_MEMB(_free_store_)(store.nodes, store.capacity);
+        return out;
+    }
+    _i_nodes d = store.nodes;
+    _m_iter i = _c_MEMB(_begin)(a), j = _c_MEMB(_begin)(b);
+    _i_index m = 0;
+    while ((i.ref && (j.ref || keep & 1)) || (j.ref && keep & 2)) {
+        const int c = _c_MEMB(_cmp_it_)(&i, &j);
+        if (c < 0) {
+            if (keep & 1) { ++m; _i_nd(d, m).value = _c_MEMB(_value_clone)(*i.ref); }
+            _c_MEMB(_next)(&i);
+        } else if (c > 0) {
+            if (keep & 2) { ++m; _i_nd(d, m).value = _c_MEMB(_value_clone)(*j.ref); }
+            _c_MEMB(_next)(&j);
+        } else {
+            if (keep & 4) { ++m; _i_nd(d, m).value = _c_MEMB(_value_clone)(*i.ref); }
+            _c_MEMB(_next)(&i); _c_MEMB(_next)(&j);
+        }
+    }
+    _c_MEMB(_set_nodes_)(&out, store, m);
+    return out;
+}
+
+STC_DEF Self
+_c_MEMB(_union)(const Self* a, const Self* b)
+    { return _c_MEMB(_combine_)(a, b, 1|2|4, a->size + b->size); }
+
+STC_DEF Self
+_c_MEMB(_intersection)(const Self* a, const Self* b)
+    { return _c_MEMB(_combine_)(a, b, 4, a->size < b->size ? a->size : b->size); }
+
+STC_DEF Self
+_c_MEMB(_difference)(const Self* a, const Self* b)
+    { return _c_MEMB(_combine_)(a, b, 1, a->size); }
+#endif // !i_no_clone
+
+#undef _i_rawkey
+
 #if !defined i_no_emplace
 STC_DEF _m_result
 _c_MEMB(_emplace)(Self* self, _m_keyraw rkey _i_MAP_ONLY(, _m_rmapped rmapped)) {
@@ -578,11 +971,11 @@ _c_MEMB(_emplace)(Self* self, _m_keyraw rkey _i_MAP_ONLY(, _m_rmapped rmapped))
 #endif // i_no_emplace
 
 static void
-_c_MEMB(_drop_r_)(_m_node* d, int32_t tn) {
+_c_MEMB(_drop_r_)(_i_nodes d, _i_index tn) {
     if (tn != 0) {
-        _c_MEMB(_drop_r_)(d, d[tn].link[0]);
-        _c_MEMB(_drop_r_)(d, d[tn].link[1]);
-        _c_MEMB(_value_drop)(&d[tn].value);
+        _c_MEMB(_drop_r_)(d, _i_nd(d, tn).link[0]);
+        _c_MEMB(_drop_r_)(d, _i_nd(d, tn).link[1]);
+        _c_MEMB(_value_drop)(&_i_nd(d, tn).value);
     }
 }
 
@@ -591,11 +984,21 @@ _c_MEMB(_drop)(const Self* cself) {
     Self* self = (Self*)cself;
     if (self->capacity != 0) {
         _c_MEMB(_drop_r_)(self->nodes, self->root);
-        i_free(self->nodes, (self->capacity + 1)*c_sizeof(_m_node));
+        _c_MEMB(_free_store_)(self->nodes, self->capacity);
     }
 }
 
+#undef _i_recount
 #endif // i_implement
+#undef i_order_stats
+#undef _i_order_stats
+#undef i_index64
+#undef i_chunked
+#undef _i_chunked
+#undef _i_index
+#undef _i_nodes
+#undef _i_nd
+#undef _i_if_order_stats
 #undef _i_is_set
 #undef _i_is_map
 #undef _i_sorted
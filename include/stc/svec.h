@@ -0,0 +1,387 @@
+/* MIT License
+ *
+ * Copyright (c) 2025 Tyge Løvset
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Small vector - a vec which stores up to i_inline elements inside the struct, and moves
+// them to the heap when it grows beyond that. Use svec_X_data() instead of the data member.
+/*
+#include <stdio.h>
+#define i_type Tokens, int
+#define i_inline 8
+#define i_use_cmp
+#include "stc/svec.h"
+
+int main(void) {
+    Tokens t = {0};
+    for (c_range(i, 5)) Tokens_push(&t, 10 - (int)i); // no allocation
+    Tokens_sort(&t);
+    for (c_each(i, Tokens, t)) printf(" %d", *i.ref);
+    Tokens_drop(&t);
+}
+*/
+#include "priv/linkage.h"
+#include "types.h"
+
+#ifndef STC_SVEC_H_INCLUDED
+#define STC_SVEC_H_INCLUDED
+#include "common.h"
+#include <stdlib.h>
+#endif // STC_SVEC_H_INCLUDED
+
+#ifndef _i_prefix
+  #define _i_prefix svec_
+#endif
+#ifndef i_inline
+  #define i_inline 8
+#endif
+#include "priv/template.h"
+
+#ifndef i_declared
+   _c_DEFTYPES(_c_svec_types, Self, i_key, i_inline);
+#endif
+typedef i_keyraw _m_raw;
+STC_API void            _c_MEMB(_drop)(const Self* cself);
+STC_API void            _c_MEMB(_clear)(Self* self);
+STC_API bool            _c_MEMB(_reserve)(Self* self, isize cap);
+STC_API bool            _c_MEMB(_resize)(Self* self, isize size, _m_value null);
+STC_API _m_iter         _c_MEMB(_erase_n)(Self* self, isize idx, isize n);
+STC_API _m_iter         _c_MEMB(_insert_uninit)(Self* self, isize idx, isize n);
+#if defined _i_has_eq
+STC_API _m_iter         _c_MEMB(_find_in)(const Self* self, _m_iter it1, _m_iter it2, _m_raw raw);
+#endif // _i_has_eq
+STC_INLINE Self         _c_MEMB(_init)(void) { return c_literal(Self){0}; }
+STC_INLINE void         _c_MEMB(_value_drop)(_m_value* val) { i_keydrop(val); }
+
+STC_INLINE bool         _c_MEMB(_is_inline)(const Self* self) { return self->capacity == 0; }
+STC_INLINE _m_value*    _c_MEMB(_data)(const Self* self)
+                            { return self->capacity ? self->data.ptr : (_m_value*)self->data.buf; }
+STC_INLINE isize        _c_MEMB(_capacity)(const Self* self)
+                            { return self->capacity ? self->capacity : i_inline; }
+
+STC_INLINE Self _c_MEMB(_move)(Self *self) {
+    Self m = *self;
+    memset(self, 0, sizeof *self);
+    return m;
+}
+
+STC_INLINE void _c_MEMB(_take)(Self *self, Self unowned) {
+    _c_MEMB(_drop)(self);
+    *self = unowned;
+}
+
+STC_INLINE _m_value* _c_MEMB(_push)(Self* self, _m_value value) {
+    if (self->size == _c_MEMB(_capacity)(self))
+        if (!_c_MEMB(_reserve)(self, self->size*2 + 4))
+            return NULL;
+    _m_value *v = _c_MEMB(_data)(self) + self->size++;
+    *v = value;
+    return v;
+}
+
+STC_INLINE void _c_MEMB(_put_n)(Self* self, const _m_raw* raw, isize n)
+    { while (n--) _c_MEMB(_push)(self, i_keyfrom((*raw))), ++raw; }
+
+STC_INLINE Self _c_MEMB(_with_n)(const _m_raw* raw, isize n)
+    { Self cx = {0}; _c_MEMB(_put_n)(&cx, raw, n); return cx; }
+
+#if !defined i_no_emplace
+STC_API _m_iter _c_MEMB(_emplace_n)(Self* self, isize idx, const _m_raw raw[], isize n);
+
+STC_INLINE _m_value* _c_MEMB(_emplace)(Self* self, _m_raw raw)
+    { return _c_MEMB(_push)(self, i_keyfrom(raw)); }
+
+STC_INLINE _m_value* _c_MEMB(_emplace_back)(Self* self, _m_raw raw)
+    { return _c_MEMB(_push)(self, i_keyfrom(raw)); }
+
+STC_INLINE _m_iter _c_MEMB(_emplace_at)(Self* self, _m_iter it, _m_raw raw) {
+    const isize idx = it.ref ? it.ref - _c_MEMB(_data)(self) : self->size;
+    return _c_MEMB(_emplace_n)(self, idx, &raw, 1);
+}
+#endif // !i_no_emplace
+
+#if !defined i_no_clone
+STC_API Self            _c_MEMB(_clone)(Self cx);
+STC_API _m_iter         _c_MEMB(_copy_n)(Self* self, isize idx, const _m_value arr[], isize n);
+
+STC_INLINE _m_value     _c_MEMB(_value_clone)(_m_value val)
+                            { return i_keyclone(val); }
+
+STC_INLINE void         _c_MEMB(_copy)(Self* self, const Self other) {
+                            if (self->capacity && self->data.ptr == other.data.ptr) return;
+                            Self tmp = _c_MEMB(_clone)(other); // other may be a copy of *self
+                            _c_MEMB(_drop)(self);
+                            *self = tmp;
+                        }
+#endif // !i_no_clone
+
+STC_INLINE isize        _c_MEMB(_size)(const Self* self) { return self->size; }
+STC_INLINE bool         _c_MEMB(_is_empty)(const Self* self) { return !self->size; }
+STC_INLINE _m_raw       _c_MEMB(_value_toraw)(const _m_value* val) { return i_keytoraw(val); }
+STC_INLINE const _m_value*  _c_MEMB(_front)(const Self* self) { return _c_MEMB(_data)(self); }
+STC_INLINE _m_value*        _c_MEMB(_front_mut)(Self* self) { return _c_MEMB(_data)(self); }
+STC_INLINE const _m_value*  _c_MEMB(_back)(const Self* self) { return _c_MEMB(_data)(self) + self->size - 1; }
+STC_INLINE _m_value*        _c_MEMB(_back_mut)(Self* self) { return _c_MEMB(_data)(self) + self->size - 1; }
+
+STC_INLINE void         _c_MEMB(_pop)(Self* self)
+                            { c_assert(self->size); _m_value* p = _c_MEMB(_data)(self) + --self->size; i_keydrop(p); }
+STC_INLINE _m_value     _c_MEMB(_pull)(Self* self)
+                            { c_assert(self->size); return _c_MEMB(_data)(self)[--self->size]; }
+STC_INLINE _m_value*    _c_MEMB(_push_back)(Self* self, _m_value value)
+                            { return _c_MEMB(_push)(self, value); }
+STC_INLINE void         _c_MEMB(_pop_back)(Self* self) { _c_MEMB(_pop)(self); }
+
+STC_INLINE Self _c_MEMB(_with_size)(const isize size, _m_value null) {
+    Self cx = {0};
+    _c_MEMB(_resize)(&cx, size, null);
+    return cx;
+}
+
+STC_INLINE Self _c_MEMB(_with_capacity)(const isize cap) {
+    Self cx = {0};
+    _c_MEMB(_reserve)(&cx, cap);
+    return cx;
+}
+
+// Moves the elements back inside the struct when they fit.
+STC_INLINE void _c_MEMB(_shrink_to_fit)(Self* self) {
+    _c_MEMB(_reserve)(self, _c_MEMB(_size)(self));
+}
+
+STC_INLINE _m_iter
+_c_MEMB(_insert_n)(Self* self, const isize idx, const _m_value arr[], const isize n) {
+    _m_iter it = _c_MEMB(_insert_uninit)(self, idx, n);
+    if (it.ref)
+        c_memcpy(it.ref, arr, n*c_sizeof *arr);
+    return it;
+}
+
+STC_INLINE _m_iter _c_MEMB(_insert_at)(Self* self, _m_iter it, const _m_value value) {
+    const isize idx = it.ref ? it.ref - _c_MEMB(_data)(self) : self->size;
+    return _c_MEMB(_insert_n)(self, idx, &value, 1);
+}
+
+STC_INLINE _m_iter _c_MEMB(_erase_at)(Self* self, _m_iter it) {
+    return _c_MEMB(_erase_n)(self, it.ref - _c_MEMB(_data)(self), 1);
+}
+
+STC_INLINE _m_iter _c_MEMB(_erase_range)(Self* self, _m_iter i1, _m_iter i2) {
+    const _m_value* p2 = i1.ref && !i2.ref ? i1.end : i2.ref;
+    return _c_MEMB(_erase_n)(self, i1.ref - _c_MEMB(_data)(self), p2 - i1.ref);
+}
+
+STC_INLINE const _m_value* _c_MEMB(_at)(const Self* self, const isize idx) {
+    c_assert(idx < self->size); return _c_MEMB(_data)(self) + idx;
+}
+
+STC_INLINE _m_value* _c_MEMB(_at_mut)(Self* self, const isize idx) {
+    c_assert(idx < self->size); return _c_MEMB(_data)(self) + idx;
+}
+
+// iteration: iterators to inline elements are invalidated when the svec is moved or copied
+
+STC_INLINE _m_iter _c_MEMB(_begin)(const Self* self) {
+    _m_value* d = _c_MEMB(_data)(self);
+    _m_iter it = {self->size ? d : NULL, d + self->size};
+    return it;
+}
+
+STC_INLINE _m_iter _c_MEMB(_rbegin)(const Self* self) {
+    _m_value* d = _c_MEMB(_data)(self);
+    _m_iter it = {self->size ? d + self->size - 1 : NULL, d - 1};
+    return it;
+}
+
+STC_INLINE _m_iter _c_MEMB(_end)(const Self* self)
+    { (void)self; _m_iter it = {0}; return it; }
+
+STC_INLINE _m_iter _c_MEMB(_rend)(const Self* self)
+    { (void)self; _m_iter it = {0}; return it; }
+
+STC_INLINE void _c_MEMB(_next)(_m_iter* it)
+    { if (++it->ref == it->end) it->ref = NULL; }
+
+STC_INLINE void _c_MEMB(_rnext)(_m_iter* it)
+    { if (--it->ref == it->end) it->ref = NULL; }
+
+STC_INLINE _m_iter _c_MEMB(_advance)(_m_iter it, size_t n) {
+    if ((it.ref += n) >= it.end) it.ref = NULL;
+    return it;
+}
+
+STC_INLINE isize _c_MEMB(_index)(const Self* self, _m_iter it)
+    { return (it.ref - _c_MEMB(_data)(self)); }
+
+STC_INLINE void _c_MEMB(_adjust_end_)(Self* self, isize n)
+    { self->size += n; }
+
+#if defined _i_has_eq
+STC_INLINE _m_iter _c_MEMB(_find)(const Self* self, _m_raw raw) {
+    return _c_MEMB(_find_in)(self, _c_MEMB(_begin)(self), _c_MEMB(_end)(self), raw);
+}
+
+STC_INLINE bool _c_MEMB(_eq)(const Self* self, const Self* other) {
+    if (self->size != other->size) return false;
+    const _m_value *x = _c_MEMB(_data)(self), *y = _c_MEMB(_data)(other);
+    for (isize i = 0; i < self->size; ++i) {
+        const _m_raw _rx = i_keytoraw((x+i)), _ry = i_keytoraw((y+i));
+        if (!(i_eq((&_rx), (&_ry)))) return false;
+    }
+    return true;
+}
+#endif // _i_has_eq
+
+#if defined _i_has_cmp
+#include "priv/sort_prv.h"
+#endif // _i_has_cmp
+
+/* -------------------------- IMPLEMENTATION ------------------------- */
+#if defined i_implement
+
+STC_DEF void
+_c_MEMB(_clear)(Self* self) {
+    if (self->size == 0) return;
+    _m_value *d = _c_MEMB(_data)(self), *p = d + self->size;
+    while (p-- != d) { i_keydrop(p); }
+    self->size = 0;
+}
+
+STC_DEF void
+_c_MEMB(_drop)(const Self* cself) {
+    Self* self = (Self*)cself;
+    _c_MEMB(_clear)(self);
+    if (self->capacity)
+        i_free(self->data.ptr, self->capacity*c_sizeof(*self->data.ptr));
+}
+
+STC_DEF bool
+_c_MEMB(_reserve)(Self* self, const isize cap) {
+    if (cap <= i_inline) { // move the elements inline if asked to shrink to fit
+        if (self->capacity && cap == self->size) {
+            _m_value* d = self->data.ptr;
+            const isize dcap = self->capacity;
+            c_memcpy(self->data.buf, d, self->size*c_sizeof *d);
+            i_free(d, dcap*c_sizeof *d);
+            self->capacity = 0;
+        }
+        return true;
+    }
+    if (cap > _c_MEMB(_capacity)(self) || (cap == self->size && cap != self->capacity)) {
+        _m_value* d;
+        if (self->capacity) {
+            d = (_m_value*)i_realloc(self->data.ptr, self->capacity*c_sizeof *d, cap*c_sizeof *d);
+        } else if ((d = _i_malloc(_m_value, cap)) != NULL) {
+            c_memcpy(d, self->data.buf, self->size*c_sizeof *d);
+        }
+        if (d == NULL)
+            return false;
+        self->data.ptr = d;
+        self->capacity = cap;
+    }
+    return true;
+}
+
+STC_DEF bool
+_c_MEMB(_resize)(Self* self, const isize len, _m_value null) {
+    if (len > _c_MEMB(_capacity)(self) && !_c_MEMB(_reserve)(self, len))
+        return false;
+    _m_value* d = _c_MEMB(_data)(self);
+    const isize n = self->size;
+    for (isize i = len; i < n; ++i)
+        { i_keydrop((d + i)); }
+    for (isize i = n; i < len; ++i)
+        d[i] = null;
+    self->size = len;
+    return true;
+}
+
+STC_DEF _m_iter
+_c_MEMB(_insert_uninit)(Self* self, const isize idx, const isize n) {
+    if (self->size + n > _c_MEMB(_capacity)(self))
+        if (!_c_MEMB(_reserve)(self, self->size*3/2 + n))
+            return _c_MEMB(_end)(self);
+
+    _m_value* d = _c_MEMB(_data)(self), *pos = d + idx;
+    c_memmove(pos + n, pos, (self->size - idx)*c_sizeof *pos);
+    self->size += n;
+    return c_literal(_m_iter){pos, d + self->size};
+}
+
+STC_DEF _m_iter
+_c_MEMB(_erase_n)(Self* self, const isize idx, const isize len) {
+    c_assert(idx + len <= self->size);
+    _m_value* d = _c_MEMB(_data)(self) + idx, *p = d, *end = _c_MEMB(_data)(self) + self->size;
+    for (isize i = 0; i < len; ++i, ++p)
+        { i_keydrop(p); }
+    memmove(d, p, (size_t)(end - p)*sizeof *d);
+    self->size -= len;
+    return c_literal(_m_iter){p == end ? NULL : d, end - len};
+}
+
+#if !defined i_no_clone
+STC_DEF Self
+_c_MEMB(_clone)(Self vec) {
+    Self tmp = vec;
+    tmp.size = tmp.capacity = 0;
+    _c_MEMB(_copy_n)(&tmp, 0, _c_MEMB(_data)(&vec), vec.size);
+    return tmp;
+}
+
+STC_DEF _m_iter
+_c_MEMB(_copy_n)(Self* self, const isize idx,
+                 const _m_value arr[], const isize n) {
+    _m_iter it = _c_MEMB(_insert_uninit)(self, idx, n);
+    if (it.ref)
+        for (_m_value* p = it.ref, *q = p + n; p != q; ++arr)
+            *p++ = i_keyclone((*arr));
+    return it;
+}
+#endif // !i_no_clone
+
+#if !defined i_no_emplace
+STC_DEF _m_iter
+_c_MEMB(_emplace_n)(Self* self, const isize idx, const _m_raw raw[], isize n) {
+    _m_iter it = _c_MEMB(_insert_uninit)(self, idx, n);
+    if (it.ref)
+        for (_m_value* p = it.ref; n--; ++raw, ++p)
+            *p = i_keyfrom((*raw));
+    return it;
+}
+#endif // !i_no_emplace
+
+#if defined _i_has_eq
+STC_DEF _m_iter
+_c_MEMB(_find_in)(const Self* self, _m_iter i1, _m_iter i2, _m_raw raw) {
+    (void)self;
+    const _m_value* p2 = i1.ref && !i2.ref ? i1.end : i2.ref;
+    for (; i1.ref != p2; ++i1.ref) {
+        const _m_raw r = i_keytoraw(i1.ref);
+        if (i_eq((&raw), (&r)))
+            return i1;
+    }
+    i2.ref = NULL;
+    return i2;
+}
+#endif //  _i_has_eq
+#endif // i_implement
+#undef i_inline
+#include "priv/linkage2.h"
+#include "priv/template2.h"
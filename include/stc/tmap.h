@@ -0,0 +1,820 @@
+/* MIT License
+ *
+ * Copyright (c) 2025 Tyge Løvset
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Trie map and set with cstr keys - an adaptive radix tree. The inner nodes branch on one byte
+// of the key, and have room for 4, 16, 48 or 256 children. Chains of nodes with one child are
+// compressed into a prefix of the node below. The leaves are also linked in key order.
+/*
+#include <stdio.h>
+#define i_implement
+#include "stc/cstr.h"
+
+#define i_type Routes
+#define i_val int
+#include "stc/tmap.h"
+
+int main(void) {
+    Routes r = c_make(Routes, {{"/", 0}, {"/api/", 1}, {"/api/users/", 2}, {"/static/", 3}});
+
+    const Routes_value* v = Routes_longest_prefix_match(&r, "/api/users/42");
+    printf("%s -> %d\n", cstr_str(&v->first), v->second); // "/api/users/" -> 2
+
+    for (Routes_iter it = Routes_prefix_begin(&r, "/api"); it.ref; Routes_next(&it))
+        printf("%s\n", cstr_str(&it.ref->first)); // "/api/", "/api/users/"
+    Routes_drop(&r);
+}
+*/
+#include "priv/linkage.h"
+#include "types.h"
+
+#ifndef STC_TMAP_H_INCLUDED
+#define STC_TMAP_H_INCLUDED
+#include "common.h"
+#include <stdlib.h>
+#define _tmap_prefix_max 12 // prefix bytes kept in a node: longer prefixes are read from a leaf
+enum { _tmap_n4, _tmap_n16, _tmap_n48, _tmap_n256 };
+
+// The header of the inner nodes. Child pointers to leaves are tagged with bit 0.
+struct tmap_node {
+    uint8_t type;
+    uint16_t count;      // number of children
+    uint32_t prefix_len; // bytes matched before the branch byte
+    uint8_t prefix[_tmap_prefix_max];
+    void* end;           // the leaf with the key which ends before the branch byte, or NULL
+};
+struct tmap_node4 { struct tmap_node h; uint8_t key[4]; void* child[4]; };
+struct tmap_node16 { struct tmap_node h; uint8_t key[16]; void* child[16]; };
+struct tmap_node48 { struct tmap_node h; uint8_t slot[256]; void* child[48]; }; // slot: index + 1
+struct tmap_node256 { struct tmap_node h; void* child[256]; };
+
+#define _tmap_is_leaf(p) ((uintptr_t)(p) & 1)
+#define _tmap_leaf(p) ((void*)((uintptr_t)(p) & ~(uintptr_t)1))
+#define _tmap_tagged(leaf) ((void*)((uintptr_t)(leaf) | 1))
+
+STC_INLINE isize _tmap_size(int type) {
+    switch (type) {
+        case _tmap_n4: return c_sizeof(struct tmap_node4);
+        case _tmap_n16: return c_sizeof(struct tmap_node16);
+        case _tmap_n48: return c_sizeof(struct tmap_node48);
+    }
+    return c_sizeof(struct tmap_node256);
+}
+
+// The sorted keys and the children of a node4 or node16.
+#define _tmap_keys(n) ((n)->type == _tmap_n4 ? ((struct tmap_node4*)(n))->key : ((struct tmap_node16*)(n))->key)
+#define _tmap_kids(n) ((n)->type == _tmap_n4 ? ((struct tmap_node4*)(n))->child : ((struct tmap_node16*)(n))->child)
+
+// The address of the child for byte b, or NULL.
+STC_INLINE void** _tmap_find_child(struct tmap_node* n, uint8_t b) {
+    if (n->type == _tmap_n48) {
+        struct tmap_node48* m = (struct tmap_node48*)n;
+        return m->slot[b] ? &m->child[m->slot[b] - 1] : NULL;
+    }
+    if (n->type == _tmap_n256) {
+        struct tmap_node256* m = (struct tmap_node256*)n;
+        return m->child[b] ? &m->child[b] : NULL;
+    }
+    uint8_t* key = _tmap_keys(n);
+    for (int i = 0; i < n->count; ++i)
+        if (key[i] == b) return &_tmap_kids(n)[i];
+    return NULL;
+}
+
+// The first child with byte > b (b = -1 for the first child), or NULL. Sets *at to its byte.
+STC_INLINE void* _tmap_next_child(struct tmap_node* n, int b, int* at) {
+    if (n->type == _tmap_n48) {
+        struct tmap_node48* m = (struct tmap_node48*)n;
+        for (int c = b + 1; c < 256; ++c)
+            if (m->slot[c]) { *at = c; return m->child[m->slot[c] - 1]; }
+    } else if (n->type == _tmap_n256) {
+        struct tmap_node256* m = (struct tmap_node256*)n;
+        for (int c = b + 1; c < 256; ++c)
+            if (m->child[c]) { *at = c; return m->child[c]; }
+    } else {
+        uint8_t* key = _tmap_keys(n);
+        for (int i = 0; i < n->count; ++i)
+            if (key[i] > b) { *at = key[i]; return _tmap_kids(n)[i]; }
+    }
+    return NULL;
+}
+
+STC_INLINE void* _tmap_last_child(struct tmap_node* n) {
+    if (n->type == _tmap_n48) {
+        struct tmap_node48* m = (struct tmap_node48*)n;
+        for (int c = 255; c >= 0; --c)
+            if (m->slot[c]) return m->child[m->slot[c] - 1];
+    } else if (n->type == _tmap_n256) {
+        struct tmap_node256* m = (struct tmap_node256*)n;
+        for (int c = 255; c >= 0; --c)
+            if (m->child[c]) return m->child[c];
+    } else if (n->count) {
+        return _tmap_kids(n)[n->count - 1];
+    }
+    return NULL;
+}
+
+STC_INLINE bool _tmap_is_full(const struct tmap_node* n) {
+    return n->count == (n->type == _tmap_n4 ? 4 : n->type == _tmap_n16 ? 16 :
+                        n->type == _tmap_n48 ? 48 : 256);
+}
+
+// Adds child for byte b to n, which must have room for it.
+STC_INLINE void _tmap_add_child(struct tmap_node* n, uint8_t b, void* child) {
+    if (n->type == _tmap_n48) {
+        struct tmap_node48* m = (struct tmap_node48*)n;
+        int i = 0;
+        while (m->child[i] != NULL) ++i;
+        m->child[i] = child;
+        m->slot[b] = (uint8_t)(i + 1);
+    } else if (n->type == _tmap_n256) {
+        ((struct tmap_node256*)n)->child[b] = child;
+    } else {
+        uint8_t* key = _tmap_keys(n);
+        void** kid = _tmap_kids(n);
+        int i = n->count;
+        for (; i > 0 && key[i - 1] > b; --i)
+            key[i] = key[i - 1], kid[i] = kid[i - 1];
+        key[i] = b, kid[i] = child;
+    }
+    ++n->count;
+}
+
+STC_INLINE void _tmap_remove_child(struct tmap_node* n, uint8_t b) {
+    if (n->type == _tmap_n48) {
+        struct tmap_node48* m = (struct tmap_node48*)n;
+        m->child[m->slot[b] - 1] = NULL;
+        m->slot[b] = 0;
+    } else if (n->type == _tmap_n256) {
+        ((struct tmap_node256*)n)->child[b] = NULL;
+    } else {
+        uint8_t* key = _tmap_keys(n);
+        void** kid = _tmap_kids(n);
+        int i = 0;
+        while (key[i] != b) ++i;
+        for (; i + 1 < n->count; ++i)
+            key[i] = key[i + 1], kid[i] = kid[i + 1];
+    }
+    --n->count;
+}
+
+// Copies the header and the children of n to the empty node m of another type.
+STC_INLINE void _tmap_copy_node(struct tmap_node* m, struct tmap_node* n) {
+    const uint8_t type = m->type;
+    *m = *n;
+    m->type = type, m->count = 0;
+    int b = -1;
+    for (void* c; (c = _tmap_next_child(n, b, &b)) != NULL; )
+        _tmap_add_child(m, (uint8_t)b, c);
+}
+
+STC_INLINE void _tmap_set_prefix(struct tmap_node* n, const char* s, isize len) {
+    n->prefix_len = (uint32_t)len;
+    c_memcpy(n->prefix, s, len < _tmap_prefix_max ? len : _tmap_prefix_max);
+}
+
+// The smallest and the largest leaf under p, which is not NULL.
+STC_INLINE void* _tmap_min_leaf(void* p) {
+    int b;
+    for (; !_tmap_is_leaf(p); p = _tmap_next_child((struct tmap_node*)p, -1, &b))
+        if (((struct tmap_node*)p)->end) return ((struct tmap_node*)p)->end;
+    return _tmap_leaf(p);
+}
+
+STC_INLINE void* _tmap_max_leaf(void* p) {
+    while (!_tmap_is_leaf(p)) {
+        void* c = _tmap_last_child((struct tmap_node*)p);
+        if (c == NULL) return ((struct tmap_node*)p)->end;
+        p = c;
+    }
+    return _tmap_leaf(p);
+}
+#endif // STC_TMAP_H_INCLUDED
+
+#ifndef _i_prefix
+  #define _i_prefix tmap_
+#endif
+#ifndef _i_is_set
+  #define _i_is_map
+  #define _i_MAP_ONLY c_true
+  #define _i_SET_ONLY c_false
+  #define _i_keyref(vp) (&(vp)->first)
+#else
+  #define _i_MAP_ONLY c_false
+  #define _i_SET_ONLY c_true
+  #define _i_keyref(vp) (vp)
+#endif
+#if defined i_key || defined i_keyclass || defined i_keypro
+  #error "tmap/tset keys are cstr: do not define i_key, i_keyclass or i_keypro"
+#endif
+#define i_keypro cstr
+#include "priv/template.h"
+
+typedef i_key _m_key;
+typedef i_val _m_mapped;
+_i_MAP_ONLY( struct _m_value {
+    _m_key first;
+    _m_mapped second;
+}; )
+typedef _i_SET_ONLY( _m_key )
+        _i_MAP_ONLY( struct _m_value )
+_m_value;
+
+typedef i_keyraw _m_keyraw;
+typedef i_valraw _m_rmapped;
+typedef _i_SET_ONLY( i_keyraw )
+        _i_MAP_ONLY( struct { _m_keyraw first;
+                              _m_rmapped second; } )
+_m_raw;
+
+typedef struct _m_node {
+    _m_value value; // first: a leaf pointer is also a pointer to its key
+    struct _m_node *prev, *next;
+} _m_node;
+
+typedef struct { _m_value* ref; _m_node *_leaf, *_end; } _m_iter;
+typedef struct { _m_value* ref; bool inserted; } _m_result;
+
+typedef struct Self {
+    void* root;
+    _m_node *head, *tail;
+    isize size;
+} Self;
+
+STC_API _m_result       _c_MEMB(_insert_entry_)(Self* self, csview key);
+STC_API _m_node*        _c_MEMB(_find_node_)(const Self* self, csview key);
+STC_API _m_node*        _c_MEMB(_bound_)(const Self* self, csview key, int mode);
+STC_API const _m_value* _c_MEMB(_longest_prefix_match_sv)(const Self* self, csview key);
+STC_API bool            _c_MEMB(_erase_sv)(Self* self, csview key);
+STC_API void            _c_MEMB(_clear)(Self* self);
+#if !defined i_no_clone
+STC_API Self            _c_MEMB(_clone)(Self map);
+#endif
+
+STC_INLINE Self         _c_MEMB(_init)(void) { Self map = {0}; return map; }
+STC_INLINE bool         _c_MEMB(_is_empty)(const Self* cx) { return cx->size == 0; }
+STC_INLINE isize        _c_MEMB(_size)(const Self* cx) { return cx->size; }
+STC_INLINE void         _c_MEMB(_drop)(const Self* self) { _c_MEMB(_clear)((Self*)self); }
+
+STC_INLINE csview _c_MEMB(_keysv_)(const _m_node* leaf)
+    { return cstr_sv(_i_keyref(&leaf->value)); }
+
+STC_INLINE _m_iter _c_MEMB(_begin)(const Self* self) {
+    _m_iter it = {self->head ? &self->head->value : NULL, self->head, NULL};
+    return it;
+}
+
+STC_INLINE _m_iter _c_MEMB(_end)(const Self* self)
+    { (void)self; _m_iter it = {0}; return it; }
+
+STC_INLINE void _c_MEMB(_next)(_m_iter* it) {
+    it->_leaf = it->_leaf->next;
+    it->ref = it->_leaf != it->_end ? &it->_leaf->value : NULL;
+}
+
+STC_INLINE _m_iter _c_MEMB(_advance)(_m_iter it, size_t n) {
+    while (n-- && it.ref) _c_MEMB(_next)(&it);
+    return it;
+}
+
+STC_INLINE _m_iter _c_MEMB(_find_sv)(const Self* self, csview key) {
+    _m_iter it = {NULL};
+    if ((it._leaf = _c_MEMB(_find_node_)(self, key)) != NULL) it.ref = &it._leaf->value;
+    return it;
+}
+STC_INLINE _m_iter _c_MEMB(_find)(const Self* self, _m_keyraw rkey)
+    { return _c_MEMB(_find_sv)(self, c_sv(rkey, c_strlen(rkey))); }
+
+STC_INLINE bool _c_MEMB(_contains_sv)(const Self* self, csview key)
+    { return _c_MEMB(_find_node_)(self, key) != NULL; }
+STC_INLINE bool _c_MEMB(_contains)(const Self* self, _m_keyraw rkey)
+    { return _c_MEMB(_contains_sv)(self, c_sv(rkey, c_strlen(rkey))); }
+
+STC_INLINE const _m_value* _c_MEMB(_get_sv)(const Self* self, csview key)
+    { return _c_MEMB(_find_sv)(self, key).ref; }
+STC_INLINE const _m_value* _c_MEMB(_get)(const Self* self, _m_keyraw rkey)
+    { return _c_MEMB(_find)(self, rkey).ref; }
+STC_INLINE _m_value* _c_MEMB(_get_mut)(Self* self, _m_keyraw rkey)
+    { return _c_MEMB(_find)(self, rkey).ref; }
+
+// Iterates from the first entry with key >= key.
+STC_INLINE _m_iter _c_MEMB(_lower_bound_sv)(const Self* self, csview key) {
+    _m_iter it = {NULL};
+    if ((it._leaf = _c_MEMB(_bound_)(self, key, 0)) != NULL) it.ref = &it._leaf->value;
+    return it;
+}
+STC_INLINE _m_iter _c_MEMB(_lower_bound)(const Self* self, _m_keyraw rkey)
+    { return _c_MEMB(_lower_bound_sv)(self, c_sv(rkey, c_strlen(rkey))); }
+
+// Iterates the entries with keys that start with prefix, in key order.
+STC_INLINE _m_iter _c_MEMB(_prefix_begin_sv)(const Self* self, csview prefix) {
+    _m_iter it = {NULL};
+    it._leaf = _c_MEMB(_bound_)(self, prefix, 0);
+    it._end = _c_MEMB(_bound_)(self, prefix, 2);
+    if (it._leaf != it._end) it.ref = &it._leaf->value;
+    return it;
+}
+STC_INLINE _m_iter _c_MEMB(_prefix_begin)(const Self* self, _m_keyraw rprefix)
+    { return _c_MEMB(_prefix_begin_sv)(self, c_sv(rprefix, c_strlen(rprefix))); }
+
+// The entry with the longest key which is a prefix of key, or NULL.
+STC_INLINE const _m_value* _c_MEMB(_longest_prefix_match)(const Self* self, _m_keyraw rkey)
+    { return _c_MEMB(_longest_prefix_match_sv)(self, c_sv(rkey, c_strlen(rkey))); }
+
+STC_INLINE bool _c_MEMB(_erase)(Self* self, _m_keyraw rkey)
+    { return _c_MEMB(_erase_sv)(self, c_sv(rkey, c_strlen(rkey))); }
+
+STC_INLINE _m_iter _c_MEMB(_erase_at)(Self* self, _m_iter it) {
+    _m_iter next = it;
+    _c_MEMB(_next)(&next);
+    _c_MEMB(_erase_sv)(self, _c_MEMB(_keysv_)(it._leaf));
+    return next;
+}
+
+STC_INLINE _m_value* _c_MEMB(_front)(const Self* self) { return &self->head->value; }
+STC_INLINE _m_value* _c_MEMB(_back)(const Self* self) { return &self->tail->value; }
+
+STC_INLINE _m_raw _c_MEMB(_value_toraw)(const _m_value* val) {
+    return _i_SET_ONLY( i_keytoraw(val) )
+           _i_MAP_ONLY( c_literal(_m_raw){i_keytoraw((&val->first)),
+                                          i_valtoraw((&val->second))} );
+}
+
+STC_INLINE void _c_MEMB(_value_drop)(_m_value* val) {
+    i_keydrop(_i_keyref(val));
+    _i_MAP_ONLY( i_valdrop((&val->second)); )
+}
+
+STC_INLINE Self _c_MEMB(_move)(Self *self) {
+    Self m = *self;
+    memset(self, 0, sizeof *self);
+    return m;
+}
+
+STC_INLINE void _c_MEMB(_take)(Self *self, Self unowned) {
+    _c_MEMB(_drop)(self);
+    *self = unowned;
+}
+
+#if !defined i_no_clone
+STC_INLINE _m_value _c_MEMB(_value_clone)(_m_value _val) {
+    *_i_keyref(&_val) = i_keyclone((*_i_keyref(&_val)));
+    _i_MAP_ONLY( _val.second = i_valclone(_val.second); )
+    return _val;
+}
+
+STC_INLINE void _c_MEMB(_copy)(Self *self, const Self other) {
+    if (self->root == other.root)
+        return;
+    _c_MEMB(_drop)(self);
+    *self = _c_MEMB(_clone)(other);
+}
+#endif // !i_no_clone
+
+STC_INLINE _m_result
+_c_MEMB(_insert)(Self* self, _m_key _key _i_MAP_ONLY(, _m_mapped _mapped)) {
+    _m_result _res = _c_MEMB(_insert_entry_)(self, cstr_sv(&_key));
+    if (_res.inserted)
+        { *_i_keyref(_res.ref) = _key; _i_MAP_ONLY( _res.ref->second = _mapped; )}
+    else
+        { i_keydrop((&_key)); _i_MAP_ONLY( i_valdrop((&_mapped)); )}
+    return _res;
+}
+
+STC_INLINE _m_value* _c_MEMB(_push)(Self* self, _m_value _val) {
+    _m_result _res = _c_MEMB(_insert_entry_)(self, cstr_sv(_i_keyref(&_val)));
+    if (_res.inserted)
+        *_res.ref = _val;
+    else
+        _c_MEMB(_value_drop)(&_val);
+    return _res.ref;
+}
+
+STC_INLINE _m_result
+_c_MEMB(_emplace_sv)(Self* self, csview key _i_MAP_ONLY(, _m_rmapped rmapped)) {
+    _m_result _res = _c_MEMB(_insert_entry_)(self, key);
+    if (_res.inserted) {
+        *_i_keyref(_res.ref) = cstr_from_sv(key);
+        _i_MAP_ONLY( _res.ref->second = i_valfrom(rmapped); )
+    }
+    return _res;
+}
+
+STC_INLINE _m_result
+_c_MEMB(_emplace)(Self* self, _m_keyraw rkey _i_MAP_ONLY(, _m_rmapped rmapped))
+    { return _c_MEMB(_emplace_sv)(self, c_sv(rkey, c_strlen(rkey)) _i_MAP_ONLY(, rmapped)); }
+
+#ifdef _i_is_map
+    STC_INLINE const _m_mapped* _c_MEMB(_at)(const Self* self, _m_keyraw rkey)
+        { return &_c_MEMB(_find)(self, rkey).ref->second; }
+
+    STC_INLINE _m_mapped* _c_MEMB(_at_mut)(Self* self, _m_keyraw rkey)
+        { return &_c_MEMB(_find)(self, rkey).ref->second; }
+
+    STC_INLINE _m_result _c_MEMB(_insert_or_assign)(Self* self, _m_key _key, _m_mapped _mapped) {
+        _m_result _res = _c_MEMB(_insert_entry_)(self, cstr_sv(&_key));
+        if (_res.ref == NULL)
+            { i_keydrop((&_key)); i_valdrop((&_mapped)); return _res; }
+        if (_res.inserted)
+            _res.ref->first = _key;
+        else
+            { i_keydrop((&_key)); i_valdrop((&_res.ref->second)); }
+        _res.ref->second = _mapped;
+        return _res;
+    }
+
+    STC_INLINE _m_result _c_MEMB(_emplace_or_assign)(Self* self, _m_keyraw rkey, _m_rmapped rmapped) {
+        const csview key = c_sv(rkey, c_strlen(rkey));
+        _m_result _res = _c_MEMB(_insert_entry_)(self, key);
+        if (_res.ref == NULL)
+            return _res;
+        if (_res.inserted)
+            _res.ref->first = cstr_from_sv(key);
+        else
+            i_valdrop((&_res.ref->second));
+        _res.ref->second = i_valfrom(rmapped);
+        return _res;
+    }
+
+    STC_INLINE _m_result _c_MEMB(_put)(Self* self, _m_keyraw rkey, _m_rmapped rmapped)
+        { return _c_MEMB(_emplace_or_assign)(self, rkey, rmapped); }
+#endif // _i_is_map
+
+STC_INLINE void _c_MEMB(_put_n)(Self* self, const _m_raw* raw, isize n) {
+    while (n--)
+        #if defined _i_is_set
+            _c_MEMB(_emplace)(self, *raw++);
+        #else
+            _c_MEMB(_put)(self, raw->first, raw->second), ++raw;
+        #endif
+}
+
+STC_INLINE Self _c_MEMB(_with_n)(const _m_raw* raw, isize n)
+    { Self cx = {0}; _c_MEMB(_put_n)(&cx, raw, n); return cx; }
+
+/* -------------------------- IMPLEMENTATION ------------------------- */
+#if defined i_implement
+
+static void _c_MEMB(_free_nodes_)(void* p) {
+    if (p == NULL || _tmap_is_leaf(p))
+        return;
+    struct tmap_node* n = (struct tmap_node*)p;
+    int b = -1;
+    for (void* c; (c = _tmap_next_child(n, b, &b)) != NULL; )
+        _c_MEMB(_free_nodes_)(c);
+    i_free(n, _tmap_size(n->type));
+}
+
+STC_DEF void _c_MEMB(_clear)(Self* self) {
+    _c_MEMB(_free_nodes_)(self->root);
+    for (_m_node* l = self->head, *next; l != NULL; l = next) {
+        next = l->next;
+        _c_MEMB(_value_drop)(&l->value);
+        i_free(l, c_sizeof *l);
+    }
+    memset(self, 0, sizeof *self);
+}
+
+#if !defined i_no_clone
+STC_DEF Self _c_MEMB(_clone)(Self map) {
+    Self out = {0};
+    for (_m_node* l = map.head; l != NULL; l = l->next) {
+        _m_result res = _c_MEMB(_insert_entry_)(&out, _c_MEMB(_keysv_)(l));
+        if (res.inserted) *res.ref = _c_MEMB(_value_clone)(l->value);
+    }
+    return out;
+}
+#endif
+
+// Compares the prefix of n with key from depth d. Sets *m to the number of equal bytes, and returns
+// <0, 0 or >0 when the prefix is less than, equal to or greater than the rest of key. A prefix which
+// is longer than the rest of key, and starts with it, compares greater.
+static int _c_MEMB(_prefix_cmp_)(const struct tmap_node* n, csview key, isize d, isize* m) {
+    const isize len = n->prefix_len, rest = key.size - d;
+    const uint8_t* p = n->prefix, *s = (const uint8_t*)key.buf + d;
+    if (len > _tmap_prefix_max)
+        p = (const uint8_t*)_c_MEMB(_keysv_)((_m_node*)_tmap_min_leaf((void*)n)).buf + d;
+    for (isize i = 0; i < len; ++i) {
+        if (i == rest) { *m = i; return 1; }
+        if (p[i] != s[i]) { *m = i; return p[i] < s[i] ? -1 : 1; }
+    }
+    *m = len;
+    return 0;
+}
+
+// Only the stored part of long prefixes is compared: the caller must compare the key of the leaf found.
+STC_INLINE bool _c_MEMB(_skip_prefix_)(const struct tmap_node* n, csview key, isize* d) {
+    if (n->prefix_len == 0)
+        return true;
+    if (*d + n->prefix_len > key.size ||
+        memcmp(n->prefix, key.buf + *d, n->prefix_len < _tmap_prefix_max ? n->prefix_len : _tmap_prefix_max))
+        return false;
+    *d += n->prefix_len;
+    return true;
+}
+
+STC_INLINE bool _c_MEMB(_key_eq_)(const _m_node* leaf, csview key) {
+    const csview lk = _c_MEMB(_keysv_)(leaf);
+    return lk.size == key.size && !memcmp(lk.buf, key.buf, (size_t)key.size);
+}
+
+STC_DEF _m_node* _c_MEMB(_find_node_)(const Self* self, csview key) {
+    void* p = self->root;
+    isize d = 0;
+    while (p != NULL && !_tmap_is_leaf(p)) {
+        struct tmap_node* n = (struct tmap_node*)p;
+        if (!_c_MEMB(_skip_prefix_)(n, key, &d))
+            return NULL;
+        if (d == key.size) {
+            p = n->end ? _tmap_tagged(n->end) : NULL;
+            break;
+        }
+        void** c = _tmap_find_child(n, (uint8_t)key.buf[d++]);
+        p = c ? *c : NULL;
+    }
+    if (p == NULL || !_c_MEMB(_key_eq_)((_m_node*)_tmap_leaf(p), key))
+        return NULL;
+    return (_m_node*)_tmap_leaf(p);
+}
+
+// mode 0: the first leaf with key >= key, 1: the first leaf > key, 2: the first leaf after
+// all keys which start with key. NULL if there is none.
+STC_DEF _m_node* _c_MEMB(_bound_)(const Self* self, csview key, int mode) {
+    void* p = self->root;
+    isize d = 0, m;
+    while (p != NULL) {
+        if (_tmap_is_leaf(p)) {
+            _m_node* l = (_m_node*)_tmap_leaf(p);
+            const csview lk = _c_MEMB(_keysv_)(l);
+            int c = memcmp(lk.buf, key.buf, (size_t)(lk.size < key.size ? lk.size : key.size));
+            if (c == 0) {
+                if (mode == 2 && lk.size >= key.size) return l->next;
+                c = (lk.size > key.size) - (lk.size < key.size);
+            }
+            return c > 0 || (c == 0 && mode == 0) ? l : l->next;
+        }
+        struct tmap_node* n = (struct tmap_node*)p;
+        const int c = _c_MEMB(_prefix_cmp_)(n, key, d, &m);
+        if (c < 0 || (c > 0 && mode == 2 && d + m == key.size)) // subtree before key, or all start with key
+            return ((_m_node*)_tmap_max_leaf(p))->next;
+        if (c > 0)
+            return (_m_node*)_tmap_min_leaf(p);
+        d += n->prefix_len;
+        if (d == key.size) {
+            if (mode == 2) return ((_m_node*)_tmap_max_leaf(p))->next;
+            if (mode == 1 && n->end) return ((_m_node*)n->end)->next;
+            return (_m_node*)_tmap_min_leaf(p);
+        }
+        const uint8_t b = (uint8_t)key.buf[d];
+        void** child = _tmap_find_child(n, b);
+        if (child != NULL) {
+            p = *child;
+            ++d;
+            continue;
+        }
+        int at;
+        void* q = _tmap_next_child(n, b, &at);
+        return q ? (_m_node*)_tmap_min_leaf(q) : ((_m_node*)_tmap_max_leaf(p))->next;
+    }
+    return NULL;
+}
+
+STC_DEF const _m_value* _c_MEMB(_longest_prefix_match_sv)(const Self* self, csview key) {
+    void* p = self->root;
+    _m_node* best = NULL;
+    isize d = 0, m;
+    while (p != NULL) {
+        if (_tmap_is_leaf(p)) {
+            _m_node* l = (_m_node*)_tmap_leaf(p);
+            const csview lk = _c_MEMB(_keysv_)(l);
+            if (lk.size <= key.size && !memcmp(lk.buf, key.buf, (size_t)lk.size))
+                best = l;
+            break;
+        }
+        struct tmap_node* n = (struct tmap_node*)p;
+        if (_c_MEMB(_prefix_cmp_)(n, key, d, &m) != 0)
+            break;
+        d += n->prefix_len;
+        if (n->end) // all bytes so far are matched, so the key of end is key[0, d)
+            best = (_m_node*)n->end;
+        if (d == key.size)
+            break;
+        void** c = _tmap_find_child(n, (uint8_t)key.buf[d++]);
+        p = c ? *c : NULL;
+    }
+    return best ? &best->value : NULL;
+}
+
+// Puts leaf in n: as the end leaf if its key ends at d, else as the child for byte key[d].
+STC_INLINE void _c_MEMB(_put_leaf_)(struct tmap_node* n, csview key, isize d, _m_node* leaf) {
+    if (d == key.size) n->end = leaf;
+    else _tmap_add_child(n, (uint8_t)key.buf[d], _tmap_tagged(leaf));
+}
+
+STC_DEF _m_result _c_MEMB(_insert_entry_)(Self* self, csview key) {
+    enum { at_empty, at_leaf, at_prefix, at_end, at_child } where;
+    _m_result res = {NULL};
+    void** ref = &self->root;
+    isize d = 0, m = 0;
+    for (;;) { // find where the key goes, without changing the tree
+        void* p = *ref;
+        if (p == NULL) {
+            where = at_empty;
+            break;
+        }
+        if (_tmap_is_leaf(p)) {
+            _m_node* l = (_m_node*)_tmap_leaf(p);
+            const csview lk = _c_MEMB(_keysv_)(l);
+            for (m = d; m < lk.size && m < key.size && lk.buf[m] == key.buf[m]; ++m) ;
+            if (m == lk.size && m == key.size)
+                { res.ref = &l->value; return res; }
+            where = at_leaf;
+            break;
+        }
+        struct tmap_node* n = (struct tmap_node*)p;
+        _c_MEMB(_prefix_cmp_)(n, key, d, &m);
+        if (m < n->prefix_len) {
+            where = at_prefix;
+            break;
+        }
+        d += n->prefix_len;
+        if (d == key.size) {
+            if (n->end)
+                { res.ref = &((_m_node*)n->end)->value; return res; }
+            where = at_end;
+            break;
+        }
+        void** c = _tmap_find_child(n, (uint8_t)key.buf[d]);
+        if (c == NULL) {
+            where = at_child;
+            break;
+        }
+        ref = c;
+        ++d;
+    }
+
+    _m_node* leaf = _i_malloc(_m_node, 1);
+    struct tmap_node* nn = NULL;
+    if (leaf == NULL)
+        return res;
+    if (where == at_leaf || where == at_prefix ||
+        (where == at_child && _tmap_is_full((struct tmap_node*)*ref))) {
+        const int type = where == at_child ? ((struct tmap_node*)*ref)->type + 1 : _tmap_n4;
+        nn = (struct tmap_node*)i_calloc(1, _tmap_size(type));
+        if (nn == NULL)
+            { i_free(leaf, c_sizeof *leaf); return res; }
+        nn->type = (uint8_t)type;
+    }
+    _m_node* next = _c_MEMB(_bound_)(self, key, 0); // the key is not in the tree
+
+    switch (where) {
+    case at_empty:
+        *ref = _tmap_tagged(leaf);
+        break;
+    case at_leaf: { // the keys of the leaf and the new leaf differ at m
+        _m_node* l = (_m_node*)_tmap_leaf(*ref);
+        _tmap_set_prefix(nn, key.buf + d, m - d);
+        _c_MEMB(_put_leaf_)(nn, _c_MEMB(_keysv_)(l), m, l);
+        _c_MEMB(_put_leaf_)(nn, key, m, leaf);
+        *ref = nn;
+        break;
+    }
+    case at_prefix: { // split the prefix of n at m: nn gets the first m bytes
+        struct tmap_node* n = (struct tmap_node*)*ref;
+        const uint8_t* full = n->prefix;
+        if (n->prefix_len > _tmap_prefix_max)
+            full = (const uint8_t*)_c_MEMB(_keysv_)((_m_node*)_tmap_min_leaf(n)).buf + d;
+        const uint8_t b = full[m];
+        const isize rest = n->prefix_len - m - 1;
+        _tmap_set_prefix(nn, key.buf + d, m);
+        memmove(n->prefix, full + m + 1, (size_t)(rest < _tmap_prefix_max ? rest : _tmap_prefix_max));
+        n->prefix_len = (uint32_t)rest;
+        _tmap_add_child(nn, b, n);
+        _c_MEMB(_put_leaf_)(nn, key, d + m, leaf);
+        *ref = nn;
+        break;
+    }
+    case at_end:
+        ((struct tmap_node*)*ref)->end = leaf;
+        break;
+    case at_child:
+        if (nn != NULL) { // grow the full node
+            struct tmap_node* n = (struct tmap_node*)*ref;
+            _tmap_copy_node(nn, n);
+            i_free(n, _tmap_size(n->type));
+            *ref = nn;
+        }
+        _tmap_add_child((struct tmap_node*)*ref, (uint8_t)key.buf[d], _tmap_tagged(leaf));
+        break;
+    }
+
+    leaf->next = next;
+    leaf->prev = next ? next->prev : self->tail;
+    if (leaf->prev) leaf->prev->next = leaf; else self->head = leaf;
+    if (next) next->prev = leaf; else self->tail = leaf;
+    ++self->size;
+    res.ref = &leaf->value;
+    res.inserted = true;
+    return res;
+}
+
+// After a leaf or child was removed from the node *ref, which starts at depth d:
+// replace it by its only leaf or child, or by a smaller node type when it is sparse.
+static void _c_MEMB(_shrink_)(void** ref, isize d) {
+    struct tmap_node* n = (struct tmap_node*)*ref;
+    if (n->count == 0 || (n->count == 1 && n->end == NULL)) {
+        int b;
+        void* c = n->count ? _tmap_next_child(n, -1, &b) : _tmap_tagged(n->end);
+        if (!_tmap_is_leaf(c)) { // prepend the prefix of n and b to the prefix of c
+            struct tmap_node* cn = (struct tmap_node*)c;
+            const isize len = n->prefix_len + 1 + cn->prefix_len;
+            const csview lk = _c_MEMB(_keysv_)((_m_node*)_tmap_min_leaf(c));
+            _tmap_set_prefix(cn, lk.buf + d, len);
+        }
+        *ref = c;
+        i_free(n, _tmap_size(n->type));
+        return;
+    }
+    if ((n->type == _tmap_n256 && n->count <= 37) || (n->type == _tmap_n48 && n->count <= 12) ||
+        (n->type == _tmap_n16 && n->count <= 3)) {
+        struct tmap_node* m = (struct tmap_node*)i_calloc(1, _tmap_size(n->type - 1));
+        if (m == NULL)
+            return;
+        m->type = (uint8_t)(n->type - 1);
+        _tmap_copy_node(m, n);
+        *ref = m;
+        i_free(n, _tmap_size(n->type));
+    }
+}
+
+// Unlinks the leaf with key under *ref, at depth d, from the tree. Returns it, or NULL if not found.
+static _m_node* _c_MEMB(_unlink_)(void** ref, csview key, isize d) {
+    void* p = *ref;
+    if (p == NULL)
+        return NULL;
+    if (_tmap_is_leaf(p)) {
+        _m_node* l = (_m_node*)_tmap_leaf(p);
+        if (!_c_MEMB(_key_eq_)(l, key))
+            return NULL;
+        *ref = NULL;
+        return l;
+    }
+    struct tmap_node* n = (struct tmap_node*)p;
+    const isize d0 = d;
+    if (!_c_MEMB(_skip_prefix_)(n, key, &d))
+        return NULL;
+    _m_node* l;
+    if (d == key.size) {
+        if ((l = (_m_node*)n->end) == NULL || !_c_MEMB(_key_eq_)(l, key))
+            return NULL;
+        n->end = NULL;
+    } else {
+        void** c = _tmap_find_child(n, (uint8_t)key.buf[d]);
+        if (c == NULL || (l = _c_MEMB(_unlink_)(c, key, d + 1)) == NULL)
+            return NULL;
+        if (*c != NULL)
+            return l;
+        _tmap_remove_child(n, (uint8_t)key.buf[d]);
+    }
+    _c_MEMB(_shrink_)(ref, d0);
+    return l;
+}
+
+STC_DEF bool _c_MEMB(_erase_sv)(Self* self, csview key) {
+    _m_node* l = _c_MEMB(_unlink_)(&self->root, key, 0);
+    if (l == NULL)
+        return false;
+    if (l->prev) l->prev->next = l->next; else self->head = l->next;
+    if (l->next) l->next->prev = l->prev; else self->tail = l->prev;
+    --self->size;
+    _c_MEMB(_value_drop)(&l->value);
+    i_free(l, c_sizeof *l);
+    return true;
+}
+#endif // i_implement
+#undef _i_is_set
+#undef _i_is_map
+#undef _i_keyref
+#undef _i_MAP_ONLY
+#undef _i_SET_ONLY
+#include "priv/linkage2.h"
+#include "priv/template2.h"
@@ -26,6 +26,47 @@
 #else
   #define _i_aux_struct
 #endif
+#ifdef i_store_hash
+  #define _i_hashes_struct uint32_t* hashes;
+  #define _i_hashes_fixed(N) uint32_t hashes[N];
+#else
+  #define _i_hashes_struct
+  #define _i_hashes_fixed(N)
+#endif
+#ifdef i_slab
+  #define _i_slot(SELF) SELF##_value*
+  #define _i_slab_struct struct hmap_slab _slab;
+  #define _i_slab_iter(SELF) SELF##_value** _sref;
+#else
+  #define _i_slot(SELF) SELF##_value
+  #define _i_slab_struct
+  #define _i_slab_iter(SELF)
+#endif
+#ifdef i_capacity // hmap: inline tables
+  #define _i_table_struct(SELF) \
+    _i_slot(SELF) table[_hmap_fixed_buckets(i_capacity)]; \
+    struct hmap_meta meta[_hmap_fixed_buckets(i_capacity) + 1]; \
+    _i_hashes_fixed(_hmap_fixed_buckets(i_capacity))
+#else
+  #define _i_table_struct(SELF) \
+    _i_slot(SELF)* table; \
+    struct hmap_meta* meta; \
+    _i_hashes_struct
+#endif
+#ifdef i_stats
+  #define _i_stats_struct struct hmap_counters _stats;
+#else
+  #define _i_stats_struct
+#endif
+#ifdef i_incremental
+  #define _i_rehash_struct(SELF) \
+    struct { SELF##_value* table; struct hmap_meta* meta; _i_hashes_struct \
+             ptrdiff_t size, bucket_count, pos; } _old;
+  #define _i_rehash_iter(SELF) const struct SELF* _map;
+#else
+  #define _i_rehash_struct(SELF)
+  #define _i_rehash_iter(SELF)
+#endif
 
 #ifndef STC_TYPES_H_INCLUDED
 #define STC_TYPES_H_INCLUDED
@@ -33,18 +74,38 @@
 #include <stdint.h>
 #include <stddef.h>
 
+struct hmap_counters { uint64_t lookups, probes, compares, rehashes; }; // see hmap i_stats
+struct hmap_slab { void *chunks, *free, *next, *end; }; // see hmap i_slab
+
+// Buckets of a hmap with i_capacity: the power of two above 1.25 * cap (load factor <= 0.8).
+#define _hmap_fixed_buckets(cap) (_hmap_smear16((cap) + (cap)/4) + 1)
+#define _hmap_smear16(x) (_hmap_smear8(x) | _hmap_smear8(x) >> 16)
+#define _hmap_smear8(x) (_hmap_smear4(x) | _hmap_smear4(x) >> 8)
+#define _hmap_smear4(x) (_hmap_smear2(x) | _hmap_smear2(x) >> 4)
+#define _hmap_smear2(x) (_hmap_smear1(x) | _hmap_smear1(x) >> 2)
+#define _hmap_smear1(x) ((x) | (x) >> 1)
+
 #define declare_arc(C, VAL) _c_arc_types(C, VAL)
 #define declare_box(C, VAL) _c_box_types(C, VAL)
 #define declare_deq(C, VAL) _c_deque_types(C, VAL)
 #define declare_list(C, VAL) _c_list_types(C, VAL)
 #define declare_hmap(C, KEY, VAL) _c_htable_types(C, KEY, VAL, c_true, c_false)
 #define declare_hset(C, KEY) _c_htable_types(C, cset, KEY, KEY, c_false, c_true)
+#define declare_phmap(C, KEY, VAL) _c_phtable_types(C, KEY, VAL, c_true, c_false)
+#define declare_phset(C, KEY) _c_phtable_types(C, KEY, KEY, c_false, c_true)
 #define declare_smap(C, KEY, VAL) _c_aatree_types(C, KEY, VAL, c_true, c_false)
 #define declare_sset(C, KEY) _c_aatree_types(C, KEY, KEY, c_false, c_true)
+#define declare_bmap(C, KEY, VAL) _c_btree_types(C, KEY, VAL, c_true, c_false)
+#define declare_bset(C, KEY) _c_btree_types(C, KEY, KEY, c_false, c_true)
+#define declare_fmap(C, KEY, VAL) _c_flatmap_types(C, KEY, VAL, c_true, c_false)
+#define declare_fset(C, KEY) _c_flatmap_types(C, KEY, KEY, c_false, c_true)
+#define declare_psmap(C, KEY, VAL) _c_pstree_types(C, KEY, VAL, c_true, c_false)
+#define declare_psset(C, KEY) _c_pstree_types(C, KEY, KEY, c_false, c_true)
 #define declare_stack(C, VAL) _c_stack_types(C, VAL)
 #define declare_pqueue(C, VAL) _c_pqueue_types(C, VAL)
 #define declare_queue(C, VAL) _c_deque_types(C, VAL)
 #define declare_vec(C, VAL) _c_vec_types(C, VAL)
+#define declare_svec(C, VAL, N) _c_svec_types(C, VAL, N)
 
 // csview : non-null terminated string view
 typedef const char csview_value;
@@ -156,18 +217,123 @@ typedef union {
     } SELF##_result; \
 \
     typedef struct { \
-        SELF##_value *ref, *_end; \
+        SELF##_value *ref; \
+        _i_slot(SELF) *_end; \
         struct hmap_meta *_mref; \
+        _i_slab_iter(SELF) \
+        _i_rehash_iter(SELF) \
     } SELF##_iter; \
 \
     typedef struct SELF { \
-        SELF##_value* table; \
-        struct hmap_meta* meta; \
+        _i_table_struct(SELF) \
         ptrdiff_t size, bucket_count; \
+        _i_rehash_struct(SELF) \
+        _i_stats_struct \
+        _i_slab_struct \
+        _i_aux_struct \
+    } SELF
+
+#define _c_phtable_types(SELF, KEY, VAL, MAP_ONLY, SET_ONLY) \
+    typedef KEY SELF##_key; \
+    typedef VAL SELF##_mapped; \
+\
+    typedef SET_ONLY( SELF##_key ) \
+            MAP_ONLY( struct SELF##_value ) \
+    SELF##_value, SELF##_entry; \
+\
+    typedef struct { SELF##_value *ref, *end; } SELF##_iter; \
+\
+    typedef struct SELF { \
+        SELF##_value* table; \
+        uint16_t* pilots; \
+        uint32_t* remap; \
+        uint64_t seed; \
+        ptrdiff_t size, slot_count, bucket_count; \
         _i_aux_struct \
     } SELF
 
 #define _c_aatree_types(SELF, KEY, VAL, MAP_ONLY, SET_ONLY) \
+    _c_aatree_types_ex(SELF, KEY, VAL, MAP_ONLY, SET_ONLY, int32_t, SELF##_node*)
+
+#define _c_aatree_types_ex(SELF, KEY, VAL, MAP_ONLY, SET_ONLY, INDEX, NODES) \
+    typedef KEY SELF##_key; \
+    typedef VAL SELF##_mapped; \
+    typedef struct SELF##_node SELF##_node; \
+\
+    typedef SET_ONLY( SELF##_key ) \
+            MAP_ONLY( struct SELF##_value ) \
+    SELF##_value, SELF##_entry; \
+\
+    typedef struct { \
+        SELF##_value *ref; \
+        bool inserted; \
+    } SELF##_result; \
+\
+    typedef struct { \
+        SELF##_value *ref; \
+        NODES _d; \
+        int _top; \
+        INDEX _tn, _st[sizeof(INDEX)*9]; \
+    } SELF##_iter; \
+\
+    typedef struct SELF { \
+        NODES nodes; \
+        INDEX root, disp, head, size, capacity; \
+        _i_aux_struct \
+    } SELF
+
+#define _c_btree_types(SELF, KEY, VAL, MAP_ONLY, SET_ONLY) \
+    typedef KEY SELF##_key; \
+    typedef VAL SELF##_mapped; \
+    typedef struct SELF##_leaf SELF##_leaf; \
+\
+    typedef SET_ONLY( SELF##_key ) \
+            MAP_ONLY( struct SELF##_value ) \
+    SELF##_value, SELF##_entry; \
+\
+    typedef struct { \
+        SELF##_value *ref; \
+        bool inserted; \
+    } SELF##_result; \
+\
+    typedef struct { \
+        SELF##_value *ref; \
+        SELF##_leaf *_leaf; \
+        int _i; \
+    } SELF##_iter; \
+\
+    typedef struct SELF { \
+        void *root; \
+        SELF##_leaf *first; \
+        ptrdiff_t size; \
+        int height; \
+        _i_aux_struct \
+    } SELF
+
+#define _c_flatmap_types(SELF, KEY, VAL, MAP_ONLY, SET_ONLY) \
+    typedef KEY SELF##_key; \
+    typedef VAL SELF##_mapped; \
+\
+    typedef SET_ONLY( SELF##_key ) \
+            MAP_ONLY( struct SELF##_value ) \
+    SELF##_value, SELF##_entry; \
+\
+    typedef struct { \
+        SELF##_value *ref; \
+        bool inserted; \
+    } SELF##_result; \
+\
+    typedef struct { \
+        SELF##_value *ref, *end; \
+    } SELF##_iter; \
+\
+    typedef struct SELF { \
+        SELF##_value *data; \
+        ptrdiff_t size, capacity; \
+        _i_aux_struct \
+    } SELF
+
+#define _c_pstree_types(SELF, KEY, VAL, MAP_ONLY, SET_ONLY) \
     typedef KEY SELF##_key; \
     typedef VAL SELF##_mapped; \
     typedef struct SELF##_node SELF##_node; \
@@ -183,14 +349,13 @@ typedef union {
 \
     typedef struct { \
         SELF##_value *ref; \
-        SELF##_node *_d; \
+        SELF##_node *_tn, *_st[64]; \
         int _top; \
-        int32_t _tn, _st[36]; \
     } SELF##_iter; \
 \
     typedef struct SELF { \
-        SELF##_node *nodes; \
-        int32_t root, disp, head, size, capacity; \
+        SELF##_node *root; \
+        ptrdiff_t size; \
         _i_aux_struct \
     } SELF
 
@@ -204,4 +369,14 @@ typedef union {
     typedef struct { SELF##_value *ref, *end; } SELF##_iter; \
     typedef struct SELF { SELF##_value *data; ptrdiff_t size, capacity; _i_aux_struct } SELF
 
+// capacity is 0 while the elements are stored in data.buf, else the capacity of data.ptr
+#define _c_svec_types(SELF, VAL, N) \
+    typedef VAL SELF##_value; \
+    typedef struct { SELF##_value *ref, *end; } SELF##_iter; \
+    typedef struct SELF { \
+        ptrdiff_t size, capacity; \
+        union { SELF##_value *ptr; SELF##_value buf[N]; } data; \
+        _i_aux_struct \
+    } SELF
+
 #endif // STC_TYPES_H_INCLUDED
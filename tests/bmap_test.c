@@ -0,0 +1,138 @@
+#include "ctest.h"
+#include "stc/cstr.h"
+#include "stc/random.h"
+
+#define i_type bmap_ii, int, int
+#define i_use_eq
+#include "stc/bmap.h"
+
+#define i_type smap_ii, int, int
+#include "stc/smap.h"
+
+#define i_type bset_str
+#define i_keypro cstr
+#include "stc/bset.h"
+
+#define i_type sset_str
+#define i_keypro cstr
+#include "stc/sset.h"
+
+static bool same_ii(const bmap_ii* b, const smap_ii* s) {
+    if (bmap_ii_size(b) != smap_ii_size(s)) return false;
+    bmap_ii_iter i = bmap_ii_begin(b);
+    for (c_each(j, smap_ii, *s)) {
+        if (i.ref->first != j.ref->first || i.ref->second != j.ref->second) return false;
+        bmap_ii_next(&i);
+    }
+    return i.ref == NULL;
+}
+
+static bool same_str(const bset_str* b, const sset_str* s) {
+    if (bset_str_size(b) != sset_str_size(s)) return false;
+    bset_str_iter i = bset_str_begin(b);
+    for (c_each(j, sset_str, *s)) {
+        if (!cstr_eq(i.ref, j.ref)) return false;
+        bset_str_next(&i);
+    }
+    return i.ref == NULL;
+}
+
+TEST(bmap, basics)
+{
+    bmap_ii m = c_make(bmap_ii, {{5, 50}, {3, 30}, {8, 80}, {1, 10}});
+    bmap_ii res = c_make(bmap_ii, {{1, 10}, {3, 30}, {5, 50}, {8, 80}});
+    EXPECT_TRUE(bmap_ii_eq(&res, &m));
+    EXPECT_FALSE(bmap_ii_insert(&m, 3, 33).inserted);
+    bmap_ii_insert_or_assign(&m, 3, 33);
+    EXPECT_EQ(33, *bmap_ii_at(&m, 3));
+    EXPECT_EQ(1, bmap_ii_front(&m)->first);
+    EXPECT_EQ(8, bmap_ii_back(&m)->first);
+    EXPECT_EQ(5, bmap_ii_lower_bound(&m, 4).ref->first);
+    EXPECT_TRUE(bmap_ii_lower_bound(&m, 9).ref == NULL);
+    EXPECT_EQ(1, bmap_ii_erase(&m, 3));
+    EXPECT_EQ(0, bmap_ii_erase(&m, 3));
+    EXPECT_EQ(8, bmap_ii_advance(bmap_ii_begin(&m), 2).ref->first);
+    c_drop(bmap_ii, &m, &res);
+}
+
+TEST(bmap, random_ops)
+{
+    enum {N = 60000, R = 4000};
+    crand64 rng = crand64_from(2025);
+    bmap_ii b = {0};
+    smap_ii s = {0};
+
+    for (int i = 0; i < N; ++i) {
+        const int k = (int)(crand64_uint_r(&rng, 1) % R), op = (int)(crand64_uint_r(&rng, 1) % 8);
+        if (op < 4) {
+            EXPECT_EQ(smap_ii_insert(&s, k, i).inserted, bmap_ii_insert(&b, k, i).inserted);
+        } else if (op < 7) {
+            EXPECT_EQ(smap_ii_erase(&s, k), bmap_ii_erase(&b, k));
+        } else {
+            smap_ii_iter j = smap_ii_lower_bound(&s, k);
+            bmap_ii_iter it = bmap_ii_lower_bound(&b, k);
+            ASSERT_EQ(j.ref == NULL, it.ref == NULL);
+            if (j.ref) {
+                EXPECT_EQ(j.ref->first, it.ref->first);
+                j = smap_ii_erase_at(&s, j);
+                it = bmap_ii_erase_at(&b, it);
+                ASSERT_EQ(j.ref == NULL, it.ref == NULL);
+                if (j.ref) EXPECT_EQ(j.ref->first, it.ref->first);
+            }
+        }
+        if (i % 5000 == 0)
+            ASSERT_TRUE(same_ii(&b, &s));
+    }
+    ASSERT_TRUE(same_ii(&b, &s));
+    for (int k = 0; k < R; ++k)
+        EXPECT_EQ(smap_ii_contains(&s, k), bmap_ii_contains(&b, k));
+
+    bmap_ii c = bmap_ii_clone(b);
+    EXPECT_TRUE(bmap_ii_eq(&b, &c));
+
+    // erase the middle half as a range, then everything from the front
+    smap_ii_erase_range(&s, smap_ii_lower_bound(&s, R/4), smap_ii_lower_bound(&s, 3*R/4));
+    bmap_ii_iter it = bmap_ii_erase_range(&b, bmap_ii_lower_bound(&b, R/4), bmap_ii_lower_bound(&b, 3*R/4));
+    EXPECT_TRUE(it.ref != NULL && it.ref->first >= 3*R/4);
+    EXPECT_TRUE(same_ii(&b, &s));
+    it = bmap_ii_erase_range(&b, bmap_ii_begin(&b), bmap_ii_end(&b));
+    EXPECT_TRUE(it.ref == NULL);
+    EXPECT_TRUE(bmap_ii_is_empty(&b));
+    EXPECT_TRUE(bmap_ii_insert(&b, 1, 1).inserted);
+
+    // the clone is unaffected; drain it in ascending order
+    for (int k = 0; k < R; ++k)
+        bmap_ii_erase(&c, k);
+    EXPECT_TRUE(bmap_ii_is_empty(&c));
+    c_drop(bmap_ii, &b, &c);
+    c_drop(smap_ii, &s);
+}
+
+TEST(bmap, cstr_keys)
+{
+    enum {N = 20000};
+    crand64 rng = crand64_from(7);
+    bset_str b = {0};
+    sset_str s = {0};
+    char buf[32];
+
+    for (int i = 0; i < N; ++i) {
+        snprintf(buf, sizeof buf, "key%u", (unsigned)(crand64_uint_r(&rng, 1) % 3000));
+        if (i & 3) {
+            sset_str_emplace(&s, buf);
+            bset_str_emplace(&b, buf);
+        } else {
+            EXPECT_EQ(sset_str_erase(&s, buf), bset_str_erase(&b, buf));
+        }
+    }
+    EXPECT_TRUE(same_str(&b, &s));
+
+    bset_str c = bset_str_clone(b);
+    bset_str_iter it = bset_str_begin(&c);
+    while (it.ref) // erase every other key
+        if ((it = bset_str_erase_at(&c, it)).ref) bset_str_next(&it);
+    EXPECT_EQ(bset_str_size(&b)/2, bset_str_size(&c));
+    EXPECT_TRUE(same_str(&b, &s));
+    c_drop(bset_str, &b, &c);
+    c_drop(sset_str, &s);
+}
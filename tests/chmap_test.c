@@ -0,0 +1,93 @@
+#include <stdio.h>
+#include "stc/cstr.h"
+#include "ctest.h"
+
+#define i_type chmap_ii, int, int
+#include "stc/chmap.h"
+
+#define i_type chmap_si
+#define i_keypro cstr
+#define i_val int
+#define i_shards 8
+#include "stc/chmap.h"
+
+static void add_to(chmap_si_value* v, void* arg) { v->second += *(int *)arg; }
+static void sum_of(const chmap_ii_value* v, void* arg) { *(long *)arg += v->second; }
+
+TEST(chmap, basic)
+{
+    chmap_ii map = chmap_ii_init();
+    int val = 0;
+    for (int i = 0; i < 1000; ++i)
+        EXPECT_TRUE(chmap_ii_insert(&map, i, i*2));
+    EXPECT_FALSE(chmap_ii_insert(&map, 10, 0));
+    EXPECT_EQ(1000, chmap_ii_size(&map));
+    EXPECT_TRUE(chmap_ii_get(&map, 10, &val));
+    EXPECT_EQ(20, val);
+    EXPECT_FALSE(chmap_ii_get(&map, 1000, &val));
+
+    EXPECT_FALSE(chmap_ii_put(&map, 10, 11));
+    EXPECT_TRUE(chmap_ii_get(&map, 10, &val));
+    EXPECT_EQ(11, val);
+    EXPECT_TRUE(chmap_ii_erase(&map, 10));
+    EXPECT_FALSE(chmap_ii_erase(&map, 10));
+    EXPECT_FALSE(chmap_ii_contains(&map, 10));
+    EXPECT_EQ(999, chmap_ii_size(&map));
+
+    long sum = 0;
+    chmap_ii_visit(&map, sum_of, &sum);
+    EXPECT_EQ(999*1000 - 20, sum);
+    chmap_ii_clear(&map);
+    EXPECT_TRUE(chmap_ii_is_empty(&map));
+    chmap_ii_drop(&map);
+}
+
+TEST(chmap, cstr_update)
+{
+    chmap_si map = {0};
+    int one = 1, n = 0;
+    const char* words[] = {"a", "b", "a", "c", "a", "b"};
+    for (c_range(i, c_arraylen(words)))
+        chmap_si_emplace_update(&map, words[i], 0, add_to, &one);
+    EXPECT_EQ(3, chmap_si_size(&map));
+    EXPECT_TRUE(chmap_si_get(&map, "a", &n));
+    EXPECT_EQ(3, n);
+    EXPECT_TRUE(chmap_si_update(&map, "c", add_to, &one));
+    EXPECT_FALSE(chmap_si_update(&map, "d", add_to, &one));
+    EXPECT_TRUE(chmap_si_get(&map, "c", &n));
+    EXPECT_EQ(2, n);
+    EXPECT_TRUE(chmap_si_insert(&map, cstr_lit("d"), 4));
+    EXPECT_FALSE(chmap_si_insert_or_assign(&map, cstr_lit("d"), 5));
+    EXPECT_TRUE(chmap_si_get(&map, "d", &n));
+    EXPECT_EQ(5, n);
+    chmap_si_drop(&map);
+}
+
+#if defined __unix__ || defined __APPLE__
+#include <pthread.h>
+enum {NTHREADS = 4, NKEYS = 20000};
+static chmap_ii shared;
+
+static void* worker(void* arg) {
+    const int id = (int)(intptr_t)arg;
+    for (int i = 0; i < NKEYS; ++i) {
+        chmap_ii_insert(&shared, id*NKEYS + i, i);
+        chmap_ii_contains(&shared, ((id + 1) % NTHREADS)*NKEYS + i);
+        if (i & 1) chmap_ii_erase(&shared, id*NKEYS + i);
+    }
+    return NULL;
+}
+
+TEST(chmap, threads)
+{
+    pthread_t t[NTHREADS];
+    for (c_range(i, NTHREADS))
+        pthread_create(&t[i], NULL, worker, (void*)(intptr_t)i);
+    for (c_range(i, NTHREADS))
+        pthread_join(t[i], NULL);
+    EXPECT_EQ(NTHREADS*NKEYS/2, chmap_ii_size(&shared));
+    for (c_range(i, NKEYS))
+        EXPECT_EQ(!(i & 1), chmap_ii_contains(&shared, 3*NKEYS + (int)i));
+    chmap_ii_drop(&shared);
+}
+#endif
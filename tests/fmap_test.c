@@ -0,0 +1,142 @@
+#include "ctest.h"
+#include "stc/cstr.h"
+#include "stc/random.h"
+
+#define i_type fmap_ii, int, int
+#define i_use_eq
+#include "stc/fmap.h"
+
+#define i_type smap_ii, int, int
+#include "stc/smap.h"
+
+#define i_type fmap_str
+#define i_keypro cstr
+#define i_valpro cstr
+#include "stc/fmap.h"
+
+#define i_type fset_str
+#define i_keypro cstr
+#include "stc/fset.h"
+
+static bool same_ii(const fmap_ii* f, const smap_ii* s) {
+    if (fmap_ii_size(f) != smap_ii_size(s)) return false;
+    fmap_ii_iter i = fmap_ii_begin(f);
+    for (c_each(j, smap_ii, *s)) {
+        if (i.ref->first != j.ref->first || i.ref->second != j.ref->second) return false;
+        fmap_ii_next(&i);
+    }
+    return i.ref == NULL;
+}
+
+TEST(fmap, basics)
+{
+    fmap_ii m = c_make(fmap_ii, {{5, 50}, {3, 30}, {8, 80}, {1, 10}});
+    EXPECT_EQ(4, fmap_ii_size(&m));
+    EXPECT_FALSE(fmap_ii_insert(&m, 3, 33).inserted);
+    EXPECT_EQ(30, *fmap_ii_at(&m, 3));
+    fmap_ii_insert_or_assign(&m, 3, 33);
+    EXPECT_EQ(33, *fmap_ii_at(&m, 3));
+    EXPECT_TRUE(fmap_ii_insert(&m, 4, 40).inserted);
+    EXPECT_EQ(1, fmap_ii_erase(&m, 8));
+    EXPECT_EQ(0, fmap_ii_erase(&m, 8));
+    EXPECT_EQ(1, fmap_ii_front(&m)->first);
+    EXPECT_EQ(5, fmap_ii_back(&m)->first);
+    EXPECT_EQ(4, fmap_ii_lower_bound(&m, 4).ref->first);
+    EXPECT_EQ(5, fmap_ii_lower_bound(&m, 5).ref->first);
+    EXPECT_TRUE(fmap_ii_lower_bound(&m, 6).ref == NULL);
+    EXPECT_TRUE(fmap_ii_find(&m, 2).ref == NULL);
+    EXPECT_TRUE(fmap_ii_get(&m, 0) == NULL);
+
+    fmap_ii res = c_make(fmap_ii, {{1, 10}, {3, 33}, {4, 40}, {5, 50}});
+    EXPECT_TRUE(fmap_ii_eq(&res, &m));
+    fmap_ii c = fmap_ii_clone(m);
+    fmap_ii_iter it = fmap_ii_erase_at(&c, fmap_ii_find(&c, 3));
+    EXPECT_EQ(4, it.ref->first);
+    it = fmap_ii_erase_range(&c, it, fmap_ii_end(&c));
+    EXPECT_TRUE(it.ref == NULL);
+    EXPECT_EQ(1, fmap_ii_size(&c));
+    EXPECT_FALSE(fmap_ii_eq(&res, &c));
+    c_drop(fmap_ii, &m, &res, &c);
+
+    fmap_str s = {0};
+    fmap_str_emplace(&s, "two", "2");
+    fmap_str_emplace(&s, "one", "1");
+    fmap_str_emplace_or_assign(&s, "two", "II");
+    fmap_str_put(&s, "three", "3");
+    EXPECT_EQ(3, fmap_str_size(&s));
+    EXPECT_STREQ("II", cstr_str(fmap_str_at(&s, "two")));
+    EXPECT_STREQ("one", cstr_str(&fmap_str_front(&s)->first));
+    fmap_str_drop(&s);
+
+    fset_str t = c_make(fset_str, {"one", "two", "three"});
+    fset_str_emplace(&t, "four");
+    fset_str_erase(&t, "one");
+    EXPECT_EQ(3, fset_str_size(&t));
+    EXPECT_FALSE(fset_str_contains(&t, "one"));
+    EXPECT_STREQ("two", cstr_str(fset_str_back(&t)));
+    fset_str_drop(&t);
+}
+
+TEST(fmap, random)
+{
+    enum {N = 40000, R = 3000};
+    crand64 rng = crand64_from(2025);
+    fmap_ii m = {0};
+    smap_ii ref = {0};
+
+    for (int i = 0; i < N; ++i) {
+        const int k = (int)(crand64_uint_r(&rng, 1) % R), op = (int)(crand64_uint_r(&rng, 1) % 8);
+        if (op < 4)
+            EXPECT_EQ(smap_ii_insert(&ref, k, i).inserted, fmap_ii_insert(&m, k, i).inserted);
+        else if (op < 5)
+            fmap_ii_put(&m, k, -i), smap_ii_put(&ref, k, -i);
+        else
+            EXPECT_EQ(smap_ii_erase(&ref, k), fmap_ii_erase(&m, k));
+    }
+    EXPECT_TRUE(same_ii(&m, &ref));
+    for (int k = -1; k <= R; ++k) {
+        const smap_ii_value* v = smap_ii_get(&ref, k);
+        const fmap_ii_value* w = fmap_ii_get(&m, k);
+        EXPECT_TRUE(v ? w && w->second == v->second : w == NULL);
+    }
+    fmap_ii_shrink_to_fit(&m);
+    EXPECT_EQ(fmap_ii_size(&m), fmap_ii_capacity(&m));
+    fmap_ii_drop(&m);
+    smap_ii_drop(&ref);
+}
+
+TEST(fmap, put_n)
+{
+    enum {N = 20000, B = 997};
+    crand64 rng = crand64_from(7);
+    fmap_ii m = {0};
+    smap_ii ref = {0};
+    fmap_ii_raw batch[B];
+
+    for (int i = 0; i < N; i += B) { // unsorted batches with duplicate keys
+        for (int j = 0; j < B; ++j) {
+            batch[j].first = (int)(crand64_uint_r(&rng, 1) % 5000);
+            batch[j].second = i + j;
+        }
+        fmap_ii_put_n(&m, batch, B);
+        smap_ii_put_n(&ref, (const smap_ii_raw*)batch, B);
+        EXPECT_TRUE(same_ii(&m, &ref));
+    }
+    for (int j = 0; j < B; ++j) // a sorted batch
+        batch[j].first = 2*j, batch[j].second = -j;
+    fmap_ii_put_n(&m, batch, B);
+    smap_ii_put_n(&ref, (const smap_ii_raw*)batch, B);
+    EXPECT_TRUE(same_ii(&m, &ref));
+    fmap_ii_drop(&m);
+    smap_ii_drop(&ref);
+
+    fmap_str s = c_make(fmap_str, {{"b", "1"}, {"d", "2"}, {"a", "3"}, {"b", "4"}, {"c", "5"}, {"a", "6"}});
+    EXPECT_EQ(4, fmap_str_size(&s));
+    EXPECT_STREQ("6", cstr_str(fmap_str_at(&s, "a")));
+    EXPECT_STREQ("4", cstr_str(fmap_str_at(&s, "b")));
+    c_push_items(fmap_str, &s, {{"e", "7"}, {"a", "8"}, {"e", "9"}});
+    EXPECT_EQ(5, fmap_str_size(&s));
+    EXPECT_STREQ("8", cstr_str(fmap_str_at(&s, "a")));
+    EXPECT_STREQ("9", cstr_str(fmap_str_at(&s, "e")));
+    fmap_str_drop(&s);
+}
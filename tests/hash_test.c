@@ -0,0 +1,105 @@
+#include <stdio.h>
+#include "stc/cstr.h"
+#include "stc/csview.h"
+#include "stc/random.h"
+#include "ctest.h"
+
+TEST(hash, hash_str)
+{
+    char buf[320 + 8];
+    crand64 rng = crand64_from(1234);
+    for (int i = 0; i < c_arraylen(buf); ++i)
+        buf[i] = (char)(crand64_uint_r(&rng, 1) % 255 + 1);
+
+    for (int align = 0; align < 8; ++align) {
+        for (int len = 0; len <= 320; ++len) {
+            char* s = buf + align;
+            char saved = s[len];
+            s[len] = '\0';
+            EXPECT_TRUE(c_basehash_n(s, len) == c_hash_str(s));
+            s[len] = saved;
+        }
+    }
+    cstr str = cstr_from("The quick brown fox jumps over the lazy dog, twice over!");
+    csview sv = cstr_sv(&str);
+    EXPECT_TRUE(cstr_hash(&str) == c_hash_str(cstr_str(&str)));
+    EXPECT_TRUE(csview_hash(&sv) == cstr_hash(&str));
+    EXPECT_TRUE(c_basehash_n("abcd", 4) != c_basehash_n("abce", 4));
+    cstr_drop(&str);
+}
+
+TEST(hash, avalanche)
+{
+    // Flipping any single input bit should flip each output bit with probability ~0.5.
+    static const int sizes[] = {3, 4, 8, 13, 16, 24, 48, 64, 100};
+    enum {ROUNDS = 200};
+    crand64 rng = crand64_from(4321);
+    uint8_t key[100];
+
+    for (int s = 0; s < c_arraylen(sizes); ++s) {
+        const int len = sizes[s];
+        int flips[64] = {0};
+        for (int r = 0; r < ROUNDS; ++r) {
+            for (int i = 0; i < len; ++i)
+                key[i] = (uint8_t)crand64_uint_r(&rng, 1);
+            const uint64_t h0 = c_hash_n(key, len);
+            for (int bit = 0; bit < len*8; ++bit) {
+                key[bit/8] ^= (uint8_t)(1u << bit%8);
+                const uint64_t d = h0 ^ c_hash_n(key, len);
+                key[bit/8] ^= (uint8_t)(1u << bit%8);
+                for (int j = 0; j < 64; ++j)
+                    flips[j] += (int)(d >> j & 1);
+            }
+        }
+        const double trials = (double)ROUNDS*len*8;
+        int total = 0;
+        for (int j = 0; j < 64; ++j) {
+            EXPECT_NEAR(0.5, flips[j]/trials, 0.05);
+            total += flips[j];
+        }
+        EXPECT_NEAR(32.0, total/trials, 0.5);
+    }
+}
+
+#define i_type hmap_si
+#define i_keypro cstr
+#define i_val int
+#include "stc/hmap.h"
+
+#define i_type hmap_u64, uint64_t, int
+#include "stc/hmap.h"
+
+TEST(hash, hmap_distribution)
+{
+    // Structured keys must spread over the buckets: short probe distances only.
+    enum {N = 100000};
+    hmap_si smap = {0};
+    hmap_u64 imap = {0};
+    char buf[32];
+    for (int i = 0; i < N; ++i) {
+        snprintf(buf, sizeof buf, "key%d", i);
+        hmap_si_emplace(&smap, buf, i);
+        hmap_u64_insert(&imap, (uint64_t)i << 20, i);
+    }
+    EXPECT_EQ(N, hmap_si_size(&smap));
+    EXPECT_EQ(N, hmap_u64_size(&imap));
+
+    int smax = 0, imax = 0;
+    double ssum = 0, isum = 0;
+    for (isize i = 0; i < smap.bucket_count; ++i)
+        if (smap.meta[i].dist) {
+            ssum += smap.meta[i].dist - 1;
+            if (smap.meta[i].dist > smax) smax = smap.meta[i].dist;
+        }
+    for (isize i = 0; i < imap.bucket_count; ++i)
+        if (imap.meta[i].dist) {
+            isum += imap.meta[i].dist - 1;
+            if (imap.meta[i].dist > imax) imax = imap.meta[i].dist;
+        }
+    EXPECT_LT(smax, 40);
+    EXPECT_LT(imax, 40);
+    EXPECT_DOUBLE_LT(ssum/N, 2.0);
+    EXPECT_DOUBLE_LT(isum/N, 2.0);
+    hmap_si_drop(&smap);
+    hmap_u64_drop(&imap);
+}
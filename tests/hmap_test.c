@@ -1,5 +1,7 @@
 #include <stdio.h>
 #include "stc/cstr.h"
+#include "stc/random.h"
+#include "stc/algorithm.h"
 #include "ctest.h"
 
 #define i_type hmap_ii, int, int
@@ -58,3 +60,635 @@ TEST(hmap, mapdemo3)
 
     c_drop(hmap_cstr, &map, &res1, &res2);
 }
+
+#define i_type hmap_simd, int, int
+#define i_simd_probe
+#include "stc/hmap.h"
+
+TEST(hmap, simd_probe)
+{
+    hmap_simd map = {0};
+    hmap_ii ref = {0};
+    for (int i = 0; i < 20000; ++i) {
+        int k = (int)((unsigned)i * 2654435761U >> 8);
+        hmap_simd_insert(&map, k, i);
+        hmap_ii_insert(&ref, k, i);
+    }
+    EXPECT_EQ(hmap_ii_size(&ref), hmap_simd_size(&map));
+
+    for (c_each_kv(k, v, hmap_ii, ref)) {
+        const hmap_simd_value* e = hmap_simd_get(&map, *k);
+        ASSERT_TRUE(e != NULL);
+        EXPECT_EQ(*v, e->second);
+    }
+    for (int i = 0; i < 20000; i += 2) {
+        int k = (int)((unsigned)i * 2654435761U >> 8);
+        EXPECT_EQ(hmap_ii_erase(&ref, k), hmap_simd_erase(&map, k));
+    }
+    for (int i = 0; i < 40000; ++i) {
+        int k = (int)((unsigned)i * 2654435761U >> 8);
+        EXPECT_EQ(hmap_ii_contains(&ref, k), hmap_simd_contains(&map, k));
+    }
+    hmap_simd_drop(&map);
+    hmap_ii_drop(&ref);
+}
+
+TEST(hmap, batch)
+{
+    enum {N = 5000};
+    static hmap_ii_raw raw[N];
+    static int keys[2*N];
+    static const hmap_ii_value* vals[2*N];
+    static bool found[2*N];
+    for (int i = 0; i < N; ++i) {
+        raw[i].first = (i*7) % (N/2); // half are duplicates
+        raw[i].second = i;
+    }
+    hmap_ii map = {0}, ref = {0};
+    hmap_ii_put_n(&map, raw, N);
+    for (int i = 0; i < N; ++i)
+        hmap_ii_insert_or_assign(&ref, raw[i].first, raw[i].second);
+    EXPECT_TRUE(hmap_ii_eq(&map, &ref));
+
+    for (int i = 0; i < 2*N; ++i)
+        keys[i] = i - N/2;
+    EXPECT_EQ(N/2, hmap_ii_get_n(&map, keys, 2*N, vals));
+    EXPECT_EQ(N/2, hmap_ii_contains_n(&map, keys, 2*N, found));
+    for (int i = 0; i < 2*N; ++i) {
+        EXPECT_TRUE(vals[i] == hmap_ii_get(&map, keys[i]));
+        EXPECT_EQ(hmap_ii_contains(&map, keys[i]), found[i]);
+    }
+    c_drop(hmap_ii, &map, &ref);
+    map = hmap_ii_init();
+    EXPECT_EQ(0, hmap_ii_get_n(&map, keys, 2*N, vals));
+    EXPECT_TRUE(vals[0] == NULL);
+}
+
+TEST(hmap, batch_emplace)
+{
+    const hmap_cstr_raw raw[] = {{"Map", "test"}, {"Make", "my"}, {"Map", "day"}, {"Sunny", "day"}};
+    hmap_cstr map = hmap_cstr_with_n(raw, c_arraylen(raw));
+    const char* keys[] = {"Map", "Hello", "Sunny"};
+    const hmap_cstr_value* vals[3];
+
+    EXPECT_EQ(3, hmap_cstr_size(&map));
+    EXPECT_EQ(2, hmap_cstr_get_n(&map, keys, 3, vals));
+    EXPECT_STREQ("day", cstr_str(&vals[0]->second));
+    EXPECT_TRUE(vals[1] == NULL);
+    EXPECT_STREQ("Sunny", cstr_str(&vals[2]->first));
+    hmap_cstr_drop(&map);
+}
+
+#define i_type hmap_inc, int, int
+#define i_incremental
+#define i_rehash_step 8
+#include "stc/hmap.h"
+
+TEST(hmap, incremental)
+{
+    hmap_inc map = {0};
+    hmap_ii ref = {0};
+    for (int i = 0; i < 50000; ++i) {
+        int k = (int)((unsigned)i * 2654435761U >> 8);
+        hmap_inc_insert(&map, k, i);
+        hmap_ii_insert(&ref, k, i);
+        if (i % 3 == 0) {
+            int e = (int)((unsigned)(i/2) * 2654435761U >> 8);
+            EXPECT_EQ(hmap_ii_erase(&ref, e), hmap_inc_erase(&map, e));
+        }
+        if (map._old.size != 0 && i % 64 == 0) { // lookups and find/erase_at during a resize
+            for (int j = 0; j <= i; j += 7) {
+                int q = (int)((unsigned)j * 2654435761U >> 8);
+                const hmap_ii_value* v = hmap_ii_get(&ref, q);
+                const hmap_inc_value* w = hmap_inc_get(&map, q);
+                ASSERT_EQ(v != NULL, w != NULL);
+                if (v) EXPECT_EQ(v->second, w->second);
+            }
+            hmap_inc_iter it = hmap_inc_find(&map, k);
+            ASSERT_TRUE(it.ref != NULL);
+            hmap_inc_erase_at(&map, it);
+            hmap_ii_erase(&ref, k);
+        }
+    }
+    EXPECT_EQ(hmap_ii_size(&ref), hmap_inc_size(&map));
+
+    const isize pending = map._old.size;
+    hmap_inc copy = hmap_inc_clone(map);
+    EXPECT_TRUE(hmap_inc_eq(&copy, &map));
+    EXPECT_EQ(pending, map._old.size); // iteration does not move entries
+
+    isize n = 0;
+    for (c_each_kv(k, v, hmap_inc, copy)) {
+        const hmap_ii_value* e = hmap_ii_get(&ref, *k);
+        ASSERT_TRUE(e != NULL);
+        EXPECT_EQ(e->second, *v);
+        ++n;
+    }
+    EXPECT_EQ(hmap_ii_size(&ref), n);
+
+    hmap_inc_clear(&copy);
+    EXPECT_EQ(0, hmap_inc_size(&copy));
+    c_drop(hmap_inc, &map, &copy);
+    hmap_ii_drop(&ref);
+}
+
+TEST(hmap, incremental_reinsert)
+{
+    hmap_inc map = {0};
+    int grows = 0;
+    for (int i = 0; i < 20000; ++i) {
+        if (i > 0 && (isize)map.size - (isize)map._old.size >= hmap_inc_capacity(&map)) {
+            // the next insert grows the table: re-insert keys which are still in the current one
+            ++grows;
+            for (int j = i - 1; j >= 0 && j >= i - 3; --j) {
+                const isize size = hmap_inc_size(&map);
+                EXPECT_FALSE(hmap_inc_insert(&map, j, -1).inserted);
+                EXPECT_EQ(size, hmap_inc_size(&map));
+            }
+        }
+        hmap_inc_insert(&map, i, i);
+    }
+    EXPECT_TRUE(grows > 5);
+    EXPECT_EQ(20000, hmap_inc_size(&map));
+
+    hmap_ii seen = {0};
+    for (c_each_kv(k, v, hmap_inc, map)) {
+        EXPECT_TRUE(hmap_ii_insert(&seen, *k, *v).inserted); // no duplicate keys
+        EXPECT_EQ(*k, *v);
+    }
+    EXPECT_EQ(20000, hmap_ii_size(&seen));
+    hmap_ii_drop(&seen);
+    hmap_inc_drop(&map);
+}
+
+#define i_type hmap_incimg, int, int
+#define i_incremental
+#define i_image
+#include "stc/hmap.h"
+
+TEST(hmap, incremental_iter)
+{
+    hmap_incimg map = {0};
+    int i = 0;
+    do { // stop in the middle of a resize
+        hmap_incimg_insert(&map, i, i);
+    } while (++i < 1000 || map._old.size == 0);
+    const isize pending = map._old.size;
+    ASSERT_TRUE(pending > 0 && pending < hmap_incimg_size(&map));
+
+    // begin() on a const map visits the old table, then the current one, without moving entries
+    const hmap_incimg* cmap = &map;
+    hmap_ii seen = {0};
+    for (c_each_kv(k, v, hmap_incimg, *cmap)) {
+        EXPECT_TRUE(hmap_ii_insert(&seen, *k, *v).inserted);
+        EXPECT_EQ(*k, *v);
+    }
+    EXPECT_EQ(i, hmap_ii_size(&seen));
+    EXPECT_EQ(pending, map._old.size);
+
+    // the image of a map with a pending resize holds the entries of both tables
+    const char* path = "stc_hmap_incimg_test.bin";
+    FILE* fp = fopen(path, "wb");
+    ASSERT_NOT_NULL(fp);
+    EXPECT_TRUE(hmap_incimg_write_image(cmap, fp));
+    fclose(fp);
+    EXPECT_EQ(pending, map._old.size);
+    cmmap file = cmmap_open(path);
+    ASSERT_NOT_NULL(file.data);
+    hmap_incimg view;
+    EXPECT_TRUE(hmap_incimg_view_image(&view, file.data, file.size));
+    EXPECT_EQ(i, hmap_incimg_size(&view));
+    for (int j = 0; j < i; ++j)
+        EXPECT_TRUE(hmap_incimg_contains(&view, j));
+    cmmap_close(&file);
+    remove(path);
+
+    // erase_at() of every odd key while iterating, across both tables
+    hmap_incimg_iter it = hmap_incimg_begin(&map);
+    while (it.ref) {
+        if (it.ref->first & 1) it = hmap_incimg_erase_at(&map, it);
+        else hmap_incimg_next(&it);
+    }
+    EXPECT_EQ(i/2 + (i & 1), hmap_incimg_size(&map));
+    for (int j = 0; j < i; ++j)
+        EXPECT_EQ(!(j & 1), hmap_incimg_contains(&map, j));
+
+    hmap_ii_drop(&seen);
+    hmap_incimg_drop(&map);
+}
+
+#define i_type hmap_sinc
+#define i_keypro cstr
+#define i_val int
+#define i_incremental
+#include "stc/hmap.h"
+
+TEST(hmap, incremental_drop)
+{
+    hmap_sinc map = {0};
+    char buf[32];
+    int i = 0;
+    do { // stop in the middle of a resize
+        snprintf(buf, sizeof buf, "key%d", i);
+        hmap_sinc_emplace(&map, buf, i);
+    } while (++i < 1000 || map._old.size == 0);
+    EXPECT_EQ(i - 1, *hmap_sinc_at(&map, buf));
+    EXPECT_EQ(0, *hmap_sinc_at(&map, "key0"));
+    hmap_sinc_drop(&map); // entries in both tables are dropped
+}
+
+#define i_type hmap_sh
+#define i_keypro cstr
+#define i_val int
+#define i_store_hash
+#include "stc/hmap.h"
+
+#define i_type hmap_shinc, int, int
+#define i_store_hash
+#define i_incremental
+#include "stc/hmap.h"
+
+TEST(hmap, store_hash)
+{
+    hmap_sh map = {0};
+    hmap_shinc imap = {0};
+    char buf[32];
+    for (int i = 0; i < 6000; ++i) {
+        snprintf(buf, sizeof buf, "key%d", i);
+        hmap_sh_emplace(&map, buf, i);
+        hmap_shinc_insert(&imap, i*3, i);
+    }
+    for (int i = 0; i < 6000; i += 3) {
+        snprintf(buf, sizeof buf, "key%d", i);
+        EXPECT_EQ(1, hmap_sh_erase(&map, buf));
+        EXPECT_EQ(1, hmap_shinc_erase(&imap, i*3));
+    }
+    hmap_sh copy = hmap_sh_clone(map);
+    hmap_sh_reserve(&copy, 100000);
+    EXPECT_TRUE(hmap_sh_eq(&copy, &map));
+
+    for (int i = 0; i < 7000; ++i) {
+        snprintf(buf, sizeof buf, "key%d", i);
+        const hmap_sh_value* v = hmap_sh_get(&copy, buf);
+        const hmap_shinc_value* w = hmap_shinc_get(&imap, i*3);
+        EXPECT_EQ(i < 6000 && i % 3 != 0, v != NULL);
+        EXPECT_EQ(i < 6000 && i % 3 != 0, w != NULL);
+        if (v) EXPECT_EQ(i, v->second);
+        if (w) EXPECT_EQ(i, w->second);
+    }
+    c_drop(hmap_sh, &map, &copy);
+    hmap_shinc_drop(&imap);
+}
+
+#define i_type hmap_img, int, double
+#define i_store_hash
+#define i_image
+#include "stc/hmap.h"
+
+#define i_type hset_simg
+#define i_keypro cstr
+#define i_image
+#include "stc/hset.h"
+
+#define i_type hset_simg_view
+#define i_keypro cmmap_str
+#define i_image
+#include "stc/hset.h"
+
+TEST(hmap, image)
+{
+    const char* path = "stc_hmap_image_test.bin";
+    hmap_img map = {0}, view;
+    hset_simg set = {0};
+    hset_simg_view sview;
+    char buf[64];
+    for (int i = 0; i < 3000; ++i) {
+        hmap_img_insert(&map, i*5, i/2.0);
+        snprintf(buf, sizeof buf, i & 1 ? "k%d" : "a key longer than the short string buffer %d", i);
+        hset_simg_emplace(&set, buf);
+    }
+    FILE* fp = fopen(path, "wb");
+    ASSERT_NOT_NULL(fp);
+    EXPECT_TRUE(hmap_img_write_image(&map, fp));
+    EXPECT_TRUE(hset_simg_write_image(&set, fp));
+    fclose(fp);
+
+    cmmap file = cmmap_open(path);
+    ASSERT_NOT_NULL(file.data);
+    const struct hmap_image* h = (const struct hmap_image*)file.data;
+    const char* second = file.data + h->end_pos;
+    EXPECT_TRUE(hmap_img_view_image(&view, file.data, h->end_pos));
+    EXPECT_TRUE(hset_simg_view_view_image(&sview, second, file.size - h->end_pos));
+    EXPECT_FALSE(hset_simg_view_view_image(&sview, file.data, file.size)); // not a string set image
+    EXPECT_TRUE(hset_simg_view_view_image(&sview, second, file.size - h->end_pos));
+
+    EXPECT_EQ(3000, hmap_img_size(&view));
+    EXPECT_EQ(3000, hset_simg_view_size(&sview));
+    for (int i = 0; i < 3100; ++i) {
+        const hmap_img_value* v = hmap_img_get(&view, i*5);
+        EXPECT_EQ(i < 3000, v != NULL);
+        if (v) EXPECT_DOUBLE_EQ(i/2.0, v->second);
+        snprintf(buf, sizeof buf, i & 1 ? "k%d" : "a key longer than the short string buffer %d", i);
+        EXPECT_EQ(i < 3000, hset_simg_view_contains(&sview, buf));
+    }
+    isize n = 0;
+    for (c_each(i, hset_simg_view, sview))
+        n += hset_simg_contains(&set, cmmap_str_str(i.ref));
+    EXPECT_EQ(3000, n);
+
+    cmmap_close(&file);
+    remove(path);
+    hmap_img_drop(&map);
+    hset_simg_drop(&set);
+}
+
+#define i_type hmap_st, int, int
+#define i_stats
+#include "stc/hmap.h"
+
+TEST(hmap, stats)
+{
+    hmap_st map = {0};
+    hmap_ii plain = {0};
+    struct hmap_stats st = hmap_st_stats(&map);
+    EXPECT_EQ(0, st.size);
+    EXPECT_EQ(0, st.max_psl);
+
+    for (int i = 0; i < 5000; ++i) {
+        hmap_st_insert(&map, i*7, i);
+        hmap_ii_insert(&plain, i*7, i);
+    }
+    st = hmap_st_stats(&map);
+    EXPECT_EQ(5000, st.size);
+    EXPECT_EQ(hmap_st_bucket_count(&map), st.bucket_count);
+    EXPECT_TRUE(st.bytes >= st.bucket_count*c_sizeof(hmap_st_value));
+    EXPECT_TRUE(st.counters.rehashes > 0);
+    EXPECT_EQ(5000, (int)st.counters.lookups);
+    isize n = 0;
+    for (int k = 0; k < hmap_stats_bins; ++k)
+        n += st.psl_hist[k];
+    EXPECT_EQ(5000, n);
+    const isize psl = (isize)(st.mean_psl*5000 + 0.5); // sum of PSLs
+    EXPECT_TRUE(st.fingerprint_collision_rate >= 0.0 && st.fingerprint_collision_rate < 0.2);
+
+    hmap_st_reset_stats(&map);
+    for (int i = 0; i < 5000; ++i)
+        EXPECT_TRUE(hmap_st_contains(&map, i*7));
+    st = hmap_st_stats(&map);
+    EXPECT_EQ(5000, (int)st.counters.lookups);
+    EXPECT_TRUE(st.counters.compares >= 5000);
+    EXPECT_EQ(5000 + psl, (isize)st.counters.probes); // a hit probes PSL + 1 buckets
+    EXPECT_EQ(0, (int)st.counters.rehashes);
+
+    struct hmap_stats pst = hmap_ii_stats(&plain); // no i_stats: same layout, no counters
+    EXPECT_EQ(st.bucket_count, pst.bucket_count);
+    EXPECT_DOUBLE_EQ(st.mean_psl, pst.mean_psl);
+    EXPECT_EQ(0, (int)pst.counters.lookups);
+    hmap_st_drop(&map);
+    hmap_ii_drop(&plain);
+}
+
+typedef struct { int id; char data[200]; } Session;
+#define i_type hmap_sess, int, Session
+#define i_slab
+#include "stc/hmap.h"
+
+#define i_type hset_sslab
+#define i_keypro cstr
+#define i_slab
+#define i_store_hash
+#include "stc/hset.h"
+
+TEST(hmap, slab)
+{
+    hmap_sess map = {0};
+    hset_sslab set = {0};
+    const hmap_sess_value* first = hmap_sess_insert(&map, 0, (Session){.id=0}).ref;
+    char buf[32];
+    for (int i = 1; i < 3000; ++i) {
+        Session s = {.id=i};
+        snprintf(s.data, sizeof s.data, "session %d", i);
+        hmap_sess_insert(&map, i, s);
+        snprintf(buf, sizeof buf, "key%d", i);
+        hset_sslab_emplace(&set, buf);
+    }
+    EXPECT_EQ(3000, hmap_sess_size(&map));
+    EXPECT_EQ(2999, hset_sslab_size(&set));
+    EXPECT_TRUE(first == hmap_sess_get(&map, 0)); // entries are not moved by rehashing
+    EXPECT_STREQ("session 77", hmap_sess_at(&map, 77)->data);
+
+    for (int i = 0; i < 3000; i += 2) {
+        EXPECT_EQ(1, hmap_sess_erase(&map, i));
+        snprintf(buf, sizeof buf, "key%d", i);
+        EXPECT_EQ(i != 0, hset_sslab_erase(&set, buf));
+    }
+    for (hmap_sess_iter it = hmap_sess_begin(&map); it.ref; ) // erase ids divisible by 3
+        it = it.ref->second.id % 3 == 0 ? hmap_sess_erase_at(&map, it) : (hmap_sess_next(&it), it);
+    hmap_sess_erase_entry(&map, hmap_sess_get_mut(&map, 1));
+
+    hmap_sess copy = hmap_sess_clone(map);
+    int n = 0;
+    for (c_each(i, hmap_sess, copy)) {
+        EXPECT_EQ(i.ref->first, i.ref->second.id);
+        n += (i.ref->first & 1) && i.ref->first % 3 && i.ref->first != 1;
+    }
+    EXPECT_EQ(hmap_sess_size(&copy), n);
+    EXPECT_EQ(999, n);
+    EXPECT_TRUE(hmap_sess_eq(&map, &copy));
+    EXPECT_TRUE(hmap_sess_find(&copy, 5).ref != NULL);
+    EXPECT_TRUE(hmap_sess_find(&copy, 6).ref == NULL);
+    EXPECT_TRUE(hset_sslab_contains(&set, "key2999"));
+    EXPECT_FALSE(hset_sslab_contains(&set, "key2998"));
+
+    struct hmap_stats st = hmap_sess_stats(&map);
+    EXPECT_TRUE(st.bytes >= 999*c_sizeof(hmap_sess_value) + st.bucket_count*c_sizeof(void*));
+    hmap_sess_clear(&map);
+    EXPECT_EQ(0, hmap_sess_size(&map));
+    hmap_sess_insert(&map, 1, (Session){.id=1});
+    EXPECT_EQ(1, hmap_sess_at(&map, 1)->id);
+    c_drop(hmap_sess, &map, &copy);
+    hset_sslab_drop(&set);
+}
+
+static bool is_odd_key(const hmap_sh_value* v, void* arg)
+    { (void)arg; return v->second & 1; }
+static bool has_digit(const hset_sslab_value* v, void* arg)
+    { return strchr(cstr_str(v), *(const char *)arg) != NULL; }
+static bool key_below(const hmap_ii_value* v, void* arg)
+    { return v->first < *(int *)arg; }
+
+TEST(hmap, erase_if)
+{
+    hmap_ii map = {0}, ref = {0};
+    hmap_sh smap = {0};
+    hset_sslab set = {0};
+    char buf[32];
+    char seven[] = "7";
+    isize sevens = 0;
+    crand64 rng = crand64_from(42);
+    for (int i = 0; i < 20000; ++i) {
+        int k = (int)(crand64_uint_r(&rng, 1) % 1000000);
+        hmap_ii_insert(&map, k, i);
+        snprintf(buf, sizeof buf, "key%d", i);
+        hmap_sh_emplace(&smap, buf, i);
+        hset_sslab_emplace(&set, buf);
+        sevens += strchr(buf, '7') != NULL;
+    }
+    ref = hmap_ii_clone(map);
+    int limit = 300000;
+    c_erase_if(hmap_ii, &ref, value->first < limit);
+    isize n = hmap_ii_size(&map);
+    EXPECT_EQ(n - hmap_ii_size(&ref), hmap_ii_erase_if(&map, key_below, &limit));
+    EXPECT_TRUE(hmap_ii_eq(&map, &ref));
+    for (c_each(i, hmap_ii, map)) // all entries are still reachable by lookup
+        EXPECT_TRUE(hmap_ii_contains(&map, i.ref->first));
+
+    EXPECT_EQ(10000, hmap_sh_erase_if(&smap, is_odd_key, NULL));
+    EXPECT_EQ(10000, hmap_sh_size(&smap));
+    EXPECT_TRUE(hmap_sh_contains(&smap, "key1234"));
+    EXPECT_FALSE(hmap_sh_contains(&smap, "key1235"));
+
+    EXPECT_EQ(20000 - sevens, hset_sslab_retain(&set, has_digit, seven));
+    EXPECT_EQ(sevens, hset_sslab_size(&set));
+    EXPECT_TRUE(hset_sslab_contains(&set, "key17"));
+    EXPECT_FALSE(hset_sslab_contains(&set, "key18"));
+    hmap_ii_shrink_to_fit(&map);
+    EXPECT_TRUE(hmap_ii_eq(&map, &ref));
+    c_drop(hmap_ii, &map, &ref);
+    hmap_sh_drop(&smap);
+    hset_sslab_drop(&set);
+}
+
+#define i_type hmap_fix, int, int
+#define i_capacity 40
+#include "stc/hmap.h"
+
+#define i_type hset_sfix
+#define i_keypro cstr
+#define i_capacity 8
+#define i_store_hash
+#include "stc/hset.h"
+
+TEST(hmap, capacity)
+{
+    hmap_fix map = {0};
+    EXPECT_EQ(64, c_arraylen(map.table));
+    EXPECT_EQ(40, hmap_fix_capacity(&map));
+    EXPECT_TRUE(hmap_fix_begin(&map).ref == NULL);
+    EXPECT_FALSE(hmap_fix_contains(&map, 1));
+    for (int i = 0; i < 40; ++i)
+        EXPECT_TRUE(hmap_fix_insert(&map, i*11, i).inserted);
+    hmap_fix_result res = hmap_fix_insert(&map, 1000, 0); // full
+    EXPECT_FALSE(res.inserted);
+    EXPECT_TRUE(res.ref == NULL);
+    EXPECT_TRUE(hmap_fix_insert(&map, 22, 0).ref != NULL); // existing key
+    EXPECT_FALSE(hmap_fix_reserve(&map, 41));
+    EXPECT_EQ(40, hmap_fix_size(&map));
+
+    hmap_fix copy = hmap_fix_clone(map);
+    EXPECT_EQ(1, hmap_fix_erase(&map, 11));
+    EXPECT_TRUE(hmap_fix_insert(&map, 1000, 99).inserted);
+    EXPECT_EQ(99, *hmap_fix_at(&map, 1000));
+    EXPECT_FALSE(hmap_fix_eq(&map, &copy));
+    int sum = 0;
+    for (c_each(i, hmap_fix, copy)) sum += i.ref->second;
+    EXPECT_EQ(39*40/2, sum);
+
+    hset_sfix set = {0};
+    char buf[32];
+    for (int i = 0; i < 10; ++i) {
+        snprintf(buf, sizeof buf, "a long key string %d", i);
+        EXPECT_EQ(i < 8, hset_sfix_emplace(&set, buf).inserted);
+    }
+    hset_sfix set2 = hset_sfix_clone(set);
+    hset_sfix_clear(&set);
+    EXPECT_EQ(0, hset_sfix_size(&set));
+    EXPECT_TRUE(hset_sfix_insert(&set, cstr_lit("x")).inserted);
+    EXPECT_TRUE(hset_sfix_contains(&set2, "a long key string 7"));
+    EXPECT_FALSE(hset_sfix_contains(&set2, "a long key string 8"));
+    c_drop(hset_sfix, &set, &set2);
+    c_drop(hmap_fix, &map, &copy);
+}
+
+TEST(hmap, capacity_self_copy)
+{
+    hset_sfix set = {0};
+    char buf[64];
+    for (int i = 0; i < 6; ++i) {
+        snprintf(buf, sizeof buf, "a key longer than the short string buffer %d", i);
+        hset_sfix_emplace(&set, buf);
+    }
+    hset_sfix_copy(&set, set); // the argument is a copy of the inline table of set
+    EXPECT_EQ(6, hset_sfix_size(&set));
+    for (int i = 0; i < 6; ++i) {
+        snprintf(buf, sizeof buf, "a key longer than the short string buffer %d", i);
+        EXPECT_TRUE(hset_sfix_contains(&set, buf));
+    }
+    hset_sfix set2 = {0};
+    hset_sfix_copy(&set2, set);
+    hset_sfix_copy(&set, set2);
+    EXPECT_TRUE(hset_sfix_eq(&set, &set2));
+    c_drop(hset_sfix, &set, &set2);
+}
+
+static size_t clump_hash(const int* k) // 8 keys per home bucket: long clusters
+    { return (size_t)(*k/8)*0x9E3779B97F4A7C15U; }
+
+#define i_type hmap_par, int, int
+#define i_hash clump_hash
+#define i_parallel
+#include "stc/hmap.h"
+
+#define i_type hmap_spar
+#define i_keypro cstr
+#define i_val int
+#define i_store_hash
+#define i_parallel
+#include "stc/hmap.h"
+
+TEST(hmap, build_n)
+{
+    enum {N = 60000};
+    crand64 rng = crand64_from(1234);
+    hmap_par_raw* raw = c_new_n(hmap_par_raw, N);
+    for (int i = 0; i < N; ++i) // many equal keys: the last value wins
+        raw[i].first = (int)crand64_uint_r(&rng, 1) % (N/2), raw[i].second = i;
+
+    for (c_range32(threads, 1, 8, 3)) {
+        hmap_par map = hmap_par_build_n(raw, N, threads);
+        hmap_par ref = hmap_par_with_n(raw, N);
+        EXPECT_EQ(hmap_par_bucket_count(&ref), hmap_par_bucket_count(&map));
+        EXPECT_EQ(hmap_par_size(&ref), hmap_par_size(&map));
+        isize same = 0;
+        for (isize i = 0; i < ref.bucket_count; ++i)
+            same += ref.meta[i].dist == map.meta[i].dist && ref.meta[i].hashx == map.meta[i].hashx &&
+                    (ref.meta[i].dist == 0 || (ref.table[i].first == map.table[i].first &&
+                                               ref.table[i].second == map.table[i].second));
+        EXPECT_EQ(ref.bucket_count, same);
+        c_drop(hmap_par, &map, &ref);
+    }
+
+    hmap_spar_raw* sraw = c_new_n(hmap_spar_raw, N);
+    char* text = (char*)c_malloc(N*12);
+    for (int i = 0; i < N; ++i) {
+        sraw[i].first = text + i*12, sraw[i].second = i;
+        snprintf(text + i*12, 12, "%d", raw[i].first);
+    }
+    hmap_spar smap = hmap_spar_build_n(sraw, N, 4);
+    hmap_spar sref = hmap_spar_with_n(sraw, N);
+    isize same = 0;
+    for (isize i = 0; i < sref.bucket_count; ++i)
+        same += sref.meta[i].dist == smap.meta[i].dist &&
+                (sref.meta[i].dist == 0 || (sref.hashes[i] == smap.hashes[i] &&
+                                            cstr_eq(&sref.table[i].first, &smap.table[i].first) &&
+                                            sref.table[i].second == smap.table[i].second));
+    EXPECT_EQ(sref.bucket_count, same);
+    EXPECT_TRUE(hmap_spar_eq(&smap, &sref));
+    hmap_spar empty = hmap_spar_build_n(sraw, 0, 4);
+    EXPECT_EQ(0, hmap_spar_size(&empty));
+
+    c_drop(hmap_spar, &smap, &sref, &empty);
+    c_free(text, N*12);
+    c_free(sraw, N*c_sizeof *sraw);
+    c_free(raw, N*c_sizeof *raw);
+}
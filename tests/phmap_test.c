@@ -0,0 +1,76 @@
+#include <stdio.h>
+#include "stc/cstr.h"
+#include "ctest.h"
+
+#define i_type phmap_ii, int, int
+#include "stc/phmap.h"
+
+#define i_type phmap_si
+#define i_keypro cstr
+#define i_val int
+#include "stc/phmap.h"
+
+#define i_type phset_u64, uint64_t
+#include "stc/phset.h"
+
+TEST(phmap, basic)
+{
+    phmap_ii map = c_make(phmap_ii, {{8, 64}, {11, 121}, {-3, 9}, {0, 0}});
+    EXPECT_EQ(4, phmap_ii_size(&map));
+    EXPECT_EQ(64, *phmap_ii_at(&map, 8));
+    EXPECT_EQ(121, *phmap_ii_at(&map, 11));
+    EXPECT_EQ(9, *phmap_ii_at(&map, -3));
+    EXPECT_TRUE(phmap_ii_contains(&map, 0));
+    EXPECT_FALSE(phmap_ii_contains(&map, 1));
+    *phmap_ii_at_mut(&map, 8) = 65;
+    EXPECT_EQ(65, phmap_ii_get(&map, 8)->second);
+
+    int sum = 0;
+    for (c_each_kv(k, v, phmap_ii, map))
+        sum += *k + *v;
+    EXPECT_EQ(8 + 11 - 3 + 65 + 121 + 9, sum);
+
+    phmap_ii empty = {0};
+    EXPECT_FALSE(phmap_ii_contains(&empty, 8));
+    EXPECT_TRUE(phmap_ii_build(&empty, NULL, 0));
+    c_drop(phmap_ii, &map, &empty);
+}
+
+TEST(phmap, cstr_keys)
+{
+    phmap_si map = c_make(phmap_si, {{"Mon", 1}, {"Tue", 2}, {"Wed", 3}, {"Thu", 4},
+                                     {"Fri", 5}, {"Sat", 6}, {"Sun", 7}, {"Mon", 8}});
+    EXPECT_EQ(7, phmap_si_size(&map));
+    EXPECT_EQ(1, *phmap_si_at(&map, "Mon")); // first of duplicates is kept
+    EXPECT_EQ(5, *phmap_si_at(&map, "Fri"));
+    EXPECT_FALSE(phmap_si_contains(&map, "Xyz"));
+    EXPECT_TRUE(phmap_si_find(&map, "Xyz").ref == phmap_si_end(&map).ref);
+
+    phmap_si copy = phmap_si_clone(map);
+    EXPECT_TRUE(phmap_si_eq(&map, &copy));
+    EXPECT_EQ(7, *phmap_si_at(&copy, "Sun"));
+    c_drop(phmap_si, &map, &copy);
+}
+
+TEST(phmap, large)
+{
+    enum {N = 100000};
+    phset_u64_raw* keys = c_new_n(phset_u64_raw, N);
+    for (int i = 0; i < N; ++i)
+        keys[i] = (uint64_t)i << 20;
+    phset_u64 set = {0};
+    EXPECT_TRUE(phset_u64_build(&set, keys, N));
+    EXPECT_EQ(N, phset_u64_size(&set));
+    EXPECT_TRUE(phset_u64_bucket_count(&set) <= N/4 + 1);
+
+    int found = 0, misses = 0;
+    for (int i = 0; i < N; ++i) {
+        const uint64_t* ref = phset_u64_get(&set, keys[i]);
+        found += ref && *ref == keys[i];
+        misses += phset_u64_contains(&set, keys[i] + 1);
+    }
+    EXPECT_EQ(N, found);
+    EXPECT_EQ(0, misses);
+    phset_u64_drop(&set);
+    c_free(keys, N*c_sizeof *keys);
+}
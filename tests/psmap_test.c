@@ -0,0 +1,176 @@
+#include "ctest.h"
+#include "stc/cstr.h"
+#include "stc/random.h"
+
+#define i_type psmap_ii, int, int
+#define i_use_eq
+#include "stc/psmap.h"
+
+#define i_type smap_ii, int, int
+#include "stc/smap.h"
+
+#define i_type psset_str
+#define i_keypro cstr
+#include "stc/psset.h"
+
+static bool same_ii(const psmap_ii* p, const smap_ii* s) {
+    if (psmap_ii_size(p) != smap_ii_size(s)) return false;
+    psmap_ii_iter i = psmap_ii_begin(p);
+    for (c_each(j, smap_ii, *s)) {
+        if (i.ref->first != j.ref->first || i.ref->second != j.ref->second) return false;
+        psmap_ii_next(&i);
+    }
+    return i.ref == NULL;
+}
+
+// Checks the AA-tree rules and that no node is freed while in use; returns the number of nodes.
+static int aa_check(const psmap_ii_node* n, bool* ok) {
+    if (n == NULL) return 0;
+    const psmap_ii_node *l = n->link[0], *r = n->link[1];
+    if (n->rc < 1) *ok = false;
+    if ((l ? l->level : 0) != n->level - 1) *ok = false;
+    if (r && r->level != n->level && r->level != n->level - 1) *ok = false;
+    if (r && r->link[1] && r->link[1]->level >= n->level) *ok = false;
+    if (n->level > 1 && (l == NULL || r == NULL)) *ok = false;
+    return 1 + aa_check(l, ok) + aa_check(r, ok);
+}
+
+TEST(psmap, basics)
+{
+    psmap_ii m = c_make(psmap_ii, {{5, 50}, {3, 30}, {8, 80}, {1, 10}});
+    psmap_ii snap = psmap_ii_clone(m);
+    EXPECT_TRUE(m.root == snap.root);
+    EXPECT_FALSE(psmap_ii_insert(&m, 3, 33).inserted);
+    EXPECT_TRUE(m.root == snap.root); // nothing changed: nothing copied
+    EXPECT_EQ(0, psmap_ii_erase(&m, 4));
+    EXPECT_TRUE(m.root == snap.root);
+
+    psmap_ii_insert_or_assign(&m, 3, 33);
+    psmap_ii_insert(&m, 4, 40);
+    EXPECT_EQ(1, psmap_ii_erase(&m, 8));
+    EXPECT_EQ(33, *psmap_ii_at(&m, 3));
+    EXPECT_EQ(30, *psmap_ii_at(&snap, 3));
+    EXPECT_EQ(4, psmap_ii_size(&m));
+    EXPECT_EQ(4, psmap_ii_size(&snap));
+    EXPECT_EQ(5, psmap_ii_back(&m)->first);
+    EXPECT_EQ(8, psmap_ii_back(&snap)->first);
+    EXPECT_EQ(5, psmap_ii_lower_bound(&snap, 4).ref->first);
+    EXPECT_EQ(4, psmap_ii_lower_bound(&m, 4).ref->first);
+    EXPECT_TRUE(psmap_ii_lower_bound(&m, 6).ref == NULL);
+
+    psmap_ii res = c_make(psmap_ii, {{1, 10}, {3, 33}, {4, 40}, {5, 50}});
+    EXPECT_TRUE(psmap_ii_eq(&res, &m));
+    psmap_ii_drop(&m); // the snapshot keeps the nodes it uses
+    EXPECT_EQ(80, *psmap_ii_at(&snap, 8));
+    c_drop(psmap_ii, &snap, &res);
+
+    psset_str s = c_make(psset_str, {"one", "two", "three"});
+    psset_str t = psset_str_clone(s);
+    psset_str_emplace(&s, "four");
+    psset_str_erase(&t, "one");
+    EXPECT_EQ(4, psset_str_size(&s));
+    EXPECT_EQ(2, psset_str_size(&t));
+    EXPECT_TRUE(psset_str_contains(&s, "one"));
+    EXPECT_FALSE(psset_str_contains(&t, "one"));
+    EXPECT_STREQ("two", cstr_str(psset_str_back(&t)));
+    c_drop(psset_str, &s, &t);
+}
+
+TEST(psmap, versions)
+{
+    enum {N = 40000, R = 3000, V = 16};
+    crand64 rng = crand64_from(2024);
+    psmap_ii m = {0}, snap[V] = {0};
+    smap_ii ref = {0}, sref[V] = {0};
+    bool ok = true;
+
+    for (int i = 0; i < N; ++i) {
+        const int k = (int)(crand64_uint_r(&rng, 1) % R), op = (int)(crand64_uint_r(&rng, 1) % 8);
+        if (op < 4)
+            EXPECT_EQ(smap_ii_insert(&ref, k, i).inserted, psmap_ii_insert(&m, k, i).inserted);
+        else if (op < 5)
+            psmap_ii_put(&m, k, -i), smap_ii_put(&ref, k, -i);
+        else
+            EXPECT_EQ(smap_ii_erase(&ref, k), psmap_ii_erase(&m, k));
+        if (i % (N/V) == 0) { // keep a snapshot, and update an older one
+            const int v = i/(N/V);
+            snap[v] = psmap_ii_clone(m);
+            sref[v] = smap_ii_clone(ref);
+            if (v > 0) {
+                psmap_ii_insert(&snap[v - 1], -1 - v, v);
+                smap_ii_insert(&sref[v - 1], -1 - v, v);
+            }
+        }
+    }
+    EXPECT_TRUE(same_ii(&m, &ref));
+    EXPECT_EQ(psmap_ii_size(&m), aa_check(m.root, &ok));
+    for (int v = 0; v < V; ++v) {
+        EXPECT_TRUE(same_ii(&snap[v], &sref[v]));
+        EXPECT_EQ(psmap_ii_size(&snap[v]), aa_check(snap[v].root, &ok));
+    }
+    EXPECT_TRUE(ok);
+    for (int v = 0; v < V; v += 2) // drop half the versions, and check the rest
+        psmap_ii_drop(&snap[v]), smap_ii_drop(&sref[v]);
+    for (int k = 0; k < R; k += 2)
+        psmap_ii_erase(&m, k), smap_ii_erase(&ref, k);
+    for (int v = 1; v < V; v += 2)
+        EXPECT_TRUE(same_ii(&snap[v], &sref[v]));
+    EXPECT_TRUE(same_ii(&m, &ref));
+    for (int v = 1; v < V; v += 2)
+        psmap_ii_drop(&snap[v]), smap_ii_drop(&sref[v]);
+    psmap_ii_drop(&m);
+    smap_ii_drop(&ref);
+}
+
+#if defined __unix__ || defined __APPLE__
+#include <pthread.h>
+enum {NREADERS = 3, NVERSIONS = 20000, WINDOW = 50};
+static psmap_ii published;
+static chmap_rwlock publish_lock;
+static _c_atomic(long) done;
+
+// Each version holds the keys [v - WINDOW + 1, v] that are >= 0, all mapped to v.
+static void* reader(void* arg) {
+    long* errors = (long *)arg;
+    while (!_c_atomic_load(&done)) {
+        chmap_rwlock_rdlock(&publish_lock);
+        psmap_ii snap = psmap_ii_clone(published);
+        chmap_rwlock_rdunlock(&publish_lock);
+        if (snap.size) {
+            const int v = psmap_ii_back(&snap)->first;
+            int k = v < WINDOW ? 0 : v - WINDOW + 1;
+            *errors += psmap_ii_size(&snap) != v - k + 1;
+            for (c_each(it, psmap_ii, snap))
+                *errors += it.ref->first != k++ || it.ref->second != v;
+        }
+        psmap_ii_drop(&snap);
+    }
+    return NULL;
+}
+
+TEST(psmap, threads)
+{
+    pthread_t t[NREADERS];
+    long errors[NREADERS] = {0};
+    psmap_ii m = {0};
+    for (c_range(i, NREADERS))
+        pthread_create(&t[i], NULL, reader, &errors[i]);
+    for (int v = 0; v < NVERSIONS; ++v) {
+        if (v >= WINDOW) psmap_ii_erase(&m, v - WINDOW);
+        for (int k = v < WINDOW ? 0 : v - WINDOW + 1; k < v; ++k) // copies the nodes shared with readers
+            psmap_ii_insert_or_assign(&m, k, v);
+        psmap_ii_insert(&m, v, v);
+        psmap_ii snap = psmap_ii_clone(m);
+        chmap_rwlock_wrlock(&publish_lock);
+        psmap_ii_take(&published, snap);
+        chmap_rwlock_wrunlock(&publish_lock);
+    }
+    _c_atomic_store(&done, 1);
+    for (c_range(i, NREADERS)) {
+        pthread_join(t[i], NULL);
+        EXPECT_EQ(0, errors[i]);
+    }
+    EXPECT_EQ(WINDOW, psmap_ii_size(&published));
+    c_drop(psmap_ii, &m, &published);
+}
+#endif
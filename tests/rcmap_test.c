@@ -0,0 +1,157 @@
+#include <stdio.h>
+#include "stc/cstr.h"
+#include "ctest.h"
+
+static void (*epoch_stall)(void); // called by readers between reading the epoch and counting themselves
+#define STC_EPOCH_STALL() (epoch_stall ? epoch_stall() : (void)0)
+
+#define i_type rcset_u64, uint64_t
+#include "stc/rcset.h"
+
+#define i_type rcmap_ss
+#define i_keypro cstr
+#define i_valpro cstr
+#include "stc/rcmap.h"
+
+static void count_len(const rcmap_ss_value* v, void* arg) { *(isize *)arg += cstr_size(&v->second); }
+
+TEST(rcmap, set_basic)
+{
+    rcset_u64 set = {0};
+    EXPECT_FALSE(rcset_u64_contains(&set, 1));
+    for (uint64_t i = 0; i < 100000; ++i)
+        EXPECT_TRUE(rcset_u64_insert(&set, i*7));
+    EXPECT_FALSE(rcset_u64_insert(&set, 7));
+    EXPECT_EQ(100000, rcset_u64_size(&set));
+    for (uint64_t i = 0; i < 100000; i += 2)
+        EXPECT_TRUE(rcset_u64_erase(&set, i*7));
+    EXPECT_FALSE(rcset_u64_erase(&set, 0));
+    EXPECT_EQ(50000, rcset_u64_size(&set));
+
+    int found = 0;
+    for (uint64_t i = 0; i < 100000; ++i)
+        found += rcset_u64_contains(&set, i*7) == (i & 1);
+    EXPECT_EQ(100000, found);
+    rcset_u64_drop(&set);
+}
+
+TEST(rcmap, map_cstr)
+{
+    rcmap_ss map = {0};
+    cstr val = {0};
+    EXPECT_TRUE(rcmap_ss_put(&map, "color", "red"));
+    EXPECT_TRUE(rcmap_ss_emplace(&map, "shape", "circle"));
+    EXPECT_FALSE(rcmap_ss_emplace(&map, "shape", "square"));
+    EXPECT_FALSE(rcmap_ss_put(&map, "color", "blue"));
+    EXPECT_TRUE(rcmap_ss_insert(&map, cstr_lit("size"), cstr_lit("large")));
+    EXPECT_EQ(3, rcmap_ss_size(&map));
+
+    EXPECT_TRUE(rcmap_ss_get(&map, "color", &val));
+    EXPECT_STREQ("blue", cstr_str(&val));
+    cstr_drop(&val);
+    EXPECT_TRUE(rcmap_ss_get(&map, "shape", &val));
+    EXPECT_STREQ("circle", cstr_str(&val));
+    cstr_drop(&val);
+
+    isize len = 0;
+    rcmap_ss_visit(&map, count_len, &len);
+    EXPECT_EQ(4 + 6 + 5, len);
+    for (int i = 0; i < 200; ++i) // retire many replaced nodes
+        rcmap_ss_put(&map, "color", i & 1 ? "green" : "yellow");
+    EXPECT_TRUE(rcmap_ss_get(&map, "color", &val));
+    EXPECT_STREQ("green", cstr_str(&val));
+    cstr_drop(&val);
+    rcmap_ss_drop(&map);
+}
+
+#if defined __unix__ || defined __APPLE__
+#include <pthread.h>
+enum {NREADERS = 3, NKEYS = 20000};
+static rcset_u64 shared;
+static _c_atomic(long) done;
+
+static void* reader(void* arg) {
+    long* errors = (long *)arg;
+    while (!_c_atomic_load(&done))
+        for (uint64_t i = 0; i < NKEYS; i += 2) // even keys are never erased
+            *errors += !rcset_u64_contains(&shared, i);
+    return NULL;
+}
+
+TEST(rcmap, threads)
+{
+    pthread_t t[NREADERS];
+    long errors[NREADERS] = {0};
+    for (uint64_t i = 0; i < NKEYS; i += 2)
+        rcset_u64_insert(&shared, i);
+    for (c_range(i, NREADERS))
+        pthread_create(&t[i], NULL, reader, &errors[i]);
+    for (int r = 0; r < 4; ++r) { // grow, erase and reinsert the odd keys
+        for (uint64_t i = 1; i < (uint64_t)NKEYS*(r + 1); i += 2)
+            rcset_u64_insert(&shared, i);
+        for (uint64_t i = 1; i < (uint64_t)NKEYS*(r + 1); i += 2)
+            rcset_u64_erase(&shared, i);
+    }
+    _c_atomic_store(&done, 1);
+    for (c_range(i, NREADERS)) {
+        pthread_join(t[i], NULL);
+        EXPECT_EQ(0, errors[i]);
+    }
+    EXPECT_EQ(NKEYS/2, rcset_u64_size(&shared));
+    rcset_u64_drop(&shared);
+}
+
+// The writer publishes a new cell, waits for the readers of the old one and then poisons it.
+// A reader that sees a poisoned cell has used memory after it was reclaimed.
+enum {NCELLS = 1024, NRECLAIMS = 5000};
+static _c_epoch epoch;
+static long cells[NCELLS];
+static _c_atomic(long*) current;
+static _c_atomic(long) stop;
+
+static void reclaim_once(void) { epoch_stall = NULL; _c_epoch_synchronize(&epoch); }
+static void yield_twice(void) { _chmap_yield(); _chmap_yield(); }
+
+static void* epoch_reader(void* arg) {
+    long* errors = (long *)arg;
+    while (!_c_atomic_load(&stop)) {
+        const int token = _c_epoch_enter(&epoch);
+        const long* cell = _c_atomic_load_sc(&current);
+        _chmap_yield(); // let the writer reclaim what it can
+        *errors += *cell != 42;
+        _c_epoch_leave(&epoch, token);
+    }
+    return NULL;
+}
+
+TEST(rcmap, epoch_stall)
+{
+    // A reclaim runs after the reader has read the epoch, but before it is counted:
+    // the reader must still be counted where the next reclaim waits.
+    epoch_stall = reclaim_once;
+    int token = _c_epoch_enter(&epoch);
+    EXPECT_EQ(_c_atomic_load(&epoch.epoch) & 1, token / _c_epoch_slots);
+    _c_epoch_leave(&epoch, token);
+
+    pthread_t t[NREADERS];
+    long errors[NREADERS] = {0};
+    cells[0] = 42;
+    _c_atomic_store_sc(&current, &cells[0]);
+    epoch_stall = yield_twice;
+    for (c_range(i, NREADERS))
+        pthread_create(&t[i], NULL, epoch_reader, &errors[i]);
+    for (int i = 1; i <= NRECLAIMS; ++i) {
+        long* old = _c_atomic_load(&current);
+        cells[i % NCELLS] = 42;
+        _c_atomic_store_sc(&current, &cells[i % NCELLS]);
+        _c_epoch_synchronize(&epoch);
+        *old = -1;
+    }
+    _c_atomic_store(&stop, 1);
+    for (c_range(i, NREADERS)) {
+        pthread_join(t[i], NULL);
+        EXPECT_EQ(0, errors[i]);
+    }
+    epoch_stall = NULL;
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,171 @@
+#include <stdio.h>
+#include "stc/cstr.h"
+#include "stc/random.h"
+#include "ctest.h"
+
+static int epoch_stall; // readers yield between reading the epoch and counting themselves
+#define STC_EPOCH_STALL() (epoch_stall ? _chmap_yield() : (void)0)
+
+#define i_type skset_int, int
+#include "stc/skset.h"
+
+#define i_type sset_int, int
+#include "stc/sset.h"
+
+#define i_type skmap_ss
+#define i_keypro cstr
+#define i_valpro cstr
+#include "stc/skmap.h"
+
+struct collect { int keys[64]; int n; };
+static void collect_key(const int* k, void* arg) {
+    struct collect* c = (struct collect *)arg;
+    if (c->n < 64) c->keys[c->n] = *k;
+    ++c->n;
+}
+static void store_key(const int* k, void* arg) { *(int *)arg = *k; }
+static void append_key(const skmap_ss_value* v, void* arg) { cstr_append_s((cstr *)arg, v->first); }
+
+TEST(skmap, basics)
+{
+    skmap_ss map = {0};
+    cstr val = {0};
+    EXPECT_TRUE(skmap_ss_emplace(&map, "shape", "circle"));
+    EXPECT_TRUE(skmap_ss_emplace(&map, "color", "red"));
+    EXPECT_FALSE(skmap_ss_emplace(&map, "shape", "square"));
+    EXPECT_TRUE(skmap_ss_insert(&map, cstr_lit("size"), cstr_lit("large")));
+    EXPECT_FALSE(skmap_ss_insert(&map, cstr_lit("size"), cstr_lit("small")));
+    EXPECT_EQ(3, skmap_ss_size(&map));
+
+    EXPECT_TRUE(skmap_ss_get(&map, "shape", &val));
+    EXPECT_STREQ("circle", cstr_str(&val));
+    cstr_drop(&val);
+    EXPECT_FALSE(skmap_ss_get(&map, "weight", &val));
+    cstr keys = {0};
+    skmap_ss_visit(&map, append_key, &keys);
+    EXPECT_STREQ("colorshapesize", cstr_str(&keys));
+    cstr_drop(&keys);
+
+    EXPECT_TRUE(skmap_ss_erase(&map, "color"));
+    EXPECT_FALSE(skmap_ss_erase(&map, "color"));
+    EXPECT_FALSE(skmap_ss_contains(&map, "color"));
+    EXPECT_EQ(2, skmap_ss_size(&map));
+    for (int i = 0; i < 200; ++i) // retire many erased nodes
+        skmap_ss_emplace(&map, "color", "blue"), skmap_ss_erase(&map, "color");
+    EXPECT_EQ(2, skmap_ss_size(&map));
+    skmap_ss_drop(&map);
+}
+
+TEST(skmap, ordered)
+{
+    enum {N = 40000, R = 3000};
+    crand64 rng = crand64_from(2025);
+    skset_int s = {0};
+    sset_int ref = {0};
+
+    for (int i = 0; i < N; ++i) {
+        const int k = (int)(crand64_uint_r(&rng, 1) % R);
+        if (crand64_uint_r(&rng, 1) % 3)
+            EXPECT_EQ(sset_int_insert(&ref, k).inserted, skset_int_insert(&s, k));
+        else
+            EXPECT_EQ(sset_int_erase(&ref, k), skset_int_erase(&s, k));
+    }
+    EXPECT_EQ(sset_int_size(&ref), skset_int_size(&s));
+    for (int k = -1; k <= R; ++k) {
+        int lb = -1;
+        sset_int_iter it = sset_int_lower_bound(&ref, k);
+        EXPECT_EQ(it.ref != NULL, skset_int_lower_bound(&s, k, store_key, &lb));
+        EXPECT_EQ(it.ref ? *it.ref : -1, lb);
+        EXPECT_EQ(sset_int_contains(&ref, k), skset_int_contains(&s, k));
+    }
+    struct collect c = {0};
+    const int lo = 1000, hi = 1100;
+    skset_int_visit_range(&s, &lo, &hi, collect_key, &c);
+    int n = 0;
+    for (sset_int_iter it = sset_int_lower_bound(&ref, lo); it.ref && *it.ref < hi; sset_int_next(&it), ++n)
+        if (n < 64) EXPECT_EQ(*it.ref, c.keys[n]);
+    EXPECT_EQ(n, c.n);
+    c.n = 0;
+    skset_int_visit(&s, collect_key, &c);
+    EXPECT_EQ(sset_int_size(&ref), c.n);
+    skset_int_drop(&s);
+    sset_int_drop(&ref);
+}
+
+#if defined __unix__ || defined __APPLE__
+#include <pthread.h>
+enum {NTHREADS = 3, NKEYS = 2000, NROUNDS = 4};
+static skset_int shared;
+static _c_atomic(long) done;
+
+struct scan { int last; long errors; };
+static void check_order(const int* k, void* arg) {
+    struct scan* s = (struct scan *)arg;
+    s->errors += *k <= s->last;
+    s->last = *k;
+}
+
+static void* reader(void* arg) {
+    long* errors = (long *)arg;
+    while (!_c_atomic_load(&done)) {
+        for (int i = 0; i < NKEYS; i += 4) // multiples of 4 are never erased
+            *errors += !skset_int_contains(&shared, i);
+        struct scan s = {-1, 0};
+        skset_int_visit(&shared, check_order, &s);
+        *errors += s.errors;
+    }
+    return NULL;
+}
+
+// Each writer inserts and erases the odd keys, all writers on the same keys.
+static void* writer(void* arg) {
+    (void)arg;
+    for (int r = 0; r < NROUNDS; ++r) {
+        for (int i = 1; i < NKEYS; i += 2)
+            skset_int_insert(&shared, i);
+        for (int i = 1; i < NKEYS; i += 2)
+            skset_int_erase(&shared, i);
+    }
+    return NULL;
+}
+
+static void run_threads(void)
+{
+    pthread_t r[NTHREADS], w[NTHREADS];
+    long errors[NTHREADS] = {0};
+    for (int i = 0; i < NKEYS; i += 4)
+        skset_int_insert(&shared, i);
+    for (c_range(i, NTHREADS))
+        pthread_create(&r[i], NULL, reader, &errors[i]);
+    for (c_range(i, NTHREADS))
+        pthread_create(&w[i], NULL, writer, NULL);
+    for (c_range(i, NTHREADS))
+        pthread_join(w[i], NULL);
+    _c_atomic_store(&done, 1);
+    for (c_range(i, NTHREADS)) {
+        pthread_join(r[i], NULL);
+        EXPECT_EQ(0, errors[i]);
+    }
+    EXPECT_EQ(NKEYS/4, skset_int_size(&shared));
+    struct collect c = {0};
+    skset_int_visit(&shared, collect_key, &c);
+    EXPECT_EQ(NKEYS/4, c.n);
+    skset_int_drop(&shared);
+    shared = (skset_int){0};
+    _c_atomic_store(&done, 0);
+}
+
+TEST(skmap, threads)
+{
+    run_threads();
+}
+
+// Nodes are reclaimed while readers are preempted between reading the epoch and counting
+// themselves in it. A reclaim that does not wait for them frees nodes they are visiting.
+TEST(skmap, threads_stall)
+{
+    epoch_stall = 1;
+    run_threads();
+    epoch_stall = 0;
+}
+#endif
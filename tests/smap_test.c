@@ -150,3 +150,319 @@ TEST(smap, insert)
     c_drop(mymap, &m3, &res3);
     c_drop(vec_ii, &v);
 }
+
+
+#define i_type sset_str
+#define i_keypro cstr
+#include "stc/sset.h"
+
+// Checks the AA-tree rules and the key order; returns the number of nodes.
+static int aa_check(const smap_ii_node* d, int32_t tn, int lo, int hi, bool* ok) {
+    if (tn == 0) return 0;
+    const smap_ii_node* n = &d[tn];
+    const smap_ii_node *l = &d[n->link[0]], *r = &d[n->link[1]];
+    if (n->value.first <= lo || n->value.first >= hi) *ok = false;
+    if (l->level != n->level - 1) *ok = false;
+    if (r->level != n->level && r->level != n->level - 1) *ok = false;
+    if (d[r->link[1]].level >= n->level) *ok = false;
+    if (n->level > 1 && (n->link[0] == 0 || n->link[1] == 0)) *ok = false;
+    return 1 + aa_check(d, n->link[0], lo, n->value.first, ok)
+             + aa_check(d, n->link[1], n->value.first, hi, ok);
+}
+
+TEST(smap, sorted_n)
+{
+    enum {N = 1000};
+    smap_ii_raw raw[N];
+    bool ok = true;
+    for (int n = 0; n < 70; ++n) { // all small sizes
+        for (int i = 0; i < n; ++i) raw[i] = (smap_ii_raw){i*2, i};
+        smap_ii m = smap_ii_with_sorted_n(raw, n);
+        EXPECT_EQ(n, aa_check(m.nodes, m.root, -1, N*4, &ok));
+        EXPECT_EQ(n, smap_ii_size(&m));
+        smap_ii_drop(&m);
+    }
+    EXPECT_TRUE(ok);
+
+    // merge into a map built one insert at a time; duplicate keys update the mapped value
+    smap_ii m = {0}, ref = {0};
+    for (int i = 0; i < N; ++i) {
+        smap_ii_insert(&m, i*3, -i);
+        smap_ii_insert(&ref, i*3, -i);
+    }
+    for (int i = 0; i < N; ++i) raw[i] = (smap_ii_raw){i*2, i};
+    raw[N - 1] = raw[N - 2]; // repeated input key: the last one wins
+    raw[N - 1].second = 7;
+    smap_ii_put_sorted_n(&m, raw, N);
+    smap_ii_put_n(&ref, raw, N);
+    EXPECT_EQ(smap_ii_size(&ref), aa_check(m.nodes, m.root, -1, N*4, &ok));
+    EXPECT_TRUE(ok);
+    EXPECT_TRUE(smap_ii_eq(&ref, &m));
+    EXPECT_EQ(7, *smap_ii_at(&m, (N - 2)*2));
+    EXPECT_EQ(3, *smap_ii_at(&m, 6));
+    for (int i = 0; i < N; i += 2) // the tree is still a valid AA-tree for erase and insert
+        smap_ii_erase(&m, i*3), smap_ii_erase(&ref, i*3);
+    smap_ii_insert(&m, -5, 5), smap_ii_insert(&ref, -5, 5);
+    EXPECT_TRUE(smap_ii_eq(&ref, &m));
+    aa_check(m.nodes, m.root, -10, N*4, &ok);
+    EXPECT_TRUE(ok);
+
+    // unsorted input falls back to put_n()
+    raw[0] = (smap_ii_raw){N*3, 1};
+    smap_ii_put_sorted_n(&m, raw, 3);
+    smap_ii_put_n(&ref, raw, 3);
+    EXPECT_TRUE(smap_ii_eq(&ref, &m));
+    c_drop(smap_ii, &m, &ref);
+
+    const char* words[] = {"alpha", "beta", "beta", "delta", "gamma"};
+    sset_str s = sset_str_with_sorted_n(words, 5);
+    EXPECT_EQ(4, sset_str_size(&s));
+    EXPECT_STREQ("gamma", cstr_str(sset_str_back(&s)));
+    sset_str_put_sorted_n(&s, words, 2);
+    EXPECT_TRUE(sset_str_contains(&s, "gamma"));
+    EXPECT_EQ(4, sset_str_size(&s));
+    sset_str_drop(&s);
+}
+
+
+#define i_type oset_int, int
+#define i_order_stats
+#include "stc/sset.h"
+#include "stc/random.h"
+
+static int32_t os_check(const oset_int_node* d, int32_t tn, bool* ok) {
+    if (tn == 0) return 0;
+    int32_t n = os_check(d, d[tn].link[0], ok) + os_check(d, d[tn].link[1], ok) + 1;
+    if (d[tn].count != n) *ok = false;
+    return n;
+}
+
+TEST(smap, order_stats)
+{
+    enum {N = 20000, R = 5000};
+    crand64 rng = crand64_from(99);
+    oset_int s = {0};
+    bool ok = true;
+
+    for (int i = 0; i < N; ++i) {
+        const int k = (int)(crand64_uint_r(&rng, 1) % R);
+        if (crand64_uint_r(&rng, 1) % 3) oset_int_insert(&s, k);
+        else oset_int_erase(&s, k);
+    }
+    EXPECT_EQ(oset_int_size(&s), os_check(s.nodes, s.root, &ok));
+    EXPECT_TRUE(ok);
+
+    isize rank = 0;
+    for (c_each(it, oset_int, s)) { // select(rank(k)) == k for each k
+        EXPECT_EQ(rank, oset_int_rank(&s, *it.ref));
+        EXPECT_EQ(rank, oset_int_rank(&s, *it.ref - 1) + (oset_int_contains(&s, *it.ref - 1) ? 1 : 0));
+        oset_int_iter j = oset_int_select(&s, rank++);
+        ASSERT_TRUE(j.ref != NULL);
+        EXPECT_EQ(*it.ref, *j.ref);
+    }
+    oset_int_iter j = oset_int_select(&s, 10); // the iterator continues in order
+    oset_int_iter it = oset_int_advance(oset_int_begin(&s), 10);
+    for (; it.ref; oset_int_next(&it), oset_int_next(&j))
+        ASSERT_TRUE(it.ref == j.ref);
+    EXPECT_TRUE(j.ref == NULL);
+    EXPECT_TRUE(oset_int_select(&s, oset_int_size(&s)).ref == NULL);
+
+    isize n = 0;
+    for (c_each(it, oset_int, s)) n += (*it.ref >= 1000 && *it.ref < 2500);
+    EXPECT_EQ(n, oset_int_count_range(&s, 1000, 2500));
+    EXPECT_EQ(0, oset_int_count_range(&s, 2500, 1000));
+    EXPECT_EQ(oset_int_size(&s), oset_int_count_range(&s, -1, R));
+
+    oset_int c = oset_int_clone(s);
+    int keys[100];
+    for (int i = 0; i < 100; ++i) keys[i] = R + i;
+    oset_int_put_sorted_n(&c, keys, 100);
+    os_check(c.nodes, c.root, &ok);
+    EXPECT_TRUE(ok);
+    EXPECT_EQ(R, *oset_int_select(&c, oset_int_size(&s)).ref);
+    c_drop(oset_int, &s, &c);
+}
+
+TEST(smap, compact)
+{
+    enum {N = 20000};
+    crand64 rng = crand64_from(5);
+    smap_ii m = {0}, ref = {0};
+    for (int i = 0; i < N*4; ++i) {
+        const int k = (int)(crand64_uint_r(&rng, 1) % N);
+        if (i & 1) smap_ii_insert(&m, k, i), smap_ii_insert(&ref, k, i);
+        else smap_ii_erase(&m, k), smap_ii_erase(&ref, k);
+    }
+    EXPECT_TRUE(smap_ii_compact(&m));
+    EXPECT_TRUE(smap_ii_eq(&ref, &m));
+    EXPECT_EQ(smap_ii_size(&m), smap_ii_capacity(&m));
+    bool ok = true;
+    EXPECT_EQ(smap_ii_size(&m), aa_check(m.nodes, m.root, -1, N, &ok));
+    for (int32_t i = 2; i <= m.size; ++i) // nodes are stored in key order
+        ok &= m.nodes[i - 1].value.first < m.nodes[i].value.first;
+    EXPECT_TRUE(ok);
+
+    smap_ii_insert(&m, N, 0); // grows again
+    smap_ii_erase(&m, smap_ii_front(&m)->first);
+    EXPECT_EQ(smap_ii_size(&ref), smap_ii_size(&m));
+    smap_ii_clear(&m);
+    EXPECT_TRUE(smap_ii_compact(&m));
+    EXPECT_EQ(0, smap_ii_capacity(&m));
+    c_drop(smap_ii, &m, &ref);
+}
+
+TEST(smap, clone_erased)
+{
+    smap_ii m = {0}, ref = {0};
+    for (int i = 0; i < 1000; ++i)
+        smap_ii_insert(&m, i, i);
+    for (int i = 0; i < 1000; i += 2) // leaves free nodes in m
+        smap_ii_erase(&m, i);
+    smap_ii c = smap_ii_clone(m);
+    for (int i = 1000; i < 3000; ++i) // the clone must allocate from its own node array
+        smap_ii_insert(&c, i, i);
+    for (int i = 1; i < 1000; i += 2)
+        smap_ii_insert(&ref, i, i);
+    EXPECT_EQ(500, smap_ii_size(&m));
+    EXPECT_TRUE(smap_ii_eq(&ref, &m));
+    for (int i = 1000; i < 3000; ++i)
+        smap_ii_insert(&ref, i, i);
+    EXPECT_TRUE(smap_ii_eq(&ref, &c));
+    bool ok = true;
+    EXPECT_EQ(2500, aa_check(c.nodes, c.root, -1, 3000, &ok));
+    EXPECT_TRUE(ok);
+    c_drop(smap_ii, &m, &c, &ref);
+}
+
+#define i_type iset, int
+#include "stc/sset.h"
+
+TEST(smap, set_algebra)
+{
+    iset a = {0}, b = {0};
+    for (int i = 0; i < 3000; i += 2) iset_insert(&a, i);  // even numbers
+    for (int i = 0; i < 3000; i += 3) iset_insert(&b, i);  // multiples of 3
+    iset u = iset_union(&a, &b), n = iset_intersection(&a, &b), d = iset_difference(&a, &b);
+    bool ok = true;
+    for (int i = -1; i <= 3000; ++i) {
+        const bool x = iset_contains(&a, i), y = iset_contains(&b, i);
+        ok &= iset_contains(&u, i) == (x || y);
+        ok &= iset_contains(&n, i) == (x && y);
+        ok &= iset_contains(&d, i) == (x && !y);
+    }
+    EXPECT_TRUE(ok);
+    EXPECT_EQ(2000, iset_size(&u));
+    EXPECT_EQ(500, iset_size(&n));
+    EXPECT_EQ(1000, iset_size(&d));
+    iset e = iset_intersection(&d, &b);
+    EXPECT_TRUE(iset_is_empty(&e) && e.capacity == 0);
+    c_drop(iset, &a, &b, &u, &n, &d, &e);
+
+    // merge moves the entries with new keys; the common keys stay in other
+    smap_ii m1 = c_make(smap_ii, {{1, 10}, {3, 30}, {5, 50}});
+    smap_ii m2 = c_make(smap_ii, {{2, 20}, {3, 33}, {6, 60}});
+    smap_ii res = c_make(smap_ii, {{1, 10}, {2, 20}, {3, 30}, {5, 50}, {6, 60}});
+    EXPECT_TRUE(smap_ii_merge(&m1, &m2));
+    EXPECT_TRUE(smap_ii_eq(&res, &m1));
+    EXPECT_EQ(1, smap_ii_size(&m2));
+    EXPECT_EQ(33, *smap_ii_at(&m2, 3));
+
+    // split at a key, and join back
+    smap_ii hi = {0};
+    EXPECT_TRUE(smap_ii_split(&m1, 3, &hi));
+    EXPECT_EQ(2, smap_ii_size(&m1));
+    EXPECT_EQ(3, smap_ii_size(&hi));
+    EXPECT_EQ(3, smap_ii_front(&hi)->first);
+    EXPECT_EQ(2, smap_ii_back(&m1)->first);
+    EXPECT_TRUE(smap_ii_join(&m1, &hi));
+    EXPECT_TRUE(smap_ii_eq(&res, &m1) && smap_ii_is_empty(&hi));
+    EXPECT_TRUE(smap_ii_split(&m1, 0, &hi)); // everything moves
+    EXPECT_TRUE(smap_ii_is_empty(&m1) && smap_ii_eq(&res, &hi));
+    smap_ii_insert(&m1, 7, 70);
+    EXPECT_TRUE(smap_ii_erase(&hi, 2));
+    c_drop(smap_ii, &m1, &m2, &res, &hi);
+}
+
+// An allocator that fails while alloc_fail is set
+static bool alloc_fail;
+static void* fail_realloc(void* p, isize old_sz, isize sz)
+    { return alloc_fail ? NULL : c_realloc(p, old_sz, sz); }
+static void fail_free(void* p, isize sz) { c_free(p, sz); }
+
+#define i_type smap_oom, int, int
+#define i_allocator fail
+#include "stc/smap.h"
+
+TEST(smap, split_oom)
+{
+    smap_oom m = {0}, hi = {0}, other = c_make(smap_oom, {{100, 1}});
+    for (int i = 0; i < 10; ++i)
+        smap_oom_insert(&m, i, i);
+    alloc_fail = true;
+    EXPECT_FALSE(smap_oom_split(&m, 5, &hi)); // both maps are unchanged
+    EXPECT_EQ(10, smap_oom_size(&m));
+    EXPECT_TRUE(smap_oom_is_empty(&hi));
+    EXPECT_FALSE(smap_oom_merge(&m, &other));
+    EXPECT_EQ(1, smap_oom_size(&other));
+    EXPECT_TRUE(smap_oom_split(&m, 10, &hi)); // nothing to move: no allocation
+    EXPECT_TRUE(smap_oom_split(&other, 0, &hi)); // moves it all: no allocation
+    EXPECT_EQ(1, smap_oom_size(&hi));
+    alloc_fail = false;
+
+    EXPECT_TRUE(smap_oom_split(&m, 5, &hi)); // the previous entries of hi are dropped
+    EXPECT_EQ(5, smap_oom_size(&m));
+    EXPECT_EQ(5, smap_oom_size(&hi));
+    EXPECT_EQ(4, smap_oom_back(&m)->first);
+    EXPECT_EQ(5, smap_oom_front(&hi)->first);
+    c_drop(smap_oom, &m, &hi, &other);
+}
+
+#define i_type bigmap, int64_t, int
+#define i_index64
+#define i_chunked
+#define i_order_stats
+#include "stc/smap.h"
+
+TEST(smap, chunked)
+{
+    enum {N = 200000}; // spans several 64K node chunks
+    bigmap m = {0}, hi = {0};
+    smap_ii ref = {0};
+    for (int i = 0; i < N; ++i) {
+        const int k = (int)((i*7919LL) % N);
+        bigmap_insert(&m, k, i), smap_ii_insert(&ref, k, i);
+    }
+    const bigmap_value* first = bigmap_get(&m, 0);
+    bigmap_reserve(&m, N*2); // adds chunks: existing entries are not moved
+    EXPECT_TRUE(first == bigmap_get(&m, 0));
+    for (int i = 0; i < N; i += 3)
+        bigmap_erase(&m, i), smap_ii_erase(&ref, i);
+    EXPECT_EQ(smap_ii_size(&ref), bigmap_size(&m));
+    EXPECT_EQ(bigmap_size(&m), bigmap_rank(&m, N/2) + bigmap_count_range(&m, N/2, N));
+
+    bool ok = bigmap_size(&m) == smap_ii_size(&ref);
+    bigmap_iter it = bigmap_begin(&m);
+    for (c_each(j, smap_ii, ref)) {
+        ok &= it.ref->first == j.ref->first && it.ref->second == j.ref->second;
+        bigmap_next(&it);
+    }
+    EXPECT_TRUE(ok);
+
+    bigmap c = bigmap_clone(m);
+    EXPECT_TRUE(bigmap_compact(&c));
+    EXPECT_EQ(bigmap_size(&m), bigmap_size(&c));
+    EXPECT_EQ(N - 1, bigmap_back(&c)->first);
+    EXPECT_TRUE(bigmap_split(&c, N/2, &hi));
+    EXPECT_EQ(N/2, bigmap_front(&hi)->first);
+    EXPECT_EQ(bigmap_size(&m), bigmap_size(&c) + bigmap_size(&hi));
+    EXPECT_TRUE(bigmap_join(&c, &hi));
+    EXPECT_TRUE(bigmap_is_empty(&hi));
+    bigmap d = bigmap_difference(&m, &c);
+    EXPECT_TRUE(bigmap_is_empty(&d));
+    bigmap_raw raw[3] = {{N, 1}, {N + 1, 2}, {N + 2, 3}};
+    bigmap_put_sorted_n(&c, raw, 3);
+    EXPECT_EQ(bigmap_size(&m) + 3, bigmap_size(&c));
+    EXPECT_EQ(N + 1, bigmap_select(&c, bigmap_size(&m) + 1).ref->first);
+    c_drop(bigmap, &m, &c, &hi, &d);
+    smap_ii_drop(&ref);
+}
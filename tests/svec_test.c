@@ -0,0 +1,85 @@
+#include <stdio.h>
+#include "stc/cstr.h"
+#include "ctest.h"
+
+#define i_type svec_int, int
+#define i_use_cmp
+#define i_inline 4
+#include "stc/svec.h"
+
+#define i_type svec_str
+#define i_keypro cstr
+#define i_use_eq
+#include "stc/svec.h"
+
+TEST(svec, basics)
+{
+    svec_int v = {0};
+    EXPECT_TRUE(svec_int_is_inline(&v));
+    EXPECT_EQ(4, svec_int_capacity(&v));
+    for (c_range(i, 4)) svec_int_push(&v, 40 - 10*(int)i);
+    EXPECT_TRUE(svec_int_is_inline(&v));
+
+    svec_int_sort(&v);
+    EXPECT_EQ(10, *svec_int_front(&v));
+    EXPECT_EQ(2, svec_int_lower_bound(&v, 25));
+    svec_int_erase_n(&v, 1, 2);
+    EXPECT_EQ(2, svec_int_size(&v));
+    EXPECT_EQ(40, *svec_int_back(&v));
+
+    for (c_range(i, 10)) svec_int_push(&v, (int)i); // spill to the heap
+    EXPECT_FALSE(svec_int_is_inline(&v));
+    EXPECT_EQ(12, svec_int_size(&v));
+    svec_int_insert_n(&v, 1, c_make_array(int, {7, 8}), 2);
+    EXPECT_EQ(7, *svec_int_at(&v, 1));
+    EXPECT_EQ(40, *svec_int_at(&v, 3));
+    EXPECT_EQ(9, *svec_int_back(&v));
+
+    int sum = 0;
+    for (c_each(i, svec_int, v)) sum += *i.ref;
+    EXPECT_EQ(10 + 7 + 8 + 40 + 45, sum);
+
+    svec_int_erase_n(&v, 2, 10);
+    svec_int_shrink_to_fit(&v); // back inline
+    EXPECT_TRUE(svec_int_is_inline(&v));
+    EXPECT_EQ(4, svec_int_size(&v));
+    EXPECT_EQ(10, *svec_int_at(&v, 0));
+    EXPECT_EQ(7, *svec_int_at(&v, 1));
+    EXPECT_EQ(8, *svec_int_at(&v, 2));
+    EXPECT_EQ(9, *svec_int_at(&v, 3));
+
+    svec_int w = svec_int_move(&v);
+    EXPECT_EQ(0, svec_int_size(&v));
+    EXPECT_EQ(4, svec_int_size(&w));
+    EXPECT_TRUE(svec_int_resize(&w, 6, -1));
+    EXPECT_EQ(-1, *svec_int_back(&w));
+    svec_int_drop(&w);
+}
+
+TEST(svec, cstr)
+{
+    svec_str v = c_make(svec_str, {"one", "two", "three"});
+    svec_str w = svec_str_clone(v);
+    EXPECT_TRUE(svec_str_is_inline(&v));
+
+    for (c_range(i, 20)) svec_str_push(&v, cstr_from_fmt("long string number %d", (int)i));
+    EXPECT_FALSE(svec_str_is_inline(&v));
+    EXPECT_EQ(23, svec_str_size(&v));
+    EXPECT_STREQ("long string number 19", cstr_str(svec_str_back(&v)));
+    svec_str_emplace_at(&v, svec_str_begin(&v), "zero");
+    EXPECT_STREQ("zero", cstr_str(svec_str_front(&v)));
+    EXPECT_EQ(2, svec_str_find(&v, "two").ref - svec_str_data(&v));
+
+    svec_str_copy(&w, v);
+    EXPECT_TRUE(svec_str_eq(&v, &w));
+    svec_str_copy(&v, v);
+    EXPECT_EQ(24, svec_str_size(&v));
+    svec_str_erase_range(&v, svec_str_advance(svec_str_begin(&v), 4), svec_str_end(&v));
+    svec_str_shrink_to_fit(&v);
+    EXPECT_EQ(4, svec_str_size(&v));
+    EXPECT_TRUE(svec_str_is_inline(&v));
+    EXPECT_STREQ("three", cstr_str(svec_str_back(&v)));
+    EXPECT_FALSE(svec_str_eq(&v, &w));
+    svec_str_drop(&v);
+    svec_str_drop(&w);
+}
@@ -0,0 +1,163 @@
+#include <stdio.h>
+#include "stc/cstr.h"
+#include "stc/random.h"
+#include "ctest.h"
+
+#define i_type tmap_si
+#define i_val int
+#include "stc/tmap.h"
+
+#define i_type tset_s
+#include "stc/tset.h"
+
+#define i_type sset_s
+#define i_keypro cstr
+#include "stc/sset.h"
+
+TEST(tmap, basics)
+{
+    tmap_si map = c_make(tmap_si, {{"/", 0}, {"/api/", 1}, {"/api/users/", 2}, {"/static/", 3}});
+    EXPECT_EQ(4, tmap_si_size(&map));
+    EXPECT_FALSE(tmap_si_emplace(&map, "/api/", 5).inserted);
+    EXPECT_TRUE(tmap_si_insert(&map, cstr_lit(""), 9).inserted);
+    EXPECT_EQ(9, *tmap_si_at(&map, ""));
+    tmap_si_insert_or_assign(&map, cstr_lit("/api/"), 10);
+    EXPECT_EQ(10, *tmap_si_at(&map, "/api/"));
+    EXPECT_TRUE(tmap_si_contains_sv(&map, c_sv("/static/index", 8)));
+    EXPECT_FALSE(tmap_si_contains(&map, "/api"));
+
+    const tmap_si_value* v = tmap_si_longest_prefix_match(&map, "/api/users/42");
+    EXPECT_STREQ("/api/users/", cstr_str(&v->first));
+    v = tmap_si_longest_prefix_match(&map, "/apix");
+    EXPECT_STREQ("/", cstr_str(&v->first));
+    v = tmap_si_longest_prefix_match(&map, "x");
+    EXPECT_STREQ("", cstr_str(&v->first));
+
+    cstr keys = {0};
+    for (c_each(i, tmap_si, map))
+        cstr_append(&keys, cstr_str(&i.ref->first)), cstr_append(&keys, ",");
+    EXPECT_STREQ(",/,/api/,/api/users/,/static/,", cstr_str(&keys));
+    cstr_clear(&keys);
+    for (tmap_si_iter it = tmap_si_prefix_begin(&map, "/a"); it.ref; tmap_si_next(&it))
+        cstr_append(&keys, cstr_str(&it.ref->first));
+    EXPECT_STREQ("/api//api/users/", cstr_str(&keys));
+    cstr_drop(&keys);
+
+    tmap_si clone = tmap_si_clone(map);
+    EXPECT_TRUE(tmap_si_erase(&map, "/api/"));
+    EXPECT_FALSE(tmap_si_erase(&map, "/api/"));
+    EXPECT_EQ(2, *tmap_si_at(&map, "/api/users/"));
+    EXPECT_EQ(4, tmap_si_size(&map));
+    EXPECT_EQ(5, tmap_si_size(&clone));
+    EXPECT_EQ(10, *tmap_si_at(&clone, "/api/"));
+    tmap_si_drop(&map);
+    tmap_si_drop(&clone);
+}
+
+// Random keys from a small alphabet, some with a long shared prefix, and some with any byte.
+static void random_key(crand64* rng, char* buf) {
+    static const char* stems[] = {"", "a", "ab", "abracadabra-abracadabra-", "z"};
+    const uint64_t r = crand64_uint_r(rng, 1);
+    int n = sprintf(buf, "%s", stems[r % 5]);
+    const int len = (int)((r >> 8) % 5);
+    for (int i = 0; i < len; ++i)
+        buf[n++] = (r >> 16) % 3 ? "abc"[crand64_uint_r(rng, 1) % 3]
+                                  : (char)(1 + crand64_uint_r(rng, 1) % 255);
+    buf[n] = '\0';
+}
+
+static bool starts_with(const cstr* s, const char* prefix)
+    { return !strncmp(cstr_str(s), prefix, strlen(prefix)); }
+
+TEST(tmap, random)
+{
+    enum {N = 30000};
+    crand64 rng = crand64_from(2025);
+    tset_s s = {0};
+    sset_s ref = {0};
+    char key[64];
+
+    for (int i = 0; i < N; ++i) {
+        random_key(&rng, key);
+        if (crand64_uint_r(&rng, 1) % 3)
+            EXPECT_EQ(sset_s_emplace(&ref, key).inserted, tset_s_emplace(&s, key).inserted);
+        else
+            EXPECT_EQ(sset_s_erase(&ref, key), tset_s_erase(&s, key));
+    }
+    EXPECT_EQ(sset_s_size(&ref), tset_s_size(&s));
+
+    sset_s_iter r = sset_s_begin(&ref);
+    for (tset_s_iter it = tset_s_begin(&s); it.ref; tset_s_next(&it), sset_s_next(&r))
+        EXPECT_TRUE(r.ref && cstr_eq(it.ref, r.ref));
+    EXPECT_TRUE(r.ref == NULL);
+
+    for (int i = 0; i < 500; ++i) {
+        random_key(&rng, key);
+        EXPECT_EQ(sset_s_contains(&ref, key), tset_s_contains(&s, key));
+        sset_s_iter lb = sset_s_lower_bound(&ref, key);
+        tset_s_iter it = tset_s_lower_bound(&s, key);
+        EXPECT_TRUE(lb.ref ? it.ref && cstr_eq(it.ref, lb.ref) : it.ref == NULL);
+
+        const cstr* best = NULL;
+        int n = 0;
+        for (lb = sset_s_lower_bound(&ref, key); lb.ref && starts_with(lb.ref, key); sset_s_next(&lb))
+            ++n;
+        for (c_each(j, sset_s, ref))
+            if (!strncmp(key, cstr_str(j.ref), (size_t)cstr_size(j.ref)))
+                best = j.ref;
+        const cstr* v = tset_s_longest_prefix_match(&s, key);
+        EXPECT_TRUE(best ? v && cstr_eq(v, best) : v == NULL);
+        for (it = tset_s_prefix_begin(&s, key); it.ref; tset_s_next(&it)) {
+            EXPECT_TRUE(starts_with(it.ref, key));
+            --n;
+        }
+        EXPECT_EQ(0, n);
+    }
+
+    for (c_each(i, sset_s, ref)) // erase all, and shrink the nodes
+        EXPECT_TRUE(tset_s_erase(&s, cstr_str(i.ref)));
+    EXPECT_EQ(0, tset_s_size(&s));
+    EXPECT_TRUE(s.root == NULL && s.head == NULL);
+    tset_s_drop(&s);
+    sset_s_drop(&ref);
+}
+
+TEST(tmap, nodes)
+{
+    tset_s s = {0};
+    char key[40] = "a-long-shared-prefix-";
+    const int n = (int)strlen(key);
+    for (int b = 1; b < 256; ++b) { // grow one node through all four node types
+        key[n] = (char)b, key[n + 1] = '\0';
+        EXPECT_TRUE(tset_s_emplace(&s, key).inserted);
+    }
+    key[n] = '\0';
+    EXPECT_TRUE(tset_s_emplace(&s, key).inserted);
+    EXPECT_TRUE(tset_s_emplace(&s, "a-long-shared").inserted); // split the long prefix
+    EXPECT_TRUE(tset_s_emplace(&s, "a-long-shaped").inserted);
+    EXPECT_EQ(258, tset_s_size(&s));
+
+    for (int b = 255; b >= 1; b -= 2) { // shrink it, with the odd bytes erased
+        key[n] = (char)b, key[n + 1] = '\0';
+        EXPECT_TRUE(tset_s_erase(&s, key));
+    }
+    int count = 0, last = 0;
+    for (tset_s_iter it = tset_s_prefix_begin(&s, "a-long-shared-"); it.ref; tset_s_next(&it), ++count) {
+        const int b = cstr_size(it.ref) > n ? (uint8_t)cstr_str(it.ref)[n] : 0;
+        EXPECT_TRUE(b == 0 || (b % 2 == 0 && b > last));
+        last = b;
+    }
+    EXPECT_EQ(128, count);
+    for (int b = 2; b < 256; b += 2) {
+        key[n] = (char)b, key[n + 1] = '\0';
+        EXPECT_TRUE(tset_s_erase(&s, key));
+    }
+    key[n] = '\0';
+    EXPECT_STREQ(key, cstr_str(tset_s_longest_prefix_match(&s, "a-long-shared-prefix-x")));
+    EXPECT_STREQ("a-long-shared", cstr_str(tset_s_longest_prefix_match(&s, "a-long-shared-prefiX")));
+    EXPECT_TRUE(tset_s_erase(&s, "a-long-shared"));
+    EXPECT_TRUE(tset_s_contains(&s, key));
+    EXPECT_TRUE(tset_s_contains(&s, "a-long-shaped"));
+    EXPECT_EQ(2, tset_s_size(&s));
+    tset_s_drop(&s);
+}